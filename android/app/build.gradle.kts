@@ -27,6 +27,19 @@ android {
         }
     }
 
+    externalNativeBuild {
+        // Native core shared with the desktop service (chunk scheduling)
+        cmake {
+            path = file("../../native/CMakeLists.txt")
+            version = "3.22.1"
+        }
+    }
+
+    androidResources {
+        // Keep models uncompressed so they can be memory-mapped straight from the APK
+        noCompress += listOf("onnx")
+    }
+
     compileOptions {
         sourceCompatibility = JavaVersion.VERSION_17
         targetCompatibility = JavaVersion.VERSION_17
@@ -0,0 +1,35 @@
+package com.voiceinput
+
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Runs the pipeline benchmark on a device:
+ *
+ *   ./gradlew connectedAndroidTest -Pandroid.testInstrumentationRunnerArguments.class=com.voiceinput.PipelineBenchmarkTest
+ *
+ * then pull the report with
+ *
+ *   adb shell run-as com.voiceinput cat files/benchmarks/<report>.json
+ */
+@RunWith(AndroidJUnit4::class)
+class PipelineBenchmarkTest {
+
+    @Test
+    fun runPipelineBenchmark() = runBlocking {
+        val context = InstrumentationRegistry.getInstrumentation().targetContext
+        val benchmark = PipelineBenchmark(context)
+        val report = benchmark.run()
+        val file = benchmark.writeReport(report)
+        Log.i("PipelineBenchTest", report.toJson())
+
+        assertTrue(file.exists())
+        assertTrue("Missing encoder metrics", report.metrics.keys.any { it.startsWith("encode.") })
+        assertTrue("Missing streaming lag", report.metrics.containsKey("streaming.lag_p50"))
+    }
+}
@@ -0,0 +1,56 @@
+package com.voiceinput.core
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.voiceinput.core.ChunkScheduler.Action
+import org.junit.Assert.*
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Checks the JNI binding of the native scheduler on a device:
+ *
+ *   ./gradlew connectedAndroidTest -Pandroid.testInstrumentationRunnerArguments.class=com.voiceinput.core.ChunkSchedulerTest
+ *
+ * The scheduling rules themselves are tested in native/tests/chunk_scheduler_test.cpp.
+ */
+@RunWith(AndroidJUnit4::class)
+class ChunkSchedulerTest {
+
+    private val limits = ChunkLimits(minAudioLengthBytes = 1000, maxChunkBytes = 4000, silenceDurationMs = 500)
+
+    @Test
+    fun nativeActionsMapToKotlinActions() = ChunkScheduler(limits).use { scheduler ->
+        scheduler.reset(0)
+        assertEquals(Action.IGNORE, scheduler.onChunk(true, 0, 1000, 100))
+        assertEquals(Action.APPEND, scheduler.onChunk(false, 0, 1000, 1000))
+        assertEquals(Action.APPEND_AND_FLUSH, scheduler.onChunk(false, 3000, 1000, 1100))
+        assertEquals(Action.IGNORE, scheduler.onChunk(true, 2000, 500, 1200, keepSilence = false))
+        assertEquals(Action.FLUSH, scheduler.onChunk(true, 2000, 500, 1600))
+        assertEquals(1100L, scheduler.lastSpeechMs)
+        assertTrue(scheduler.flushOnIdle(1000, recentAudio = false))
+        assertFalse(scheduler.flushOnIdle(1000, recentAudio = true))
+    }
+
+    @Test
+    fun newLimitsReachTheNativeScheduler() {
+        val scheduler = ChunkScheduler(limits)
+        scheduler.limits = limits.copy(maxChunkBytes = 1000)
+        assertEquals(Action.APPEND_AND_FLUSH, scheduler.onChunk(false, 0, 1000, 100))
+
+        scheduler.close()
+        scheduler.limits = limits // Ignored once closed
+        assertEquals(limits, scheduler.limits)
+    }
+
+    @Test
+    fun callsAfterCloseThrowInsteadOfReachingNative() {
+        val scheduler = ChunkScheduler(limits)
+        scheduler.close()
+        scheduler.close() // Idempotent
+
+        assertThrows(IllegalStateException::class.java) { scheduler.onChunk(false, 0, 1000, 100) }
+        assertThrows(IllegalStateException::class.java) { scheduler.reset(0) }
+        assertThrows(IllegalStateException::class.java) { scheduler.flushOnIdle(1000, recentAudio = false) }
+        assertThrows(IllegalStateException::class.java) { scheduler.lastSpeechMs }
+    }
+}
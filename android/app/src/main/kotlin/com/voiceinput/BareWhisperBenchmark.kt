@@ -11,7 +11,7 @@ import kotlin.math.sin
 /**
  * DEFINITIVE BENCHMARK TEST
  *
- * Tests ONLY whisper.cpp performance with ZERO overhead:
+ * Tests ONLY ONNX Whisper engine performance with ZERO overhead:
  * - No VAD
  * - No streaming
  * - No pipeline
@@ -19,7 +19,9 @@ import kotlin.math.sin
  *
  * Just: Raw audio → WhisperEngine → Result
  *
- * This gives us the TRUE performance baseline for whisper.cpp on this device.
+ * This gives us the TRUE performance baseline for the engine on this device. It is a
+ * single timing of a single clip; for repeated runs with percentiles across every
+ * pipeline stage use [PipelineBenchmark].
  */
 class BareWhisperBenchmark(private val context: Context) {
 
@@ -91,10 +93,10 @@ class BareWhisperBenchmark(private val context: Context) {
             Log.i(TAG, "   Model: Whisper SMALL (ONNX INT8)")
             Log.i(TAG, "   Audio: ${audioLengthSec}s (${audioData.size} bytes)")
             Log.i(TAG, "   Threads: $threadCount (${Runtime.getRuntime().availableProcessors()} cores available)")
-            Log.i(TAG, "   Test: Direct WhisperEngine.transcribe() with APU acceleration")
+            Log.i(TAG, "   Test: Direct WhisperEngine.transcribe() (${whisperEngine.getModelInfo().type})")
             Log.i(TAG, "")
 
-            // THE BENCHMARK: Pure whisper.cpp call
+            // THE BENCHMARK: Pure WhisperEngine call (encode + decode)
             Log.i(TAG, "⚡ Starting transcription...")
             val startTime = System.currentTimeMillis()
 
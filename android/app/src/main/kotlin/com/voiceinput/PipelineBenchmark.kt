@@ -0,0 +1,300 @@
+package com.voiceinput
+
+import android.content.Context
+import android.os.Build
+import android.os.PowerManager
+import android.util.Log
+import com.voiceinput.config.AppConfig
+import com.voiceinput.core.AudioRecorder
+import com.voiceinput.core.BenchmarkReport
+import com.voiceinput.core.BenchmarkSamples
+import com.voiceinput.core.SileroVAD
+import com.voiceinput.core.TextProcessor
+import com.voiceinput.core.TraceStage
+import com.voiceinput.core.Transcript
+import com.voiceinput.core.VoiceInputPipeline
+import com.voiceinput.core.WhisperEngine
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.File
+import java.text.SimpleDateFormat
+import java.util.Date
+import java.util.Locale
+import java.util.TimeZone
+import kotlin.math.sin
+
+/**
+ * Reproducible benchmark of every pipeline stage.
+ *
+ * Where [BareWhisperBenchmark] times one transcription of one clip, this runs a fixed corpus
+ * (jfk.wav tiled to [corpusSec] seconds) through each stage with [warmup] untimed and
+ * [repeats] timed runs, and reports percentiles per metric:
+ * - init.cold / init.warm: first engine initialization in the process, then re-initialization
+ * - encode.<n>s: encoder per clip (clips up to 30 s, the encoder's window)
+ * - decode.per_token / decode.<n>s: decoder per text token and per clip
+ * - vad.per_frame: Silero VAD per 32 ms frame
+ * - stitch.per_append: Transcript.append per window
+ * - streaming.lag_p50 / streaming.lag_p95: capture to text (END_TO_END trace stage) with the
+ *   [STREAMING_CLIP_SEC] clip fed at real-time pace
+ * - file.<n>s_rtf: offline file transcription of every clip
+ *
+ * The report also records peak RSS and the thermal state (so throttled runs can be told
+ * apart) and is written as JSON by [writeReport]. Run it from the instrumented test
+ * PipelineBenchmarkTest.
+ */
+class PipelineBenchmark(
+    private val context: Context,
+    private val warmup: Int = 1,
+    private val repeats: Int = 5,
+    private val corpusSec: List<Int> = CORPUS_SEC
+) {
+
+    companion object {
+        private const val TAG = "PipelineBench"
+        private const val SAMPLE_RATE = 16000
+        private const val BYTES_PER_SECOND = SAMPLE_RATE * 2
+        private const val ENCODER_WINDOW_SEC = 30
+
+        val CORPUS_SEC = listOf(5, 15, 30, 120)
+        const val STREAMING_CLIP_SEC = 15
+        private const val STREAMING_CHUNK_MS = 100L
+    }
+
+    init {
+        require(warmup >= 0) { "Warmup runs must not be negative, got $warmup" }
+        require(repeats > 0) { "Repeats must be positive, got $repeats" }
+        require(corpusSec.isNotEmpty() && corpusSec.all { it > 0 }) { "Corpus clip lengths must be positive: $corpusSec" }
+    }
+
+    private val samples = BenchmarkSamples()
+    private val notes = LinkedHashMap<String, String>()
+
+    /**
+     * Run the whole suite; takes several minutes on a phone
+     */
+    suspend fun run(): BenchmarkReport = withContext(Dispatchers.IO) {
+        Log.i(TAG, "========================================")
+        Log.i(TAG, "🔬 PIPELINE BENCHMARK: corpus ${corpusSec}s, warmup $warmup, repeats $repeats")
+        Log.i(TAG, "========================================")
+
+        val startedAt = SimpleDateFormat("yyyy-MM-dd'T'HH:mm:ss'Z'", Locale.US)
+            .apply { timeZone = TimeZone.getTimeZone("UTC") }
+            .format(Date())
+        val thermalBefore = thermalState()
+        val corpus = buildCorpus()
+
+        val engine = benchmarkInit()
+        try {
+            benchmarkEncodeDecode(engine, corpus)
+            benchmarkVad(corpus)
+            benchmarkStitch()
+        } catch (e: Exception) {
+            engine.release()
+            throw e
+        }
+        // The pipeline owns the engine from here on and releases it
+        benchmarkPipeline(engine, corpus)
+
+        val thermalAfter = thermalState()
+        val report = BenchmarkReport(
+            platform = "android",
+            build = appVersion(),
+            device = "${Build.MANUFACTURER} ${Build.MODEL} (API ${Build.VERSION.SDK_INT})",
+            model = engine.manifest.tier,
+            startedAt = startedAt,
+            warmup = warmup,
+            repeats = repeats,
+            corpusSec = corpusSec,
+            thermalState = if (thermalBefore == thermalAfter) thermalAfter else "$thermalBefore->$thermalAfter",
+            peakRssKb = peakRssKb(),
+            metrics = samples.stats(),
+            notes = notes
+        )
+        Log.i(TAG, "✅ Benchmark complete: ${report.metrics.size} metrics, thermal ${report.thermalState}, peak RSS ${report.peakRssKb} kB")
+        report
+    }
+
+    /**
+     * Write [report] as JSON under the app's files dir, named by its start time
+     */
+    fun writeReport(report: BenchmarkReport, dir: File = File(context.filesDir, "benchmarks")): File {
+        dir.mkdirs()
+        val file = File(dir, "pipeline-${report.startedAt.replace(":", "")}.json")
+        file.writeText(report.toJson())
+        Log.i(TAG, "📄 Benchmark report written to ${file.absolutePath}")
+        return file
+    }
+
+    /**
+     * Run [block] [warmup] times untimed, then [repeats] times timed
+     */
+    private inline fun measure(metric: String, unit: String = "ms", block: () -> Double) {
+        repeat(warmup) { block() }
+        repeat(repeats) { samples.add(metric, unit, block()) }
+    }
+
+    private inline fun elapsedMs(block: () -> Unit): Double {
+        val start = System.nanoTime()
+        block()
+        return (System.nanoTime() - start) / 1_000_000.0
+    }
+
+    private suspend fun benchmarkInit(): WhisperEngine {
+        Log.i(TAG, "📦 Engine initialization")
+        var engine = WhisperEngine(context)
+        val coldMs = initializeTimed(engine)
+        samples.add("init.cold", "ms", coldMs)
+        // A warm start here means the optimized model cache survived from an earlier run
+        notes["init.cold.model_cache"] = if (engine.getModelInfo().warmStart) "warm" else "cold"
+
+        repeat(repeats) {
+            engine.release()
+            engine = WhisperEngine(context)
+            samples.add("init.warm", "ms", initializeTimed(engine))
+        }
+        return engine
+    }
+
+    private suspend fun initializeTimed(engine: WhisperEngine): Double {
+        val start = System.nanoTime()
+        check(engine.initialize()) { "Failed to initialize Whisper ${engine.manifest.tier}" }
+        return (System.nanoTime() - start) / 1_000_000.0
+    }
+
+    private suspend fun benchmarkEncodeDecode(engine: WhisperEngine, corpus: Map<Int, ByteArray>) {
+        for ((sec, clip) in corpus) {
+            if (sec > ENCODER_WINDOW_SEC) continue
+            Log.i(TAG, "⚡ Encode/decode ${sec}s clip")
+            measure("encode.${sec}s") { elapsedMs { engine.encode(clip).close() } }
+
+            repeat(warmup) { engine.decode(engine.encode(clip)) }
+            repeat(repeats) {
+                val encoded = engine.encode(clip)
+                val start = System.nanoTime()
+                val result = engine.decode(encoded)
+                val decodeMs = (System.nanoTime() - start) / 1_000_000.0
+                samples.add("decode.${sec}s", "ms", decodeMs)
+                if (result.tokens.isNotEmpty()) {
+                    samples.add("decode.per_token", "ms", decodeMs / result.tokens.size)
+                }
+            }
+        }
+    }
+
+    private suspend fun benchmarkVad(corpus: Map<Int, ByteArray>) {
+        Log.i(TAG, "🎙️ Silero VAD")
+        val vad = SileroVAD(context, AppConfig())
+        try {
+            val clip = corpus.getValue(corpus.keys.filter { it <= ENCODER_WINDOW_SEC }.maxOrNull() ?: corpus.keys.first())
+            val frames = clip.size / vad.getFrameSizeBytes()
+            measure("vad.per_frame", "us") {
+                vad.resetStream()
+                elapsedMs { vad.processFrames(clip) } * 1000.0 / frames
+            }
+        } finally {
+            vad.close()
+        }
+    }
+
+    private fun benchmarkStitch() {
+        Log.i(TAG, "🧵 Text stitching")
+        val processor = TextProcessor()
+        val windows = List(40) { i -> "and so my fellow americans ask not what your country can do for you window $i" }
+        measure("stitch.per_append", "us") {
+            val transcript = Transcript(processor)
+            val start = System.nanoTime()
+            for (window in windows) transcript.append(window)
+            (System.nanoTime() - start) / 1000.0 / windows.size
+        }
+    }
+
+    private suspend fun benchmarkPipeline(engine: WhisperEngine, corpus: Map<Int, ByteArray>) {
+        // Tier stepping is off so every run measures the same model
+        val config = AppConfig().let { it.copy(transcription = it.transcription.copy(adaptiveModel = false)) }
+        val pipeline = VoiceInputPipeline(context, AudioRecorder(), engine, config)
+        try {
+            val streamingClip = corpus[STREAMING_CLIP_SEC] ?: corpus.values.first()
+            val chunkBytes = (BYTES_PER_SECOND * STREAMING_CHUNK_MS / 1000).toInt()
+            Log.i(TAG, "📡 Streaming lag (${streamingClip.size / BYTES_PER_SECOND}s at real-time pace)")
+            repeat(warmup + repeats) { run ->
+                pipeline.trace.reset()
+                pipeline.feedFileAudio(streamingClip, chunkBytes, STREAMING_CHUNK_MS)
+                val lag = pipeline.trace.summary()[TraceStage.END_TO_END] ?: return@repeat
+                if (run >= warmup) {
+                    samples.add("streaming.lag_p50", "ms", lag.p50Ms.toDouble())
+                    samples.add("streaming.lag_p95", "ms", lag.p95Ms.toDouble())
+                }
+            }
+
+            for ((sec, clip) in corpus) {
+                Log.i(TAG, "📁 File transcription ${sec}s clip")
+                measure("file.${sec}s_rtf", "x") { elapsedMs { pipeline.transcribeFile(clip) } / (sec * 1000.0) }
+            }
+        } finally {
+            pipeline.release()
+        }
+    }
+
+    /**
+     * jfk.wav tiled to every corpus length, or synthetic audio if the asset is missing
+     */
+    private fun buildCorpus(): Map<Int, ByteArray> {
+        val source = try {
+            context.assets.open("jfk.wav").use { input ->
+                input.skip(44) // Standard WAV header
+                input.readBytes()
+            }
+        } catch (e: Exception) {
+            Log.w(TAG, "jfk.wav not found, using synthetic audio", e)
+            null
+        }
+        notes["corpus.source"] = if (source != null) "jfk.wav" else "synthetic"
+
+        return corpusSec.associateWith { sec ->
+            val length = sec * BYTES_PER_SECOND
+            if (source == null || source.isEmpty()) {
+                syntheticAudio(length)
+            } else {
+                ByteArray(length) { i -> source[i % source.size] }
+            }
+        }
+    }
+
+    private fun syntheticAudio(length: Int): ByteArray {
+        val audio = ByteArray(length)
+        for (i in 0 until length / 2) {
+            val t = i.toDouble() / SAMPLE_RATE
+            val sample = ((sin(2.0 * Math.PI * 200.0 * t) * 0.3 + sin(2.0 * Math.PI * 800.0 * t) * 0.2) * 10000).toInt()
+            audio[i * 2] = (sample and 0xFF).toByte()
+            audio[i * 2 + 1] = ((sample shr 8) and 0xFF).toByte()
+        }
+        return audio
+    }
+
+    private fun thermalState(): String {
+        if (Build.VERSION.SDK_INT < Build.VERSION_CODES.Q) return "unknown"
+        val powerManager = context.getSystemService(Context.POWER_SERVICE) as PowerManager
+        return when (powerManager.currentThermalStatus) {
+            PowerManager.THERMAL_STATUS_NONE -> "none"
+            PowerManager.THERMAL_STATUS_LIGHT -> "light"
+            PowerManager.THERMAL_STATUS_MODERATE -> "moderate"
+            PowerManager.THERMAL_STATUS_SEVERE -> "severe"
+            PowerManager.THERMAL_STATUS_CRITICAL -> "critical"
+            PowerManager.THERMAL_STATUS_EMERGENCY -> "emergency"
+            PowerManager.THERMAL_STATUS_SHUTDOWN -> "shutdown"
+            else -> "unknown"
+        }
+    }
+
+    private fun peakRssKb(): Long? = try {
+        BenchmarkReport.parsePeakRssKb(File("/proc/self/status").readText())
+    } catch (e: Exception) {
+        null
+    }
+
+    private fun appVersion(): String = try {
+        context.packageManager.getPackageInfo(context.packageName, 0).versionName ?: "unknown"
+    } catch (e: Exception) {
+        "unknown"
+    }
+}
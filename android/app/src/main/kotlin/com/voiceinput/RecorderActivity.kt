@@ -12,11 +12,13 @@ import androidx.appcompat.app.AppCompatActivity
 import androidx.core.app.ActivityCompat
 import androidx.core.content.ContextCompat
 import com.voiceinput.core.AudioRecorder
+import com.voiceinput.core.AudioUtils
 import com.voiceinput.core.VoiceInputPipeline
 import com.voiceinput.core.WhisperEngine
 import com.voiceinput.config.ConfigRepository
 import com.voiceinput.data.Note
 import com.voiceinput.data.NotesRepository
+import com.voiceinput.service.EngineConnection
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.collect
 import android.util.Log
@@ -24,6 +26,8 @@ import android.graphics.drawable.GradientDrawable
 import com.voiceinput.ime.AudioVisualizerView
 import android.view.animation.Animation
 import android.view.animation.ScaleAnimation
+import java.io.File
+import java.nio.ByteBuffer
 import java.util.Locale
 import kotlin.math.max
 
@@ -35,6 +39,7 @@ class RecorderActivity : AppCompatActivity() {
     private lateinit var repository: NotesRepository
     private var audioRecorder: AudioRecorder? = null
     private var whisperEngine: WhisperEngine? = null
+    private val engineConnection = EngineConnection(this)
     private var voicePipeline: VoiceInputPipeline? = null
 
     private lateinit var statusText: TextView
@@ -87,18 +92,20 @@ class RecorderActivity : AppCompatActivity() {
         scope.launch {
             try {
                 Log.i(TAG, "Initializing components...")
-                audioRecorder = AudioRecorder()
-                whisperEngine = WhisperEngine(this@RecorderActivity)
-                val initSuccess = whisperEngine?.initialize() ?: false
+                // The whole recording is transcribed after stop, so it is captured (on disk)
+                audioRecorder = AudioRecorder(captureFile = File(cacheDir, "recorder-session.pcm"))
+                // Shared with the keyboard: already loaded if the IME has been used
+                whisperEngine = engineConnection.acquire()
 
-                if (initSuccess) {
+                if (whisperEngine != null) {
                     val config = ConfigRepository(this@RecorderActivity).load()
                     voicePipeline = VoiceInputPipeline(
                         context = this@RecorderActivity,
                         audioRecorder = audioRecorder!!,
                         whisperEngine = whisperEngine!!,
                         config = config,
-                        onResult = null
+                        onResult = null,
+                        ownsEngine = false
                     )
                     Log.i(TAG, "Components initialized successfully")
                 } else {
@@ -485,11 +492,12 @@ class RecorderActivity : AppCompatActivity() {
         recordingJob = scope.launch {
             try {
                 recorder.audioStream().collect { chunk ->
-                    // Audio is being collected by AudioRecorder
-                    // We just need to keep the stream alive
-                    Log.d(TAG, "Collected audio chunk: ${chunk.size} bytes")
+                    // Audio is being captured by AudioRecorder
+                    // We just need to keep the stream alive and show the level
+                    val level = AudioUtils.calculateLevels(chunk.data, 0, chunk.length).rms
+                    chunk.recycle()
                     withContext(Dispatchers.Main) {
-                        audioVisualizer.updateAudioData(chunk)
+                        audioVisualizer.updateLevel(level)
                     }
                 }
             } catch (e: Exception) {
@@ -510,8 +518,11 @@ class RecorderActivity : AppCompatActivity() {
         timerJob = null
 
         scope.launch(Dispatchers.IO) {
+            val recorder = audioRecorder
             try {
-                val recordedAudio = audioRecorder?.stop() ?: ByteArray(0)
+                recorder?.stop()
+                // Transcribed straight from the mapped capture file; only windows are copied out
+                val recordedAudio = recorder?.capturedAudio() ?: ByteBuffer.allocate(0)
 
                 runOnUiThread {
                     setProcessingState(true)
@@ -523,7 +534,7 @@ class RecorderActivity : AppCompatActivity() {
                 }
 
                 // Transcribe the audio
-                if (recordedAudio.isNotEmpty()) {
+                if (recordedAudio.hasRemaining()) {
                     val pipeline = voicePipeline
                     if (pipeline == null) {
                         runOnUiThread {
@@ -537,7 +548,7 @@ class RecorderActivity : AppCompatActivity() {
                     }
 
                     pipeline.clearText()
-                    pipeline.feedFileAudio(recordedAudio)
+                    pipeline.transcribeFile(recordedAudio)
                     val processedText = pipeline.getFinalText()
 
                     runOnUiThread {
@@ -573,6 +584,8 @@ class RecorderActivity : AppCompatActivity() {
                     Toast.makeText(this@RecorderActivity, "Processing error: ${e.message}", Toast.LENGTH_SHORT).show()
                     resetRecording()
                 }
+            } finally {
+                recorder?.clearBuffer() // Done reading the mapping
             }
         }
     }
@@ -649,10 +662,9 @@ class RecorderActivity : AppCompatActivity() {
             audioRecorder?.stop()
         }
         val pipeline = voicePipeline
-        if (pipeline != null) {
-            runBlocking {
-                pipeline.release()
-            }
+        runBlocking {
+            pipeline?.release()
+            engineConnection.close()
         }
         voicePipeline = null
         audioRecorder = null
@@ -5,6 +5,7 @@ import android.content.SharedPreferences
 import androidx.preference.PreferenceManager
 import com.google.gson.Gson
 import com.google.gson.GsonBuilder
+import com.voiceinput.core.DecodingOptions
 import java.io.File
 
 /**
@@ -24,7 +25,12 @@ data class AudioConfig(
     val silenceDurationSec: Float = 1.5f,  // Natural pause detection (reduced from 2.0s)
     val maxChunkDurationSec: Float = 30.0f,  // 30s rolling windows for better long-form continuity
     val overlapDurationSec: Float = 5.0f,  // 5s overlap to preserve sentence continuity across windows
-    val enableVAD: Boolean = false  // Disable VAD for now - focus on basic button recording
+    val timestampOverlapSec: Float = 1.0f,  // Overlap kept after a timestamped window with no clean segment boundary
+    val enableVAD: Boolean = false,  // Disable VAD for now - focus on basic button recording
+
+    // Live backpressure: queuing delay above the budget degrades processing step by step
+    val latencyBudgetMs: Long = 3000L,
+    val maxQueuedAudioSec: Float = 20.0f  // Recorder audio held while behind; oldest is dropped beyond this
 ) {
     init {
         require(sampleRate in VALID_SAMPLE_RATES) {
@@ -36,6 +42,12 @@ data class AudioConfig(
         require(vadThreshold in 0.0f..1.0f) {
             "VAD threshold must be between 0.0 and 1.0, got $vadThreshold"
         }
+        require(latencyBudgetMs > 0) {
+            "Latency budget must be positive, got $latencyBudgetMs"
+        }
+        require(maxQueuedAudioSec > 0f) {
+            "Max queued audio must be positive, got $maxQueuedAudioSec"
+        }
     }
 
     companion object {
@@ -54,17 +66,63 @@ data class TranscriptionConfig(
     val minChunkSizeBytes: Int = 24000, // ~0.75 sec minimum @ 16kHz (reduced from 1s)
 
     // Whisper model paths (Android-specific)
-    val modelPath: String? = null // Path to GGML model in app storage
+    val modelPath: String? = null, // Path to GGML model in app storage
+
+    // Speculative partial results while the user is still speaking
+    val partialResults: Boolean = true,
+    val partialIntervalMs: Long = 600L, // Minimum audio growth between partial decodes
+
+    // Decoding strategy (see core/WhisperDecoding.kt)
+    val beamSize: Int = 1, // 1 = greedy
+    val temperatureFallback: Boolean = true,
+    val compressionRatioThreshold: Float = 2.4f,
+    val logProbThreshold: Float = -1.0f,
+
+    // Timestamped decoding: fills TranscriptionResult.segments so windows are cut at
+    // segment boundaries instead of deduplicating a fixed overlap by text
+    val timestamps: Boolean = false,
+
+    // Prompt carry-over: the last text tokens of the transcript condition the next window
+    val promptCarryover: Boolean = true,
+    val promptMaxTokens: Int = 32, // Each token costs one decoder step per window; whisper allows up to 223
+
+    // Execution provider per stage: auto (benchmarked once per device), nnapi, qnn, xnnpack or cpu
+    val encoderBackend: String = "auto",
+    val decoderBackend: String = "auto",
+
+    // Step down to a smaller bundled model tier when transcription falls behind real time
+    // (rolling RTF above the threshold) or memory runs low (see core/ModelTierPolicy.kt)
+    val adaptiveModel: Boolean = true,
+    val adaptiveRtfThreshold: Float = 1.0f
 ) {
     init {
         val baseModel = modelName.split(".")[0]
         require(baseModel in VALID_MODELS) {
             "Model name must be one of $VALID_MODELS (or .en variant), got $modelName"
         }
+        require(partialIntervalMs >= 100) {
+            "Partial interval must be at least 100ms, got $partialIntervalMs"
+        }
+        require(beamSize in 1..DecodingOptions.MAX_BEAM_SIZE) {
+            "Beam size must be between 1 and ${DecodingOptions.MAX_BEAM_SIZE}, got $beamSize"
+        }
+        require(promptMaxTokens in 0..223) {
+            "Prompt token budget must be between 0 and 223, got $promptMaxTokens"
+        }
+        require(encoderBackend.lowercase() in VALID_BACKENDS) {
+            "Encoder backend must be one of $VALID_BACKENDS, got $encoderBackend"
+        }
+        require(decoderBackend.lowercase() in VALID_BACKENDS) {
+            "Decoder backend must be one of $VALID_BACKENDS, got $decoderBackend"
+        }
+        require(adaptiveRtfThreshold > 0f) {
+            "Adaptive RTF threshold must be positive, got $adaptiveRtfThreshold"
+        }
     }
 
     companion object {
         val VALID_MODELS = listOf("tiny", "base", "small", "medium", "large")
+        val VALID_BACKENDS = listOf("auto", "nnapi", "qnn", "xnnpack", "cpu")
     }
 }
 
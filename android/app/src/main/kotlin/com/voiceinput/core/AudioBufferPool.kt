@@ -0,0 +1,133 @@
+package com.voiceinput.core
+
+import java.io.File
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+import java.util.concurrent.ArrayBlockingQueue
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * A recorder chunk borrowed from an [AudioBufferPool].
+ *
+ * Only the first [length] bytes of [data] are audio. Whoever consumes the chunk last calls
+ * [recycle]; the array is reused for a later read, so it must not be kept after that.
+ */
+class PooledAudioBuffer internal constructor(
+    val data: ByteArray,
+    private val pool: AudioBufferPool
+) {
+    var length: Int = 0
+        internal set
+
+    internal val inPool = AtomicBoolean(false)
+
+    /**
+     * A copy of the audio, for consumers that keep it past [recycle]
+     */
+    fun toByteArray(): ByteArray = data.copyOf(length)
+
+    fun recycle() = pool.release(this)
+}
+
+/**
+ * Fixed-size audio buffers reused across recorder reads, so a live session does not
+ * allocate an array per chunk.
+ *
+ * [acquire] allocates when no free buffer is left; at most [maxPooled] returned buffers are
+ * kept. A buffer recycled twice is ignored. Thread-safe.
+ */
+class AudioBufferPool(
+    val bufferSize: Int,
+    private val maxPooled: Int = DEFAULT_MAX_POOLED
+) {
+
+    companion object {
+        // Chunks in flight: the flow buffer in front of the processor plus its channel
+        const val DEFAULT_MAX_POOLED = 64
+    }
+
+    init {
+        require(bufferSize > 0) { "Buffer size must be positive, got $bufferSize" }
+        require(maxPooled > 0) { "Pool size must be positive, got $maxPooled" }
+    }
+
+    private val free = ArrayBlockingQueue<PooledAudioBuffer>(maxPooled)
+    private val allocations = AtomicInteger(0)
+
+    /** Buffers allocated so far; stays flat once a session has warmed the pool up */
+    val allocated: Int get() = allocations.get()
+
+    fun acquire(): PooledAudioBuffer {
+        val buffer = free.poll() ?: PooledAudioBuffer(ByteArray(bufferSize), this).also { allocations.incrementAndGet() }
+        buffer.inPool.set(false)
+        buffer.length = 0
+        return buffer
+    }
+
+    fun release(buffer: PooledAudioBuffer) {
+        if (!buffer.inPool.compareAndSet(false, true)) return
+        free.offer(buffer) // Dropped to the GC when the pool is full
+    }
+}
+
+/**
+ * Recording of a whole session, spilled to [file] as raw PCM instead of being kept in memory.
+ *
+ * Chunks are appended as they are read; [map] gives the audio back as a read-only memory
+ * map, so even an hour of dictation costs no heap until a caller copies a window out of it.
+ * Not thread-safe: appends come from the recorder's read loop.
+ */
+class SessionCapture(val file: File) : AutoCloseable {
+
+    private var output: RandomAccessFile? = null
+
+    /** Bytes captured since the last [reset] */
+    var size: Long = 0L
+        private set
+
+    /**
+     * Start a new capture, discarding the previous one
+     */
+    fun reset() {
+        close()
+        file.parentFile?.mkdirs()
+        output = RandomAccessFile(file, "rw").apply { setLength(0L) }
+        size = 0L
+    }
+
+    fun append(data: ByteArray, offset: Int = 0, length: Int = data.size - offset) {
+        val out = output ?: return
+        out.write(data, offset, length)
+        size += length
+    }
+
+    /**
+     * The captured audio, memory-mapped read-only; empty if nothing was captured
+     */
+    fun map(): ByteBuffer {
+        if (size == 0L || !file.exists()) return ByteBuffer.allocate(0)
+        return RandomAccessFile(file, "r").use { input ->
+            // The mapping stays valid after the channel is closed
+            input.channel.map(FileChannel.MapMode.READ_ONLY, 0L, size)
+        }
+    }
+
+    /**
+     * Stop appending; the captured audio stays readable until the next [reset]
+     */
+    override fun close() {
+        output?.close()
+        output = null
+    }
+
+    /**
+     * Close and delete the capture file
+     */
+    fun delete() {
+        close()
+        size = 0L
+        file.delete()
+    }
+}
@@ -7,8 +7,12 @@ import kotlinx.coroutines.*
 import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.flow.*
 import kotlin.math.max
+import java.nio.ByteBuffer
+import java.util.concurrent.ConcurrentLinkedQueue
 import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.atomic.AtomicReference
 
 /**
  * Audio processing component that manages VAD-based audio buffering and transcription.
@@ -17,31 +21,52 @@ import java.util.concurrent.atomic.AtomicLong
  * This component is responsible for:
  * 1. Voice activity detection using Silero VAD
  * 2. Audio buffering based on speech detection
- * 3. Asynchronous processing of detected speech segments
- * 4. Delivery of transcription results via callbacks
+ * 3. Asynchronous processing of detected speech segments, pipelined so the
+ *    next window encodes on the APU while the previous one decodes on the CPU
+ * 4. Delivery of transcription results via callbacks, in chunk order
+ * 5. Optional speculative partial results: while speech is still accumulating, the
+ *    growing window is re-decoded and stabilized with [LocalAgreement] so the IME can
+ *    show committed and tentative text before the window is flushed
+ * 6. Prompt carry-over: each window is decoded with the tail of the transcript so far as
+ *    <|startofprev|> context, keeping accuracy across window boundaries
+ * 7. Optional timestamp stitching: with timestamped decoding, a window flushed at max
+ *    size is cut at a segment boundary from its result, so the next window re-encodes
+ *    only the unfinished segment instead of a fixed overlap (see [stitchWindow])
+ * 8. Backpressure: live audio goes through a bounded queue, and a [LatencyScheduler]
+ *    degrades processing when queuing delay exceeds the latency budget
+ * 9. Latency tracing: VAD, queue wait, encode, decode, stitch and capture-to-delivery
+ *    spans of every window are recorded in [trace]
  *
  * Now using ONNX Runtime for 45x faster transcription via APU!
  */
 class AudioProcessor(
     private val context: Context,
-    private val whisperEngine: WhisperEngine,
+    whisperEngine: WhisperEngine,
     private val textProcessor: TextProcessor,
     private var config: AppConfig,
-    private val onResult: (TranscriptionResult) -> Unit
+    private val onResult: (TranscriptionResult) -> Unit,
+    private val onPartialResult: ((PartialTranscription) -> Unit)? = null,
+    private val onOverload: (() -> Unit)? = null,  // Latency budget still exceeded after degrading; switch model tier
+    private val trace: LatencyTrace = LatencyTrace()
 ) {
 
     companion object {
         private const val TAG = "AudioProcessor"
         private const val QUEUE_TIMEOUT_MS = 50L // Reduced timeout for more responsive processing
+
+        // Flushed windows waiting for the encoder; bounds memory when transcription falls behind
+        private const val ENCODE_QUEUE_CAPACITY = 2
+
+        // A last segment ending this close to the window end is treated as cut off mid-speech
+        private const val SEGMENT_END_MARGIN_SEC = 0.5f
     }
 
+    // Replaced between windows by swapEngine() when the model tier changes
+    @Volatile private var whisperEngine: WhisperEngine = whisperEngine
+
     // VAD component (matching desktop initialization)
     private var sileroVAD: SileroVAD? = null
 
-    // VAD frame buffer for handling incomplete frames (FIXED: frame alignment issue)
-    // Stores leftover bytes between isSilent() calls to ensure proper 960-byte frame processing
-    private var vadFrameBuffer = ByteArray(0)
-
     // Configuration values cached for performance - optimized for streaming
     private var minAudioLengthBytes: Int = 0
     private var sampleRate: Int = config.audio.sampleRate
@@ -53,7 +78,13 @@ class AudioProcessor(
     private var overlapDurationSec: Float = config.audio.overlapDurationSec
     private var maxChunkBytes: Int = 0
     private var overlapBytes: Int = 0
+    private val chunkScheduler = ChunkScheduler(ChunkLimits(0, 1, 0))
     private var minChunkSizeBytes: Int = config.transcription.minChunkSizeBytes
+    private var partialResultsEnabled: Boolean = config.transcription.partialResults
+    private var partialIntervalBytes: Int = 0
+    private var timestampStitching: Boolean = config.transcription.timestamps
+    private var timestampOverlapSec: Float = config.audio.timestampOverlapSec
+    private var promptTokenBudget: Int = 0
 
     // Processing state
     private val isRunning = AtomicBoolean(false)
@@ -61,35 +92,100 @@ class AudioProcessor(
     private var processingJob: Job? = null
     private var processingScope: CoroutineScope? = null
 
-    // Audio data channel (replaces Python queue.Queue)
+    // Audio data channel (replaces Python queue.Queue), bounded to maxQueuedAudioSec
     private var audioChannel: Channel<AudioChunk>? = null
-
-    // Buffer state for the processing loop
-    private data class BufferState(
-        val activeSpeechBuffer: ByteArray = ByteArray(0),
-        val lastSpeechTime: Long = System.currentTimeMillis(),
-        val totalProcessedBytes: Int = 0
+    private var maxQueuedChunks: Int = 1
+    private var realtime = true
+
+    // Backpressure metrics and the degradation ladder that acts on them
+    @Volatile private var latencyScheduler = LatencyScheduler(config.audio.latencyBudgetMs)
+    private val queuedChunks = AtomicInteger(0)
+    private val droppedChunks = AtomicLong(0)
+    @Volatile private var chunkLagMs = 0L // Queue wait of the last chunk the worker took
+    private val windowQueuedAt = ConcurrentLinkedQueue<Long>() // Flush times of windows the encoder has not taken
+
+    // Two-stage transcription pipeline: encoder (APU) → decoder (CPU).
+    // Single consumer per stage over FIFO channels keeps results in chunk order.
+    private var encodeChannel: Channel<QueuedWindow>? = null
+    private var decodeChannel: Channel<EncodedWindow>? = null
+    private var encoderJob: Job? = null
+    private var decoderJob: Job? = null
+
+    // Windows flushed but not yet delivered; partials only run when this is zero so they
+    // never delay a final result or show text that is about to be superseded
+    private val pendingWindows = AtomicInteger(0)
+
+    // Speculative partial state. The generation changes on every flush so a partial decode
+    // that was running for an already-flushed window is dropped.
+    private val localAgreement = LocalAgreement()
+    private val partialInFlight = AtomicBoolean(false)
+    private val windowGeneration = AtomicLong(0)
+    private var lastPartialBytes = 0
+    // Prompt context as of the last delivered window, published by the decoder for partials
+    @Volatile private var deliveredContext = IntArray(0)
+
+    // Timestamp stitching: the decoder publishes where the next window should start
+    private val windowSequence = AtomicLong(0)
+    private val completedSequence = AtomicLong(0) // Last window delivered or dropped
+    private val overlapCut = AtomicReference<OverlapCut?>(null)
+
+    // A flushed window on its way through the pipeline. retainedFrom is the offset in this
+    // window where the overlap kept in the ring starts, or -1 if nothing was kept.
+    // capturedAt is when its newest audio was received; queuedAtNs starts its queue span.
+    private class QueuedWindow(
+        val audio: ByteArray,
+        val sequence: Long,
+        val retainedFrom: Int,
+        val capturedAt: Long,
+        val queuedAtNs: Long
     ) {
-        fun withSpeechAdded(chunk: ByteArray): BufferState = copy(
-            activeSpeechBuffer = activeSpeechBuffer + chunk,
-            lastSpeechTime = System.currentTimeMillis(),
-            totalProcessedBytes = totalProcessedBytes + chunk.size
-        )
+        val cookie: Int get() = sequence.toInt()
+    }
 
-        fun withSilenceAdded(chunk: ByteArray): BufferState = copy(
-            activeSpeechBuffer = activeSpeechBuffer + chunk,
-            totalProcessedBytes = totalProcessedBytes + chunk.size
-        )
+    // An encoded window and the engine that encoded it, which must also decode it
+    // [encoded] is null when the encoder failed: the window still passes through the decoder
+    // so that completedSequence only ever advances in window order
+    private class EncodedWindow(val window: QueuedWindow, val encoded: EncodedAudio?, val engine: WhisperEngine)
+
+    // Byte offset in window [sequence] at which the next window should start
+    private data class OverlapCut(val sequence: Long, val cutBytes: Int)
+
+    // Buffer state for the processing loop. The speech window lives in a preallocated
+    // ring so appending a recorder chunk copies only that chunk.
+    private class BufferState(capacityBytes: Int) {
+        val activeSpeech = PcmRingBuffer(capacityBytes)
+        var totalProcessedBytes: Int = 0
+        var capturedAt: Long = System.currentTimeMillis() // Receive time of the newest chunk
 
-        fun cleared(): BufferState = copy(
-            activeSpeechBuffer = ByteArray(0),
+        // Window whose overlap the ring currently starts with, and where it starts in it
+        var retainedWindow: Long = -1
+        var retainedFrom: Int = 0
+
+        fun addSpeech(chunk: ByteArray) {
+            activeSpeech.append(chunk)
+            totalProcessedBytes += chunk.size
+        }
+
+        fun addSilence(chunk: ByteArray) {
+            activeSpeech.append(chunk)
+            totalProcessedBytes += chunk.size
+        }
+
+        fun clear() {
+            activeSpeech.clear()
             totalProcessedBytes = 0
-        )
+            retainedWindow = -1
+        }
     }
 
     // Audio chunk wrapper for channel communication
     private sealed class AudioChunk {
-        data class Data(val bytes: ByteArray) : AudioChunk()
+        // pooled: recorder buffer behind bytes, returned to its pool once the chunk is consumed
+        class Data(val bytes: ByteArray, val receivedAt: Long, val pooled: PooledAudioBuffer? = null) : AudioChunk() {
+            fun recycle() {
+                pooled?.recycle()
+            }
+        }
         object Stop : AudioChunk() // Sentinel object (replaces Python STOP_SIGNAL)
     }
 
@@ -138,7 +234,17 @@ class AudioProcessor(
         overlapDurationSec = config.audio.overlapDurationSec
         maxChunkBytes = (maxChunkDurationSec * sampleRate * 2).toInt()
         overlapBytes = (overlapDurationSec * sampleRate * 2).toInt().coerceAtMost(maxChunkBytes / 2)
+        chunkScheduler.limits = ChunkLimits(minAudioLengthBytes, maxChunkBytes, (silenceDurationSec * 1000).toLong())
         minChunkSizeBytes = config.transcription.minChunkSizeBytes
+        partialResultsEnabled = config.transcription.partialResults
+        partialIntervalBytes = (config.transcription.partialIntervalMs * sampleRate * 2 / 1000).toInt()
+        timestampStitching = config.transcription.timestamps
+        timestampOverlapSec = config.audio.timestampOverlapSec
+        promptTokenBudget = if (config.transcription.promptCarryover) config.transcription.promptMaxTokens else 0
+        maxQueuedChunks = (config.audio.maxQueuedAudioSec * sampleRate * 2 / config.audio.chunkSize).toInt().coerceAtLeast(1)
+        if (latencyScheduler.budgetMs != config.audio.latencyBudgetMs) {
+            latencyScheduler = LatencyScheduler(config.audio.latencyBudgetMs)
+        }
 
         Log.i(TAG, "Config updated: VAD=${if (enableVAD) "on" else "off"}, SilenceDur=${silenceDurationSec}s, MaxChunk=${maxChunkDurationSec}s (${maxChunkBytes} bytes), Overlap=${overlapDurationSec}s (${overlapBytes} bytes)")
     }
@@ -155,8 +261,12 @@ class AudioProcessor(
     /**
      * Start the audio processing pipeline (matching desktop start method)
      * FIXED: Now ensures VAD is fully initialized before starting
+     *
+     * @param realtime True for live capture: a full audio queue drops its oldest chunk and the
+     *   latency scheduler may degrade processing. False (e.g. file input) makes [addAudio]
+     *   wait for room instead, so every sample is transcribed at full quality.
      */
-    suspend fun start(): Boolean {
+    suspend fun start(realtime: Boolean = true): Boolean {
         if (isRunning.getAndSet(true)) {
             Log.w(TAG, "AudioProcessor already running")
             return false
@@ -170,11 +280,26 @@ class AudioProcessor(
 
         // Reset timing and VAD buffer
         lastAudioTime.set(System.currentTimeMillis())
-        vadFrameBuffer = ByteArray(0) // Clear any leftover frames from previous session
+        sileroVAD?.resetStream() // Clear any leftover frame and RNN state from previous session
+        pendingWindows.set(0)
+        partialInFlight.set(false)
+        lastPartialBytes = 0
+        deliveredContext = IntArray(0)
+        localAgreement.reset()
+        overlapCut.set(null)
+        this.realtime = realtime
+        latencyScheduler.reset()
+        queuedChunks.set(0)
+        droppedChunks.set(0)
+        chunkLagMs = 0L
+        windowQueuedAt.clear()
 
         // Create processing scope and channel
         processingScope = CoroutineScope(Dispatchers.Default + SupervisorJob())
-        audioChannel = Channel(capacity = Channel.UNLIMITED)
+        audioChannel = Channel(capacity = maxQueuedChunks)
+
+        // Start the transcription pipeline before the worker that feeds it
+        startTranscriptionPipeline(processingScope!!)
 
         // Start the worker coroutine (replaces Python worker thread)
         processingJob = processingScope!!.launch {
@@ -201,6 +326,11 @@ class AudioProcessor(
         // Wait for processing to finish
         processingJob?.join()
 
+        // Drain the transcription pipeline so queued windows still produce results
+        encodeChannel?.close()
+        encoderJob?.join()
+        decoderJob?.join()
+
         // Clean up
         audioChannel?.close()
         processingScope?.cancel()
@@ -211,22 +341,118 @@ class AudioProcessor(
 
     /**
      * Add audio data to the processing pipeline (matching desktop add_audio method)
+     *
+     * In realtime mode this never suspends: when the queue is full the oldest chunk is
+     * dropped, so a stalled pipeline costs at most maxQueuedAudioSec of memory and the
+     * recorder is never blocked.
      */
     suspend fun addAudio(data: ByteArray) {
-        if (isRunning.get() && data.isNotEmpty()) {
-            audioChannel?.send(AudioChunk.Data(data))
-            lastAudioTime.set(System.currentTimeMillis())
+        if (!isRunning.get() || data.isEmpty()) return
+        enqueue(data, null)
+    }
+
+    /**
+     * Add a pooled recorder chunk; it is recycled once processed or dropped
+     */
+    suspend fun addAudio(buffer: PooledAudioBuffer) {
+        if (!isRunning.get() || buffer.length == 0) {
+            buffer.recycle()
+            return
+        }
+        if (buffer.length == buffer.data.size) {
+            enqueue(buffer.data, buffer) // Recorder reads fill the buffer, so no copy
+        } else {
+            val bytes = buffer.toByteArray()
+            buffer.recycle()
+            enqueue(bytes, null)
+        }
+    }
+
+    private suspend fun enqueue(data: ByteArray, pooled: PooledAudioBuffer?) {
+        val channel = audioChannel
+        if (channel == null) {
+            pooled?.recycle()
+            return
+        }
+        val now = System.currentTimeMillis()
+        val chunk = AudioChunk.Data(data, now, pooled)
+
+        queuedChunks.incrementAndGet()
+        if (!realtime) {
+            channel.send(chunk)
+        } else if (!channel.trySend(chunk).isSuccess) {
+            when (val oldest = channel.tryReceive().getOrNull()) {
+                is AudioChunk.Data -> {
+                    oldest.recycle()
+                    queuedChunks.decrementAndGet()
+                    if (droppedChunks.incrementAndGet() == 1L) {
+                        Log.w(TAG, "Audio queue full (${maxQueuedChunks} chunks), dropping oldest audio")
+                    }
+                }
+                AudioChunk.Stop -> channel.trySend(oldest) // Stopping; keep the sentinel
+                null -> Unit
+            }
+            if (!channel.trySend(chunk).isSuccess) {
+                chunk.recycle()
+                queuedChunks.decrementAndGet()
+                droppedChunks.incrementAndGet()
+            }
         }
+        lastAudioTime.set(now)
     }
 
+    /**
+     * Current backpressure metrics of the live audio path
+     */
+    fun getLatencyStats(): LatencyStats {
+        val scheduler = latencyScheduler
+        return LatencyStats(
+            queuedChunks = queuedChunks.get().coerceAtLeast(0),
+            queuedWindows = windowQueuedAt.size,
+            audioLagMs = audioLagMs(System.currentTimeMillis()),
+            budgetMs = scheduler.budgetMs,
+            level = scheduler.level,
+            droppedChunks = droppedChunks.get()
+        )
+    }
+
+    /**
+     * Queuing delay: the longer of the last chunk's wait for the worker loop and the
+     * oldest flushed window's wait for the encoder
+     */
+    private fun audioLagMs(now: Long): Long {
+        val windowWait = windowQueuedAt.peek()?.let { now - it } ?: 0L
+        return max(chunkLagMs, windowWait)
+    }
+
+    /**
+     * Feed the current lag to the scheduler and request a smaller tier if it says so
+     */
+    private fun updateLatencySchedule() {
+        if (!realtime) return
+        val scheduler = latencyScheduler
+        val now = System.currentTimeMillis()
+        val lag = audioLagMs(now)
+        val previous = scheduler.level
+        val switchTier = scheduler.update(lag, now)
+        if (scheduler.level != previous) {
+            Log.i(TAG, "Latency ${lag}ms (budget ${scheduler.budgetMs}ms): ${previous.name} -> ${scheduler.level.name}")
+        }
+        if (switchTier) {
+            onOverload?.invoke()
+        }
+    }
+
+    // Overlap actually kept between windows; halved once the scheduler sheds load
+    private fun overlapScale(): Float =
+        if (latencyScheduler.level >= LatencyScheduler.Level.SHRINK_OVERLAP) 0.5f else 1.0f
+
     /**
      * Determine if audio chunk is silent using VAD (matching desktop _is_silent method)
-     * FIXED: Now buffers incomplete frames instead of discarding them
      *
-     * This ensures:
-     * - Zero data loss at chunk boundaries
-     * - Proper VAD frame alignment (960 bytes)
-     * - Accurate speech detection across arbitrary chunk sizes
+     * SileroVAD streams the audio in exact model windows and carries incomplete windows
+     * over to the next call, so chunk boundaries lose no audio. Every window is analyzed
+     * to keep the recurrent state continuous.
      */
     suspend fun isSilent(audioData: ByteArray): Boolean {
         if (!enableVAD) {
@@ -239,41 +465,34 @@ class AudioProcessor(
             return false
         }
 
-        // VAD expects ~30ms frames (480 samples at 16kHz = 960 bytes)
-        val vadFrameSize = vad.getFrameSizeBytes()
-
-        // Combine buffered leftover bytes with new audio data
-        val combined = vadFrameBuffer + audioData
-
-        // If combined data is still too small for one frame, buffer it and assume speech
-        // This prevents losing the first word when audio chunks are smaller than VAD frame size
-        if (combined.size < vadFrameSize) {
-            vadFrameBuffer = combined
-            return false // Assume speech until we have enough data to make a proper decision
-        }
-
-        // Process all complete VAD frames
-        var hasSpeech = false
-        var offset = 0
+        return vad.isSilent(audioData)
+    }
 
-        while (offset + vadFrameSize <= combined.size) {
-            val frameBytes = combined.sliceArray(offset until offset + vadFrameSize)
-            val isFrameSilent = vad.isSilent(frameBytes)
-            if (!isFrameSilent) {
-                hasSpeech = true
-                break // Early exit on first speech detection
-            }
-            offset += vadFrameSize
+    /**
+     * Silence flag per frame of a complete recording, from the VAD in a single pass
+     *
+     * Used by offline transcription (see [FileTranscriber]); the processor must not be running.
+     *
+     * @return null if VAD is disabled or could not be initialized
+     */
+    suspend fun classifySilence(pcm: ByteBuffer, frameBytes: Int): BooleanArray? {
+        if (!enableVAD) return null
+        if (sileroVAD?.isInitialized() != true) {
+            initializeVAD()
         }
-
-        // ✅ FIXED: Buffer remaining incomplete frame bytes for next call
-        vadFrameBuffer = if (offset < combined.size) {
-            combined.sliceArray(offset until combined.size)
-        } else {
-            ByteArray(0) // All frames processed cleanly
+        val vad = sileroVAD?.takeIf { it.isInitialized() } ?: return null
+
+        vad.resetStream()
+        val total = pcm.limit()
+        val silent = BooleanArray((total + frameBytes - 1) / frameBytes)
+        for (i in silent.indices) {
+            val start = i * frameBytes
+            val frame = ByteArray(minOf(frameBytes, total - start))
+            FileTranscriber.copyRange(pcm, start, frame)
+            silent[i] = vad.isSilent(frame)
         }
-
-        return !hasSpeech // Return true if silent (i.e., not speech)
+        vad.resetStream()
+        return silent
     }
 
     /**
@@ -282,7 +501,9 @@ class AudioProcessor(
     private suspend fun workerLoop() {
         Log.i(TAG, "AudioProcessor worker loop started")
 
-        var bufferState = BufferState()
+        // Room for a full window plus the chunk that pushes it over the limit
+        val bufferState = BufferState(maxChunkBytes + 2 * config.audio.chunkSize)
+        chunkScheduler.reset(System.currentTimeMillis())
 
         try {
             while (isRunning.get()) {
@@ -291,27 +512,44 @@ class AudioProcessor(
                     audioChannel?.receive()
                 }
 
+                if (chunk is AudioChunk.Data) {
+                    queuedChunks.decrementAndGet()
+                    chunkLagMs = System.currentTimeMillis() - chunk.receivedAt
+                } else if (chunk == null) {
+                    chunkLagMs = 0L // Nothing was waiting
+                }
+                updateLatencySchedule()
+
                 when (chunk) {
                     is AudioChunk.Stop -> {
                         Log.d(TAG, "Stop signal received in worker loop")
                         // Process any remaining data before stopping (matching desktop behavior)
-                        if (bufferState.activeSpeechBuffer.size >= minChunkSizeBytes) {
-                            Log.i(TAG, "Processing final remaining buffer chunk (${bufferState.activeSpeechBuffer.size} bytes) before stopping")
-                            processAudioBuffer(bufferState.activeSpeechBuffer)
+                        applyOverlapCut(bufferState)
+                        if (bufferState.activeSpeech.size >= minChunkSizeBytes) {
+                            Log.i(TAG, "Processing final remaining buffer chunk (${bufferState.activeSpeech.size} bytes) before stopping")
+                            processAudioBuffer(bufferState.activeSpeech.toByteArray(), capturedAt = bufferState.capturedAt)
                         }
                         break
                     }
 
                     is AudioChunk.Data -> {
-                        bufferState = processAudioChunk(bufferState, chunk.bytes)
+                        applyOverlapCut(bufferState)
+                        bufferState.capturedAt = chunk.receivedAt
+                        try {
+                            processAudioChunk(bufferState, chunk.bytes)
+                        } finally {
+                            chunk.recycle() // VAD and the window ring copy what they keep
+                        }
+                        maybeStartPartial(bufferState)
                     }
 
                     null -> {
                         // Timeout occurred - check for inactivity processing (matching desktop timeout logic)
-                        if (bufferState.activeSpeechBuffer.size >= minAudioLengthBytes && !hasRecentAudio()) {
-                            Log.i(TAG, "Processing chunk: ${bufferState.activeSpeechBuffer.size} bytes (timeout)")
-                            processAudioBuffer(bufferState.activeSpeechBuffer)
-                            bufferState = bufferState.cleared()
+                        applyOverlapCut(bufferState)
+                        if (chunkScheduler.flushOnIdle(bufferState.activeSpeech.size, hasRecentAudio())) {
+                            Log.i(TAG, "Processing chunk: ${bufferState.activeSpeech.size} bytes (timeout)")
+                            processAudioBuffer(bufferState.activeSpeech.toByteArray(), capturedAt = bufferState.capturedAt)
+                            bufferState.clear()
                         }
                     }
                 }
@@ -325,129 +563,352 @@ class AudioProcessor(
 
     /**
      * Process a single audio chunk with VAD and buffering logic (extracted from desktop _worker_loop)
+     *
+     * Updates [state] in place; windows are copied out of the ring only when flushed.
      */
-    private suspend fun processAudioChunk(currentState: BufferState, audioChunk: ByteArray): BufferState {
-        if (audioChunk.isEmpty()) return currentState
+    private suspend fun processAudioChunk(state: BufferState, audioChunk: ByteArray) {
+        if (audioChunk.isEmpty()) return
 
         try {
             // Check VAD on the incoming chunk (matching desktop logic)
-            val isChunkSilent = isSilent(audioChunk)
-            val currentTime = System.currentTimeMillis()
-            val timeSinceLastSpeech = (currentTime - currentState.lastSpeechTime) / 1000.0
+            val isChunkSilent = trace.span(TraceStage.VAD) { isSilent(audioChunk) }
+            val buffer = state.activeSpeech
 
             // PERFORMANCE: Minimal logging in hot path - only log major events
-
-            return if (!isChunkSilent) {
-                // Speech detected - use streaming optimization
-                val newState = currentState.withSpeechAdded(audioChunk)
-
-                // Process if buffer exceeds max duration/size (matching desktop logic)
-                if (newState.activeSpeechBuffer.size >= maxChunkBytes) {
-                    // PERFORMANCE: Reduced logging - only log when processing
-                    Log.i(TAG, "Processing chunk: ${newState.activeSpeechBuffer.size} bytes (max size)")
-                    processAudioBuffer(newState.activeSpeechBuffer.copyOfRange(0, maxChunkBytes))
-                    retainOverlapWindow(newState, maxChunkBytes)
-                } else {
-                    newState
+            val action = chunkScheduler.onChunk(
+                silent = isChunkSilent,
+                bufferedBytes = buffer.size,
+                chunkBytes = audioChunk.size,
+                nowMs = System.currentTimeMillis(),
+                keepSilence = latencyScheduler.level < LatencyScheduler.Level.DROP_SILENCE
+            )
+            when (action) {
+                ChunkScheduler.Action.IGNORE -> Unit // No buffered speech, or silence dropped under load
+
+                ChunkScheduler.Action.APPEND, ChunkScheduler.Action.APPEND_AND_FLUSH -> {
+                    // Speech, or some silence after it (helps context)
+                    if (isChunkSilent) state.addSilence(audioChunk) else state.addSpeech(audioChunk)
+                    if (action == ChunkScheduler.Action.APPEND_AND_FLUSH) {
+                        Log.i(TAG, "Processing chunk: ${buffer.size} bytes (max size${if (isChunkSilent) " silence" else ""})")
+                        flushWithOverlap(state)
+                    }
                 }
-            } else {
-                // Silence detected - still process accumulated speech if significant
-                if (currentState.activeSpeechBuffer.size >= minAudioLengthBytes &&
-                    timeSinceLastSpeech >= silenceDurationSec) {
+
+                ChunkScheduler.Action.FLUSH -> {
                     // Process buffer due to silence after speech
-                    Log.i(TAG, "Processing chunk: ${currentState.activeSpeechBuffer.size} bytes (silence)")
-                    processAudioBuffer(currentState.activeSpeechBuffer)
-                    currentState.cleared()
-                } else if (currentState.activeSpeechBuffer.isNotEmpty()) {
-                    // Buffer some silence if speech just ended (helps context)
-                    val newState = currentState.withSilenceAdded(audioChunk)
-
-                    // Process if silence makes buffer exceed max size (matching desktop logic)
-                    if (newState.activeSpeechBuffer.size >= maxChunkBytes) {
-                        Log.i(TAG, "Processing chunk: ${newState.activeSpeechBuffer.size} bytes (max size silence)")
-                        processAudioBuffer(newState.activeSpeechBuffer.copyOfRange(0, maxChunkBytes))
-                        retainOverlapWindow(newState, maxChunkBytes)
-                    } else {
-                        newState
-                    }
-                } else {
-                    currentState // No buffered speech, ignore silence
+                    Log.i(TAG, "Processing chunk: ${buffer.size} bytes (silence)")
+                    processAudioBuffer(buffer.toByteArray(), capturedAt = state.capturedAt)
+                    state.clear()
                 }
             }
         } catch (e: Exception) {
             Log.e(TAG, "Error processing audio chunk: ${e.message}", e)
-            return currentState.cleared() // Clear buffer on error to prevent reprocessing bad data
+            state.clear() // Clear buffer on error to prevent reprocessing bad data
         }
     }
 
-    private fun retainOverlapWindow(state: BufferState, processedBytes: Int): BufferState {
-        val buffer = state.activeSpeechBuffer
+    /**
+     * Flush the first maxChunkBytes of the window and keep the overlap tail
+     */
+    private suspend fun flushWithOverlap(state: BufferState) {
+        // Whole samples
+        val overlap = (overlapBytes * overlapScale()).toInt() and 1.inv()
+        val overlapStart = if (overlap > 0) {
+            max(0, maxChunkBytes - overlap)
+        } else {
+            maxChunkBytes
+        }
+        val sequence = processAudioBuffer(state.activeSpeech.toByteArray(0, maxChunkBytes), overlapStart, state.capturedAt)
+        retainOverlapWindow(state, overlapStart, sequence)
+    }
+
+    /**
+     * Drop the flushed part of the window, keeping the overlap tail (no copy)
+     */
+    private fun retainOverlapWindow(state: BufferState, overlapStart: Int, sequence: Long) {
+        val buffer = state.activeSpeech
         if (buffer.isEmpty()) {
-            return state.cleared()
+            state.clear()
+            return
         }
 
-        val overlapStart = if (overlapBytes > 0) {
-            max(0, processedBytes - overlapBytes)
-        } else {
-            processedBytes
+        buffer.discard(overlapStart.coerceAtMost(buffer.size))
+        state.totalProcessedBytes = buffer.size
+        state.retainedWindow = sequence
+        state.retainedFrom = overlapStart
+    }
+
+    /**
+     * Trim the retained overlap to the cut published for its window, if it has arrived.
+     *
+     * Until then the whole overlap stays, so a late result only costs the text-based
+     * deduplication in [TextProcessor] that is used without timestamps.
+     */
+    private fun applyOverlapCut(state: BufferState) {
+        val cut = overlapCut.get() ?: return
+        if (cut.sequence != state.retainedWindow) return
+        overlapCut.compareAndSet(cut, null)
+        state.retainedWindow = -1
+
+        val drop = (cut.cutBytes - state.retainedFrom).coerceIn(0, state.activeSpeech.size)
+        if (drop == 0) return
+        state.activeSpeech.discard(drop)
+        state.totalProcessedBytes = state.activeSpeech.size
+        lastPartialBytes = 0
+
+        // The window now starts elsewhere, so earlier partial hypotheses no longer apply
+        synchronized(localAgreement) {
+            windowGeneration.incrementAndGet()
+            localAgreement.reset()
         }
-        val retained = if (overlapStart < buffer.size) {
-            buffer.copyOfRange(overlapStart, buffer.size)
-        } else {
-            ByteArray(0)
+        Log.d(TAG, "Overlap cut at segment boundary: dropped ${drop} of ${drop + state.activeSpeech.size} retained bytes")
+    }
+
+    /**
+     * Cut a max-size window at a segment boundary using its timestamps.
+     *
+     * A last segment that reaches the window end was probably cut off mid-word. If it lies
+     * within the retained overlap, its text is dropped here and the next window starts at
+     * its beginning, so it is transcribed once and whole. Otherwise the next window starts
+     * after the last complete segment, or keeps only timestampOverlapSec when no boundary
+     * is usable.
+     */
+    private fun stitchWindow(window: QueuedWindow, result: TranscriptionResult): TranscriptionResult {
+        if (!timestampStitching || window.retainedFrom < 0) return result
+
+        val bytesPerSec = sampleRate * 2f
+        val windowSec = window.audio.size / bytesPerSec
+        val retainedSec = window.retainedFrom / bytesPerSec
+        val segments = result.segments
+        val last = segments.lastOrNull()
+
+        var kept = segments
+        val fallbackOverlapSec = timestampOverlapSec * overlapScale()
+        val cutSec = when {
+            last == null -> windowSec - fallbackOverlapSec
+            last.endTime < windowSec - SEGMENT_END_MARGIN_SEC -> last.endTime
+            last.startTime >= retainedSec -> {
+                kept = segments.dropLast(1)
+                last.startTime
+            }
+            else -> windowSec - fallbackOverlapSec
         }
+        // Whole samples, never before the retained overlap or past the window end
+        val cutBytes = (cutSec.coerceIn(retainedSec, windowSec) * sampleRate).toInt() * 2
+        overlapCut.set(OverlapCut(window.sequence, cutBytes))
 
-        return state.copy(
-            activeSpeechBuffer = retained,
-            totalProcessedBytes = retained.size
-        )
+        if (kept.size == segments.size) return result
+        Log.d(TAG, "Deferring last segment (${"%.2f".format(last!!.startTime)}s-${"%.2f".format(last.endTime)}s) to the next window")
+        return result.copy(text = kept.joinToString(" ") { it.text }, segments = kept, tokens = kept.flatMap { it.tokens })
+    }
+
+    /**
+     * Launch the encoder and decoder stages.
+     *
+     * The decode channel is a rendezvous: the encoder finishes chunk N+1 while chunk N
+     * decodes, then waits, so at most two encoder KV caches are alive at once.
+     */
+    private fun startTranscriptionPipeline(scope: CoroutineScope) {
+        val encodeQueue = Channel<QueuedWindow>(capacity = ENCODE_QUEUE_CAPACITY)
+        val decodeQueue = Channel<EncodedWindow>(capacity = Channel.RENDEZVOUS)
+        encodeChannel = encodeQueue
+        decodeChannel = decodeQueue
+
+        encoderJob = scope.launch {
+            try {
+                for (window in encodeQueue) {
+                    windowQueuedAt.poll()
+                    trace.end(TraceStage.QUEUE, window.queuedAtNs, window.cookie)
+                    val engine = whisperEngine
+                    val encoded = try {
+                        trace.span(TraceStage.ENCODE, window.cookie) { engine.encode(window.audio) }
+                    } catch (e: Exception) {
+                        Log.e(TAG, "Error during encoder stage: ${e.message}", e)
+                        null // Skipped by the decoder, after the window before it
+                    }
+                    try {
+                        decodeQueue.send(EncodedWindow(window, encoded, engine))
+                    } catch (e: Exception) {
+                        // The decoder is gone, so nothing older can still complete after this
+                        encoded?.close()
+                        completedSequence.updateAndGet { maxOf(it, window.sequence) }
+                        pendingWindows.decrementAndGet()
+                        throw e
+                    }
+                }
+            } finally {
+                decodeQueue.close()
+            }
+        }
+
+        decoderJob = scope.launch {
+            // Tail of the delivered transcript; windows decode in order, so only this stage touches it
+            var promptContext = IntArray(0)
+            for (item in decodeQueue) {
+                val window = item.window
+                val encoded = item.encoded
+                try {
+                    if (encoded == null) continue // Encoder failed; only record it as done
+                    val decoded = trace.span(TraceStage.DECODE, window.cookie) { item.engine.decode(encoded, promptContext) }
+                    val result = if (timestampStitching && window.retainedFrom >= 0) {
+                        trace.span(TraceStage.STITCH, window.cookie) { stitchWindow(window, decoded) }
+                    } else {
+                        decoded
+                    }
+                    if (deliverResult(result)) {
+                        promptContext = nextPromptContext(promptContext, result)
+                        deliveredContext = promptContext
+                        trace.record(TraceStage.END_TO_END, (System.currentTimeMillis() - window.capturedAt) * 1_000_000L)
+                    }
+                } catch (e: Exception) {
+                    Log.e(TAG, "Error during transcription call: ${e.message}", e)
+                } finally {
+                    completedSequence.set(window.sequence)
+                    pendingWindows.decrementAndGet()
+                }
+            }
+        }
     }
 
     /**
      * Process a complete buffer of audio data (port of desktop _process_audio_buffer method)
+     *
+     * Hands the window to the encoder stage; suspends only when the bounded queue is full.
+     *
+     * @param retainedFrom Offset where the overlap kept for the next window starts, or -1
+     * @param capturedAt Receive time of the window's newest audio, for end-to-end latency
+     * @return Sequence number of the queued window, or -1 if it was not queued
      */
-    private suspend fun processAudioBuffer(audioData: ByteArray) {
+    private suspend fun processAudioBuffer(
+        audioData: ByteArray,
+        retainedFrom: Int = -1,
+        capturedAt: Long = System.currentTimeMillis()
+    ): Long {
         val bufferLen = audioData.size
         if (bufferLen < minChunkSizeBytes) {
             Log.d(TAG, "Skipping transcription for small buffer chunk ($bufferLen bytes < $minChunkSizeBytes min bytes)")
-            return
+            return -1
         }
 
         Log.i(TAG, "Sending buffer chunk (${"%.1f".format(bufferLen / 1024.0)} KB) to transcription engine")
 
-        try {
-            // Transcribe the audio (matching desktop transcription call)
-            val result = whisperEngine.transcribe(audioData)
+        val queue = encodeChannel
+        if (queue == null) {
+            Log.w(TAG, "Transcription pipeline not running, dropping chunk")
+            return -1
+        }
+
+        // The final result replaces any partial hypothesis for this window
+        synchronized(localAgreement) {
+            windowGeneration.incrementAndGet()
+            localAgreement.reset()
+        }
+        lastPartialBytes = 0
+
+        val sequence = windowSequence.incrementAndGet()
+        pendingWindows.incrementAndGet()
+        windowQueuedAt.add(System.currentTimeMillis())
+        val queuedAtNs = trace.begin(TraceStage.QUEUE, sequence.toInt())
+        queue.send(QueuedWindow(audioData, sequence, retainedFrom, capturedAt, queuedAtNs))
+        return sequence
+    }
+
+    /**
+     * Start a speculative decode of the window still being recorded, if one is due.
+     *
+     * Runs at most one partial at a time and only once the window has grown by
+     * partialIntervalMs of audio since the last one, so a slow device simply gets fewer
+     * partials instead of a backlog. A partial never starts while a flushed window is
+     * pending, and the decode lock is fair, so it delays a final result by at most one decode.
+     *
+     * Each partial re-encodes and re-decodes the whole growing window, with the delivered
+     * transcript tail as <|startofprev|> context like the final decode. The committed
+     * [LocalAgreement] words are deliberately not forced as a decoder prefix: the decoder
+     * feeds the prompt one step per token, so a forced prefix costs the same steps as
+     * generating it. It would also need the word-level agreement mapped back to tokens,
+     * and it would bypass the first-step timestamp rules.
+     */
+    private fun maybeStartPartial(state: BufferState) {
+        val callback = onPartialResult ?: return
+        if (!partialResultsEnabled) return
+
+        val bufferedBytes = state.activeSpeech.size
+        if (bufferedBytes < minChunkSizeBytes || bufferedBytes - lastPartialBytes < partialIntervalBytes) return
+        if (pendingWindows.get() > 0 || !partialInFlight.compareAndSet(false, true)) return
+
+        lastPartialBytes = bufferedBytes
+        val generation = windowGeneration.get()
+        val scope = processingScope
+        if (scope == null) {
+            partialInFlight.set(false)
+            return
+        }
+
+        // Snapshot: the ring keeps changing while the partial decodes
+        val audio = state.activeSpeech.toByteArray()
+        val engine = whisperEngine
+        scope.launch {
+            try {
+                val result = engine.decode(engine.encode(audio), deliveredContext)
+                val text = textProcessor.filterHallucinations(result.text.trim())
+                if (text.isEmpty()) return@launch
+
+                val partial = synchronized(localAgreement) {
+                    if (generation != windowGeneration.get()) null else localAgreement.update(text)
+                } ?: return@launch
+
+                Log.d(TAG, "Partial (${result.processingTimeMs}ms): committed=${partial.committed.length} tentative=${partial.tentative.length} chars")
+                callback(partial)
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                Log.w(TAG, "Partial decode failed: ${e.message}")
+            } finally {
+                partialInFlight.set(false)
+            }
+        }
+    }
 
-            // Check if the result contains meaningful text
-            val text = result.text.trim()
+    /**
+     * Append a delivered window's tokens to the prompt context, keeping the newest
+     * promptTokenBudget (0 disables carry-over)
+     */
+    private fun nextPromptContext(context: IntArray, result: TranscriptionResult): IntArray =
+        PromptCarryover.next(context, result.tokens, promptTokenBudget)
 
-            if (text.isNotEmpty()) {
-                Log.d(TAG, "AudioProcessor received transcription result: '${text.take(50)}...'")
+    /**
+     * Filter a decoded result and deliver it in chunk order
+     *
+     * @return Whether text was delivered (hallucinations and empty results are not)
+     */
+    private fun deliverResult(result: TranscriptionResult): Boolean {
+        // Check if the result contains meaningful text
+        val text = result.text.trim()
 
-                // Apply text processing (hallucination filtering, etc.)
-                val filteredText = textProcessor.filterHallucinations(text)
+        if (text.isNotEmpty()) {
+            Log.d(TAG, "AudioProcessor received transcription result: '${text.take(50)}...'")
 
-                if (filteredText.isNotEmpty()) {
-                    // Create final result with filtered text
-                    val finalResult = result.copy(text = filteredText)
+            // Apply text processing (hallucination filtering, etc.)
+            val filteredText = textProcessor.filterHallucinations(text)
 
-                    // Send the processed result via callback
-                    try {
-                        onResult(finalResult)
-                    } catch (e: Exception) {
-                        Log.e(TAG, "Error in onResult callback: ${e.message}", e)
-                    }
-                } else {
-                    Log.d(TAG, "Text was filtered out as hallucination")
+            if (filteredText.isNotEmpty()) {
+                // Create final result with filtered text
+                val finalResult = result.copy(text = filteredText)
+
+                // Send the processed result via callback
+                try {
+                    onResult(finalResult)
+                } catch (e: Exception) {
+                    Log.e(TAG, "Error in onResult callback: ${e.message}", e)
                 }
+                return true
             } else {
-                Log.d(TAG, "AudioProcessor received empty transcription result")
+                Log.d(TAG, "Text was filtered out as hallucination")
             }
-
-        } catch (e: Exception) {
-            Log.e(TAG, "Error during transcription call: ${e.message}", e)
+        } else {
+            Log.d(TAG, "AudioProcessor received empty transcription result")
         }
+        return false
     }
 
     /**
@@ -464,6 +925,24 @@ class AudioProcessor(
         updateConfigurationValues()
     }
 
+    /**
+     * Switch to another initialized engine (a different model tier) between windows.
+     *
+     * Windows encoded from now on use [engine]; windows the current engine has already
+     * taken finish on it, in order. Suspends until they and any running partial are done,
+     * so the returned engine is idle and can be released.
+     */
+    suspend fun swapEngine(engine: WhisperEngine): WhisperEngine {
+        val previous = whisperEngine
+        whisperEngine = engine
+        val lastQueued = windowSequence.get()
+        while (completedSequence.get() < lastQueued && decoderJob?.isActive == true || partialInFlight.get()) {
+            delay(QUEUE_TIMEOUT_MS)
+        }
+        Log.i(TAG, "Switched transcription engine to ${engine.manifest.tier}")
+        return previous
+    }
+
     /**
      * Get current processing status
      */
@@ -471,6 +950,7 @@ class AudioProcessor(
     suspend fun close() {
         stop() // Signal the processor to stop
         sileroVAD?.close() // Clean up VAD resources
+        chunkScheduler.close() // Worker has stopped; free the native scheduler
         Log.d(TAG, "AudioProcessor closed")
     }
 }
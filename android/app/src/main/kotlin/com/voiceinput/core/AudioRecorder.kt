@@ -10,22 +10,31 @@ import kotlinx.coroutines.flow.flow
 import kotlinx.coroutines.flow.flowOn
 import kotlinx.coroutines.isActive
 import kotlinx.coroutines.withContext
+import java.io.File
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
+import java.nio.FloatBuffer
+import kotlin.math.abs
+import kotlin.math.sqrt
 import kotlin.coroutines.coroutineContext
 
 /**
  * Handles audio recording for voice input
  * Port of desktop/voice_input_service/core/audio.py AudioRecorder
  *
+ * Chunks come from an [AudioBufferPool] and are not kept by the recorder. The whole
+ * session is only recorded when [captureFile] is set, and then spills to that file.
+ *
  * @param sampleRate Audio sample rate in Hz (16000 for Whisper)
  * @param chunkSize Number of bytes per buffer chunk
  * @param channels Number of audio channels (1=mono)
+ * @param captureFile Where to record the session for [capturedAudio]; null = no capture
  */
 class AudioRecorder(
     private val sampleRate: Int = 16000,
     private val chunkSize: Int = 960,  // Align with VAD frame size to prevent first word loss
-    private val channels: Int = 1
+    private val channels: Int = 1,
+    captureFile: File? = null
 ) {
 
     companion object {
@@ -37,8 +46,9 @@ class AudioRecorder(
     }
 
     private var audioRecord: AudioRecord? = null
-    private var isRecording = false
-    private val audioData = mutableListOf<ByteArray>()
+    @Volatile private var isRecording = false
+    private val bufferPool = AudioBufferPool(chunkSize)
+    private val capture = captureFile?.let { SessionCapture(it) }
     private val lock = Any()
 
     /**
@@ -117,7 +127,7 @@ class AudioRecorder(
 
         return try {
             synchronized(lock) {
-                audioData.clear()
+                capture?.reset()
             }
 
             audioRecord?.startRecording()
@@ -132,60 +142,55 @@ class AudioRecorder(
     }
 
     /**
-     * Stop recording audio
-     * @return Recorded audio data as ByteArray
+     * Stop recording audio; a session capture stays readable through [capturedAudio]
      */
-    fun stop(): ByteArray {
-        if (!isRecording) {
-            return synchronized(lock) {
-                concatenateAudioData()
+    fun stop() {
+        if (isRecording) {
+            try {
+                audioRecord?.stop()
+                isRecording = false
+                Log.i(TAG, "Recording stopped")
+            } catch (e: Exception) {
+                Log.e(TAG, "Error stopping recording", e)
             }
         }
 
-        try {
-            audioRecord?.stop()
-            isRecording = false
-            Log.i(TAG, "Recording stopped")
-        } catch (e: Exception) {
-            Log.e(TAG, "Error stopping recording", e)
-        }
-
-        return synchronized(lock) {
-            concatenateAudioData()
+        synchronized(lock) {
+            capture?.close()
         }
     }
 
     /**
      * Get audio stream as Flow for real-time processing
-     * Emits audio chunks as they're recorded
+     * Emits pooled chunks as they're recorded; the collector must [PooledAudioBuffer.recycle]
+     * each chunk once it is done with it (chunks it drops are simply garbage collected)
      */
-    fun audioStream(): Flow<ByteArray> = flow {
+    fun audioStream(): Flow<PooledAudioBuffer> = flow {
         if (!isRecording) {
             Log.w(TAG, "Not recording, cannot stream audio")
             return@flow
         }
 
-        val buffer = ByteArray(chunkSize)
         val record = audioRecord ?: return@flow
 
         while (coroutineContext.isActive && isRecording) {
+            val buffer = bufferPool.acquire()
             val bytesRead = withContext(Dispatchers.IO) {
-                record.read(buffer, 0, buffer.size)
+                record.read(buffer.data, 0, buffer.data.size)
             }
 
             if (bytesRead > 0) {
-                val chunk = buffer.copyOf(bytesRead)
-
-                // Store for later retrieval
-                synchronized(lock) {
-                    audioData.add(chunk)
-                }
+                buffer.length = bytesRead
+                captureChunk(buffer.data, bytesRead)
 
                 // Emit for real-time processing
-                emit(chunk)
-            } else if (bytesRead < 0) {
-                Log.e(TAG, "AudioRecord read error: $bytesRead")
-                break
+                emit(buffer)
+            } else {
+                buffer.recycle()
+                if (bytesRead < 0) {
+                    Log.e(TAG, "AudioRecord read error: $bytesRead")
+                    break
+                }
             }
         }
     }.flowOn(Dispatchers.IO)
@@ -204,28 +209,46 @@ class AudioRecorder(
         val bytesRead = record.read(buffer, 0, buffer.size)
 
         if (bytesRead > 0) {
-            val chunk = buffer.copyOf(bytesRead)
-            synchronized(lock) {
-                audioData.add(chunk)
-            }
-            chunk
+            captureChunk(buffer, bytesRead)
+            if (bytesRead == buffer.size) buffer else buffer.copyOf(bytesRead)
         } else {
             ByteArray(0)
         }
     }
 
+    private fun captureChunk(data: ByteArray, length: Int) {
+        val target = capture ?: return
+        synchronized(lock) {
+            try {
+                target.append(data, 0, length)
+            } catch (e: java.io.IOException) {
+                Log.e(TAG, "Session capture failed, disabling it for this session", e)
+                target.close()
+            }
+        }
+    }
+
+    /**
+     * The captured session (after [stop]) as a read-only memory map of the capture file;
+     * empty without a [captureFile]
+     */
+    fun capturedAudio(): ByteBuffer = synchronized(lock) {
+        capture?.map() ?: ByteBuffer.allocate(0)
+    }
+
     /**
-     * Get all recorded audio data
+     * Bytes captured in the current session
      */
-    fun getAudioData(): ByteArray = synchronized(lock) {
-        concatenateAudioData()
+    fun capturedBytes(): Long = synchronized(lock) {
+        capture?.size ?: 0L
     }
 
     /**
-     * Clear recorded audio buffer
+     * Discard the session capture
      */
     fun clearBuffer() = synchronized(lock) {
-        audioData.clear()
+        capture?.delete()
+        Unit
     }
 
     /**
@@ -233,6 +256,7 @@ class AudioRecorder(
      */
     fun release() {
         stop()
+        clearBuffer()
         audioRecord?.release()
         audioRecord = null
         Log.i(TAG, "AudioRecord released")
@@ -256,26 +280,6 @@ class AudioRecorder(
         )
     }
 
-    /**
-     * Concatenate all audio chunks into single ByteArray
-     */
-    private fun concatenateAudioData(): ByteArray {
-        if (audioData.isEmpty()) {
-            return ByteArray(0)
-        }
-
-        val totalSize = audioData.sumOf { it.size }
-        val result = ByteArray(totalSize)
-        var offset = 0
-
-        for (chunk in audioData) {
-            chunk.copyInto(result, offset)
-            offset += chunk.size
-        }
-
-        return result
-    }
-
     /**
      * Audio information data class
      */
@@ -298,17 +302,71 @@ object AudioUtils {
      * This is needed for Whisper and VAD models
      */
     fun bytesToFloat(audioBytes: ByteArray): FloatArray {
-        val shorts = ByteBuffer.wrap(audioBytes)
-            .order(ByteOrder.LITTLE_ENDIAN)
-            .asShortBuffer()
+        val floats = FloatArray(audioBytes.size / 2)
+        pcmToFloat(audioBytes, 0, floats.size, floats)
+        return floats
+    }
 
-        val floats = FloatArray(shorts.capacity())
-        for (i in 0 until shorts.capacity()) {
-            floats[i] = shorts.get(i) / 32768.0f
+    /**
+     * Shared PCM kernel: convert 16-bit little-endian samples to normalized floats and
+     * measure their level in the same pass.
+     *
+     * Decodes bytes directly instead of going through ByteBuffer.getShort() per sample,
+     * and writes into a caller-owned array so hot paths can reuse it.
+     *
+     * @return RMS and peak of the converted samples
+     */
+    fun pcmToFloat(
+        src: ByteArray,
+        srcOffset: Int,
+        sampleCount: Int,
+        dest: FloatArray,
+        destOffset: Int = 0
+    ): PcmLevels {
+        require(srcOffset >= 0 && srcOffset + sampleCount * 2 <= src.size) { "Source too small for $sampleCount samples" }
+        require(destOffset >= 0 && destOffset + sampleCount <= dest.size) { "Destination too small for $sampleCount samples" }
+
+        var sumSquares = 0.0
+        var peak = 0f
+        var o = srcOffset
+        for (i in destOffset until destOffset + sampleCount) {
+            val sample = sampleAt(src, o) / 32768.0f
+            dest[i] = sample
+            sumSquares += sample * sample
+            if (abs(sample) > peak) peak = abs(sample)
+            o += 2
         }
-        return floats
+        return levelsOf(sumSquares, peak, sampleCount)
+    }
+
+    /**
+     * RMS and peak of PCM 16-bit audio without converting it (visualizer, energy gate)
+     *
+     * @param offset Byte offset of the block to measure, so callers need not copy slices
+     * @param length Byte length of the block
+     */
+    fun calculateLevels(audioBytes: ByteArray, offset: Int = 0, length: Int = audioBytes.size - offset): PcmLevels {
+        require(offset >= 0 && offset + length <= audioBytes.size) { "Block outside audio data" }
+        val sampleCount = length / 2
+        var sumSquares = 0.0
+        var peak = 0f
+        var o = offset
+        for (i in 0 until sampleCount) {
+            val sample = sampleAt(audioBytes, o) / 32768.0f
+            sumSquares += sample * sample
+            if (abs(sample) > peak) peak = abs(sample)
+            o += 2
+        }
+        return levelsOf(sumSquares, peak, sampleCount)
     }
 
+    @Suppress("NOTHING_TO_INLINE")
+    private inline fun sampleAt(src: ByteArray, offset: Int): Short =
+        ((src[offset].toInt() and 0xFF) or (src[offset + 1].toInt() shl 8)).toShort()
+
+    private fun levelsOf(sumSquares: Double, peak: Float, sampleCount: Int): PcmLevels =
+        if (sampleCount == 0) PcmLevels(0f, 0f) else PcmLevels(sqrt(sumSquares / sampleCount).toFloat(), peak)
+
     /**
      * Convert FloatArray to ByteArray (PCM 16-bit)
      */
@@ -327,16 +385,7 @@ object AudioUtils {
     /**
      * Calculate RMS (Root Mean Square) of audio for volume detection
      */
-    fun calculateRMS(audioBytes: ByteArray): Float {
-        if (audioBytes.isEmpty()) return 0f
-
-        val floats = bytesToFloat(audioBytes)
-        var sum = 0.0
-        for (sample in floats) {
-            sum += sample * sample
-        }
-        return Math.sqrt(sum / floats.size).toFloat()
-    }
+    fun calculateRMS(audioBytes: ByteArray): Float = calculateLevels(audioBytes).rms
 
     /**
      * Check if audio is silent based on RMS threshold
@@ -344,4 +393,50 @@ object AudioUtils {
     fun isSilent(audioBytes: ByteArray, threshold: Float = 0.01f): Boolean {
         return calculateRMS(audioBytes) < threshold
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Level of a block of normalized audio: RMS and absolute peak, both in [0.0, 1.0]
+ */
+data class PcmLevels(
+    val rms: Float,
+    val peak: Float
+)
+
+/**
+ * Reusable direct FloatBuffer for feeding PCM to an ORT input tensor.
+ *
+ * ORT binds direct native-order buffers in place, while FloatBuffer.wrap() of a heap array
+ * is copied into native memory on every tensor creation. The buffer grows to the largest
+ * window seen (30s = ~1.9MB) and is then reused. Not thread-safe: callers must hold it
+ * until the session that reads the tensor has finished running.
+ */
+class PcmFloatBuffer(initialSamples: Int = 16000 * 30) {
+
+    private var scratch = FloatArray(initialSamples)
+    private var direct: FloatBuffer = allocate(initialSamples)
+
+    /** Levels of the audio from the last [load] */
+    var levels = PcmLevels(0f, 0f)
+        private set
+
+    /**
+     * Convert [pcm] and return a view of exactly its samples, ready for createTensor()
+     */
+    fun load(pcm: ByteArray): FloatBuffer {
+        val samples = pcm.size / 2
+        if (samples > scratch.size) {
+            scratch = FloatArray(samples)
+            direct = allocate(samples)
+        }
+
+        levels = AudioUtils.pcmToFloat(pcm, 0, samples, scratch)
+        direct.clear()
+        direct.put(scratch, 0, samples)
+        direct.flip()
+        return direct
+    }
+
+    private fun allocate(samples: Int): FloatBuffer =
+        ByteBuffer.allocateDirect(samples * 4).order(ByteOrder.nativeOrder()).asFloatBuffer()
+}
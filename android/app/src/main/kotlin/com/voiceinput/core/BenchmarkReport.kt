@@ -0,0 +1,100 @@
+package com.voiceinput.core
+
+import com.google.gson.GsonBuilder
+
+/**
+ * Summary of the repeated samples of one benchmark metric
+ */
+data class BenchmarkStat(
+    val unit: String,
+    val count: Int,
+    val min: Double,
+    val mean: Double,
+    val p50: Double,
+    val p95: Double,
+    val p99: Double,
+    val max: Double
+) {
+    companion object {
+        fun of(unit: String, samples: List<Double>): BenchmarkStat {
+            require(samples.isNotEmpty()) { "No samples for a $unit metric" }
+            val sorted = samples.sorted()
+            return BenchmarkStat(
+                unit = unit,
+                count = sorted.size,
+                min = sorted.first(),
+                mean = sorted.average(),
+                p50 = percentile(sorted, 50.0),
+                p95 = percentile(sorted, 95.0),
+                p99 = percentile(sorted, 99.0),
+                max = sorted.last()
+            )
+        }
+
+        /**
+         * Nearest-rank percentile of an ascending list, as in [LatencyTrace.percentile]
+         */
+        fun percentile(sorted: List<Double>, p: Double): Double {
+            if (sorted.isEmpty()) return 0.0
+            val rank = kotlin.math.ceil(p / 100.0 * sorted.size).toInt().coerceIn(1, sorted.size)
+            return sorted[rank - 1]
+        }
+    }
+}
+
+/**
+ * Benchmark results in the JSON layout shared with the desktop benchmark
+ * (voice_input_service/core/benchmark.py), so reports of two builds can be diffed.
+ *
+ * Metric names are "<stage>.<what>", e.g. "encode.15s" or "decode.per_token"; see
+ * [com.voiceinput.PipelineBenchmark] for the full list.
+ */
+data class BenchmarkReport(
+    val schema: Int = SCHEMA_VERSION,
+    val platform: String,
+    val build: String,
+    val device: String,
+    val model: String,
+    val startedAt: String,
+    val warmup: Int,
+    val repeats: Int,
+    val corpusSec: List<Int>,
+    val thermalState: String,
+    val peakRssKb: Long?,
+    val metrics: Map<String, BenchmarkStat>,
+    val notes: Map<String, String> = emptyMap()
+) {
+    companion object {
+        const val SCHEMA_VERSION = 1
+
+        fun fromJson(json: String): BenchmarkReport =
+            GsonBuilder().create().fromJson(json, BenchmarkReport::class.java)
+
+        /**
+         * Peak resident set size (VmHWM) from the contents of /proc/self/status, or null
+         */
+        fun parsePeakRssKb(procStatus: String): Long? =
+            procStatus.lineSequence()
+                .firstOrNull { it.startsWith("VmHWM:") }
+                ?.removePrefix("VmHWM:")
+                ?.trim()
+                ?.substringBefore(' ')
+                ?.toLongOrNull()
+    }
+
+    fun toJson(): String = GsonBuilder().setPrettyPrinting().create().toJson(this)
+}
+
+/**
+ * Collects samples per metric while a benchmark runs
+ */
+class BenchmarkSamples {
+    private val samples = LinkedHashMap<String, Pair<String, MutableList<Double>>>()
+
+    fun add(metric: String, unit: String, value: Double) {
+        samples.getOrPut(metric) { unit to mutableListOf() }.second.add(value)
+    }
+
+    fun stats(): Map<String, BenchmarkStat> =
+        samples.mapValues { (_, entry) -> BenchmarkStat.of(entry.first, entry.second) }
+}
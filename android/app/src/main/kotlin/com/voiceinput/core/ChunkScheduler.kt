@@ -0,0 +1,103 @@
+package com.voiceinput.core
+
+import java.io.Closeable
+
+/**
+ * Byte thresholds for cutting buffered audio into windows (16-bit mono PCM)
+ */
+data class ChunkLimits(
+    val minAudioLengthBytes: Int,
+    val maxChunkBytes: Int,
+    val silenceDurationMs: Long
+)
+
+/**
+ * Decides, chunk by chunk, when the buffered speech becomes a transcription window.
+ *
+ * - Speech is appended; reaching [ChunkLimits.maxChunkBytes] flushes the window.
+ * - Silence after at least [ChunkLimits.minAudioLengthBytes] of buffer, once
+ *   [ChunkLimits.silenceDurationMs] have passed since the last speech, flushes what is
+ *   buffered (without the silent chunk).
+ * - Shorter silences after speech are appended for context (unless [onChunk] is told not
+ *   to keep silence), and may also reach the max size.
+ * - Silence with nothing buffered is ignored.
+ *
+ * Only the decision lives here; how a window is flushed (overlap, partials) is up to the
+ * caller. The rules are implemented once in the native core (`native/src/chunk_scheduler.cpp`,
+ * loaded from libvoiceinput_jni); the desktop service binds the same code through pybind11,
+ * so both apps cut windows identically. [close] frees the native scheduler.
+ */
+class ChunkScheduler(limits: ChunkLimits) : Closeable {
+
+    enum class Action {
+        // Same order as voiceinput::ChunkAction (the native result is an ordinal)
+        IGNORE,             // Drop the chunk
+        APPEND,             // Append the chunk
+        APPEND_AND_FLUSH,   // Append the chunk, then flush (max size reached)
+        FLUSH               // Flush the buffer without the chunk (silence after speech)
+    }
+
+    private var handle = nativeCreate(limits.minAudioLengthBytes.toLong(), limits.maxChunkBytes.toLong(), limits.silenceDurationMs)
+
+    init {
+        check(handle != 0L) { "Could not allocate the native chunk scheduler" }
+    }
+
+    @Volatile
+    var limits: ChunkLimits = limits
+        set(value) {
+            field = value
+            // Config updates may still arrive after close()
+            if (handle != 0L) nativeSetLimits(handle, value.minAudioLengthBytes.toLong(), value.maxChunkBytes.toLong(), value.silenceDurationMs)
+        }
+
+    /** Time of the last speech chunk */
+    val lastSpeechMs: Long
+        get() = nativeLastSpeechMs(liveHandle())
+
+    fun reset(nowMs: Long) {
+        nativeReset(liveHandle(), nowMs)
+    }
+
+    /**
+     * @param bufferedBytes Bytes buffered before this chunk
+     * @param keepSilence Whether short silences after speech are buffered (see [LatencyScheduler])
+     */
+    fun onChunk(silent: Boolean, bufferedBytes: Int, chunkBytes: Int, nowMs: Long, keepSilence: Boolean = true): Action =
+        ACTIONS[nativeOnChunk(liveHandle(), silent, bufferedBytes, chunkBytes, nowMs, keepSilence)]
+
+    /**
+     * Whether a quiet queue (no audio for a while) should flush what is buffered
+     */
+    fun flushOnIdle(bufferedBytes: Int, recentAudio: Boolean): Boolean =
+        nativeFlushOnIdle(liveHandle(), bufferedBytes, recentAudio)
+
+    /** The native handle; JNI would dereference 0 after [close] */
+    private fun liveHandle(): Long {
+        val current = handle
+        check(current != 0L) { "ChunkScheduler is closed" }
+        return current
+    }
+
+    override fun close() {
+        if (handle == 0L) return
+        nativeDestroy(handle)
+        handle = 0L
+    }
+
+    private external fun nativeCreate(minAudioLengthBytes: Long, maxChunkBytes: Long, silenceDurationMs: Long): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeSetLimits(handle: Long, minAudioLengthBytes: Long, maxChunkBytes: Long, silenceDurationMs: Long)
+    private external fun nativeReset(handle: Long, nowMs: Long)
+    private external fun nativeLastSpeechMs(handle: Long): Long
+    private external fun nativeOnChunk(handle: Long, silent: Boolean, bufferedBytes: Int, chunkBytes: Int, nowMs: Long, keepSilence: Boolean): Int
+    private external fun nativeFlushOnIdle(handle: Long, bufferedBytes: Int, recentAudio: Boolean): Boolean
+
+    companion object {
+        private val ACTIONS = Action.values()
+
+        init {
+            System.loadLibrary("voiceinput_jni")
+        }
+    }
+}
@@ -0,0 +1,129 @@
+package com.voiceinput.core
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+
+/**
+ * Which parts of a model are loaded.
+ *
+ * Picking up work always brings the model back to [RESIDENT]; [ENCODER_ONLY] keeps the
+ * preprocessor, encoder and cross-attention cache sessions (the first half of a window)
+ * so only the decoder has to be reloaded.
+ */
+enum class EngineResidency {
+    UNLOADED,
+    ENCODER_ONLY,
+    RESIDENT
+}
+
+data class ResidencyTransition(
+    val from: EngineResidency,
+    val to: EngineResidency,
+    val reason: String,
+    val atMs: Long = System.currentTimeMillis()
+)
+
+/**
+ * The last [capacity] residency transitions, oldest first. Thread-safe.
+ */
+class ResidencyLog(private val capacity: Int = DEFAULT_CAPACITY) {
+
+    companion object {
+        const val DEFAULT_CAPACITY = 16
+    }
+
+    private val transitions = ArrayDeque<ResidencyTransition>(capacity)
+
+    @Synchronized
+    fun record(transition: ResidencyTransition) {
+        if (transitions.size == capacity) transitions.removeFirst()
+        transitions.addLast(transition)
+    }
+
+    @Synchronized
+    fun snapshot(): List<ResidencyTransition> = transitions.toList()
+}
+
+/**
+ * A model whose sessions can be warmed and dropped in stages (see [WhisperEngine])
+ */
+interface ResidentModel {
+    val residency: EngineResidency
+
+    /** Load whatever is missing and run a dummy inference so the first real one is fast */
+    suspend fun warmUp(): Boolean
+
+    /** Drop the decoder side; false if busy or not resident */
+    suspend fun releaseDecoder(reason: String): Boolean
+
+    /** Drop every session in a fixed order; false if busy or already unloaded */
+    suspend fun unload(reason: String): Boolean
+}
+
+/**
+ * Lifecycle policy for a [SharedEngine]:
+ * - [onInputStarted] (a text field gained focus): load and pre-warm before the mic is pressed
+ * - [idleTimeoutMs] after [onInputFinished] or a warm-up: release the decoder
+ * - [onMemoryWarning]: release the decoder now if idle
+ * - [onMemoryCritical]: unload everything (and drop the engine if no client holds it)
+ *
+ * A busy engine refuses to release; the idle timer then tries again later.
+ */
+class EngineResidencyPolicy<T>(
+    private val host: SharedEngine<T>,
+    private val scope: CoroutineScope,
+    private val idleTimeoutMs: Long = DEFAULT_IDLE_TIMEOUT_MS
+) where T : Any, T : ResidentModel {
+
+    companion object {
+        const val DEFAULT_IDLE_TIMEOUT_MS = 60_000L
+    }
+
+    private var warmJob: Job? = null
+    private var idleJob: Job? = null
+
+    @Synchronized
+    fun onInputStarted() {
+        idleJob?.cancel()
+        if (warmJob?.isActive == true) return
+        warmJob = scope.launch {
+            if (!host.warmUp()) return@launch
+            host.current?.warmUp()
+            scheduleIdleRelease()
+        }
+    }
+
+    @Synchronized
+    fun onInputFinished() = scheduleIdleRelease()
+
+    @Synchronized
+    fun onMemoryWarning() {
+        scope.launch { host.current?.releaseDecoder("memory warning") }
+    }
+
+    @Synchronized
+    fun onMemoryCritical() {
+        idleJob?.cancel()
+        warmJob?.cancel()
+        scope.launch {
+            host.current?.unload("critical memory")
+            host.unloadIfIdle()
+        }
+    }
+
+    @Synchronized
+    private fun scheduleIdleRelease() {
+        idleJob?.cancel()
+        idleJob = scope.launch {
+            while (true) {
+                delay(idleTimeoutMs)
+                val engine = host.current ?: return@launch
+                if (engine.residency != EngineResidency.RESIDENT) return@launch
+                if (engine.releaseDecoder("idle ${idleTimeoutMs / 1000}s")) return@launch
+                // Busy: try again after another idle period
+            }
+        }
+    }
+}
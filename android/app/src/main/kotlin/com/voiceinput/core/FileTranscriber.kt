@@ -0,0 +1,232 @@
+package com.voiceinput.core
+
+import android.util.Log
+import com.voiceinput.config.AppConfig
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
+import java.nio.ByteBuffer
+
+/**
+ * Offline transcription of a complete recording.
+ *
+ * [AudioProcessor] replays audio chunk by chunk as if it were live. Here the whole PCM
+ * buffer is segmented in one pass instead: each frame is classified as silent (VAD, or
+ * an energy gate without it), speech is packed into windows of up to maxChunkDurationSec
+ * that are cut only in pauses, and the windows run through the same two-stage pipeline:
+ * window N+1 encodes while window N decodes. [transcribe] returns once the last window
+ * is decoded, so callers need no settling delay.
+ *
+ * The recording is read through a [ByteBuffer] (PCM from index 0 to its limit), so a
+ * memory-mapped session capture is never copied whole: only frames and windows are.
+ *
+ * Windows never overlap, since every cut falls in silence.
+ */
+class FileTranscriber(private var config: AppConfig, private val trace: LatencyTrace = LatencyTrace()) {
+
+    companion object {
+        private const val TAG = "FileTranscriber"
+
+        const val FRAME_MS = 100
+        const val SILENCE_RMS = 0.01f // Matches AudioUtils.isSilent
+
+        // Audio kept around each speech region so word edges are not clipped
+        private const val PAD_FRAMES = 2
+
+        fun frameBytes(sampleRate: Int): Int = sampleRate * 2 * FRAME_MS / 1000
+
+        /**
+         * Energy-gate silence flags, one per frame of [frameBytes] (the last may be short)
+         */
+        fun energySilence(pcm: ByteArray, frameBytes: Int, threshold: Float = SILENCE_RMS): BooleanArray =
+            energySilence(ByteBuffer.wrap(pcm), frameBytes, threshold)
+
+        fun energySilence(pcm: ByteBuffer, frameBytes: Int, threshold: Float = SILENCE_RMS): BooleanArray {
+            val total = pcm.limit()
+            val frame = ByteArray(frameBytes)
+            val silent = BooleanArray((total + frameBytes - 1) / frameBytes)
+            for (i in silent.indices) {
+                val start = i * frameBytes
+                val length = minOf(frameBytes, total - start)
+                copyRange(pcm, start, frame, length)
+                silent[i] = AudioUtils.calculateLevels(frame, 0, length).rms < threshold
+            }
+            return silent
+        }
+
+        /**
+         * Copy [length] bytes of [pcm] starting at index [start] into [dest], leaving [pcm] untouched
+         */
+        fun copyRange(pcm: ByteBuffer, start: Int, dest: ByteArray, length: Int = dest.size) {
+            val view = pcm.duplicate()
+            view.position(start)
+            view.get(dest, 0, length)
+        }
+
+        /**
+         * Cut a recording into transcription windows.
+         *
+         * Speech regions end at a run of at least [minSilenceFrames] silent frames. Consecutive
+         * regions are packed into one window while it stays within [maxWindowFrames]; a single
+         * region longer than that is split at its last silent frame in the final third, or
+         * hard at the limit if it has none.
+         *
+         * @param silent Silence flag per frame, as from [energySilence]
+         * @param minWindowBytes Windows shorter than this are dropped
+         * @return Byte ranges into the recording
+         */
+        fun segment(
+            totalBytes: Int,
+            silent: BooleanArray,
+            frameBytes: Int,
+            minSilenceFrames: Int,
+            maxWindowFrames: Int,
+            minWindowBytes: Int
+        ): List<IntRange> {
+            require(maxWindowFrames >= 3) { "Windows must span at least 3 frames, got $maxWindowFrames" }
+            val frames = silent.size
+
+            // 1. Speech regions [start, end) in frames, padded
+            val regions = ArrayList<IntArray>()
+            var regionStart = -1
+            var lastSpeech = -1
+            for (i in 0 until frames) {
+                if (!silent[i]) {
+                    if (regionStart < 0) regionStart = i
+                    lastSpeech = i
+                } else if (regionStart >= 0 && i - lastSpeech >= minSilenceFrames) {
+                    regions.add(intArrayOf(regionStart, lastSpeech + 1))
+                    regionStart = -1
+                }
+            }
+            if (regionStart >= 0) regions.add(intArrayOf(regionStart, lastSpeech + 1))
+            for (region in regions) {
+                region[0] = maxOf(0, region[0] - PAD_FRAMES)
+                region[1] = minOf(frames, region[1] + PAD_FRAMES)
+            }
+
+            // 2. Pack regions into windows, splitting regions that are too long on their own
+            val windows = ArrayList<IntRange>()
+            var windowStart = -1
+            var windowEnd = -1
+            fun emit(start: Int, end: Int) {
+                val from = start * frameBytes
+                val to = minOf(totalBytes, end * frameBytes)
+                if (to - from >= minWindowBytes) windows.add(from until to)
+            }
+            for (region in regions) {
+                var start = maxOf(region[0], windowEnd) // Padding may overlap the previous window
+                val end = region[1]
+                if (windowStart >= 0 && end - windowStart <= maxWindowFrames) {
+                    windowEnd = end
+                    continue
+                }
+                if (windowStart >= 0) emit(windowStart, windowEnd)
+
+                while (end - start > maxWindowFrames) {
+                    val limit = start + maxWindowFrames
+                    var cut = limit
+                    for (i in limit - 1 downTo start + maxWindowFrames * 2 / 3) {
+                        if (silent[i]) {
+                            cut = i + 1
+                            break
+                        }
+                    }
+                    emit(start, cut)
+                    start = cut
+                }
+                windowStart = start
+                windowEnd = end
+            }
+            if (windowStart >= 0) emit(windowStart, windowEnd)
+            return windows
+        }
+    }
+
+    /**
+     * Segment [pcm] with [segment] using the current configuration
+     *
+     * @param silent Per-frame silence flags (see [frameBytes]); energy gate if null
+     */
+    fun segmentRecording(pcm: ByteBuffer, silent: BooleanArray? = null): List<IntRange> {
+        val audio = config.audio
+        val frameBytes = frameBytes(audio.sampleRate)
+        return segment(
+            totalBytes = pcm.limit(),
+            silent = silent ?: energySilence(pcm, frameBytes),
+            frameBytes = frameBytes,
+            minSilenceFrames = maxOf(1, (audio.silenceDurationSec * 1000 / FRAME_MS).toInt()),
+            maxWindowFrames = (audio.maxChunkDurationSec * 1000 / FRAME_MS).toInt(),
+            minWindowBytes = config.transcription.minChunkSizeBytes
+        )
+    }
+
+    /**
+     * Transcribe [windows] of [pcm], encoding the next window while the current one decodes
+     *
+     * Results are filtered for hallucinations and delivered in order; each delivered window's
+     * tokens become prompt context for the next. A window that fails is logged and skipped.
+     *
+     * @return Number of windows that produced text
+     */
+    suspend fun transcribe(
+        engine: WhisperEngine,
+        textProcessor: TextProcessor,
+        pcm: ByteBuffer,
+        windows: List<IntRange>,
+        onResult: (TranscriptionResult) -> Unit
+    ): Int = coroutineScope {
+        val promptBudget = if (config.transcription.promptCarryover) config.transcription.promptMaxTokens else 0
+        // Rendezvous: at most the decoding window and the next encoded one hold encoder caches
+        // Each window carries its own index, which skipped (failed) encodes would shift otherwise
+        val encodedWindows = Channel<IndexedValue<EncodedAudio>>(capacity = Channel.RENDEZVOUS)
+
+        launch {
+            try {
+                for ((index, range) in windows.withIndex()) {
+                    val encoded = try {
+                        trace.span(TraceStage.ENCODE, index) { engine.encode(ByteArray(range.count()).also { copyRange(pcm, range.first, it) }) }
+                    } catch (e: CancellationException) {
+                        throw e
+                    } catch (e: Exception) {
+                        Log.e(TAG, "Encoding window ${range.first}-${range.last} failed: ${e.message}", e)
+                        continue
+                    }
+                    try {
+                        encodedWindows.send(IndexedValue(index, encoded))
+                    } catch (e: Exception) {
+                        encoded.close()
+                        throw e
+                    }
+                }
+            } finally {
+                encodedWindows.close()
+            }
+        }
+
+        var promptContext = IntArray(0)
+        var delivered = 0
+        for ((index, encoded) in encodedWindows) {
+            val result = try {
+                trace.span(TraceStage.DECODE, index) { engine.decode(encoded, promptContext) }
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                Log.e(TAG, "Decoding window $index failed: ${e.message}", e)
+                continue
+            }
+            val text = textProcessor.filterHallucinations(result.text.trim())
+            if (text.isEmpty()) continue
+
+            onResult(result.copy(text = text))
+            promptContext = PromptCarryover.next(promptContext, result.tokens, promptBudget)
+            delivered++
+        }
+        delivered
+    }
+
+    fun updateSettings(newConfig: AppConfig) {
+        config = newConfig
+    }
+}
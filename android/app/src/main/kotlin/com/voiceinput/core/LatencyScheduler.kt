@@ -0,0 +1,91 @@
+package com.voiceinput.core
+
+/**
+ * Keeps live transcription within a latency budget by degrading step by step.
+ *
+ * The lag fed to [update] is queuing delay: how long audio has been waiting to be
+ * processed, not counting the processing itself, so it stays near zero while the
+ * device keeps up and grows once windows arrive faster than they are transcribed.
+ *
+ * While the lag is over budget the level rises one step per [stepIntervalMs]:
+ * 1. [Level.DROP_SILENCE]: silence after speech is no longer buffered into windows
+ * 2. [Level.SHRINK_OVERLAP]: the audio re-encoded between windows is halved
+ * 3. [Level.SWITCH_TIER]: a smaller model tier is requested (again every [tierRetryMs]
+ *    while still over budget)
+ * Once the lag falls under half the budget, the level steps back down at the same pace.
+ * A tier switch is not undone.
+ */
+class LatencyScheduler(
+    val budgetMs: Long,
+    private val stepIntervalMs: Long = STEP_INTERVAL_MS,
+    private val tierRetryMs: Long = TIER_RETRY_MS
+) {
+    enum class Level { NORMAL, DROP_SILENCE, SHRINK_OVERLAP, SWITCH_TIER }
+
+    companion object {
+        const val STEP_INTERVAL_MS = 2000L
+        const val TIER_RETRY_MS = 15000L
+    }
+
+    init {
+        require(budgetMs > 0) { "Latency budget must be positive, got $budgetMs" }
+    }
+
+    /** Current degradation; read by other threads */
+    @Volatile var level = Level.NORMAL
+        private set
+
+    private var lastChangeMs = 0L
+
+    /**
+     * Re-evaluate the level for the current lag
+     *
+     * @return True if a smaller model tier should be requested now
+     */
+    fun update(lagMs: Long, nowMs: Long): Boolean {
+        val current = level
+        val sinceChange = nowMs - lastChangeMs
+
+        if (lagMs > budgetMs) {
+            if (current == Level.SWITCH_TIER) {
+                if (sinceChange < tierRetryMs) return false
+                lastChangeMs = nowMs
+                return true
+            }
+            // The first step is taken at once; later ones give the previous step time to work
+            if (current != Level.NORMAL && sinceChange < stepIntervalMs) return false
+            level = Level.values()[current.ordinal + 1]
+            lastChangeMs = nowMs
+            return level == Level.SWITCH_TIER
+        }
+
+        if (lagMs < budgetMs / 2 && current != Level.NORMAL && sinceChange >= stepIntervalMs) {
+            level = Level.values()[current.ordinal - 1]
+            lastChangeMs = nowMs
+        }
+        return false
+    }
+
+    fun reset() {
+        level = Level.NORMAL
+        lastChangeMs = 0L
+    }
+}
+
+/**
+ * Backpressure metrics of the live audio path
+ *
+ * @param queuedChunks Recorder chunks waiting for the VAD/buffering loop
+ * @param queuedWindows Flushed windows waiting for the encoder
+ * @param audioLagMs Queuing delay of the oldest waiting audio
+ * @param level Current degradation step
+ * @param droppedChunks Chunks discarded because the bounded audio queue was full
+ */
+data class LatencyStats(
+    val queuedChunks: Int,
+    val queuedWindows: Int,
+    val audioLagMs: Long,
+    val budgetMs: Long,
+    val level: LatencyScheduler.Level,
+    val droppedChunks: Long
+)
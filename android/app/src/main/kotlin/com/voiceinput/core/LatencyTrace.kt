@@ -0,0 +1,164 @@
+package com.voiceinput.core
+
+import android.os.Build
+import android.os.Trace
+
+/**
+ * Stages of a transcription window, from captured audio to text in the editor
+ */
+enum class TraceStage(val label: String) {
+    VAD("vad"),                // Silence decision for one recorder chunk
+    QUEUE("queue"),            // Flushed window waiting for the encoder
+    ENCODE("encode"),
+    DECODE("decode"),
+    STITCH("stitch"),          // Timestamp cut of a max-size window
+    TEXT("text"),              // Appending the window's text to the transcript
+    END_TO_END("end_to_end"),  // Newest captured audio of a window -> its text delivered
+    COMMIT("commit")           // Stop pressed -> final text committed to the InputConnection
+}
+
+/**
+ * Latency percentiles of one stage over the recent spans
+ */
+data class StagePercentiles(
+    val count: Int,
+    val p50Ms: Float,
+    val p95Ms: Float,
+    val p99Ms: Float
+)
+
+/**
+ * Receives span boundaries as they happen, e.g. to show them in a system trace
+ */
+interface TraceSink {
+    fun begin(stage: TraceStage, cookie: Int)
+    fun end(stage: TraceStage, cookie: Int)
+
+    companion object {
+        val NONE = object : TraceSink {
+            override fun begin(stage: TraceStage, cookie: Int) = Unit
+            override fun end(stage: TraceStage, cookie: Int) = Unit
+        }
+    }
+}
+
+/**
+ * Emits spans as async trace sections, visible in Perfetto and systrace captures of the app.
+ *
+ * Async sections are used because stages suspend and resume on other threads, which
+ * [Trace.beginSection] does not allow. They need API 29; older devices record no sections.
+ */
+object SystraceSink : TraceSink {
+    private const val PREFIX = "VoiceInput:"
+
+    override fun begin(stage: TraceStage, cookie: Int) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) Trace.beginAsyncSection(PREFIX + stage.label, cookie)
+    }
+
+    override fun end(stage: TraceStage, cookie: Int) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) Trace.endAsyncSection(PREFIX + stage.label, cookie)
+    }
+}
+
+/**
+ * Span timing for every pipeline stage, replacing ad-hoc timing logs.
+ *
+ * Each stage keeps its most recent [capacity] durations, from which [summary] computes
+ * p50/p95/p99. Spans are also forwarded to [sink]. Overlapping spans of the same stage
+ * (e.g. windows queued behind each other) need distinct cookies; window sequence numbers
+ * are used for that. Thread-safe.
+ */
+class LatencyTrace(
+    private val capacity: Int = DEFAULT_CAPACITY,
+    private val sink: TraceSink = TraceSink.NONE
+) {
+
+    companion object {
+        const val DEFAULT_CAPACITY = 256
+
+        /**
+         * Nearest-rank percentile of [sorted]
+         */
+        fun percentile(sorted: LongArray, p: Double): Long {
+            if (sorted.isEmpty()) return 0L
+            val rank = kotlin.math.ceil(p / 100.0 * sorted.size).toInt().coerceIn(1, sorted.size)
+            return sorted[rank - 1]
+        }
+
+        /**
+         * One-line form of a [summary] for logs, e.g. "decode p50/p95/p99 120.0/180.0/210.0ms (n=12)"
+         */
+        fun format(summary: Map<TraceStage, StagePercentiles>): String =
+            if (summary.isEmpty()) "no spans" else summary.entries.joinToString(", ") { (stage, p) ->
+                "${stage.label} p50/p95/p99 ${"%.1f".format(p.p50Ms)}/${"%.1f".format(p.p95Ms)}/${"%.1f".format(p.p99Ms)}ms (n=${p.count})"
+            }
+    }
+
+    init {
+        require(capacity > 0) { "Capacity must be positive, got $capacity" }
+    }
+
+    // Ring of recent durations (ns) per stage
+    private val durations = Array(TraceStage.values().size) { LongArray(capacity) }
+    private val counts = IntArray(TraceStage.values().size)
+    private val lock = Any()
+
+    /**
+     * Start a span; pass the returned start time to [end]
+     */
+    fun begin(stage: TraceStage, cookie: Int = 0): Long {
+        sink.begin(stage, cookie)
+        return System.nanoTime()
+    }
+
+    fun end(stage: TraceStage, startNs: Long, cookie: Int = 0) {
+        sink.end(stage, cookie)
+        record(stage, System.nanoTime() - startNs)
+    }
+
+    inline fun <T> span(stage: TraceStage, cookie: Int = 0, block: () -> T): T {
+        val start = begin(stage, cookie)
+        try {
+            return block()
+        } finally {
+            end(stage, start, cookie)
+        }
+    }
+
+    /**
+     * Record a duration measured elsewhere (e.g. from capture timestamps)
+     */
+    fun record(stage: TraceStage, durationNs: Long) {
+        synchronized(lock) {
+            val i = stage.ordinal
+            durations[i][counts[i] % capacity] = durationNs.coerceAtLeast(0L)
+            counts[i]++
+        }
+    }
+
+    /**
+     * Percentiles of every stage that has recorded spans
+     */
+    fun summary(): Map<TraceStage, StagePercentiles> {
+        val result = LinkedHashMap<TraceStage, StagePercentiles>()
+        for (stage in TraceStage.values()) {
+            val sorted = synchronized(lock) {
+                val n = minOf(counts[stage.ordinal], capacity)
+                durations[stage.ordinal].copyOf(n)
+            }
+            if (sorted.isEmpty()) continue
+            sorted.sort()
+            result[stage] = StagePercentiles(
+                count = sorted.size,
+                p50Ms = percentile(sorted, 50.0) / 1_000_000f,
+                p95Ms = percentile(sorted, 95.0) / 1_000_000f,
+                p99Ms = percentile(sorted, 99.0) / 1_000_000f
+            )
+        }
+        return result
+    }
+
+    fun reset() {
+        synchronized(lock) { counts.fill(0) }
+    }
+}
@@ -0,0 +1,82 @@
+package com.voiceinput.core
+
+/**
+ * LocalAgreement-2 stabilization of streaming hypotheses.
+ *
+ * Each partial decode of the growing speech buffer yields a full hypothesis for the current
+ * window. Words on which two consecutive hypotheses agree are committed; the rest of the
+ * latest hypothesis stays tentative. Committed words never change until [reset], which the
+ * processor calls when the window is flushed for its final transcription.
+ */
+class LocalAgreement {
+
+    private var previousWords: List<String> = emptyList()
+    private var committedWords: List<String> = emptyList()
+
+    /**
+     * Add a new hypothesis for the current window and return the split text
+     */
+    @Synchronized
+    fun update(hypothesis: String): PartialTranscription {
+        val words = hypothesis.trim().split(WHITESPACE).filter { it.isNotEmpty() }
+
+        // The agreed prefix may only grow: keep what is committed and extend it word by word
+        var agreed = committedWords.size
+        while (agreed < words.size && agreed < previousWords.size &&
+            normalize(words[agreed]) == normalize(previousWords[agreed])) {
+            agreed++
+        }
+        if (agreed > committedWords.size && startsWithCommitted(words)) {
+            committedWords = words.subList(0, agreed).toList()
+        }
+        previousWords = words
+
+        val tentative = if (startsWithCommitted(words)) {
+            words.drop(committedWords.size)
+        } else {
+            // The new hypothesis rewrote committed words; show only what goes past them
+            words.drop(minOf(committedWords.size, words.size))
+        }
+
+        return PartialTranscription(
+            committed = committedWords.joinToString(" "),
+            tentative = tentative.joinToString(" ")
+        )
+    }
+
+    /**
+     * Forget the current window (its final result has been produced)
+     */
+    @Synchronized
+    fun reset() {
+        previousWords = emptyList()
+        committedWords = emptyList()
+    }
+
+    private fun startsWithCommitted(words: List<String>): Boolean {
+        if (words.size < committedWords.size) return false
+        return committedWords.indices.all { normalize(words[it]) == normalize(committedWords[it]) }
+    }
+
+    // Punctuation and case often flip between decodes of the same audio
+    private fun normalize(word: String): String =
+        word.lowercase().trim { !it.isLetterOrDigit() }
+
+    private companion object {
+        val WHITESPACE = Regex("\\s+")
+    }
+}
+
+/**
+ * Streaming hypothesis for the window that is still being recorded
+ *
+ * @param committed Stable text that later partials will not change
+ * @param tentative Trailing text that may still be revised
+ */
+data class PartialTranscription(
+    val committed: String,
+    val tentative: String
+) {
+    val text: String
+        get() = listOf(committed, tentative).filter { it.isNotEmpty() }.joinToString(" ")
+}
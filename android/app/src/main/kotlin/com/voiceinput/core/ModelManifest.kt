@@ -0,0 +1,150 @@
+package com.voiceinput.core
+
+import android.content.Context
+import android.util.Log
+
+/**
+ * Special token IDs of a Whisper vocabulary
+ */
+data class WhisperTokens(
+    val endOfText: Int,
+    val startOfTranscript: Int,
+    val english: Int,
+    val transcribe: Int,
+    val startOfPrev: Int,
+    val noTimestamps: Int,
+    val timestampBegin: Int,   // <|0.00|>; timestamps follow in 20ms steps up to <|30.00|>
+    val vocabSize: Int         // Used if the decoder export leaves the logits dimension dynamic
+) {
+    companion object {
+        val MULTILINGUAL = WhisperTokens(
+            endOfText = 50257,
+            startOfTranscript = 50258,
+            english = 50259,
+            transcribe = 50359,
+            startOfPrev = 50361,
+            noTimestamps = 50363,
+            timestampBegin = 50364,
+            vocabSize = 51865
+        )
+    }
+}
+
+/**
+ * Describes one Whisper model tier as exported for [WhisperEngine]: the five ONNX files
+ * (initializer, encoder, cache initializer, decoder, detokenizer) under [assetDir], the
+ * decoder shape needed for the self-attention cache, and the vocabulary's token IDs.
+ *
+ * Tiers are ordered from smallest to largest so [smaller] can step down when a device
+ * cannot keep up (see [ModelTierPolicy]).
+ */
+data class ModelManifest(
+    val tier: String,
+    val displayName: String,
+    val assetDir: String,
+    val decoderLayers: Int,
+    val attentionHeads: Int,
+    val headDim: Int = 64,
+    val tokens: WhisperTokens = WhisperTokens.MULTILINGUAL
+) {
+    val initializerPath: String get() = "$assetDir/Whisper_initializer.onnx"
+    val encoderPath: String get() = "$assetDir/Whisper_encoder.onnx"
+    val cacheInitializerPath: String get() = "$assetDir/Whisper_cache_initializer.onnx"
+    val decoderPath: String get() = "$assetDir/Whisper_decoder.onnx"
+    val detokenizerPath: String get() = "$assetDir/Whisper_detokenizer.onnx"
+
+    /** Encoder exported for a [seconds]-long window instead of the full 30 s (see [EncoderBuckets]) */
+    fun bucketEncoderPath(seconds: Int): String = "$assetDir/${bucketEncoderFile(seconds)}"
+
+    /**
+     * Whether this tier's models are packaged in the APK
+     */
+    fun isBundled(context: Context): Boolean {
+        return try {
+            context.assets.list(assetDir)?.contains("Whisper_encoder.onnx") == true
+        } catch (e: Exception) {
+            false
+        }
+    }
+
+    /**
+     * Window lengths with a shortened encoder packaged for this tier, shortest first
+     */
+    fun bundledEncoderBuckets(context: Context): List<Int> {
+        return try {
+            val files = context.assets.list(assetDir)?.toSet() ?: return emptyList()
+            EncoderBuckets.LENGTHS_SEC.filter { bucketEncoderFile(it) in files }
+        } catch (e: Exception) {
+            emptyList()
+        }
+    }
+
+    private fun bucketEncoderFile(seconds: Int) = "Whisper_encoder_${seconds}s.onnx"
+
+    /**
+     * Next smaller tiers, nearest first
+     */
+    fun smaller(): List<ModelManifest> = TIERS.takeWhile { it.tier != tier }.reversed()
+
+    companion object {
+        private const val TAG = "ModelManifest"
+
+        val TINY = ModelManifest("tiny", "Whisper TINY INT8 (39M params)", "models/tiny", decoderLayers = 4, attentionHeads = 6)
+        val BASE = ModelManifest("base", "Whisper BASE INT8 (74M params)", "models/base", decoderLayers = 6, attentionHeads = 8)
+        val SMALL = ModelManifest("small", "Whisper SMALL INT8 (244M params)", "models", decoderLayers = 12, attentionHeads = 12)
+
+        /** Known tiers, smallest first */
+        val TIERS = listOf(TINY, BASE, SMALL)
+
+        /**
+         * Tier for a config model name such as "base.en-q5_1", or null if there is no export for it
+         */
+        fun forName(modelName: String): ModelManifest? {
+            val tier = modelName.substringBefore('.').substringBefore('-').lowercase()
+            return TIERS.firstOrNull { it.tier == tier }
+        }
+
+        /**
+         * The requested tier if it is bundled, otherwise the nearest bundled one
+         * (smaller tiers first, since the request is an upper bound on cost)
+         */
+        fun resolve(context: Context, modelName: String): ModelManifest {
+            val requested = forName(modelName) ?: SMALL
+            if (requested.isBundled(context)) return requested
+
+            val fallback = (requested.smaller() + TIERS.filter { it !in requested.smaller() && it != requested })
+                .firstOrNull { it.isBundled(context) } ?: SMALL
+            Log.w(TAG, "Model '$modelName' is not bundled, using ${fallback.tier}")
+            return fallback
+        }
+    }
+}
+
+/**
+ * Shortened encoder windows.
+ *
+ * The initializer always pads audio to a 30 s mel (100 frames per second), so the full
+ * encoder costs the same for a 2 s utterance as for a 30 s one. A bucket export takes only
+ * the first [frames] of the mel; [select] picks the smallest bundled bucket that covers a
+ * chunk. Bucket exports need a cache initializer and decoder whose encoder-sequence axis is
+ * dynamic, since the cross-attention cache shrinks with the window.
+ */
+object EncoderBuckets {
+    const val FULL_WINDOW_SEC = 30
+    const val MEL_FRAMES_PER_SEC = 100
+
+    /** Bucket lengths an export may provide; [FULL_WINDOW_SEC] is the regular encoder */
+    val LENGTHS_SEC = listOf(5, 10, 20)
+
+    // Padding kept after the speech, so a word ending at the edge is not cut
+    const val MARGIN_SEC = 0.25f
+
+    /**
+     * Smallest of [available] (ascending) that fits [durationSec] plus the margin, or null
+     * for the full window
+     */
+    fun select(durationSec: Float, available: List<Int>): Int? =
+        available.firstOrNull { durationSec + MARGIN_SEC <= it }
+
+    fun frames(seconds: Int): Int = seconds * MEL_FRAMES_PER_SEC
+}
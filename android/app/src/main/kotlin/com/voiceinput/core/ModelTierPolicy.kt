@@ -0,0 +1,74 @@
+package com.voiceinput.core
+
+/**
+ * Decides when to step down to a smaller model tier.
+ *
+ * Tracks the real-time factor (processing time / audio duration) over the last [window]
+ * transcriptions. Once the rolling RTF exceeds [rtfThreshold] - windows are queuing up
+ * faster than they are transcribed - or memory pressure is reported, the policy trips
+ * once; [reset] re-arms it after the swap so the new tier is measured from scratch.
+ */
+class ModelTierPolicy(
+    private val rtfThreshold: Float = 1.0f,
+    private val window: Int = 5
+) {
+    init {
+        require(rtfThreshold > 0f) { "RTF threshold must be positive, got $rtfThreshold" }
+        require(window >= 1) { "Window must be at least 1, got $window" }
+    }
+
+    private val processingMs = LongArray(window)
+    private val audioMs = LongArray(window)
+    private var count = 0
+    private var next = 0
+    private var tripped = false
+
+    /** Total processing time over total audio for the recorded window (0 until any audio) */
+    val rollingRtf: Float
+        @Synchronized get() {
+            val audio = audioMs.sum()
+            return if (audio == 0L) 0f else processingMs.sum().toFloat() / audio
+        }
+
+    /**
+     * Record one transcription
+     *
+     * @return True if the tier should step down now
+     */
+    @Synchronized
+    fun record(processingTimeMs: Long, audioDurationSec: Float): Boolean {
+        if (audioDurationSec <= 0f) return false
+        processingMs[next] = processingTimeMs
+        audioMs[next] = (audioDurationSec * 1000).toLong()
+        next = (next + 1) % window
+        if (count < window) count++
+
+        if (tripped || count < window || rollingRtf <= rtfThreshold) return false
+        tripped = true
+        return true
+    }
+
+    /**
+     * Memory pressure reported by [MemoryManager]
+     *
+     * @return True if the tier should step down now
+     */
+    @Synchronized
+    fun onMemoryPressure(): Boolean {
+        if (tripped) return false
+        tripped = true
+        return true
+    }
+
+    /**
+     * Forget the measurements and re-arm, e.g. after switching tiers
+     */
+    @Synchronized
+    fun reset() {
+        processingMs.fill(0)
+        audioMs.fill(0)
+        count = 0
+        next = 0
+        tripped = false
+    }
+}
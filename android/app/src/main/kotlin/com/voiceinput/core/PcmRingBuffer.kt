@@ -0,0 +1,114 @@
+package com.voiceinput.core
+
+/**
+ * Preallocated ring buffer for 16-bit PCM bytes.
+ *
+ * Replaces growing a ByteArray with `buffer + chunk` on every recorder chunk: appends copy
+ * only the new bytes, and dropping the front of the window (flush with overlap) just moves
+ * the head. Bytes are copied out only when a window is handed to the transcription engine.
+ *
+ * Not thread-safe; owned by the AudioProcessor worker loop.
+ */
+class PcmRingBuffer(initialCapacity: Int) {
+
+    init {
+        require(initialCapacity > 0) { "Capacity must be positive, got $initialCapacity" }
+    }
+
+    private var data = ByteArray(initialCapacity)
+    private var head = 0 // Index of the oldest byte
+
+    /** Number of buffered bytes */
+    var size = 0
+        private set
+
+    val capacity: Int
+        get() = data.size
+
+    fun isEmpty(): Boolean = size == 0
+
+    fun isNotEmpty(): Boolean = size > 0
+
+    /**
+     * Append bytes at the end, growing the storage only if the window outgrows it
+     */
+    fun append(src: ByteArray, offset: Int = 0, length: Int = src.size - offset) {
+        require(offset >= 0 && length >= 0 && offset + length <= src.size) {
+            "Invalid range offset=$offset length=$length for ${src.size} bytes"
+        }
+        ensureCapacity(size + length)
+
+        val tail = (head + size) % data.size
+        val firstPart = minOf(length, data.size - tail)
+        System.arraycopy(src, offset, data, tail, firstPart)
+        if (firstPart < length) {
+            System.arraycopy(src, offset + firstPart, data, 0, length - firstPart)
+        }
+        size += length
+    }
+
+    /**
+     * Copy [length] bytes starting [start] bytes after the head into [dest]
+     */
+    fun copyTo(dest: ByteArray, destOffset: Int = 0, start: Int = 0, length: Int = size - start) {
+        checkRange(start, length)
+        require(destOffset >= 0 && destOffset + length <= dest.size) {
+            "Destination too small: need ${destOffset + length}, have ${dest.size}"
+        }
+
+        val from = (head + start) % data.size
+        val firstPart = minOf(length, data.size - from)
+        System.arraycopy(data, from, dest, destOffset, firstPart)
+        if (firstPart < length) {
+            System.arraycopy(data, 0, dest, destOffset + firstPart, length - firstPart)
+        }
+    }
+
+    /**
+     * Copy a range of the window into a new array (e.g. a window to transcribe)
+     */
+    fun toByteArray(start: Int = 0, length: Int = size - start): ByteArray {
+        val result = ByteArray(length)
+        copyTo(result, 0, start, length)
+        return result
+    }
+
+    /**
+     * Drop the oldest [count] bytes without copying
+     */
+    fun discard(count: Int) {
+        require(count in 0..size) { "Cannot discard $count of $size bytes" }
+        head = (head + count) % data.size
+        size -= count
+        if (size == 0) head = 0
+    }
+
+    /**
+     * Keep only the newest [count] bytes
+     */
+    fun retainLast(count: Int) {
+        discard(size - count.coerceIn(0, size))
+    }
+
+    fun clear() {
+        head = 0
+        size = 0
+    }
+
+    private fun checkRange(start: Int, length: Int) {
+        require(start >= 0 && length >= 0 && start + length <= size) {
+            "Invalid range start=$start length=$length for $size bytes"
+        }
+    }
+
+    private fun ensureCapacity(required: Int) {
+        if (required <= data.size) return
+
+        var newCapacity = data.size
+        while (newCapacity < required) newCapacity *= 2
+        val grown = ByteArray(newCapacity)
+        copyTo(grown, 0, 0, size)
+        data = grown
+        head = 0
+    }
+}
@@ -0,0 +1,97 @@
+package com.voiceinput.core
+
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+
+/**
+ * One lazily loaded engine shared by every client in the process, with a reference count.
+ *
+ * The first [acquire] loads the engine; later ones get the same instance, so opening the
+ * keyboard after the app (or the other way round) does not load the model again. [release]
+ * only drops the reference: the engine stays warm until [unloadIfIdle] or [close]. Loading,
+ * and therefore the first clients, are serialized by a fair lock; inference requests from
+ * all clients then queue on the engine's own decode lock.
+ *
+ * Generic in the engine type so the counting can be tested without ONNX Runtime.
+ */
+class SharedEngine<T : Any>(
+    private val load: suspend () -> T?,
+    private val unload: (T) -> Unit
+) {
+
+    private val lock = Mutex()
+    @Volatile private var engine: T? = null
+    @Volatile private var references = 0
+
+    val isLoaded: Boolean get() = engine != null
+
+    /** The loaded engine, without loading it or taking a reference */
+    val current: T? get() = engine
+
+    /** Clients holding a reference */
+    val clients: Int get() = references
+
+    /**
+     * Take a reference, loading the engine if needed
+     *
+     * @return The engine, or null if it failed to load (no reference is taken then)
+     */
+    suspend fun acquire(): T? = lock.withLock {
+        val loaded = engine ?: load()?.also { engine = it } ?: return@withLock null
+        references++
+        loaded
+    }
+
+    /**
+     * [acquire] and hand the engine to [build]; if [build] throws, the reference is dropped
+     * again before the exception propagates, so a client that fails to set up does not pin
+     * the engine
+     *
+     * @return What [build] returned, or null if the engine failed to load
+     */
+    suspend fun <R> acquireFor(build: suspend (T) -> R): R? {
+        val loaded = acquire() ?: return null
+        return try {
+            build(loaded)
+        } catch (e: Throwable) {
+            release()
+            throw e
+        }
+    }
+
+    /**
+     * Drop a reference taken by [acquire]; the engine stays loaded
+     */
+    suspend fun release() = lock.withLock {
+        if (references > 0) references--
+    }
+
+    /**
+     * Load the engine without taking a reference (pre-warm)
+     */
+    suspend fun warmUp(): Boolean = lock.withLock {
+        engine != null || load()?.also { engine = it } != null
+    }
+
+    /**
+     * Unload the engine if no client holds it
+     *
+     * @return True if it was unloaded
+     */
+    suspend fun unloadIfIdle(): Boolean = lock.withLock {
+        val loaded = engine
+        if (loaded == null || references > 0) return@withLock false
+        engine = null
+        unload(loaded)
+        true
+    }
+
+    /**
+     * Unload the engine regardless of references (host shutting down)
+     */
+    suspend fun close() = lock.withLock {
+        engine?.let(unload)
+        engine = null
+        references = 0
+    }
+}
@@ -4,9 +4,9 @@ import android.content.Context
 import android.util.Log
 import ai.onnxruntime.*
 import com.voiceinput.config.AppConfig
+import com.voiceinput.onnx.ModelLoader
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
-import java.io.IOException
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.nio.FloatBuffer
@@ -17,6 +17,11 @@ import java.nio.FloatBuffer
  *
  * Handles voice activity detection using the Silero VAD model with ONNX Runtime.
  * Maintains the same logic and configuration as the desktop version but adapted for Android.
+ *
+ * Audio is streamed through [processFrames], which cuts it into the exact windows the model
+ * was trained on (512 samples at 16kHz) and carries partial windows over to the next call.
+ * All tensors live on direct buffers allocated once; the recurrent state ping-pongs between
+ * two pinned tensors, so steady-state inference allocates nothing per frame.
  */
 class SileroVAD(
     private val context: Context,
@@ -27,17 +32,36 @@ class SileroVAD(
         private const val TAG = "SileroVAD"
         private const val MODEL_FILENAME = "silero_vad.onnx"
 
-        // VAD frame settings (matching desktop implementation)
-        private const val FRAME_DURATION_MS = 30 // Silero examples use 30ms frames
         private const val BYTES_PER_SAMPLE = 2   // 16-bit PCM = 2 bytes per sample
+
+        // Recurrent state shape [2, batch, 128]
+        private val STATE_SHAPE = longArrayOf(2, 1, 128)
+        private const val STATE_SIZE = 2 * 1 * 128
     }
 
     private var ortEnvironment: OrtEnvironment? = null
     private var ortSession: OrtSession? = null
     private var initialized = false
 
-    // State tensor for stateful RNN (shape [2, None, 128])
-    private var stateState: OnnxTensor? = null
+    // Pinned I/O tensors over direct buffers (see allocateTensors)
+    private var inputBuffer: FloatBuffer? = null    // [1, context + frame]
+    private var inputTensor: OnnxTensor? = null
+    private var sampleRateTensor: OnnxTensor? = null
+    private var probabilityBuffer: FloatBuffer? = null
+    private var probabilityTensor: OnnxTensor? = null
+    private val stateBuffers = arrayOfNulls<FloatBuffer>(2)
+    private val stateTensors = arrayOfNulls<OnnxTensor>(2)
+    private var currentState = 0 // Index of the state tensor fed as input
+    private val inputs = HashMap<String, OnnxTensor>(4)
+    private val pinnedOutputs = HashMap<String, OnnxValue>(2)
+    private var probabilityOutputName = "output"
+    private var stateOutputName = "stateN"
+
+    // Streaming position: bytes of an incomplete frame carried between calls
+    private var pendingFrame = ByteArray(0)
+    private var frameScratch = FloatArray(0)
+    private var pendingBytes = 0
+    private var processedSamples = 0L
 
     // State tracking for smarter logging
     private var lastLogTime = 0L
@@ -48,8 +72,10 @@ class SileroVAD(
     private var sampleRate: Int = config.audio.sampleRate
     private var vadThreshold: Float = config.audio.vadThreshold
 
-    // Frame size calculations (matching desktop logic)
-    private val frameSizeSamples: Int = (sampleRate * (FRAME_DURATION_MS / 1000.0)).toInt()
+    // Silero v5 window: 512 samples at 16kHz (256 at 8kHz), each preceded by the last
+    // 64 (32) samples of the previous window as context
+    private val frameSizeSamples: Int = if (sampleRate == 8000) 256 else 512
+    private val contextSamples: Int = if (sampleRate == 8000) 32 else 64
     private val frameSizeBytes: Int = frameSizeSamples * BYTES_PER_SAMPLE
 
     init {
@@ -59,7 +85,7 @@ class SileroVAD(
                       "Current config rate is ${sampleRate}Hz. VAD might not work as expected.")
         }
 
-        Log.d(TAG, "VAD Frame size: $frameSizeBytes bytes (${FRAME_DURATION_MS}ms) at ${sampleRate}Hz")
+        Log.d(TAG, "VAD Frame size: $frameSizeBytes bytes (${getFrameDurationMs()}ms) at ${sampleRate}Hz")
 
         initializeDetector()
     }
@@ -75,11 +101,6 @@ class SileroVAD(
             // Initialize ONNX Runtime environment
             ortEnvironment = OrtEnvironment.getEnvironment()
 
-            // Load model from assets
-            val modelBytes = context.assets.open("models/$MODEL_FILENAME").use { inputStream ->
-                inputStream.readBytes()
-            }
-
             // Create session options for Android optimization
             val sessionOptions = OrtSession.SessionOptions().apply {
                 // Use CPU provider for maximum compatibility
@@ -93,13 +114,14 @@ class SileroVAD(
             }
 
             // Create ONNX session
-            ortSession = ortEnvironment!!.createSession(modelBytes, sessionOptions)
+            // Memory-mapped from the APK, no heap copy of the model
+            ortSession = ModelLoader.createSession(ortEnvironment!!, context, "models/$MODEL_FILENAME", sessionOptions)
 
             // Validate model input/output shapes
             validateModelShapes()
 
-            // Initialize state tensor (shape [2, 1, 128])
-            initializeStateTensor()
+            // Allocate pinned input/output tensors once
+            allocateTensors()
 
             initialized = true
             Log.i(TAG, "Silero VAD model loaded successfully")
@@ -161,274 +183,208 @@ class SileroVAD(
     }
 
     /**
-     * Determine if audio chunk is silent using Silero VAD.
-     * Port of desktop is_silent() method with identical logic.
+     * Run VAD over a stream of audio, one probability per model window.
      *
-     * @param audioChunk Raw audio bytes (16-bit PCM, matching sample_rate) to analyze.
-     *                   Should ideally be a multiple of frame_size_bytes, but the underlying
-     *                   model can handle variable lengths.
-     * @return True if audio is determined to be silent, False if speech is detected (or if VAD failed).
+     * Consecutive calls form one continuous stream: an incomplete trailing window is kept
+     * and completed by the next call, and timestamps count from the last [resetStream].
+     *
+     * @param audioChunk Raw audio bytes (16-bit PCM little-endian, matching sample_rate), any length
+     * @return Probabilities for every window completed by this chunk (empty if VAD failed)
      */
-    suspend fun isSilent(audioChunk: ByteArray): Boolean = withContext(Dispatchers.Default) {
-        // Fail-safe checks (matching desktop behavior)
+    suspend fun processFrames(audioChunk: ByteArray): List<VadFrame> = withContext(Dispatchers.Default) {
         if (!initialized || ortSession == null) {
-            Log.w(TAG, "Silero VAD not initialized, cannot perform silence detection. Assuming NOT silent.")
-            return@withContext false // Fail safe: assume not silent if VAD isn't working
-        }
-
-        if (audioChunk.isEmpty()) {
-            Log.d(TAG, "Received empty audio chunk, assuming silent.")
-            return@withContext true
+            return@withContext emptyList()
         }
 
+        val frames = ArrayList<VadFrame>(audioChunk.size / frameSizeBytes + 1)
         try {
-            // Convert bytes to float32 array (matching desktop preprocessing)
-            val audioFloat32 = convertBytesToFloat32(audioChunk)
-
-            // Run inference with both audio and sample rate (matching desktop behavior)
-            val speechProb = runInference(audioFloat32)
-
-            // Apply threshold from config (matching desktop logic)
-            val isSpeech = speechProb >= vadThreshold
-
-            // Smart logging: only log significant state changes (reduce noise)
-            val currentTime = System.currentTimeMillis()
-            val timeSinceLastLog = currentTime - lastLogTime
-            
-            if (isSpeech != lastSpeechState) {
-                // Only log if it's a significant change (not micro-speech)
-                if (isSpeech) {
-                    Log.i(TAG, "🎤 Speech started: prob=${"%.3f".format(speechProb)}")
-                    consecutiveSpeechFrames = 1
-                } else {
-                    // Only log speech end if it was a significant duration
-                    if (consecutiveSpeechFrames >= 10) { // At least 300ms of speech
-                        Log.i(TAG, "🔇 Speech ended after ${consecutiveSpeechFrames} frames")
-                    }
-                    consecutiveSpeechFrames = 0
+            var offset = 0
+
+            // Complete the window left over from the previous chunk
+            if (pendingBytes > 0) {
+                val copied = minOf(frameSizeBytes - pendingBytes, audioChunk.size)
+                System.arraycopy(audioChunk, 0, pendingFrame, pendingBytes, copied)
+                pendingBytes += copied
+                offset = copied
+                if (pendingBytes < frameSizeBytes) {
+                    return@withContext frames
                 }
-                lastLogTime = currentTime
-            } else if (isSpeech && timeSinceLastLog > 3000) {
-                // Periodic update during speech: log every 3 seconds max
-                Log.d(TAG, "🎤 Speech continuing: prob=${"%.3f".format(speechProb)} (${consecutiveSpeechFrames} frames)")
-                lastLogTime = currentTime
+                frames.add(emitFrame(runFrame(pendingFrame, 0)))
+                pendingBytes = 0
             }
-            
-            if (isSpeech) {
-                consecutiveSpeechFrames++
-            }
-            lastSpeechState = isSpeech
 
-            return@withContext !isSpeech // Return true if silent (i.e., not speech)
+            // Full windows straight from the chunk, no intermediate copies
+            while (offset + frameSizeBytes <= audioChunk.size) {
+                frames.add(emitFrame(runFrame(audioChunk, offset)))
+                offset += frameSizeBytes
+            }
 
+            pendingBytes = audioChunk.size - offset
+            System.arraycopy(audioChunk, offset, pendingFrame, 0, pendingBytes)
         } catch (e: Exception) {
             Log.e(TAG, "Error during Silero VAD processing: ${e.message}")
-            
-            // On tensor shape errors, reinitialize state to prevent corruption
-            if (e.message?.contains("dimensions") == true || e.message?.contains("shape") == true) {
-                Log.w(TAG, "Tensor shape error detected - reinitializing state tensor")
-                try {
-                    stateState?.close()
-                    initializeStateTensor()
-                } catch (reinitError: Exception) {
-                    Log.e(TAG, "Failed to reinitialize state tensor: ${reinitError.message}")
-                }
-            }
-            
-            return@withContext false // Fail safe: assume not silent on error
+            // Corrupted recurrent state would skew every following frame
+            resetState()
         }
+        frames
     }
 
     /**
-     * Convert audio bytes to float32 array.
-     * Matches desktop conversion: audio_int16.astype(np.float32) / 32768.0
+     * Determine if audio chunk is silent using Silero VAD.
+     * Port of desktop is_silent() method with identical logic.
+     *
+     * @param audioChunk Raw audio bytes (16-bit PCM, matching sample_rate) to analyze.
+     *                   Streamed through [processFrames]; any length is accepted.
+     * @return True if audio is determined to be silent, False if speech is detected (or if VAD failed).
      */
-    private fun convertBytesToFloat32(audioBytes: ByteArray): FloatArray {
-        val byteBuffer = ByteBuffer.wrap(audioBytes)
-            .order(ByteOrder.LITTLE_ENDIAN) // Ensure little-endian byte order
+    suspend fun isSilent(audioChunk: ByteArray): Boolean {
+        // Fail-safe checks (matching desktop behavior)
+        if (!initialized || ortSession == null) {
+            Log.w(TAG, "Silero VAD not initialized, cannot perform silence detection. Assuming NOT silent.")
+            return false // Fail safe: assume not silent if VAD isn't working
+        }
 
-        val audioFloat32 = FloatArray(audioBytes.size / 2) // 16-bit samples = 2 bytes per sample
+        if (audioChunk.isEmpty()) {
+            Log.d(TAG, "Received empty audio chunk, assuming silent.")
+            return true
+        }
+
+        val frames = processFrames(audioChunk)
+        if (frames.isEmpty()) {
+            // Not a full window yet (or VAD failed) - assume speech so the first word isn't lost
+            return false
+        }
 
-        for (i in audioFloat32.indices) {
-            if (byteBuffer.remaining() >= 2) {
-                val int16Sample = byteBuffer.short
-                audioFloat32[i] = int16Sample.toFloat() / 32768.0f // Normalize to [-1.0, 1.0]
+        // Apply threshold from config (matching desktop logic)
+        val speechProb = frames.maxOf { it.probability }
+        val isSpeech = speechProb >= vadThreshold
+
+        // Smart logging: only log significant state changes (reduce noise)
+        val currentTime = System.currentTimeMillis()
+        val timeSinceLastLog = currentTime - lastLogTime
+
+        if (isSpeech != lastSpeechState) {
+            // Only log if it's a significant change (not micro-speech)
+            if (isSpeech) {
+                Log.i(TAG, "🎤 Speech started at ${frames.first { it.isSpeech }.timestampMs}ms: prob=${"%.3f".format(speechProb)}")
+                consecutiveSpeechFrames = 0
+            } else {
+                // Only log speech end if it was a significant duration
+                if (consecutiveSpeechFrames >= 10) { // At least 320ms of speech
+                    Log.i(TAG, "🔇 Speech ended after ${consecutiveSpeechFrames} frames")
+                }
+                consecutiveSpeechFrames = 0
             }
+            lastLogTime = currentTime
+        } else if (isSpeech && timeSinceLastLog > 3000) {
+            // Periodic update during speech: log every 3 seconds max
+            Log.d(TAG, "🎤 Speech continuing: prob=${"%.3f".format(speechProb)} (${consecutiveSpeechFrames} frames)")
+            lastLogTime = currentTime
         }
 
-        return audioFloat32
+        consecutiveSpeechFrames += frames.count { it.isSpeech }
+        lastSpeechState = isSpeech
+
+        return !isSpeech // Return true if silent (i.e., not speech)
     }
 
     /**
-     * Create ONNX input tensor from float32 audio array
-     * NOTE: Starting with simple single-input approach, may need to add sample rate later
+     * Start a new stream: drop any partial window, zero the recurrent state and timestamps
      */
-    private fun createInputTensor(audioFloat32: FloatArray): OnnxTensor {
-        val ortEnvironment = this.ortEnvironment ?: throw IllegalStateException("ORT environment not initialized")
-
-        // Create audio tensor - trying different shapes to match model expectations
-        // Most ONNX Silero models expect shape [1, audio_length] (batch_size=1)
-        val shape = longArrayOf(1, audioFloat32.size.toLong())
-        val floatBuffer = FloatBuffer.wrap(audioFloat32)
+    fun resetStream() {
+        pendingBytes = 0
+        processedSamples = 0L
+        resetState()
+    }
 
-        return OnnxTensor.createTensor(ortEnvironment, floatBuffer, shape)
+    private fun emitFrame(probability: Float): VadFrame {
+        val frame = VadFrame(
+            timestampMs = processedSamples * 1000 / sampleRate,
+            probability = probability,
+            isSpeech = probability >= vadThreshold
+        )
+        processedSamples += frameSizeSamples
+        return frame
     }
 
     /**
-     * Run inference with audio, sample rate, and state inputs (stateful RNN)
+     * Run one model window starting at [offset] in [pcm].
+     * Matches desktop conversion: audio_int16.astype(np.float32) / 32768.0
      */
-    private fun runInference(audioFloat32: FloatArray): Float {
-        val ortSession = this.ortSession ?: throw IllegalStateException("ORT session not initialized")
-
-        // Create all input tensors (audio, sample rate, h0, c0)
-        val inputs = createMultiInputTensors(audioFloat32)
-
-        try {
-            val result = ortSession.run(inputs)
-            try {
-                // Get output tensor (Silero VAD outputs speech probability + updated states)
-                val outputTensor = result.get(0) as OnnxTensor
-                val outputArray = outputTensor.floatBuffer.array()
-
-                // Update state tensor from model output for next inference
-                updateStateTensor(result)
-
-                // Return speech probability
-                return outputArray[0]
-            } finally {
-                // Close the result to free resources
-                result.close()
-            }
-        } finally {
-            // Clean up only the temporary input tensors (not the persistent state tensor)
-            inputs["input"]?.close()
-            inputs["sr"]?.close()
-            // Note: state tensor is persistent and should not be closed here
+    private fun runFrame(pcm: ByteArray, offset: Int): Float {
+        val session = ortSession ?: throw IllegalStateException("ORT session not initialized")
+        val input = inputBuffer ?: throw IllegalStateException("VAD tensors not allocated")
+
+        AudioUtils.pcmToFloat(pcm, offset, frameSizeSamples, frameScratch)
+        input.position(contextSamples)
+        input.put(frameScratch, 0, frameSizeSamples)
+        input.rewind()
+
+        // The output state of this frame becomes the input state of the next
+        inputs["state"] = stateTensors[currentState]!!
+        pinnedOutputs[stateOutputName] = stateTensors[1 - currentState]!!
+        session.run(inputs, pinnedOutputs).close()
+        currentState = 1 - currentState
+
+        // Last samples of this window are the context for the next one
+        for (i in 0 until contextSamples) {
+            input.put(i, input.get(frameSizeSamples + i))
         }
+
+        return probabilityBuffer!!.get(0)
     }
 
     /**
-     * Update state tensor from model output for next inference
+     * Allocate the pinned tensors used by every frame
      */
-    private fun updateStateTensor(result: OrtSession.Result) {
-        try {
-            // The model should output updated state tensor
-            if (result.size() >= 2) {
-                val newStateTensor = result.get(1) as OnnxTensor
-
-                // For Silero VAD, we need exactly [2, 1, 128] shape for the state tensor
-                // The model might output this in different arrangements, so we need to handle it properly
-                val ortEnvironment = this.ortEnvironment ?: throw IllegalStateException("ORT environment not initialized")
-
-                // Get the raw state data
-                val outputBuffer = newStateTensor.floatBuffer
-                val outputData = FloatArray(outputBuffer.remaining())
-                outputBuffer.get(outputData)
-                outputBuffer.rewind() // Reset buffer position
-
-                // Expected size for [2, 1, 128] = 256 floats
-                val expectedSize = 2 * 1 * 128
-
-                val stateData = when {
-                    // Perfect size match - reshape if needed
-                    outputData.size == expectedSize -> {
-                        outputData
-                    }
-                    // Too much data - take first 256 floats
-                    outputData.size > expectedSize -> {
-                        outputData.sliceArray(0 until expectedSize)
-                    }
-                    // Too little data - pad with zeros
-                    else -> {
-                        Log.w(TAG, "Insufficient state data (${outputData.size}), padding to $expectedSize")
-                        val paddedData = FloatArray(expectedSize)
-                        outputData.copyInto(paddedData, 0, 0, minOf(outputData.size, expectedSize))
-                        paddedData
-                    }
-                }
-
-                // Close old state tensor
-                stateState?.close()
+    private fun allocateTensors() {
+        val env = ortEnvironment ?: throw IllegalStateException("ORT environment not initialized")
+        val session = ortSession ?: throw IllegalStateException("ORT session not initialized")
 
-                // Create new state tensor with correct shape [2, 1, 128]
-                val stateBuffer = FloatBuffer.wrap(stateData)
-                val correctStateShape = longArrayOf(2, 1, 128)
-                stateState = OnnxTensor.createTensor(ortEnvironment, stateBuffer, correctStateShape)
+        val outputNames = session.outputNames.toList()
+        probabilityOutputName = outputNames.getOrElse(0) { probabilityOutputName }
+        stateOutputName = outputNames.getOrElse(1) { stateOutputName }
 
-                // State tensor updated successfully
-            } else {
-                Log.w(TAG, "Model output doesn't contain state tensor (size=${result.size()})")
-            }
-        } catch (e: Exception) {
-            Log.e(TAG, "Error updating state tensor: ${e.message}", e)
-
-            // On critical error, reinitialize state tensor to prevent further corruption
-            try {
-                stateState?.close()
-                initializeStateTensor()
-                Log.i(TAG, "State tensor reinitialized due to update error")
-            } catch (reinitError: Exception) {
-                Log.e(TAG, "Failed to reinitialize state tensor: ${reinitError.message}", reinitError)
-            }
-        }
-    }
+        val input = directFloatBuffer(contextSamples + frameSizeSamples)
+        inputBuffer = input
+        inputTensor = OnnxTensor.createTensor(env, input, longArrayOf(1, (contextSamples + frameSizeSamples).toLong()))
 
-    /**
-     * Initialize state tensor for stateful RNN (shape [2, 1, 128])
-     */
-    private fun initializeStateTensor() {
-        val ortEnvironment = this.ortEnvironment ?: throw IllegalStateException("ORT environment not initialized")
+        // Sample rate as an int64 scalar (no shape dimensions)
+        val sr = ByteBuffer.allocateDirect(8).order(ByteOrder.nativeOrder()).asLongBuffer()
+        sr.put(0, sampleRate.toLong())
+        sampleRateTensor = OnnxTensor.createTensor(env, sr, longArrayOf())
 
-        // Initialize state tensor as zeros with shape [2, 1, 128]
-        val stateShape = longArrayOf(2, 1, 128)
-        val stateData = FloatArray(2 * 1 * 128) // All zeros
-        val stateBuffer = FloatBuffer.wrap(stateData)
+        val probability = directFloatBuffer(1)
+        probabilityBuffer = probability
+        probabilityTensor = OnnxTensor.createTensor(env, probability, longArrayOf(1, 1))
 
-        stateState = OnnxTensor.createTensor(ortEnvironment, stateBuffer, stateShape)
+        for (i in 0..1) {
+            val state = directFloatBuffer(STATE_SIZE)
+            stateBuffers[i] = state
+            stateTensors[i] = OnnxTensor.createTensor(env, state, STATE_SHAPE)
+        }
+        currentState = 0
+        pendingFrame = ByteArray(frameSizeBytes)
+        frameScratch = FloatArray(frameSizeSamples)
 
-        // State tensor initialized with shape [2, 1, 128]
+        inputs["input"] = inputTensor!!
+        inputs["sr"] = sampleRateTensor!!
+        pinnedOutputs[probabilityOutputName] = probabilityTensor!!
     }
 
     /**
-     * Create input tensors: audio, state, and sample rate (stateful mode)
+     * Zero the recurrent state and audio context (direct buffers are written in place)
      */
-    private fun createMultiInputTensors(audioFloat32: FloatArray): Map<String, OnnxTensor> {
-        val ortEnvironment = this.ortEnvironment ?: throw IllegalStateException("ORT environment not initialized")
-
-        // Create audio tensor with shape [1, audio_length] (batch_size=1)
-        val audioShape = longArrayOf(1, audioFloat32.size.toLong())
-        val audioBuffer = FloatBuffer.wrap(audioFloat32)
-        val audioTensor = OnnxTensor.createTensor(ortEnvironment, audioBuffer, audioShape)
-
-        // Create sample rate tensor as int64 scalar (no shape dimensions)
-        val sampleRateArray = longArrayOf(sampleRate.toLong())
-        val sampleRateBuffer = java.nio.LongBuffer.wrap(sampleRateArray)
-        val sampleRateTensor = OnnxTensor.createTensor(ortEnvironment, sampleRateBuffer, longArrayOf())
-
-        // Ensure we have a valid persistent state tensor [2, 1, 128]
-        val expectedStateShape = longArrayOf(2, 1, 128)
-        val currentStateShape = stateState?.info?.shape
-        val stateIsValid = currentStateShape != null &&
-                currentStateShape.size == expectedStateShape.size &&
-                currentStateShape.zip(expectedStateShape).all { (a, b) -> a == b }
-
-        if (!stateIsValid) {
-            Log.w(TAG, "DEBUG: Persistent state tensor missing or wrong shape: [${currentStateShape?.joinToString(",")}] → reinitializing")
-            initializeStateTensor()
+    private fun resetState() {
+        stateBuffers.forEach { buffer ->
+            buffer?.let { for (i in 0 until it.capacity()) it.put(i, 0f) }
         }
-
-        // Use the persistent state tensor for stateful operation
-        val stateTensor = stateState
-
-        // Using persistent state tensor (stateful mode)
-
-        return mapOf(
-            "input" to audioTensor,
-            "state" to requireNotNull(stateTensor) { "State tensor should be initialized" },
-            "sr" to sampleRateTensor
-        )
+        inputBuffer?.let { for (i in 0 until contextSamples) it.put(i, 0f) }
     }
 
+    private fun directFloatBuffer(size: Int): FloatBuffer =
+        ByteBuffer.allocateDirect(size * 4).order(ByteOrder.nativeOrder()).asFloatBuffer()
+
     /**
      * Update VAD settings from the stored config object.
      * Port of desktop update_settings() method
@@ -463,7 +419,7 @@ class SileroVAD(
     /**
      * Get current frame duration in milliseconds
      */
-    fun getFrameDurationMs(): Int = FRAME_DURATION_MS
+    fun getFrameDurationMs(): Int = frameSizeSamples * 1000 / sampleRate
 
     /**
      * Check if VAD is properly initialized
@@ -476,9 +432,7 @@ class SileroVAD(
      */
     fun close() {
         try {
-            // Close state tensor
-            stateState?.close()
-            stateState = null
+            closeTensors()
 
             ortSession?.close()
             ortEnvironment?.close()
@@ -489,18 +443,32 @@ class SileroVAD(
         }
     }
 
+    private fun closeTensors() {
+        inputs.clear()
+        pinnedOutputs.clear()
+        inputTensor?.close()
+        sampleRateTensor?.close()
+        probabilityTensor?.close()
+        stateTensors.forEach { it?.close() }
+        inputTensor = null
+        inputBuffer = null
+        sampleRateTensor = null
+        probabilityTensor = null
+        probabilityBuffer = null
+        stateTensors.fill(null)
+        stateBuffers.fill(null)
+    }
+
     /**
      * Clean up resources (called internally on initialization failure)
      * Fixed: Each resource cleaned independently to prevent cascading failures
      */
     private fun cleanup() {
-        // Close state tensor independently
+        // Close pinned tensors independently
         try {
-            stateState?.close()
+            closeTensors()
         } catch (e: Exception) {
-            Log.e(TAG, "Error closing state tensor: ${e.message}", e)
-        } finally {
-            stateState = null
+            Log.e(TAG, "Error closing VAD tensors: ${e.message}", e)
         }
 
         // Close session independently
@@ -521,4 +489,17 @@ class SileroVAD(
             ortEnvironment = null
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * VAD result for one model window
+ *
+ * @param timestampMs Start of the window, counted from the start of the stream
+ * @param probability Speech probability from the model
+ * @param isSpeech probability >= configured threshold
+ */
+data class VadFrame(
+    val timestampMs: Long,
+    val probability: Float,
+    val isSpeech: Boolean
+)
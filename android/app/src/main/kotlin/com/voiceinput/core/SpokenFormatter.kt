@@ -0,0 +1,163 @@
+package com.voiceinput.core
+
+/**
+ * Turns spoken structured data into symbols in a single pass over the words.
+ *
+ * Examples:
+ * - "john dot smith at gmail dot com" → "john.smith@gmail.com"
+ * - "docs dot google dot com" → "docs.google.com"
+ * - "w w w dot example dot org" → "www.example.org"
+ * - "https colon slash slash example dot org slash docs" → "https://example.org/docs"
+ *
+ * Spoken separators come from one table ([SEPARATORS]). A run of words joined by separators
+ * is only rewritten when it reads as an email, a www or protocol URL, or a domain ending in
+ * a known TLD, so "look at this" is left alone. Every rule is a hash lookup per word, so the
+ * cost stays linear in the text however many separators or TLDs are added.
+ *
+ * Mirrors SpokenFormatter in desktop/voice_input_service/utils/text_processor.py; keep the
+ * tables in sync.
+ */
+object SpokenFormatter {
+
+    /** Spoken separator words and the symbol each one stands for */
+    val SEPARATORS = mapOf(
+        "at" to "@",
+        "dot" to ".",
+        "colon" to ":",
+        "slash" to "/",
+        "underscore" to "_",
+        "dash" to "-"
+    )
+
+    /** Endings that make "word dot word" a domain (and an email host valid) */
+    val TLDS = setOf(
+        "com", "org", "net", "edu", "gov", "io", "co", "uk", "de", "fr", "jp", "cn",
+        "dev", "app", "ai", "me", "us", "ca", "au", "in", "info", "biz"
+    )
+
+    private val PROTOCOLS = setOf("http", "https", "ftp")
+
+    // Punctuation that may trail the last word of an address ("... gmail dot com.")
+    private const val TRAILING_PUNCTUATION = ".,!?;:"
+
+    private class Token(val text: String, val core: String, val lower: String) {
+        val trailing: String get() = text.substring(core.length)
+        val isLabel: Boolean = core.isNotEmpty() && core.all { it.isLetterOrDigit() } && lower !in SEPARATORS
+        val separator: String? = if (core.length == text.length) SEPARATORS[lower] else null
+    }
+
+    fun format(text: String): String {
+        val tokens = tokenize(text)
+        if (tokens.none { it.separator != null }) return tokens.joinToString(" ") { it.text }
+
+        val out = StringBuilder(text.length)
+        var i = 0
+        while (i < tokens.size) {
+            val end = matchAddress(tokens, i)
+            if (out.isNotEmpty()) out.append(' ')
+            if (end < 0) {
+                out.append(tokens[i].text)
+                i++
+            } else {
+                appendAddress(out, tokens, i, end)
+                i = end + 1
+            }
+        }
+        return out.toString()
+    }
+
+    private fun tokenize(text: String): List<Token> {
+        val tokens = ArrayList<Token>()
+        var index = 0
+        while (index < text.length) {
+            while (index < text.length && text[index].isWhitespace()) index++
+            val start = index
+            while (index < text.length && !text[index].isWhitespace()) index++
+            if (index > start) {
+                val word = text.substring(start, index)
+                val core = word.trimEnd { it in TRAILING_PUNCTUATION }
+                tokens.add(Token(word, core, core.lowercase()))
+            }
+        }
+        return tokens
+    }
+
+    // "w w w" spoken letter by letter counts as one label
+    private fun spokenWwwLength(tokens: List<Token>, start: Int): Int {
+        if (start + 2 >= tokens.size) return 0
+        for (k in start until start + 3) {
+            val token = tokens[k]
+            if (token.lower != "w" || (k < start + 2 && token.trailing.isNotEmpty())) return 0
+        }
+        return 3
+    }
+
+    /**
+     * Index of the last token of the longest address starting at [start], or -1
+     */
+    private fun matchAddress(tokens: List<Token>, start: Int): Int {
+        var index = start
+        var protocol = false
+        val first = tokens[index]
+        if (first.lower in PROTOCOLS && first.trailing.isEmpty() && index + 4 < tokens.size &&
+            tokens[index + 1].separator == ":" && tokens[index + 2].separator == "/" &&
+            tokens[index + 3].separator == "/"
+        ) {
+            protocol = true
+            index += 4
+        }
+
+        var www = false
+        val wwwLength = spokenWwwLength(tokens, index)
+        val labelEnd = when {
+            wwwLength > 0 -> { www = true; index + wwwLength - 1 }
+            tokens[index].isLabel -> { www = tokens[index].lower == "www"; index }
+            else -> return -1
+        }
+
+        var ats = 0
+        var dots = 0
+        var dotsAfterAt = 0
+        var inPath = false
+        var hostLabel = tokens[labelEnd].lower
+        var best = -1
+        var last = labelEnd
+        while (tokens[last].trailing.isEmpty() && last + 2 < tokens.size) {
+            val separator = tokens[last + 1].separator ?: break
+            val label = tokens[last + 2]
+            if (!label.isLabel) break
+            when (separator) {
+                "@" -> if (ats > 0 || protocol || www || inPath) break else ats++
+                "." -> { dots++; if (ats > 0) dotsAfterAt++ }
+                "/" -> if (dots == 0 || ats > 0) break else inPath = true
+                ":" -> break
+            }
+            last += 2
+            if (!inPath) hostLabel = label.lower
+
+            val valid = when {
+                protocol -> dots > 0
+                www -> dots >= 2
+                ats > 0 -> dotsAfterAt > 0 && hostLabel in TLDS
+                else -> dots > 0 && hostLabel in TLDS
+            }
+            if (valid) best = last
+        }
+        return best
+    }
+
+    private fun appendAddress(out: StringBuilder, tokens: List<Token>, start: Int, end: Int) {
+        var index = start
+        while (index <= end) {
+            val token = tokens[index]
+            val letters = if (token.lower == "w") spokenWwwLength(tokens, index) else 0
+            when {
+                letters > 0 -> { out.append("www"); index += letters; continue }
+                token.separator != null -> out.append(token.separator)
+                else -> out.append(token.core)
+            }
+            index++
+        }
+        out.append(tokens[end].trailing)
+    }
+}
@@ -27,11 +27,23 @@ class TextProcessor(
         // Regular expression for matching timestamp patterns from whisper.cpp
         // Pattern: [00:00:00.000 --> 00:00:05.000]
         private val TIMESTAMP_PATTERN = Regex("""\[\d{2}:\d{2}:\d{2}\.\d{3}\s+-->\s+\d{2}:\d{2}:\d{2}\.\d{3}\]\s*""")
+
+        // Compiled once: appendText runs for every window of a session
+        private val WHITESPACE = Regex("""\s+""")
+        private val CASE_BOUNDARY = Regex("""(?<=[a-z])(?=[A-Z])""")
+        private val PUNCTUATION_BOUNDARY = Regex("""(?<=[.,!?])(?=[A-Za-z])""")
+        private val NON_WORD = Regex("""[^\p{L}\p{N}'\s-]""")
+
+        // Overlap search window of appendText (in boundary tokens)
+        private const val MAX_OVERLAP_WORDS = 12
+        // Words of accumulated text that appendText needs to see; with margin for words that
+        // are only punctuation and produce no boundary token
+        private const val BOUNDARY_TAIL_WORDS = 2 * MAX_OVERLAP_WORDS
     }
 
     // Custom vocabulary corrections (personalized)
     // Maps common misrecognitions to correct terms
-    private val customVocabulary = mapOf(
+    private val customVocabulary = listOf(
         // Personal identifiers (GitHub username)
         "nitiocard" to "Nydiokar",
         "nydiokar" to "Nydiokar",  // Already correct but ensure capitalization
@@ -42,7 +54,7 @@ class TextProcessor(
 
         // Add more as you discover them
         // "some wrong phrase" to "correct phrase"
-    )
+    ).map { (wrong, correct) -> Regex("\\b$wrong\\b", RegexOption.IGNORE_CASE) to correct }
 
     // Hallucination patterns - common Whisper artifacts
     private val hallucinationPatterns = listOf(
@@ -102,7 +114,7 @@ class TextProcessor(
         var cleanText = TIMESTAMP_PATTERN.replace(text, "")
 
         // Replace multiple spaces with single space and trim
-        cleanText = cleanText.replace(Regex("""\s+"""), " ").trim()
+        cleanText = cleanText.replace(WHITESPACE, " ").trim()
 
         return cleanText
     }
@@ -179,7 +191,7 @@ class TextProcessor(
         }
 
         // Check long transcripts for hallucinations at start/end
-        val words = processedText.split(Regex("""\s+"""))
+        val words = processedText.split(WHITESPACE)
         if (words.size > 50) {
             // Look for hallucinations at start or end of long texts
             val firstFew = words.take(3).joinToString(" ").lowercase()
@@ -229,7 +241,7 @@ class TextProcessor(
         }
 
         // Check word count for regular text
-        val wordCount = cleanText.split(Regex("""\s+""")).size
+        val wordCount = cleanText.split(WHITESPACE).size
         return wordCount >= minWords
     }
 
@@ -320,6 +332,26 @@ class TextProcessor(
         return normalizeChunkBoundaryText("$result$separator$appendPart")
     }
 
+    /**
+     * Start of the part of [accumulated] that [appendText] reads and may rewrite: its last
+     * words, starting right after a space (0 for short text).
+     *
+     * For text built by appendText, only this tail can change, so appendText(accumulated, x)
+     * equals accumulated.substring(0, start) + appendText(tail, x).
+     * [Transcript] relies on this to keep appends independent of the session length.
+     */
+    fun boundaryTailStart(accumulated: CharSequence): Int {
+        var words = 0
+        var index = accumulated.length - 1
+        while (index > 0) {
+            if (accumulated[index].isWhitespace() && !accumulated[index - 1].isWhitespace()) {
+                if (++words >= BOUNDARY_TAIL_WORDS) return index + 1
+            }
+            index--
+        }
+        return 0
+    }
+
     private fun determineChunkSeparator(accumulated: String, newText: String): String {
         val lastCharAcc = accumulated.lastOrNull() ?: return ""
         val firstCharNew = newText.firstOrNull() ?: return ""
@@ -359,7 +391,7 @@ class TextProcessor(
     private fun findWordOverlap(accumulated: String, newText: String): Int {
         val accumulatedWords = tokenizeForBoundaryMatch(accumulated)
         val newWords = tokenizeForBoundaryMatch(newText)
-        val maxWords = minOf(accumulatedWords.size, newWords.size, 12)
+        val maxWords = minOf(accumulatedWords.size, newWords.size, MAX_OVERLAP_WORDS)
 
         for (overlap in maxWords downTo 2) {
             if (accumulatedWords.takeLast(overlap) == newWords.take(overlap)) {
@@ -389,8 +421,8 @@ class TextProcessor(
     private fun tokenizeForBoundaryMatch(text: String): List<String> {
         return text
             .lowercase()
-            .replace(Regex("""[^\p{L}\p{N}'\s-]"""), " ")
-            .split(Regex("""\s+"""))
+            .replace(NON_WORD, " ")
+            .split(WHITESPACE)
             .filter { it.isNotEmpty() }
             .takeLast(MAX_OVERLAP)
     }
@@ -399,15 +431,15 @@ class TextProcessor(
         if (text.isEmpty()) return text
 
         return text
-            .replace(Regex("""(?<=[a-z])(?=[A-Z])"""), " ")
-            .replace(Regex("""(?<=[.,!?])(?=[A-Za-z])"""), " ")
-            .replace(Regex("""\s+"""), " ")
+            .replace(CASE_BOUNDARY, " ")
+            .replace(PUNCTUATION_BOUNDARY, " ")
+            .replace(WHITESPACE, " ")
             .trim()
     }
 
     /**
      * Format structured data like emails, URLs, and phone numbers.
-     * Converts spoken patterns to their symbolic forms.
+     * Converts spoken patterns to their symbolic forms in one pass (see [SpokenFormatter]).
      *
      * Examples:
      * - "john at gmail dot com" → "john@gmail.com"
@@ -420,106 +452,8 @@ class TextProcessor(
     fun formatStructuredData(text: String): String {
         if (!enableSmartFormatting || text.isEmpty()) return text
 
-        var result = text
-
-        // Apply email formatting
-        result = formatEmails(result)
-
-        // Apply URL formatting
-        result = formatURLs(result)
-
-        // Future: phone numbers, addresses, etc.
-
-        return result
-    }
-
-    /**
-     * Format email addresses from spoken form.
-     * Pattern: "word at word dot word" → "word@word.word"
-     */
-    private fun formatEmails(text: String): String {
-        var result = text
-
-        // Pattern: Look for sequences like "word at word dot com/org/net"
-        // Example: "contact me at john dot smith at gmail dot com"
-        val emailPattern = Regex(
-            """(\b[\w]+(?:\s+dot\s+[\w]+)*\s+at\s+[\w]+(?:\s+dot\s+[\w]+)+)""",
-            RegexOption.IGNORE_CASE
-        )
-
-        result = emailPattern.replace(result) { match ->
-            var email = match.value
-                .replace(Regex("""\s+at\s+""", RegexOption.IGNORE_CASE), "@")
-                .replace(Regex("""\s+dot\s+""", RegexOption.IGNORE_CASE), ".")
-                .replace(Regex("""\s+"""), "")  // Remove all remaining spaces
-            email
-        }
-
-        // Also handle simple patterns without context
-        // "john at gmail dot com" even if not in a sentence
-        result = result
-            .replace(Regex("""\bat\b""", RegexOption.IGNORE_CASE)) { "@" }
-            .replace(Regex("""\bdot\b""", RegexOption.IGNORE_CASE)) { "." }
-
-        // Clean up multiple spaces that may have been created
-        result = result.replace(Regex("""\s+"""), " ").trim()
-
-        return result
-    }
-
-    /**
-     * Format URLs from spoken form.
-     * Pattern: "www dot example dot com" → "www.example.com"
-     */
-    private fun formatURLs(text: String): String {
-        var result = text
-
-        // Pattern 1: URLs starting with www
-        // "www dot google dot com"
-        val wwwPattern = Regex(
-            """\bw+\s+w+\s+w+\s+dot\s+[\w]+(?:\s+dot\s+[\w]+)+""",
-            RegexOption.IGNORE_CASE
-        )
-
-        result = wwwPattern.replace(result) { match ->
-            match.value
-                .replace(Regex("""\bw+\s+w+\s+w+\b""", RegexOption.IGNORE_CASE), "www")
-                .replace(Regex("""\s+dot\s+""", RegexOption.IGNORE_CASE), ".")
-                .replace(Regex("""\s+"""), "")
-        }
-
-        // Pattern 2: Simple domain names
-        // "google dot com", "github dot io"
-        val domainPattern = Regex(
-            """\b[\w]+\s+dot\s+(?:com|org|net|edu|gov|io|co|uk|de|fr|jp|cn)\b""",
-            RegexOption.IGNORE_CASE
-        )
-
-        result = domainPattern.replace(result) { match ->
-            match.value
-                .replace(Regex("""\s+dot\s+""", RegexOption.IGNORE_CASE), ".")
-                .replace(Regex("""\s+"""), "")
-        }
-
-        // Pattern 3: URLs with protocol
-        // "https colon slash slash google dot com"
-        val protocolPattern = Regex(
-            """\b(https?|ftp)\s+colon\s+slash\s+slash\s+[\w]+(?:\s+dot\s+[\w]+)+""",
-            RegexOption.IGNORE_CASE
-        )
-
-        result = protocolPattern.replace(result) { match ->
-            match.value
-                .replace(Regex("""\s+colon\s+""", RegexOption.IGNORE_CASE), ":")
-                .replace(Regex("""\s+slash\s+""", RegexOption.IGNORE_CASE), "/")
-                .replace(Regex("""\s+dot\s+""", RegexOption.IGNORE_CASE), ".")
-                .replace(Regex("""\s+"""), "")
-        }
-
-        // Clean up
-        result = result.replace(Regex("""\s+"""), " ").trim()
-
-        return result
+        // Future: phone numbers, addresses, etc. go into SpokenFormatter's tables
+        return SpokenFormatter.format(text)
     }
 
     /**
@@ -533,10 +467,8 @@ class TextProcessor(
     private fun applyCustomVocabulary(text: String): String {
         var result = text
 
-        // Apply case-insensitive replacements
-        for ((wrong, correct) in customVocabulary) {
-            // Replace whole word matches (with word boundaries)
-            val pattern = Regex("\\b$wrong\\b", RegexOption.IGNORE_CASE)
+        // Apply case-insensitive replacements of whole word matches (with word boundaries)
+        for ((pattern, correct) in customVocabulary) {
             result = pattern.replace(result, correct)
         }
 
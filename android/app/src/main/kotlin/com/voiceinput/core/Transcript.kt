@@ -0,0 +1,95 @@
+package com.voiceinput.core
+
+/**
+ * A change to a transcript: everything from [start] on is replaced by [text].
+ *
+ * Appends only touch the last words, so a delta stays small however long the session is.
+ */
+data class TextDelta(
+    val start: Int,
+    val text: String
+) {
+    fun applyTo(target: StringBuilder) {
+        target.setLength(start)
+        target.append(text)
+    }
+}
+
+/**
+ * Transcript of a session, appended window by window.
+ *
+ * [TextProcessor.appendText] is only run over the boundary tail (see
+ * [TextProcessor.boundaryTailStart]) instead of the whole text, and each append reports a
+ * [TextDelta] so listeners can update their copy without receiving the full text. The
+ * full string and the final formatting are built on demand and cached until the next
+ * change.
+ *
+ * [append] and [clear] must be called from one thread at a time. [preview] and
+ * [previewTail] only read an immutable snapshot of the boundary tail, published on each
+ * change, so they can run concurrently with appends (speculative partials).
+ */
+class Transcript(private val textProcessor: TextProcessor) {
+
+    /** Boundary tail of the text: [text] is everything from [start] on */
+    private class Tail(val start: Int, val text: String)
+
+    private val text = StringBuilder()
+    @Volatile private var tail = Tail(0, "")
+    private var snapshot: String? = ""
+    private var finalSnapshot: String? = ""
+
+    val length: Int get() = text.length
+
+    fun isEmpty(): Boolean = text.isEmpty()
+
+    /**
+     * Append a window's text
+     *
+     * @return The change, or null if the text added nothing (e.g. it was all overlap)
+     */
+    fun append(newText: String): TextDelta? {
+        val delta = preview(newText) ?: return null
+        delta.applyTo(text)
+        val start = textProcessor.boundaryTailStart(text)
+        tail = Tail(start, text.substring(start))
+        snapshot = null
+        finalSnapshot = null
+        return delta
+    }
+
+    /**
+     * The change [append] would make, without making it (speculative partials)
+     */
+    fun preview(newText: String): TextDelta? {
+        val tail = tail
+        val updatedTail = textProcessor.appendText(tail.text, newText)
+        var common = 0
+        val max = minOf(tail.text.length, updatedTail.length)
+        while (common < max && tail.text[common] == updatedTail[common]) common++
+        if (common == tail.text.length && common == updatedTail.length) return null
+        return TextDelta(tail.start + common, updatedTail.substring(common))
+    }
+
+    /**
+     * Boundary tail start and the tail as it reads after appending [newText]
+     */
+    fun previewTail(newText: String): Pair<Int, String> {
+        val tail = tail
+        return tail.start to textProcessor.appendText(tail.text, newText)
+    }
+
+    fun clear() {
+        text.setLength(0)
+        tail = Tail(0, "")
+        snapshot = ""
+        finalSnapshot = ""
+    }
+
+    /**
+     * Text after [TextProcessor.processFinal], computed once per change
+     */
+    fun finalText(): String =
+        finalSnapshot ?: textProcessor.processFinal(toString()).also { finalSnapshot = it }
+
+    override fun toString(): String = snapshot ?: text.toString().also { snapshot = it }
+}
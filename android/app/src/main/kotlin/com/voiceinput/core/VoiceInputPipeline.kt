@@ -5,6 +5,7 @@ import android.util.Log
 import com.voiceinput.config.AppConfig
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.*
+import java.nio.ByteBuffer
 import java.util.concurrent.atomic.AtomicBoolean
 
 /**
@@ -19,10 +20,11 @@ import java.util.concurrent.atomic.AtomicBoolean
 class VoiceInputPipeline(
     private val context: Context,
     private val audioRecorder: AudioRecorder,
-    private val whisperEngine: WhisperEngine,
+    whisperEngine: WhisperEngine,
     private val config: AppConfig,
     private val onResult: ((TranscriptionResult) -> Unit)? = null,
-    private val onAudioChunk: ((ByteArray) -> Unit)? = null
+    private val onAudioChunk: ((PooledAudioBuffer) -> Unit)? = null, // Called before the chunk is processed; must not keep it
+    ownsEngine: Boolean = true // False for an engine borrowed from SharedEngine: release() leaves it loaded
 ) {
 
     companion object {
@@ -32,6 +34,17 @@ class VoiceInputPipeline(
     private val textProcessor = TextProcessor()
     private val audioProcessor: AudioProcessor
 
+    /** Stage latencies of recent windows, also emitted as Perfetto/systrace sections */
+    val trace = LatencyTrace(sink = SystraceSink)
+    private val fileTranscriber = FileTranscriber(config, trace)
+
+    // Current engine; replaced by a smaller tier when the device cannot keep up
+    @Volatile private var whisperEngine: WhisperEngine = whisperEngine
+    @Volatile private var ownsCurrentEngine = ownsEngine
+    private val adaptiveModel = config.transcription.adaptiveModel
+    private val tierPolicy = ModelTierPolicy(rtfThreshold = config.transcription.adaptiveRtfThreshold)
+    private val tierSwitching = AtomicBoolean(false)
+
     // Memory management coordination
     private val memoryManager = MemoryManager(context)
 
@@ -40,16 +53,18 @@ class VoiceInputPipeline(
     private var job: Job? = null
     private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
 
-    // Accumulated text (using desktop approach - immediate streaming)
-    private var accumulatedText = ""
+    // Accumulated text (using desktop approach - immediate streaming); appends only touch its tail
+    private val transcript = Transcript(textProcessor)
 
     // Callbacks
-    private var onTranscriptionUpdate: ((String) -> Unit)? = null
+    private var onTranscriptionDelta: ((TextDelta) -> Unit)? = null
+    private var onPartialTranscription: ((TextDelta, String) -> Unit)? = null
     private var onError: ((Exception) -> Unit)? = null
 
     // Performance metrics
     private var transcriptionCount = 0
     private var totalProcessingTime = 0L
+    private var totalAudioMs = 0L
 
     init {
         setupMemoryManagement()
@@ -62,7 +77,14 @@ class VoiceInputPipeline(
             config = config,
             onResult = { result ->
                 handleTranscriptionResult(result)
-            }
+            },
+            onPartialResult = { partial ->
+                handlePartialResult(partial)
+            },
+            onOverload = {
+                stepDownModelTier("latency budget exceeded")
+            },
+            trace = trace
         )
     }
 
@@ -72,6 +94,7 @@ class VoiceInputPipeline(
     private fun setupMemoryManagement() {
         memoryManager.setMemoryWarningCallback {
             Log.w(TAG, "🟡 Pipeline memory warning - optimizing resources")
+            if (tierPolicy.onMemoryPressure()) stepDownModelTier("memory pressure")
             // Could implement intelligent resource management here
             scope.launch {
                 if (!isRunning.get()) {
@@ -83,10 +106,14 @@ class VoiceInputPipeline(
 
         memoryManager.setMemoryCriticalCallback {
             Log.e(TAG, "🔴 Pipeline memory critical - emergency measures")
+            if (tierPolicy.onMemoryPressure()) stepDownModelTier("critical memory")
             scope.launch {
                 if (isRunning.get()) {
                     Log.w(TAG, "Critical memory during active pipeline - considering pause")
                     // Could implement emergency pause/resume here
+                } else if (ownsCurrentEngine) {
+                    // A borrowed engine is unloaded by its host's EngineResidencyPolicy
+                    whisperEngine.unload("critical memory")
                 }
                 memoryManager.requestGarbageCollection("Pipeline critical memory")
             }
@@ -103,33 +130,86 @@ class VoiceInputPipeline(
     }
 
 
+    /**
+     * Load the next smaller bundled tier in the background and swap it in between windows.
+     *
+     * The current engine keeps transcribing while the new one loads; it is released once
+     * the windows it already took have been delivered.
+     */
+    private fun stepDownModelTier(reason: String) {
+        if (!adaptiveModel || !tierSwitching.compareAndSet(false, true)) return
+
+        val current = whisperEngine
+        val smaller = current.manifest.smaller().firstOrNull { it.isBundled(context) }
+        if (smaller == null) {
+            Log.i(TAG, "No smaller model than ${current.manifest.tier} bundled, staying ($reason)")
+            return // Leave tierSwitching set: there is nothing further to step down to
+        }
+
+        Log.w(TAG, "⬇️ Stepping down ${current.manifest.tier} → ${smaller.tier} ($reason, RTF ${"%.2f".format(tierPolicy.rollingRtf)})")
+        scope.launch(Dispatchers.IO) {
+            val next = current.withManifest(smaller)
+            var swapped = false
+            try {
+                if (!next.initialize()) {
+                    Log.e(TAG, "Failed to load ${smaller.tier}, keeping ${current.manifest.tier}")
+                    next.release()
+                    return@launch
+                }
+                // The processor takes the new engine before waiting out the old one's windows,
+                // so the swap must not be abandoned halfway
+                val retired = withContext(NonCancellable) { audioProcessor.swapEngine(next) }
+                swapped = true
+                whisperEngine = next
+                // A borrowed engine stays with its other clients
+                val ownedRetired = ownsCurrentEngine
+                ownsCurrentEngine = true
+                tierPolicy.reset()
+                if (ownedRetired) retired.release()
+                Log.i(TAG, "✅ Now transcribing with ${smaller.tier}")
+            } catch (e: Exception) {
+                if (!swapped) next.release()
+                if (e is CancellationException) throw e
+                Log.e(TAG, "Failed to step down to ${smaller.tier}", e)
+            } finally {
+                tierSwitching.set(false)
+            }
+        }
+    }
+
     /**
      * Handle transcription result from AudioProcessor with immediate streaming (desktop approach)
      */
     private fun handleTranscriptionResult(result: TranscriptionResult) {
         val filtered = result.text.trim()
 
+        if (tierPolicy.record(result.processingTimeMs, result.audioDurationSec)) {
+            stepDownModelTier("falling behind real time")
+        }
+
         if (filtered.isNotEmpty()) {
             // Update performance metrics
             transcriptionCount++
             totalProcessingTime += result.processingTimeMs
+            totalAudioMs += (result.audioDurationSec * 1000).toLong()
 
             // Memory monitoring for high-frequency operations
             memoryManager.logMemoryStatus("Transcription result #$transcriptionCount")
 
             // Use desktop approach: immediate text appending with overlap detection
-            accumulatedText = textProcessor.appendText(accumulatedText, filtered)
+            val delta = trace.span(TraceStage.TEXT) { transcript.append(filtered) }
 
             // PERFORMANCE: Reduced logging frequency for streaming
             if (transcriptionCount % 5 == 0) {
-                Log.i(TAG, "Streaming chunk #$transcriptionCount: ${accumulatedText.length} chars (${result.processingTimeMs}ms)")
+                Log.i(TAG, "Streaming chunk #$transcriptionCount: ${transcript.length} chars (${result.processingTimeMs}ms)")
             }
 
-            // Notify result callback on main thread with immediate update
+            // Notify result callback on main thread with immediate update; the IME only gets the change
+            val streamingResult = if (onResult != null) result.copy(text = transcript.toString()) else null
+            val deltaCallback = onTranscriptionDelta
             scope.launch(Dispatchers.Main) {
-                val streamingResult = result.copy(text = accumulatedText)
-                onResult?.invoke(streamingResult)
-                onTranscriptionUpdate?.invoke(accumulatedText)
+                streamingResult?.let { onResult?.invoke(it) }
+                if (delta != null) deltaCallback?.invoke(delta)
             }
 
             // Memory check after text accumulation
@@ -139,6 +219,29 @@ class VoiceInputPipeline(
         }
     }
 
+    /**
+     * Handle a speculative partial for the window still being recorded.
+     *
+     * The partial only covers the current window, so it is placed after the text already
+     * accumulated from earlier windows using the same overlap-aware append, applied to the
+     * transcript's boundary tail only. The listener gets the committed part as a delta
+     * against the delivered transcript (not applied to it) plus the tentative text.
+     * Runs on the partial coroutine while windows are appended; previewTail only reads
+     * the transcript's published tail snapshot.
+     */
+    private fun handlePartialResult(partial: PartialTranscription) {
+        val callback = onPartialTranscription ?: return
+
+        val (start, committedTail) = transcript.previewTail(partial.committed)
+        val fullTail = transcript.previewTail(partial.text).second
+        val tentative = if (fullTail.startsWith(committedTail)) fullTail.substring(committedTail.length).trim() else partial.tentative
+        val committed = TextDelta(start, committedTail)
+
+        scope.launch(Dispatchers.Main) {
+            callback(committed, tentative)
+        }
+    }
+
     /**
      * Start listening and transcribing with comprehensive memory monitoring
      */
@@ -153,6 +256,7 @@ class VoiceInputPipeline(
         // Reset performance metrics
         transcriptionCount = 0
         totalProcessingTime = 0L
+        totalAudioMs = 0L
 
         // Memory check before starting resource-intensive operations
         if (memoryManager.isMemoryCritical()) {
@@ -183,7 +287,7 @@ class VoiceInputPipeline(
         memoryManager.logMemoryStatus("After audio processor start")
 
         // isRunning already set to true via getAndSet() above
-        accumulatedText = ""
+        transcript.clear()
 
         // Start feeding audio from recorder to processor
         job = scope.launch {
@@ -230,6 +334,7 @@ class VoiceInputPipeline(
         // Performance summary
         val avgProcessingTime = if (transcriptionCount > 0) totalProcessingTime / transcriptionCount else 0L
         Log.i(TAG, "🏁 Pipeline stopped. Performance: ${transcriptionCount} transcriptions, avg ${avgProcessingTime}ms")
+        Log.i(TAG, "Latency ${LatencyTrace.format(trace.summary())}")
         Log.i(TAG, "📝 Final text: ${finalText.length} chars")
 
         // Cleanup and memory optimization after stop
@@ -244,11 +349,11 @@ class VoiceInputPipeline(
      */
     private suspend fun feedAudioToProcessor() {
         audioRecorder.audioStream()
-            .buffer(capacity = 5) // Reduced buffer for lower latency
+            .buffer(capacity = 5) // Reduced buffer for lower latency; addAudio never suspends while live
             .collect { audioChunk ->
                 try {
                     onAudioChunk?.invoke(audioChunk)
-                    // Feed audio chunk to processor (which handles VAD and transcription)
+                    // Feed audio chunk to processor (which handles VAD and transcription and recycles it)
                     audioProcessor.addAudio(audioChunk)
                 } catch (e: Exception) {
                     Log.e(TAG, "Error feeding audio to processor", e)
@@ -256,6 +361,57 @@ class VoiceInputPipeline(
             }
     }
 
+    /**
+     * Transcribe a complete recording as fast as the engine allows.
+     *
+     * Unlike [feedFileAudio], the audio does not go through the live chunk path: it is
+     * segmented in one pass and the windows are pipelined through the engine (see
+     * [FileTranscriber]). Suspends until the last window is decoded.
+     *
+     * @param audioData PCM 16-bit mono audio at the configured sample rate
+     * @return The transcript (also available via [getText])
+     */
+    suspend fun transcribeFile(audioData: ByteArray): String = transcribeFile(ByteBuffer.wrap(audioData))
+
+    /**
+     * [transcribeFile] over a buffer (e.g. a memory-mapped session capture) from index 0 to
+     * its limit; only the windows are copied out of it
+     */
+    suspend fun transcribeFile(audioData: ByteBuffer): String {
+        if (isRunning.getAndSet(true)) {
+            Log.w(TAG, "Pipeline already running - cannot transcribe file audio")
+            return transcript.toString()
+        }
+
+        transcript.clear()
+        transcriptionCount = 0
+        totalProcessingTime = 0L
+        totalAudioMs = 0L
+
+        try {
+            val startTime = System.currentTimeMillis()
+            val frameBytes = FileTranscriber.frameBytes(config.audio.sampleRate)
+            val windows = fileTranscriber.segmentRecording(audioData, audioProcessor.classifySilence(audioData, frameBytes))
+            val audioSec = audioData.limit() / (config.audio.sampleRate * 2f)
+            Log.i(TAG, "📂 Transcribing ${"%.1f".format(audioSec)}s of audio in ${windows.size} windows")
+
+            fileTranscriber.transcribe(whisperEngine, textProcessor, audioData, windows) { result ->
+                handleTranscriptionResult(result)
+            }
+
+            val elapsedMs = System.currentTimeMillis() - startTime
+            Log.i(TAG, "🏁 File transcribed in ${elapsedMs}ms (RTF ${"%.2f".format(elapsedMs / (audioSec * 1000))}): ${transcript.length} chars")
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(TAG, "Error during file transcription", e)
+        } finally {
+            isRunning.set(false)
+            memoryManager.logMemoryStatus("After file transcription")
+        }
+        return transcript.toString()
+    }
+
     /**
      * Feed file audio through the pipeline for real-time transcription
      * This allows the pipeline to process pre-recorded audio files with the same
@@ -278,12 +434,13 @@ class VoiceInputPipeline(
         Log.i(TAG, "🎬 Starting file audio streaming: ${audioData.size} bytes in ${chunkSizeBytes}-byte chunks")
 
         // Reset state for file processing
-        accumulatedText = ""
+        transcript.clear()
         transcriptionCount = 0
         totalProcessingTime = 0L
+        totalAudioMs = 0L
 
-        // Start AudioProcessor (but not AudioRecorder)
-        if (!audioProcessor.start()) {
+        // Start AudioProcessor (but not AudioRecorder); file input waits for the queue instead of dropping
+        if (!audioProcessor.start(realtime = false)) {
             Log.e(TAG, "Failed to start audio processor for file input")
             isRunning.set(false)
             return
@@ -292,13 +449,13 @@ class VoiceInputPipeline(
         memoryManager.logMemoryStatus("After audio processor start for file input")
 
         try {
-            // Split audio data into chunks
-            val chunks = audioData.toList().chunked(chunkSizeBytes)
-            Log.i(TAG, "📤 Feeding ${chunks.size} audio chunks through pipeline (${chunkSizeBytes}-byte chunks)...")
+            val chunkCount = (audioData.size + chunkSizeBytes - 1) / chunkSizeBytes
+            Log.i(TAG, "📤 Feeding $chunkCount audio chunks through pipeline (${chunkSizeBytes}-byte chunks)...")
 
             // Feed chunks through the pipeline at maximum speed
-            for ((index, chunk) in chunks.withIndex()) {
-                val chunkBytes = chunk.toByteArray()
+            for (index in 0 until chunkCount) {
+                val start = index * chunkSizeBytes
+                val chunkBytes = audioData.copyOfRange(start, minOf(audioData.size, start + chunkSizeBytes))
 
                 // PERFORMANCE: Only delay if specified (0 = no delay for max speed)
                 if (delayMs > 0) {
@@ -310,23 +467,19 @@ class VoiceInputPipeline(
 
                 // PERFORMANCE: Reduced logging frequency
                 if (index % 25 == 0) {
-                    Log.d(TAG, "Fed chunk ${index + 1}/${chunks.size}")
+                    Log.d(TAG, "Fed chunk ${index + 1}/$chunkCount")
                 }
             }
 
-            Log.i(TAG, "Finished feeding ${chunks.size} audio chunks through pipeline")
-            
-            // Wait a bit for final processing
-            delay(1000)
-            
+            Log.i(TAG, "Finished feeding $chunkCount audio chunks through pipeline")
         } catch (e: Exception) {
             Log.e(TAG, "Error during file audio processing", e)
         } finally {
-            // Stop AudioProcessor
+            // Stop AudioProcessor; returns once every queued window has been delivered
             audioProcessor.stop()
             isRunning.set(false)
 
-            Log.i(TAG, "🏁 File audio streaming completed. Final text: ${accumulatedText.length} chars")
+            Log.i(TAG, "🏁 File audio streaming completed. Final text: ${transcript.length} chars")
             memoryManager.logMemoryStatus("After file audio processing complete")
         }
     }
@@ -335,24 +488,33 @@ class VoiceInputPipeline(
      * Clear accumulated text
      */
     fun clearText() {
-        accumulatedText = ""
+        transcript.clear()
     }
 
     /**
      * Get current accumulated text
      */
-    fun getText(): String = accumulatedText
+    fun getText(): String = transcript.toString()
+
+    /**
+     * Get fully processed final text (cached until the transcript changes)
+     */
+    fun getFinalText(): String = transcript.finalText()
 
     /**
-     * Get fully processed final text
+     * Set callback for transcription updates: the change each window made to the transcript,
+     * on the main thread and in order, so applying them rebuilds [getText]
      */
-    fun getFinalText(): String = textProcessor.processFinal(accumulatedText)
+    fun setTranscriptionDeltaCallback(callback: (TextDelta) -> Unit) {
+        onTranscriptionDelta = callback
+    }
 
     /**
-     * Set callback for transcription updates
+     * Set callback for speculative partial results: the committed text as a delta against the
+     * transcript delivered so far (not to be applied to it), and the tentative text
      */
-    fun setTranscriptionUpdateCallback(callback: (String) -> Unit) {
-        onTranscriptionUpdate = callback
+    fun setPartialTranscriptionCallback(callback: (committed: TextDelta, tentative: String) -> Unit) {
+        onPartialTranscription = callback
     }
 
     /**
@@ -367,6 +529,7 @@ class VoiceInputPipeline(
      */
     fun updateSettings(newConfig: AppConfig) {
         audioProcessor.updateSettings(newConfig)
+        fileTranscriber.updateSettings(newConfig)
         Log.d(TAG, "Pipeline settings updated")
     }
 
@@ -376,25 +539,25 @@ class VoiceInputPipeline(
     fun getStatus(): PipelineStatus {
         val memoryStatus = memoryManager.getMemoryStatus()
         val avgProcessingTime = if (transcriptionCount > 0) totalProcessingTime / transcriptionCount else 0L
+        val avgRtf = if (totalAudioMs > 0) totalProcessingTime.toFloat() / totalAudioMs else 0f
 
-        // Create model info for ONNX engine
-        val modelInfo = ModelInfo(
-            name = "whisper-small-onnx",
-            path = "assets/models/",
-            language = "en",
-            isInitialized = true,
-            type = "ONNX Runtime (APU accelerated)"
-        )
+        // Model info from the ONNX engine (includes warm-start cache status)
+        val modelInfo = whisperEngine.getModelInfo()
 
         return PipelineStatus(
             isRunning = isRunning.get(),
             isRecording = audioRecorder.isCurrentlyRecording(),
-            accumulatedTextLength = accumulatedText.length,
+            accumulatedTextLength = transcript.length,
             modelInfo = modelInfo,
             isProcessorRunning = audioProcessor.isRunning(),
             transcriptionCount = transcriptionCount,
             averageProcessingTimeMs = avgProcessingTime,
-            memoryStatus = memoryStatus
+            averageRtf = avgRtf,
+            memoryStatus = memoryStatus,
+            latency = audioProcessor.getLatencyStats(),
+            stageLatency = trace.summary(),
+            residency = whisperEngine.residency,
+            residencyTransitions = whisperEngine.residencyTransitions()
         )
     }
 
@@ -422,7 +585,7 @@ class VoiceInputPipeline(
         audioProcessor.close() // Clean up VAD resources
         scope.cancel()
         audioRecorder.release()
-        whisperEngine.release()
+        if (ownsCurrentEngine) whisperEngine.release()
 
         // Final cleanup and memory management
         memoryManager.release()
@@ -444,5 +607,10 @@ data class PipelineStatus(
     val isProcessorRunning: Boolean = false,
     val transcriptionCount: Int = 0,
     val averageProcessingTimeMs: Long = 0L,
-    val memoryStatus: MemoryStatus? = null
+    val averageRtf: Float = 0f,          // Processing time / audio duration over the session
+    val memoryStatus: MemoryStatus? = null,
+    val latency: LatencyStats? = null,   // Live backpressure: queue depths, lag, degradation level
+    val stageLatency: Map<TraceStage, StagePercentiles> = emptyMap(), // p50/p95/p99 per pipeline stage
+    val residency: EngineResidency = EngineResidency.RESIDENT,
+    val residencyTransitions: List<ResidencyTransition> = emptyList() // Pre-warm / idle / memory unloads, oldest first
 )
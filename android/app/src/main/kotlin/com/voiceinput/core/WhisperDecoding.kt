@@ -0,0 +1,163 @@
+package com.voiceinput.core
+
+import com.voiceinput.config.TranscriptionConfig
+import java.util.zip.Deflater
+
+/**
+ * Decoding strategy for [WhisperEngine], mirroring whisper.cpp / openai-whisper:
+ * beam search at temperature 0, then sampling at increasing temperatures when the
+ * result looks like a hallucination (too repetitive or too unlikely).
+ *
+ * @param beamSize Hypotheses kept at temperature 0 (1 = greedy)
+ * @param temperatureFallback Retry at hotter temperatures when a result fails the thresholds
+ * @param temperatureIncrement Step between fallback temperatures, up to 1.0
+ * @param compressionRatioThreshold Text that compresses better than this is a repetition loop
+ * @param logProbThreshold Results with a lower average token log-probability are retried
+ * @param timestamps Decode timestamp tokens and return segments (single-beam only)
+ */
+data class DecodingOptions(
+    val beamSize: Int = 1,
+    val temperatureFallback: Boolean = true,
+    val temperatureIncrement: Float = 0.2f,
+    val compressionRatioThreshold: Float = 2.4f,
+    val logProbThreshold: Float = -1.0f,
+    val timestamps: Boolean = false
+) {
+    init {
+        require(beamSize in 1..MAX_BEAM_SIZE) { "Beam size must be between 1 and $MAX_BEAM_SIZE, got $beamSize" }
+        require(temperatureIncrement > 0f) { "Temperature increment must be positive, got $temperatureIncrement" }
+    }
+
+    /**
+     * Temperatures to try in order: 0.0, then 0.2, 0.4, ... 1.0 if fallback is enabled
+     */
+    val temperatures: List<Float>
+        get() {
+            if (!temperatureFallback) return listOf(0f)
+            val steps = (1.0f / temperatureIncrement + 1e-4f).toInt()
+            return (0..steps).map { it * temperatureIncrement }
+        }
+
+    /**
+     * Whether a decoded sequence should be retried at the next temperature
+     */
+    fun needsFallback(sequence: DecodedSequence, text: String): Boolean {
+        return sequence.repetitive ||
+            compressionRatio(text) > compressionRatioThreshold ||
+            sequence.avgLogProb < logProbThreshold
+    }
+
+    companion object {
+        const val MAX_BEAM_SIZE = 8
+
+        fun from(config: TranscriptionConfig) = DecodingOptions(
+            beamSize = config.beamSize,
+            temperatureFallback = config.temperatureFallback,
+            compressionRatioThreshold = config.compressionRatioThreshold,
+            logProbThreshold = config.logProbThreshold,
+            timestamps = config.timestamps
+        )
+
+        /**
+         * zlib compression ratio of the text, as used by openai-whisper. Normal speech sits
+         * around 1.0-2.0; a decoder stuck in a loop compresses far better.
+         */
+        fun compressionRatio(text: String): Float {
+            val bytes = text.toByteArray(Charsets.UTF_8)
+            if (bytes.isEmpty()) return 0f
+
+            val deflater = Deflater()
+            try {
+                deflater.setInput(bytes)
+                deflater.finish()
+                val out = ByteArray(bytes.size + 64)
+                var compressed = 0
+                while (!deflater.finished()) {
+                    compressed += deflater.deflate(out)
+                }
+                return bytes.size.toFloat() / compressed
+            } finally {
+                deflater.end()
+            }
+        }
+    }
+}
+
+/**
+ * One decoding attempt
+ *
+ * @param tokens Text tokens, plus timestamp tokens in timestamp mode (prompt excluded)
+ * @param avgLogProb Mean log-probability of the generated tokens, EOS included
+ * @param temperature Temperature the sequence was decoded at
+ * @param repetitive Decoding was cut short by [RepetitionDetector]
+ */
+data class DecodedSequence(
+    val tokens: IntArray,
+    val avgLogProb: Double,
+    val temperature: Float,
+    val repetitive: Boolean = false
+) {
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (other !is DecodedSequence) return false
+        return tokens.contentEquals(other.tokens) && avgLogProb == other.avgLogProb &&
+            temperature == other.temperature && repetitive == other.repetitive
+    }
+
+    override fun hashCode(): Int =
+        31 * (31 * (31 * tokens.contentHashCode() + avgLogProb.hashCode()) + temperature.hashCode()) + repetitive.hashCode()
+}
+
+/**
+ * Detects a decoder stuck repeating itself, so it can stop instead of running to maxTokens
+ */
+object RepetitionDetector {
+
+    // A block of 1..MAX_PERIOD tokens repeated so it covers MIN_REPEATED_TOKENS tokens
+    // (and at least MIN_REPEATS times) is a loop: 16x the same token, 4x a 4-token phrase
+    private const val MAX_PERIOD = 24
+    private const val MIN_REPEATS = 3
+    private const val MIN_REPEATED_TOKENS = 16
+
+    /**
+     * Check whether [tokens] (of which the first [length] are valid) ends in a loop.
+     *
+     * @return Length to truncate to, keeping one copy of the repeated block, or -1
+     */
+    fun findLoop(tokens: IntArray, length: Int = tokens.size): Int {
+        for (period in 1..MAX_PERIOD) {
+            val repeatsNeeded = maxOf(MIN_REPEATS, (MIN_REPEATED_TOKENS + period - 1) / period)
+            val span = period * repeatsNeeded
+            if (span > length) continue
+
+            var repeating = true
+            for (i in length - span until length - period) {
+                if (tokens[i] != tokens[i + period]) {
+                    repeating = false
+                    break
+                }
+            }
+            if (repeating) {
+                return length - span + period
+            }
+        }
+        return -1
+    }
+}
+
+/**
+ * Rolling <|startofprev|> context carried from one window to the next
+ */
+object PromptCarryover {
+
+    /**
+     * Context for the next window: the tail of [context] followed by the latest tokens,
+     * at most [budget] tokens in all (empty when carry-over is off)
+     */
+    fun next(context: IntArray, tokens: List<Int>, budget: Int): IntArray {
+        if (budget == 0) return IntArray(0)
+        if (tokens.size >= budget) return tokens.takeLast(budget).toIntArray()
+        val keep = minOf(context.size, budget - tokens.size)
+        return context.copyOfRange(context.size - keep, context.size) + tokens.toIntArray()
+    }
+}
@@ -3,15 +3,32 @@ package com.voiceinput.core
 import android.content.Context
 import android.util.Log
 import ai.onnxruntime.OnnxTensor
+import ai.onnxruntime.OnnxValue
 import ai.onnxruntime.OrtEnvironment
 import ai.onnxruntime.OrtException
 import ai.onnxruntime.OrtSession
+import ai.onnxruntime.TensorInfo
 import ai.onnxruntime.extensions.OrtxPackage
+import com.voiceinput.onnx.Backend
+import com.voiceinput.onnx.BackendManager
+import com.voiceinput.onnx.OrtModelCache
+import com.voiceinput.onnx.PlacedSession
+import com.voiceinput.onnx.PipelineStage
 import com.voiceinput.onnx.TensorUtils
 import com.voiceinput.onnx.OnnxUtils
+import com.voiceinput.onnx.TokenScores
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 import kotlinx.coroutines.withContext
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.nio.FloatBuffer
+import java.nio.LongBuffer
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicReference
+import kotlin.math.exp
+import kotlin.random.Random
 
 /**
  * ONNX Runtime-based Whisper engine for Samsung AI chip (APU) acceleration
@@ -20,7 +37,13 @@ import java.nio.FloatBuffer
  * - Uses split encoder/decoder architecture for optimal memory usage
  * - Implements KV cache for efficient autoregressive decoding
  * - Supports NNAPI acceleration for MediaTek/Qualcomm/Exynos NPUs
- * - INT8 quantized Whisper SMALL model (244M parameters)
+ * - INT8 quantized Whisper models, one tier per [ModelManifest] (SMALL by default)
+ *
+ * Chunks shorter than a bundled [EncoderBuckets] window skip the padded part of the 30 s mel
+ * and run a shortened encoder, loaded the first time a chunk fits it.
+ *
+ * Sessions can be dropped in stages between sessions ([releaseDecoder], [unload]) and are
+ * reloaded transparently by the next [encode] / [decode]; see [EngineResidencyPolicy].
  *
  * Performance on Samsung devices with MediaTek APU:
  * - RTF: ~0.44x (faster than real-time)
@@ -28,29 +51,53 @@ import java.nio.FloatBuffer
  */
 class WhisperEngine(
     private val context: Context,
-    private val language: String = "en"
-) {
+    private val language: String = "en",
+    @Volatile var decodingOptions: DecodingOptions = DecodingOptions(),
+    private val backendPreferences: Map<PipelineStage, Backend> = emptyMap(),
+    val manifest: ModelManifest = ModelManifest.SMALL
+) : ResidentModel {
 
     companion object {
         private const val TAG = "WhisperEngine"
         private const val SAMPLE_RATE = 16000
 
-        // Whisper token IDs
-        private const val START_TOKEN_ID = 50258
-        private const val ENGLISH_TOKEN_ID = 50259  // Language token for English
-        private const val TRANSCRIBE_TOKEN_ID = 50359
-        private const val NO_TIMESTAMPS_TOKEN_ID = 50363
-        private const val EOS_TOKEN_ID = 50257
+        // Previous-text context: <|startofprev|> followed by at most half the 448-token text context
+        const val MAX_PREVIOUS_TOKENS = 223
+        private const val PROMPT_MAX_TEMPERATURE = 0.5f
+
+        // Timestamp tokens in 20ms steps; the first one may be at most 1.0s in
+        private const val TIMESTAMP_STEP_SEC = 0.02f
+        private const val MAX_INITIAL_TIMESTAMP_STEPS = 50
+
+        // Ranks a looping beam below any clean one when choosing the final hypothesis
+        private const val REPETITION_PENALTY = 10.0
+
+        private const val MAX_ENCODER_FAILURES = 3
 
         // Limits
         private const val MAX_TOKENS = 445  // Maximum tokens per transcription
         private const val MAX_TOKENS_PER_SECOND = 30
-
-        // Cache dimensions
-        private const val NUM_DECODER_LAYERS = 12
-        private const val CACHE_DIM = 64
     }
 
+    // Token IDs and decoder shape of the loaded tier
+    private val specialTokens = manifest.tokens
+    private val numDecoderLayers = manifest.decoderLayers
+
+    // Forced decoder prompt: <|startoftranscript|>, <|en|>, <|transcribe|>, <|notimestamps|>
+    private val promptTokens = intArrayOf(specialTokens.startOfTranscript, specialTokens.english, specialTokens.transcribe, specialTokens.noTimestamps)
+    private val timestampPromptTokens = intArrayOf(specialTokens.startOfTranscript, specialTokens.english, specialTokens.transcribe)
+    private val maxInitialTimestampId = specialTokens.timestampBegin + MAX_INITIAL_TIMESTAMP_STEPS
+
+    // Decoder I/O names, built once instead of per token
+    private val pastDecoderKey = Array(numDecoderLayers) { "past_key_values.$it.decoder.key" }
+    private val pastDecoderValue = Array(numDecoderLayers) { "past_key_values.$it.decoder.value" }
+    private val pastEncoderKey = Array(numDecoderLayers) { "past_key_values.$it.encoder.key" }
+    private val pastEncoderValue = Array(numDecoderLayers) { "past_key_values.$it.encoder.value" }
+    private val presentDecoderKey = Array(numDecoderLayers) { "present.$it.decoder.key" }
+    private val presentDecoderValue = Array(numDecoderLayers) { "present.$it.decoder.value" }
+    private val presentEncoderKey = Array(numDecoderLayers) { "present.$it.encoder.key" }
+    private val presentEncoderValue = Array(numDecoderLayers) { "present.$it.encoder.value" }
+
     private var ortEnvironment: OrtEnvironment? = null
     private var initSession: OrtSession? = null
     private var encoderSession: OrtSession? = null
@@ -60,8 +107,64 @@ class WhisperEngine(
 
     private var initialized = false
 
+    // Optimized-graph cache under getModelsDir(), and what the last initialization got from it
+    private var modelCache: OrtModelCache? = null
+    private var warmStart = false
+    private var loadTimeMs = 0L
+
+    // Backend placement per stage, and the CPU encoder kept for run-time NNAPI/QNN failures.
+    // After MAX_ENCODER_FAILURES failures in a row the accelerated encoder is bypassed.
+    private var backendManager: BackendManager? = null
+    @Volatile private var encoderBackend = Backend.CPU
+    @Volatile private var cpuEncoderSession: OrtSession? = null
+    private var encoderSessionOptions: (() -> OrtSession.SessionOptions)? = null
+    @Volatile private var encoderDemoted = false
+    // Shortened-window encoders by length; a bucket that fails at run time is dropped from the list
+    @Volatile private var encoderBuckets: List<Int> = emptyList()
+    private val bucketEncoders = HashMap<Int, PlacedSession>()
+    // Initializer output pinned to a buffer this engine owns, so bucket windows read the mel in
+    // place (getFloatBuffer copies all of it); shape is null when the output is not static.
+    // One is kept for the next call; overlapping encodes allocate their own.
+    private var melOutputName = ""
+    private var melShape: LongArray? = null
+    private val spareMel = AtomicReference<MelOutput?>()
+    private var encoderFailures = 0
+    private val fallbackLock = Any()
+
+    // Decoder-step tensors allocated once per engine (see allocateDecoderBuffers)
+    private var inputIdBuffer: LongBuffer? = null
+    private var inputIdTensor: OnnxTensor? = null
+    private var emptyDecoderCache: OnnxTensor? = null
+    private val decoderInputs = HashMap<String, OnnxTensor>(4 * numDecoderLayers + 1)
+    private var logitsBuffer: FloatBuffer? = null
+    private var logitsTensor: OnnxTensor? = null
+    private val pinnedLogits = HashMap<String, OnnxValue>(1)
+    private var presentOutputNames: Set<String> = emptySet()
+    private var suppressedTokens = BooleanArray(0)
+    private var initialTimestampTokens = BooleanArray(0) // First step: timestamps up to MAX_INITIAL_TIMESTAMP
+    private var timestampOnlyTokens = BooleanArray(0)   // Text suppressed: next timestamp or EOS
+    private var timestampOrTextTokens = BooleanArray(0) // Text or timestamps not before the last one
+    private var timestampFloor = specialTokens.timestampBegin
+    private val stepScores = TokenScores(DecodingOptions.MAX_BEAM_SIZE + 1)
+
+    // Encoder input PCM, converted in place for every window
+    private val pcmInput = PcmFloatBuffer()
+
+    // Sampling for temperature fallback
+    private val random = Random(System.nanoTime())
+
+    // The shared decoder buffers allow one decode at a time
+    private val decodeMutex = Mutex()
+
+    // Loaded sessions; changed under residencyLock, and never while an encode/decode is active
+    private val residencyLock = Mutex()
+    private val activeCalls = AtomicInteger(0)
+    @Volatile override var residency = EngineResidency.UNLOADED
+        private set
+    private val residencyLog = ResidencyLog()
+
     /**
-     * Initialize ONNX Runtime with APU/NNAPI acceleration
+     * Initialize ONNX Runtime, placing the encoder and decoder on the best available backends
      * Compatible interface with old WhisperEngine
      */
     suspend fun initialize(): Boolean = withContext(Dispatchers.IO) {
@@ -73,149 +176,390 @@ class WhisperEngine(
      */
     @Suppress("UNUSED_PARAMETER") // Kept for API compatibility with old WhisperEngine
     suspend fun initializeFromAssets(assetPath: String): Boolean = withContext(Dispatchers.IO) {
-        // Note: assetPath is ignored - ONNX always loads from models/ directory
+        // Note: assetPath is ignored - ONNX loads from the manifest's asset directory
         // This is just for API compatibility with old WhisperEngine
         try {
-            Log.i(TAG, "========================================")
-            Log.i(TAG, "🚀 Initializing ONNX Whisper Engine")
-            Log.i(TAG, "   Model: Whisper SMALL INT8 (244M params)")
-            Log.i(TAG, "========================================")
+            residencyLock.withLock { loadSessions() }
+            initialized = true
+            true
+        } catch (e: Exception) {
+            Log.e(TAG, "❌ Failed to initialize ONNX Whisper", e)
+            e.printStackTrace()
+            false
+        }
+    }
 
-            // Create ORT environment
-            ortEnvironment = OrtEnvironment.getEnvironment()
+    /**
+     * Create the ORT environment and all five sessions; called with residencyLock held
+     */
+    private fun loadSessions() {
+        Log.i(TAG, "========================================")
+        Log.i(TAG, "🚀 Initializing ONNX Whisper Engine")
+        Log.i(TAG, "   Model: ${manifest.displayName}")
+        Log.i(TAG, "========================================")
 
-            // Load all 5 model components
-            loadInitSession()
-            loadEncoderSession()
-            loadCacheInitSession()
-            loadDecoderSession()
-            loadDetokenizerSession()
+        // Create ORT environment
+        val loadStartTime = System.currentTimeMillis()
+        ortEnvironment = OrtEnvironment.getEnvironment()
+        val cache = OrtModelCache(context, ortEnvironment!!)
+        modelCache = cache
+        backendManager = BackendManager(ortEnvironment!!, cache, backendPreferences)
+
+        // Load all 5 model components
+        loadInitSession()
+        loadEncoderSession()
+        loadCacheInitSession()
+        loadDecoderSession()
+        loadDetokenizerSession()
+        allocateDecoderBuffers()
+        encoderBuckets = manifest.bundledEncoderBuckets(context).let { if (it.isNotEmpty() && !crossAttentionAxesDynamic()) emptyList() else it }
+
+        loadTimeMs = System.currentTimeMillis() - loadStartTime
+        warmStart = cache.misses == 0
+        transition(EngineResidency.RESIDENT, "loaded in ${loadTimeMs}ms")
 
-            initialized = true
+        Log.i(TAG, "")
+        Log.i(TAG, "========================================")
+        Log.i(TAG, "✅ ONNX Whisper Engine Ready")
+        Log.i(TAG, "   Backends: ${describeBackends()}")
+        Log.i(TAG, "   Model: ${manifest.displayName}")
+        Log.i(TAG, "   Encoder windows: ${(encoderBuckets + EncoderBuckets.FULL_WINDOW_SEC).joinToString { "${it}s" }}")
+        Log.i(TAG, "   Load: ${loadTimeMs}ms (${if (warmStart) "warm, from cache" else "cold, ${cache.misses} model(s) optimized"})")
+        Log.i(TAG, "========================================")
+    }
+
+    /**
+     * Load whatever [releaseDecoder] / [unload] dropped and count the call as active until
+     * [endCall], so residency cannot change under a running encode or decode
+     */
+    private suspend fun beginCall(needDecoder: Boolean) = residencyLock.withLock {
+        when {
+            residency == EngineResidency.UNLOADED -> loadSessions()
+            needDecoder && residency == EngineResidency.ENCODER_ONLY -> {
+                val start = System.currentTimeMillis()
+                loadDecoderSession()
+                loadDetokenizerSession()
+                allocateDecoderBuffers()
+                transition(EngineResidency.RESIDENT, "decoder reloaded in ${System.currentTimeMillis() - start}ms")
+            }
+        }
+        activeCalls.incrementAndGet()
+    }
+
+    private fun endCall() {
+        activeCalls.decrementAndGet()
+    }
 
-            Log.i(TAG, "")
-            Log.i(TAG, "========================================")
-            Log.i(TAG, "✅ ONNX Whisper Engine Ready")
-            Log.i(TAG, "   Backend: NNAPI (Samsung AI Chip)")
-            Log.i(TAG, "   Model: Whisper SMALL INT8")
-            Log.i(TAG, "   Expected RTF: ~0.40-0.50x")
-            Log.i(TAG, "========================================")
+    private fun transition(to: EngineResidency, reason: String) {
+        val from = residency
+        residency = to
+        residencyLog.record(ResidencyTransition(from, to, reason))
+        Log.i(TAG, "♻️ Residency $from → $to ($reason)")
+    }
+
+    /** Recent residency changes, oldest first */
+    fun residencyTransitions(): List<ResidencyTransition> = residencyLog.snapshot()
 
+    /**
+     * Reload anything released, then encode one second of silence so NNAPI/QNN compile and
+     * allocate before the user speaks
+     */
+    override suspend fun warmUp(): Boolean {
+        if (!initialized) return false
+        return try {
+            val start = System.currentTimeMillis()
+            beginCall(needDecoder = true)
+            endCall()
+            encode(ByteArray(SAMPLE_RATE * 2)).close()
+            Log.i(TAG, "🔥 Pre-warmed in ${System.currentTimeMillis() - start}ms")
             true
         } catch (e: Exception) {
-            Log.e(TAG, "❌ Failed to initialize ONNX Whisper", e)
-            e.printStackTrace()
+            Log.w(TAG, "Pre-warm failed: ${e.message}")
             false
         }
     }
 
+    /**
+     * Close the decoder and detokenizer and their buffers, keeping the encoder side loaded
+     */
+    override suspend fun releaseDecoder(reason: String): Boolean = residencyLock.withLock {
+        if (residency != EngineResidency.RESIDENT || activeCalls.get() > 0) return@withLock false
+        decodeMutex.withLock { closeDecoderSessions() }
+        transition(EngineResidency.ENCODER_ONLY, reason)
+        true
+    }
+
+    /**
+     * Close every session: decoder side first, then the cross-attention cache initializer,
+     * the encoders and the preprocessor. The next call reloads them (via the warm cache).
+     */
+    override suspend fun unload(reason: String): Boolean = residencyLock.withLock {
+        if (residency == EngineResidency.UNLOADED || activeCalls.get() > 0) return@withLock false
+        decodeMutex.withLock { closeDecoderSessions() }
+        cacheInitSession?.close()
+        cacheInitSession = null
+        cpuEncoderSession?.close()
+        cpuEncoderSession = null
+        closeBucketEncoders()
+        encoderSession?.close()
+        encoderSession = null
+        initSession?.close()
+        initSession = null
+        spareMel.getAndSet(null)?.close()
+        backendManager = null
+        transition(EngineResidency.UNLOADED, reason)
+        true
+    }
+
+    private fun closeBucketEncoders() = synchronized(fallbackLock) {
+        bucketEncoders.values.forEach { it.session.close() }
+        bucketEncoders.clear()
+    }
+
+    private fun closeDecoderSessions() {
+        inputIdTensor?.close()
+        emptyDecoderCache?.close()
+        logitsTensor?.close()
+        decoderSession?.close()
+        detokenizerSession?.close()
+        inputIdTensor = null
+        inputIdBuffer = null
+        emptyDecoderCache = null
+        logitsTensor = null
+        logitsBuffer = null
+        pinnedLogits.clear()
+        decoderSession = null
+        detokenizerSession = null
+    }
+
     /**
      * Get model info - API compatible
      */
     fun getModelInfo(): ModelInfo {
         return ModelInfo(
-            name = "whisper-small-onnx",
-            path = "assets/models/",
+            name = "whisper-${manifest.tier}-onnx",
+            path = "assets/${manifest.assetDir}/",
             language = "en",
             isInitialized = initialized,
-            type = "ONNX Runtime (APU accelerated)"
+            type = "ONNX Runtime (${describeBackends()})",
+            warmStart = warmStart,
+            loadTimeMs = loadTimeMs,
+            cacheDir = modelCache?.cacheDir?.absolutePath
         )
     }
 
+    /**
+     * An uninitialized engine with the same settings on another model tier, for hot swapping
+     */
+    fun withManifest(manifest: ModelManifest): WhisperEngine =
+        WhisperEngine(context, language, decodingOptions, backendPreferences, manifest)
+
+    private fun describeBackends(): String {
+        val placements = backendManager?.placements ?: return "not loaded"
+        val encoder = if (encoderDemoted) "CPU (fallback)" else placements[PipelineStage.ENCODER]
+        return "encoder=$encoder, decoder=${placements[PipelineStage.DECODER]}"
+    }
+
     private fun loadInitSession() {
-        val initPath = "models/Whisper_initializer.onnx"
-        val sessionOptions = OrtSession.SessionOptions().apply {
-            registerCustomOpLibrary(OrtxPackage.getLibraryPath())
-            setCPUArenaAllocator(false)
-            setMemoryPatternOptimization(false)
-            setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+        val initPath = manifest.initializerPath
+        val sessionOptions = {
+            OrtSession.SessionOptions().apply {
+                registerCustomOpLibrary(OrtxPackage.getLibraryPath())
+                setCPUArenaAllocator(false)
+                setMemoryPatternOptimization(false)
+                setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+                backendManager!!.tuneCpuThreads(this)
+            }
         }
 
-        context.assets.open(initPath).use { inputStream ->
-            initSession = ortEnvironment!!.createSession(inputStream.readBytes(), sessionOptions)
-        }
+        val session = modelCache!!.createSession(initPath, sessionOptions)
+        initSession = session
+        val output = session.outputInfo.entries.first()
+        melOutputName = output.key
+        melShape = (output.value.info as? TensorInfo)?.shape?.takeIf { shape -> shape.all { it > 0 } }
         Log.i(TAG, "✅ Initializer model loaded")
     }
 
     private fun loadEncoderSession() {
-        val encoderPath = "models/Whisper_encoder.onnx"
-        val sessionOptions = OrtSession.SessionOptions().apply {
-            registerCustomOpLibrary(OrtxPackage.getLibraryPath())
-
-            // Memory optimization based on device RAM
-            val runtime = Runtime.getRuntime()
-            val totalMemory = runtime.maxMemory() / (1024 * 1024) // MB
+        val encoderPath = manifest.encoderPath
+        val sessionOptions = {
+            OrtSession.SessionOptions().apply {
+                registerCustomOpLibrary(OrtxPackage.getLibraryPath())
+
+                // Memory optimization based on device RAM
+                val runtime = Runtime.getRuntime()
+                val totalMemory = runtime.maxMemory() / (1024 * 1024) // MB
+
+                if (totalMemory <= 7000) {
+                    // Low RAM devices - disable arena allocator
+                    setCPUArenaAllocator(false)
+                    setMemoryPatternOptimization(false)
+                    Log.i(TAG, "   Low RAM mode enabled for encoder")
+                } else {
+                    // High RAM devices - enable optimizations
+                    setCPUArenaAllocator(true)
+                    setMemoryPatternOptimization(true)
+                }
 
-            if (totalMemory <= 7000) {
-                // Low RAM devices - disable arena allocator
-                setCPUArenaAllocator(false)
-                setMemoryPatternOptimization(false)
-                Log.i(TAG, "   Low RAM mode enabled for encoder")
-            } else {
-                // High RAM devices - enable optimizations
-                setCPUArenaAllocator(true)
-                setMemoryPatternOptimization(true)
+                setSymbolicDimensionValue("batch_size", 1)
+                setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+                // Execution provider and threads are added by the BackendManager
             }
+        }
 
-            setSymbolicDimensionValue("batch_size", 1)
-            setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+        val placed = backendManager!!.createSession(PipelineStage.ENCODER, encoderPath, sessionOptions)
+        encoderSession = placed.session
+        encoderBackend = placed.backend
+        encoderSessionOptions = sessionOptions
+        Log.i(TAG, "✅ Encoder model loaded (${placed.backend})")
+    }
 
-            // Try to enable NNAPI for APU acceleration
-            try {
-                addNnapi()
-                Log.i(TAG, "   ⚡ NNAPI (APU) acceleration enabled for encoder")
-            } catch (e: Exception) {
-                Log.w(TAG, "   NNAPI not available, using CPU for encoder")
+    /**
+     * CPU encoder for when the accelerated one fails at run time; created once and kept
+     */
+    private fun cpuEncoder(): OrtSession {
+        cpuEncoderSession?.let { return it }
+        synchronized(fallbackLock) {
+            cpuEncoderSession?.let { return it }
+            Log.i(TAG, "🔄 Creating CPU fallback encoder...")
+            val session = backendManager!!.createCpuSession(manifest.encoderPath, encoderSessionOptions!!)
+            cpuEncoderSession = session
+            return session
+        }
+    }
+
+    /**
+     * Encoder for a [seconds]-long window, placed like the full one; created on first use and kept
+     */
+    private fun bucketEncoder(seconds: Int): PlacedSession = synchronized(fallbackLock) {
+        bucketEncoders.getOrPut(seconds) {
+            backendManager!!.createSession(PipelineStage.ENCODER, manifest.bucketEncoderPath(seconds), encoderSessionOptions!!)
+                .also { Log.i(TAG, "✅ ${seconds}s encoder loaded (${it.backend})") }
+        }
+    }
+
+    /**
+     * Run the [seconds]-long bucket encoder on the first frames of [mel]
+     *
+     * @return The encoder outputs, or null if the bucket failed; it is then not used again and
+     *         the caller runs the full window
+     */
+    private fun runBucketEncoder(seconds: Int, mel: OnnxTensor, melBuffer: FloatBuffer?): OrtSession.Result? {
+        return try {
+            val encoder = bucketEncoder(seconds)
+            truncateMel(mel, melBuffer, EncoderBuckets.frames(seconds)).use { features ->
+                encoder.session.run(mapOf("input_features" to features))
             }
+        } catch (e: Exception) {
+            Log.w(TAG, "⚠️ ${seconds}s encoder failed, using the full window from now on: ${e.message}")
+            encoderBuckets = encoderBuckets - seconds
+            null
         }
+    }
 
-        context.assets.open(encoderPath).use { inputStream ->
-            encoderSession = ortEnvironment!!.createSession(inputStream.readBytes(), sessionOptions)
+    /**
+     * Copy the first [frames] of each mel bin of [mel] ([1, bins, 3000]) into a new tensor
+     *
+     * @param melBuffer The buffer [mel] is pinned to, read in place; without it the whole mel
+     *        is copied out of ORT first
+     */
+    private fun truncateMel(mel: OnnxTensor, melBuffer: FloatBuffer?, frames: Int): OnnxTensor {
+        val shape = mel.info.shape
+        val bins = shape[1].toInt()
+        val total = shape[2].toInt()
+        check(frames <= total) { "Mel has $total frames, bucket needs $frames" }
+
+        val source = melBuffer?.duplicate() ?: mel.floatBuffer
+        val truncated = ByteBuffer.allocateDirect(bins * frames * 4).order(ByteOrder.nativeOrder()).asFloatBuffer()
+        for (bin in 0 until bins) {
+            source.limit(bin * total + frames)
+            source.position(bin * total)
+            truncated.put(source)
         }
-        Log.i(TAG, "✅ Encoder model loaded")
+        truncated.flip()
+        return OnnxTensor.createTensor(ortEnvironment!!, truncated, longArrayOf(1, bins.toLong(), frames.toLong()))
     }
 
-    private fun loadCacheInitSession() {
-        val cachePath = "models/Whisper_cache_initializer.onnx"
-        val sessionOptions = OrtSession.SessionOptions().apply {
-            registerCustomOpLibrary(OrtxPackage.getLibraryPath())
-            setCPUArenaAllocator(false)
-            setMemoryPatternOptimization(false)
-            setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+    /**
+     * Whether the cache initializer and the decoder take encoder states shorter than the full
+     * window (dynamic frame axis). Bucket encoders are only used if both do: their shortened
+     * hidden states flow through both, and a fixed 1500-frame axis would fail every encode.
+     */
+    private fun crossAttentionAxesDynamic(): Boolean {
+        val hiddenStates = (cacheInitSession!!.inputInfo["encoder_hidden_states"]?.info as? TensorInfo)?.shape
+        val pastKey = (decoderSession!!.inputInfo[pastEncoderKey[0]]?.info as? TensorInfo)?.shape
+        val dynamic = hiddenStates?.getOrNull(1) == -1L && pastKey?.getOrNull(2) == -1L
+        if (!dynamic) {
+            Log.w(TAG, "⚠️ Cross-attention frame axis is fixed (${hiddenStates?.contentToString()}, ${pastKey?.contentToString()}), shortened encoder windows disabled")
         }
+        return dynamic
+    }
+
+    /**
+     * A pinned initializer output: the spare one if free, else a new one (null if the
+     * initializer's output shape is not static)
+     */
+    private fun takeMelOutput(): MelOutput? {
+        spareMel.getAndSet(null)?.let { return it }
+        val shape = melShape ?: return null
+        val buffer = ByteBuffer.allocateDirect(shape.fold(1L, Long::times).toInt() * java.lang.Float.BYTES)
+            .order(ByteOrder.nativeOrder())
+            .asFloatBuffer()
+        return MelOutput(buffer, OnnxTensor.createTensor(ortEnvironment!!, buffer, shape))
+    }
+
+    private fun recycleMelOutput(mel: MelOutput) {
+        if (!spareMel.compareAndSet(null, mel)) mel.close()
+    }
+
+    private class MelOutput(val buffer: FloatBuffer, val tensor: OnnxTensor) : AutoCloseable {
+        override fun close() = tensor.close()
+    }
 
-        context.assets.open(cachePath).use { inputStream ->
-            cacheInitSession = ortEnvironment!!.createSession(inputStream.readBytes(), sessionOptions)
+    private fun loadCacheInitSession() {
+        val cachePath = manifest.cacheInitializerPath
+        val sessionOptions = {
+            OrtSession.SessionOptions().apply {
+                registerCustomOpLibrary(OrtxPackage.getLibraryPath())
+                setCPUArenaAllocator(false)
+                setMemoryPatternOptimization(false)
+                setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+                backendManager!!.tuneCpuThreads(this)
+            }
         }
+
+        cacheInitSession = modelCache!!.createSession(cachePath, sessionOptions)
         Log.i(TAG, "✅ Cache initializer model loaded")
     }
 
     private fun loadDecoderSession() {
-        val decoderPath = "models/Whisper_decoder.onnx"
-        val sessionOptions = OrtSession.SessionOptions().apply {
-            registerCustomOpLibrary(OrtxPackage.getLibraryPath())
-            setCPUArenaAllocator(false)
-            setMemoryPatternOptimization(false)
-            setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+        val decoderPath = manifest.decoderPath
+        val sessionOptions = {
+            OrtSession.SessionOptions().apply {
+                registerCustomOpLibrary(OrtxPackage.getLibraryPath())
+                setCPUArenaAllocator(false)
+                setMemoryPatternOptimization(false)
+                setOptimizationLevel(OrtSession.SessionOptions.OptLevel.NO_OPT)
+            }
         }
 
-        context.assets.open(decoderPath).use { inputStream ->
-            decoderSession = ortEnvironment!!.createSession(inputStream.readBytes(), sessionOptions)
-        }
-        Log.i(TAG, "✅ Decoder model loaded")
+        val placed = backendManager!!.createSession(PipelineStage.DECODER, decoderPath, sessionOptions)
+        decoderSession = placed.session
+        Log.i(TAG, "✅ Decoder model loaded (${placed.backend})")
     }
 
     private fun loadDetokenizerSession() {
-        val detokenizerPath = "models/Whisper_detokenizer.onnx"
-        val sessionOptions = OrtSession.SessionOptions().apply {
-            registerCustomOpLibrary(OrtxPackage.getLibraryPath())
-            setCPUArenaAllocator(false)
-            setMemoryPatternOptimization(false)
+        val detokenizerPath = manifest.detokenizerPath
+        val sessionOptions = {
+            OrtSession.SessionOptions().apply {
+                registerCustomOpLibrary(OrtxPackage.getLibraryPath())
+                setCPUArenaAllocator(false)
+                setMemoryPatternOptimization(false)
+                backendManager!!.tuneCpuThreads(this)
+            }
         }
 
-        context.assets.open(detokenizerPath).use { inputStream ->
-            detokenizerSession = ortEnvironment!!.createSession(inputStream.readBytes(), sessionOptions)
-        }
+        detokenizerSession = modelCache!!.createSession(detokenizerPath, sessionOptions)
         Log.i(TAG, "✅ Detokenizer model loaded")
     }
 
@@ -225,8 +569,22 @@ class WhisperEngine(
      * @param audioData PCM audio samples (16kHz, mono, 16-bit little-endian)
      * @return TranscriptionResult with text and performance metrics
      */
-    suspend fun transcribe(audioData: ByteArray): TranscriptionResult = withContext(Dispatchers.IO) {
+    suspend fun transcribe(audioData: ByteArray): TranscriptionResult {
+        return decode(encode(audioData))
+    }
+
+    /**
+     * Pipeline stage 1: preprocessing, encoder (APU) and cross-attention cache init.
+     *
+     * Runs independently of [decode], so chunk N+1 can be encoded on NNAPI while
+     * chunk N is still decoding on the CPU. The returned [EncodedAudio] owns the
+     * encoder KV cache and must be passed to [decode] (or closed).
+     *
+     * @param audioData PCM audio samples (16kHz, mono, 16-bit little-endian)
+     */
+    suspend fun encode(audioData: ByteArray): EncodedAudio = withContext(Dispatchers.IO) {
         require(initialized) { "Engine not initialized. Call initialize() first." }
+        beginCall(needDecoder = false)
 
         val startTime = System.currentTimeMillis()
         val audioDurationSec = audioData.size / (SAMPLE_RATE * 2).toFloat()
@@ -245,66 +603,74 @@ class WhisperEngine(
         // Declare all resources that need cleanup
         var audioTensor: OnnxTensor? = null
         var initOutputs: OrtSession.Result? = null
+        var melOutput: MelOutput? = null
         var encoderOutputs: OrtSession.Result? = null
         var cacheInitResult: OrtSession.Result? = null
 
         try {
-            // Step 1: Convert PCM to float array
-            val audioFloats = TensorUtils.convertPcmToFloatArray(audioData)
-
-            // Step 2: Run initializer (audio preprocessing + mel-spectrogram)
+            // Step 1-2: Convert PCM into the shared direct buffer (bound by ORT without a copy)
+            // and run the initializer (audio preprocessing + mel-spectrogram). The buffer is
+            // held until the initializer has read it; partial and final encodes may overlap.
             Log.d(TAG, "Step 1: Running audio preprocessor...")
             val preOpTime = System.currentTimeMillis()
-            audioTensor = OnnxTensor.createTensor(
-                ortEnvironment!!,
-                FloatBuffer.wrap(audioFloats),
-                longArrayOf(1, audioFloats.size.toLong())
-            )
-
-            val initInputs = mapOf("audio_pcm" to audioTensor)
-            initOutputs = initSession!!.run(initInputs)
-            val melSpectrogram = initOutputs[0] as OnnxTensor
+            val melSpectrogram = synchronized(pcmInput) {
+                val samples = pcmInput.load(audioData)
+                audioTensor = OnnxTensor.createTensor(
+                    ortEnvironment!!,
+                    samples,
+                    longArrayOf(1, samples.remaining().toLong())
+                )
+                Log.d(TAG, "   Level: rms=${"%.3f".format(pcmInput.levels.rms)} peak=${"%.3f".format(pcmInput.levels.peak)}")
+
+                val pinned = takeMelOutput()
+                melOutput = pinned
+                if (pinned != null) {
+                    // ORT writes the mel straight into the pinned buffer
+                    initSession!!.run(mapOf("audio_pcm" to audioTensor), emptySet(), mapOf(melOutputName to pinned.tensor)).close()
+                    pinned.tensor
+                } else {
+                    initOutputs = initSession!!.run(mapOf("audio_pcm" to audioTensor))
+                    initOutputs!![0] as OnnxTensor
+                }
+            }
             val preOpDuration = System.currentTimeMillis() - preOpTime
             Log.i(TAG, "   Preprocessing: ${preOpDuration}ms")
 
-            // Step 3: Run encoder (this is where APU acceleration shines!)
-            Log.d(TAG, "Step 2: Running encoder on APU...")
+            // Step 3: Run encoder (this is where APU acceleration shines!), on the shortest
+            // window that covers the chunk
+            Log.d(TAG, "Step 2: Running encoder on $encoderBackend...")
             val encodeTime = System.currentTimeMillis()
             val encoderInputs = mapOf("input_features" to melSpectrogram)
             var encodeDuration: Long
-            
+            var windowSec = if (encoderDemoted) null else EncoderBuckets.select(audioDurationSec, encoderBuckets)
+
+            val accelerated = encoderBackend != Backend.CPU && !encoderDemoted
             try {
-                encoderOutputs = encoderSession!!.run(encoderInputs)
+                encoderOutputs = windowSec?.let { runBucketEncoder(it, melSpectrogram, melOutput?.buffer) }
+                if (encoderOutputs == null) {
+                    windowSec = null
+                    encoderOutputs = (if (encoderDemoted) cpuEncoder() else encoderSession!!).run(encoderInputs)
+                }
                 encodeDuration = System.currentTimeMillis() - encodeTime
-                Log.i(TAG, "   ⚡ Encoding: ${encodeDuration}ms")
+                Log.i(TAG, "   ⚡ Encoding: ${encodeDuration}ms (${windowSec ?: EncoderBuckets.FULL_WINDOW_SEC}s window)")
+                if (accelerated) synchronized(fallbackLock) { encoderFailures = 0 }
             } catch (e: Exception) {
-                Log.e(TAG, "❌ APU encoder failed: ${e.message}", e)
+                if (!accelerated) throw e
+                Log.e(TAG, "❌ $encoderBackend encoder failed: ${e.message}", e)
                 Log.i(TAG, "🔄 Attempting CPU fallback...")
-                
-                // Create CPU-only encoder session as fallback
-                val encoderPath = "models/Whisper_encoder.onnx"
-                val sessionOptions = OrtSession.SessionOptions().apply {
-                    registerCustomOpLibrary(OrtxPackage.getLibraryPath())
-                    setCPUArenaAllocator(false) // Disable arena allocator for stability
-                    setMemoryPatternOptimization(false) // Disable memory optimization
-                    setOptimizationLevel(OrtSession.SessionOptions.OptLevel.BASIC_OPT)
-                    setSymbolicDimensionValue("batch_size", 1)
-                    // Explicitly avoid NNAPI for CPU fallback
-                }
-
-                val cpuEncoderSession = ortEnvironment!!.createSession(
-                    context.assets.open(encoderPath).readBytes(),
-                    sessionOptions
-                )
 
-                // Run encoder on CPU
+                // Run encoder on the cached CPU session
                 val cpuEncodeTime = System.currentTimeMillis()
-                encoderOutputs = cpuEncoderSession.run(encoderInputs)
+                encoderOutputs = cpuEncoder().run(encoderInputs)
                 encodeDuration = System.currentTimeMillis() - cpuEncodeTime
                 Log.i(TAG, "   🖥️ CPU Encoding: ${encodeDuration}ms")
-                
-                // Cleanup CPU session
-                cpuEncoderSession.close()
+
+                synchronized(fallbackLock) {
+                    if (++encoderFailures >= MAX_ENCODER_FAILURES && !encoderDemoted) {
+                        encoderDemoted = true
+                        Log.w(TAG, "⚠️ $encoderBackend encoder failed $encoderFailures times in a row, using CPU from now on")
+                    }
+                }
             }
             
             // Extract encoder hidden states (guaranteed non-null: set by either APU or CPU encoder above)
@@ -318,41 +684,17 @@ class WhisperEngine(
             val cacheDuration = System.currentTimeMillis() - cacheTime
             Log.i(TAG, "   Cache init: ${cacheDuration}ms")
 
-            // Step 5: Autoregressive decoding
-            Log.d(TAG, "Step 4: Running autoregressive decoder...")
-            val decodeTime = System.currentTimeMillis()
-            val tokens = runAutoregressiveDecoder(cacheInitResult, audioDurationSec)
-            val decodeDuration = System.currentTimeMillis() - decodeTime
-            Log.i(TAG, "   Decoding: ${decodeDuration}ms (${tokens.size} tokens)")
-
-            // Step 6: Detokenize to text
-            Log.d(TAG, "Step 5: Detokenizing...")
-            val text = detokenize(tokens)
-
-            val totalDuration = System.currentTimeMillis() - startTime
-            val rtf = totalDuration / (audioDurationSec * 1000)
-
-            Log.i(TAG, "")
-            Log.i(TAG, "========================================")
-            Log.i(TAG, "✅ TRANSCRIPTION COMPLETE")
-            Log.i(TAG, "========================================")
-            Log.i(TAG, "   Audio duration:  ${audioDurationSec}s")
-            Log.i(TAG, "   Preprocessing:   ${preOpDuration}ms")
-            Log.i(TAG, "   Encoding:        ${encodeDuration}ms")
-            Log.i(TAG, "   Cache init:      ${cacheDuration}ms")
-            Log.i(TAG, "   Decoding:        ${decodeDuration}ms")
-            Log.i(TAG, "   Total time:      ${totalDuration}ms")
-            Log.i(TAG, "   RTF:             ${"%.2f".format(rtf)}x")
-            Log.i(TAG, "   Text:            \"$text\"")
-            Log.i(TAG, "========================================")
-
-            return@withContext TranscriptionResult(
-                text = text.trim(),
-                language = "en",
-                segments = emptyList(),
-                confidence = 1.0f,
-                processingTimeMs = totalDuration
+            val encoded = EncodedAudio(
+                cacheInitResult = cacheInitResult,
+                audioDurationSec = audioDurationSec,
+                encoderWindowSec = windowSec ?: EncoderBuckets.FULL_WINDOW_SEC,
+                startTimeMs = startTime,
+                preOpDurationMs = preOpDuration,
+                encodeDurationMs = encodeDuration,
+                cacheDurationMs = cacheDuration
             )
+            cacheInitResult = null // Ownership moved to EncodedAudio
+            return@withContext encoded
 
         } catch (e: Exception) {
             Log.e(TAG, "❌ Transcription failed", e)
@@ -362,122 +704,514 @@ class WhisperEngine(
             // Guaranteed cleanup - close each resource independently
             try { audioTensor?.close() } catch (e: Exception) { Log.e(TAG, "Error closing audioTensor", e) }
             try { initOutputs?.close() } catch (e: Exception) { Log.e(TAG, "Error closing initOutputs", e) }
+            melOutput?.let(::recycleMelOutput)
             try { encoderOutputs?.close() } catch (e: Exception) { Log.e(TAG, "Error closing encoderOutputs", e) }
             try { cacheInitResult?.close() } catch (e: Exception) { Log.e(TAG, "Error closing cacheInitResult", e) }
+            endCall()
         }
     }
 
     /**
-     * Run autoregressive decoder with KV caching
-     * Implements the same algorithm as RTranslator's Recognizer.java
+     * Pipeline stage 2: autoregressive decoder (CPU) and detokenizer.
+     *
+     * Always closes [encoded], whether decoding succeeds or not.
+     *
+     * @param previousTokens Text tokens of the preceding transcript, fed as <|startofprev|>
+     * context so a window continues the previous one (see [TranscriptionResult.tokens])
      */
-    private fun runAutoregressiveDecoder(
-        cacheInitResult: OrtSession.Result,
-        audioDurationSec: Float
-    ): IntArray {
-        val env = ortEnvironment!!
-        val tokens = mutableListOf<Int>()
+    suspend fun decode(
+        encoded: EncodedAudio,
+        previousTokens: IntArray = IntArray(0)
+    ): TranscriptionResult = withContext(Dispatchers.Default) {
+        encoded.use {
+            beginCall(needDecoder = true)
+            try {
+                val audioDurationSec = encoded.audioDurationSec
+
+                // Step 5: Autoregressive decoding, detokenizing each attempt for the fallback checks
+                Log.d(TAG, "Step 4: Running autoregressive decoder...")
+                val decodeTime = System.currentTimeMillis()
+                val options = decodingOptions
+                val (sequence, text, segments) = decodeMutex.withLock {
+                    val decoded = decodeWithFallback(encoded.cacheInitResult, audioDurationSec, options, previousTokens)
+                    val segments = if (options.timestamps) buildSegments(decoded.first, audioDurationSec) else emptyList()
+                    Triple(decoded.first, decoded.second, segments)
+                }
+                val decodeDuration = System.currentTimeMillis() - decodeTime
+                Log.i(TAG, "   Decoding: ${decodeDuration}ms (${sequence.tokens.size} tokens, T=${sequence.temperature})")
+
+                // Wall time since encode() started; exceeds the stage sum when the chunk queued behind another
+                val totalDuration = System.currentTimeMillis() - encoded.startTimeMs
+                val rtf = totalDuration / (audioDurationSec * 1000)
+
+                Log.i(TAG, "")
+                Log.i(TAG, "========================================")
+                Log.i(TAG, "✅ TRANSCRIPTION COMPLETE")
+                Log.i(TAG, "========================================")
+                Log.i(TAG, "   Audio duration:  ${audioDurationSec}s")
+                Log.i(TAG, "   Preprocessing:   ${encoded.preOpDurationMs}ms")
+                Log.i(TAG, "   Encoding:        ${encoded.encodeDurationMs}ms (${encoded.encoderWindowSec}s window)")
+                Log.i(TAG, "   Cache init:      ${encoded.cacheDurationMs}ms")
+                Log.i(TAG, "   Decoding:        ${decodeDuration}ms")
+                Log.i(TAG, "   Total time:      ${totalDuration}ms")
+                Log.i(TAG, "   RTF:             ${"%.2f".format(rtf)}x")
+                Log.i(TAG, "   Text:            \"$text\"")
+                Log.i(TAG, "========================================")
+
+                return@withContext TranscriptionResult(
+                    text = text.trim(),
+                    language = "en",
+                    segments = segments,
+                    tokens = textTokens(sequence.tokens).toList(),
+                    confidence = exp(sequence.avgLogProb).toFloat(),
+                    processingTimeMs = totalDuration,
+                    audioDurationSec = audioDurationSec
+                )
 
-        // Calculate max tokens based on audio duration
-        val maxTokens = ((audioDurationSec * MAX_TOKENS_PER_SECOND).toInt()).coerceAtMost(MAX_TOKENS)
+            } catch (e: Exception) {
+                Log.e(TAG, "❌ Transcription failed", e)
+                e.printStackTrace()
+                throw Exception("Transcription failed: ${e.message}", e)
+            } finally {
+                endCall()
+            }
+        }
+    }
 
-        // Initial decoder tokens: <|startoftranscript|>, <|en|>, <|transcribe|>, <|notimestamps|>
-        val initialTokens = intArrayOf(
-            START_TOKEN_ID,
-            ENGLISH_TOKEN_ID,
-            TRANSCRIBE_TOKEN_ID,
-            NO_TIMESTAMPS_TOKEN_ID
+    /**
+     * Allocate the decoder-step tensors that are reused for every token.
+     *
+     * input_ids is backed by a direct buffer that ORT reads in place, so each step only
+     * writes one long. The decoder self-attention cache grows by one position per step in
+     * this export, so present KV tensors are fed straight back as the next inputs rather
+     * than being bound to a fixed-size buffer.
+     */
+    private fun allocateDecoderBuffers() {
+        val env = ortEnvironment!!
+        val buffer = ByteBuffer.allocateDirect(java.lang.Long.BYTES)
+            .order(ByteOrder.nativeOrder())
+            .asLongBuffer()
+        inputIdBuffer = buffer
+        inputIdTensor = OnnxTensor.createTensor(env, buffer, longArrayOf(1, 1))
+        emptyDecoderCache = TensorUtils.createFloatTensorWithSingleValue(
+            env, 0f, longArrayOf(1, manifest.attentionHeads.toLong(), 0, manifest.headDim.toLong())
         )
 
-        var currentToken = -1  // Start with invalid token
-        var iteration = 1
-        var isFirstIteration = true
-        var previousResult: OrtSession.Result? = null
+        // Logits for one position, written by ORT into a pinned buffer and scored in place
+        val session = decoderSession!!
+        val logitsShape = (session.outputInfo["logits"]?.info as? TensorInfo)?.shape
+        val vocabSize = logitsShape?.lastOrNull()?.takeIf { it > 0 }?.toInt() ?: specialTokens.vocabSize
+        val logits = ByteBuffer.allocateDirect(vocabSize * java.lang.Float.BYTES)
+            .order(ByteOrder.nativeOrder())
+            .asFloatBuffer()
+        logitsBuffer = logits
+        logitsTensor = OnnxTensor.createTensor(env, logits, longArrayOf(1, 1, vocabSize.toLong()))
+        pinnedLogits["logits"] = logitsTensor!!
+        presentOutputNames = session.outputNames - "logits"
+
+        // Everything after EOS is a special token (SOT, language, task, notimestamps, timestamps)
+        suppressedTokens = BooleanArray(vocabSize) { it > specialTokens.endOfText }
+        // Timestamped decoding additionally allows timestamp tokens
+        timestampOnlyTokens = BooleanArray(vocabSize) { it != specialTokens.endOfText && it < specialTokens.timestampBegin }
+        // A window never starts more than MAX_INITIAL_TIMESTAMP into its speech
+        initialTimestampTokens = BooleanArray(vocabSize) { timestampOnlyTokens[it] || it > maxInitialTimestampId }
+        timestampOrTextTokens = BooleanArray(vocabSize) { it > specialTokens.endOfText && it < specialTokens.timestampBegin }
+        timestampFloor = specialTokens.timestampBegin
+    }
 
-        // Continue until EOS token is generated (but always process initial 4 tokens)
-        while (iteration <= 4 || currentToken != EOS_TOKEN_ID) {
-            // Prepare input token(s)
-            val inputIdTensor = if (iteration <= 4) {
-                TensorUtils.convertIntArrayToTensor(env, intArrayOf(initialTokens[iteration - 1]))
-            } else {
-                TensorUtils.convertIntArrayToTensor(env, intArrayOf(currentToken))
+    /**
+     * Decode with the configured strategy, falling back to hotter temperatures when the
+     * result fails the compression-ratio / log-probability / repetition checks.
+     *
+     * Like openai-whisper, the previous-text context is dropped above temperature 0.5:
+     * a hot retry is usually fighting a loop the context may have caused.
+     *
+     * @return The accepted sequence and its detokenized text
+     */
+    private fun decodeWithFallback(
+        cacheInitResult: OrtSession.Result,
+        audioDurationSec: Float,
+        options: DecodingOptions,
+        previousTokens: IntArray
+    ): Pair<DecodedSequence, String> {
+        // Calculate max tokens based on audio duration (timestamps take about a third more)
+        val tokensPerSecond = if (options.timestamps) MAX_TOKENS_PER_SECOND * 4 / 3 else MAX_TOKENS_PER_SECOND
+        val maxTokens = ((audioDurationSec * tokensPerSecond).toInt()).coerceIn(1, MAX_TOKENS)
+        var best: Pair<DecodedSequence, String>? = null
+        val conditionedPrompt = buildPrompt(options.timestamps, previousTokens)
+        val plainPrompt = buildPrompt(options.timestamps, IntArray(0))
+
+        bindCrossAttentionCache(cacheInitResult)
+        try {
+            for (temperature in options.temperatures) {
+                val prompt = if (temperature <= PROMPT_MAX_TEMPERATURE) conditionedPrompt else plainPrompt
+                // Timestamp rules depend on each hypothesis' history, so timestamped decoding is single-beam
+                val sequence = if (temperature == 0f && options.beamSize > 1 && !options.timestamps) {
+                    runBeamSearch(options.beamSize, maxTokens, prompt)
+                } else {
+                    runAutoregressiveDecoder(temperature, maxTokens, prompt, options.timestamps)
+                }
+                val text = detokenize(textTokens(sequence.tokens))
+                val candidate = sequence to text
+
+                if (!options.needsFallback(sequence, text)) {
+                    return candidate
+                }
+
+                Log.w(TAG, "   Decode at T=$temperature rejected (avgLogProb=${"%.2f".format(sequence.avgLogProb)}, " +
+                        "compression=${"%.2f".format(DecodingOptions.compressionRatio(text))}, repetitive=${sequence.repetitive})")
+                // Keep the most plausible attempt in case every temperature fails
+                val current = best
+                if (current == null || (current.first.repetitive && !sequence.repetitive) ||
+                    (current.first.repetitive == sequence.repetitive && sequence.avgLogProb > current.first.avgLogProb)) {
+                    best = candidate
+                }
             }
+        } finally {
+            // Drop references to per-chunk tensors before they are closed
+            decoderInputs.clear()
+        }
 
-            // Prepare decoder inputs
-            val decoderInputs = mutableMapOf<String, OnnxTensor>()
-            decoderInputs["input_ids"] = inputIdTensor
+        return best!!
+    }
 
-            if (isFirstIteration) {
-                // First iteration - use empty decoder cache
-                val emptyCache = TensorUtils.createFloatTensorWithSingleValue(
-                    env, 0f, longArrayOf(1, NUM_DECODER_LAYERS.toLong(), 0, CACHE_DIM.toLong())
-                )
+    /**
+     * Bind the fixed decoder inputs for a chunk: token slot and cross-attention cache.
+     * The cross-attention cache is shared by every step, attempt and beam without copies.
+     */
+    private fun bindCrossAttentionCache(cacheInitResult: OrtSession.Result) {
+        decoderInputs.clear()
+        decoderInputs["input_ids"] = inputIdTensor!!
+        for (i in 0 until numDecoderLayers) {
+            decoderInputs[pastEncoderKey[i]] = cacheInitResult.get(presentEncoderKey[i]).get() as OnnxTensor
+            decoderInputs[pastEncoderValue[i]] = cacheInitResult.get(presentEncoderValue[i]).get() as OnnxTensor
+        }
+    }
+
+    /**
+     * Run one decoder step for [token], continuing from the self-attention cache in [past]
+     * (the result of the previous step, or null for the first step). [past] is only read,
+     * so several beams can continue from the same result.
+     *
+     * Logits are written into the pinned logits tensor rather than the returned result, so
+     * they must be scored with [scoreStep] before the next step overwrites them.
+     */
+    private fun runDecoderStep(token: Int, past: OrtSession.Result?): OrtSession.Result {
+        inputIdBuffer!!.put(0, token.toLong())
+        for (i in 0 until numDecoderLayers) {
+            decoderInputs[pastDecoderKey[i]] =
+                past?.get(presentDecoderKey[i])?.get() as OnnxTensor? ?: emptyDecoderCache!!
+            decoderInputs[pastDecoderValue[i]] =
+                past?.get(presentDecoderValue[i])?.get() as OnnxTensor? ?: emptyDecoderCache!!
+        }
+        return decoderSession!!.run(decoderInputs, presentOutputNames, pinnedLogits)
+    }
+
+    /**
+     * Decoder prefix: optional <|startofprev|> context (the last text tokens of the previous
+     * transcript, at most MAX_PREVIOUS_TOKENS), then the forced task tokens
+     */
+    private fun buildPrompt(timestamps: Boolean, previousTokens: IntArray): IntArray {
+        val task = if (timestamps) timestampPromptTokens else promptTokens
+        val context = previousTokens.filter { it < specialTokens.endOfText }.takeLast(MAX_PREVIOUS_TOKENS)
+        if (context.isEmpty()) return task
+        return intArrayOf(specialTokens.startOfPrev) + context.toIntArray() + task
+    }
 
-                for (i in 0 until NUM_DECODER_LAYERS) {
-                    decoderInputs["past_key_values.$i.decoder.key"] = emptyCache
-                    decoderInputs["past_key_values.$i.decoder.value"] = emptyCache
-                    decoderInputs["past_key_values.$i.encoder.key"] =
-                        cacheInitResult.get("present.$i.encoder.key").get() as OnnxTensor
-                    decoderInputs["past_key_values.$i.encoder.value"] =
-                        cacheInitResult.get("present.$i.encoder.value").get() as OnnxTensor
+    /**
+     * Feed the forced prompt; the pinned logits then hold the first free token's scores.
+     * Each prompt token is one decoder step, so context costs one step per token.
+     */
+    private fun runPrompt(prompt: IntArray): OrtSession.Result {
+        var result: OrtSession.Result? = null
+        try {
+            for (token in prompt) {
+                val next = runDecoderStep(token, result)
+                result?.close()
+                result = next
+            }
+            return result!!
+        } catch (e: Exception) {
+            result?.close()
+            throw e
+        }
+    }
+
+    /**
+     * Score the last step's logits in place: top-k, argmax and log-softmax in one kernel,
+     * with special tokens suppressed so only text tokens and EOS can be emitted
+     */
+    private fun scoreStep(scores: TokenScores, suppressed: BooleanArray = suppressedTokens) {
+        OnnxUtils.scoreLogits(logitsBuffer!!, suppressed, scores)
+    }
+
+    /**
+     * Run autoregressive decoder with KV caching: greedy at temperature 0, sampling above.
+     * Implements the same algorithm as RTranslator's Recognizer.java
+     *
+     * Steady state allocates no tensors or arrays: input_ids, the empty cache and the
+     * logits output are preallocated and pinned, the input map is reused, and present KV
+     * tensors are passed back without copying. Stops early when the output starts looping
+     * instead of running to maxTokens.
+     *
+     * With [timestamps], [prompt] must omit <|notimestamps|>; each step is then masked with
+     * whisper's timestamp rules (see [timestampMask]).
+     */
+    private fun runAutoregressiveDecoder(
+        temperature: Float,
+        maxTokens: Int,
+        prompt: IntArray,
+        timestamps: Boolean
+    ): DecodedSequence {
+        val tokens = IntArray(maxTokens)
+        var tokenCount = 0
+        var sumLogProb = 0.0
+        var generated = 0
+        var repetitive = false
+        val scores = stepScores
+        if (timestamps) resetTimestampMasks()
+
+        var result = runPrompt(prompt)
+        try {
+            while (true) {
+                val mask = if (timestamps) timestampMask(tokens, tokenCount) else suppressedTokens
+                scoreStep(scores, mask)
+                val currentToken = if (temperature == 0f) scores.best else sampleToken(scores, temperature, mask)
+                sumLogProb += logitsBuffer!!.get(currentToken) - scores.logSumExp
+                generated++
+
+                if (currentToken == specialTokens.endOfText) break
+
+                if (currentToken >= specialTokens.timestampBegin) raiseTimestampFloor(currentToken)
+
+                tokens[tokenCount++] = currentToken
+                val loopEnd = RepetitionDetector.findLoop(tokens, tokenCount)
+                if (loopEnd >= 0) {
+                    Log.w(TAG, "   Repetition detected after $tokenCount tokens, stopping")
+                    tokenCount = loopEnd
+                    repetitive = true
+                    break
                 }
-                isFirstIteration = false
-            } else {
-                // Subsequent iterations - use previous decoder cache
-                // previousResult is guaranteed non-null here (set in previous iteration)
-                @Suppress("UNNECESSARY_NOT_NULL_ASSERTION")
-                val prevResult = previousResult!!
-                for (i in 0 until NUM_DECODER_LAYERS) {
-                    decoderInputs["past_key_values.$i.decoder.key"] =
-                        prevResult.get("present.$i.decoder.key").get() as OnnxTensor
-                    decoderInputs["past_key_values.$i.decoder.value"] =
-                        prevResult.get("present.$i.decoder.value").get() as OnnxTensor
-                    decoderInputs["past_key_values.$i.encoder.key"] =
-                        cacheInitResult.get("present.$i.encoder.key").get() as OnnxTensor
-                    decoderInputs["past_key_values.$i.encoder.value"] =
-                        cacheInitResult.get("present.$i.encoder.value").get() as OnnxTensor
+
+                // Safety check - prevent infinite loops
+                if (generated >= maxTokens) {
+                    Log.w(TAG, "   Max tokens reached ($maxTokens), stopping")
+                    break
                 }
+
+                // Feed this step's self-attention cache into the next step, then free the previous one
+                val next = runDecoderStep(currentToken, result)
+                result.close()
+                result = next
             }
+        } finally {
+            result.close()
+        }
 
-            // Run decoder
-            val result = decoderSession!!.run(decoderInputs)
+        return DecodedSequence(
+            tokens = tokens.copyOf(tokenCount),
+            avgLogProb = sumLogProb / generated,
+            temperature = temperature,
+            repetitive = repetitive
+        )
+    }
 
-            // Clean up previous result to free memory
-            previousResult?.close()
-            previousResult = result
+    /**
+     * Token mask for the next timestamped step, following whisper's ApplyTimestampRules:
+     * the first token is a timestamp; timestamps come in start/end pairs around text, so
+     * after a pair text must follow and after a lone end timestamp the next start (or EOS)
+     * must follow; timestamps never go backwards (enforced by [raiseTimestampFloor]).
+     * The first timestamp is at most MAX_INITIAL_TIMESTAMP.
+     */
+    private fun timestampMask(tokens: IntArray, count: Int): BooleanArray {
+        if (count == 0) return initialTimestampTokens
+        val lastWasTimestamp = tokens[count - 1] >= specialTokens.timestampBegin
+        if (!lastWasTimestamp) return timestampOrTextTokens
+        val penultimateWasTimestamp = count < 2 || tokens[count - 2] >= specialTokens.timestampBegin
+        return if (penultimateWasTimestamp) suppressedTokens else timestampOnlyTokens
+    }
 
-            // Extract logits and find most likely token
-            val logitsTensor = result.get("logits").get() as OnnxTensor
-            @Suppress("UNCHECKED_CAST") // ONNX model guarantees this shape
-            val logits = logitsTensor.value as Array<Array<FloatArray>>
-            val outputLogits = logits[0][0]
+    /**
+     * Suppress timestamps earlier than [timestamp] in both timestamp masks. Touches only
+     * the newly passed range, so a whole decode costs one walk over the timestamp tokens.
+     */
+    private fun raiseTimestampFloor(timestamp: Int) {
+        for (i in timestampFloor until timestamp) {
+            timestampOnlyTokens[i] = true
+            timestampOrTextTokens[i] = true
+        }
+        timestampFloor = maxOf(timestampFloor, timestamp)
+    }
 
-            currentToken = OnnxUtils.getIndexOfLargest(outputLogits)
+    private fun resetTimestampMasks() {
+        for (i in specialTokens.timestampBegin until timestampFloor) {
+            timestampOnlyTokens[i] = false
+            timestampOrTextTokens[i] = false
+        }
+        timestampFloor = specialTokens.timestampBegin
+    }
 
-            // ✅ FIX: Collect ALL non-special tokens from any iteration
-            // The decoder outputs tokens at EVERY iteration, not just after forced prompts.
-            // Previously we skipped iterations 1-4, which threw away the first word!
-            val isSpecialToken = currentToken == START_TOKEN_ID || 
-                                 currentToken == ENGLISH_TOKEN_ID || 
-                                 currentToken == TRANSCRIBE_TOKEN_ID || 
-                                 currentToken == NO_TIMESTAMPS_TOKEN_ID
-            
-            if (!isSpecialToken && currentToken != EOS_TOKEN_ID) {
-                tokens.add(currentToken)
-            }
+    /**
+     * Sample a token from softmax(logits / temperature) over the unsuppressed tokens
+     */
+    private fun sampleToken(scores: TokenScores, temperature: Float, suppressed: BooleanArray): Int {
+        val logits = logitsBuffer!!
+        // The best log-probability plus the log-sum-exp recovers the largest logit
+        val max = scores.logProbs[0] + scores.logSumExp
+
+        var total = 0.0
+        for (i in 0 until logits.limit()) {
+            if (suppressed[i]) continue
+            total += exp((logits.get(i) - max) / temperature)
+        }
+
+        var threshold = random.nextDouble() * total
+        for (i in 0 until logits.limit()) {
+            if (suppressed[i]) continue
+            threshold -= exp((logits.get(i) - max) / temperature)
+            if (threshold <= 0) return i
+        }
+        return scores.best
+    }
+
+    /**
+     * Text tokens of a sequence, without timestamp tokens
+     */
+    private fun textTokens(tokens: IntArray): IntArray {
+        if (tokens.none { it >= specialTokens.timestampBegin }) return tokens
+        return tokens.filter { it < specialTokens.timestampBegin }.toIntArray()
+    }
 
-            // Safety check - prevent infinite loops
-            if (iteration >= maxTokens) {
-                Log.w(TAG, "   Max tokens reached ($maxTokens), stopping")
-                break
+    /**
+     * Split a timestamped sequence into segments. Times are seconds from the window start;
+     * a segment still open when decoding stopped ends at the end of the audio.
+     */
+    private fun buildSegments(sequence: DecodedSequence, audioDurationSec: Float): List<TranscriptionSegment> {
+        val segments = mutableListOf<TranscriptionSegment>()
+        val confidence = exp(sequence.avgLogProb).toFloat()
+        val text = ArrayList<Int>()
+        var start = -1f
+
+        fun emit(end: Float) {
+            if (text.isNotEmpty()) {
+                val segmentText = detokenize(text.toIntArray())
+                if (segmentText.isNotEmpty()) {
+                    segments.add(TranscriptionSegment(segmentText, maxOf(start, 0f), maxOf(end, start), confidence, text.toList()))
+                }
+                text.clear()
             }
+            start = -1f
+        }
 
-            iteration++
+        for (token in sequence.tokens) {
+            if (token < specialTokens.timestampBegin) {
+                text.add(token)
+                continue
+            }
+            val time = (token - specialTokens.timestampBegin) * TIMESTAMP_STEP_SEC
+            if (start < 0f) {
+                start = time
+            } else {
+                emit(time)
+            }
         }
+        emit(audioDurationSec)
+
+        return segments
+    }
+
+    /**
+     * A live hypothesis: its text tokens, the decoder result after its last token, and
+     * the best next tokens scored from that step (saved before the logits are overwritten)
+     */
+    private class Beam(
+        val tokens: IntArray,
+        val sumLogProb: Double,
+        val generated: Int,
+        val result: OrtSession.Result,
+        val nextTokens: IntArray,
+        val nextLogProbs: FloatArray
+    )
+
+    private class BeamCandidate(val parent: Beam, val token: Int, val sumLogProb: Double)
+
+    private fun newBeam(tokens: IntArray, sumLogProb: Double, generated: Int, result: OrtSession.Result): Beam {
+        val scores = stepScores
+        scoreStep(scores)
+        return Beam(
+            tokens, sumLogProb, generated, result,
+            scores.indices.copyOf(scores.count), scores.logProbs.copyOf(scores.count)
+        )
+    }
+
+    /**
+     * Beam search at temperature 0.
+     *
+     * Beams are expanded as batch-1 decoder steps. A beam's result supplies the present KV
+     * tensors that every child reads in place, so no cache is copied; parent results are
+     * closed once the whole generation has run. Finished hypotheses are ranked by average
+     * log-probability.
+     */
+    private fun runBeamSearch(beamSize: Int, maxTokens: Int, prompt: IntArray): DecodedSequence {
+        val finished = mutableListOf<DecodedSequence>()
+        var beams = listOf(newBeam(IntArray(0), 0.0, 0, runPrompt(prompt)))
 
-        previousResult?.close()
+        try {
+            while (beams.isNotEmpty() && finished.size < beamSize) {
+                val candidates = ArrayList<BeamCandidate>(beams.size * (beamSize + 1))
+                for (beam in beams) {
+                    // beamSize + 1 so that an EOS candidate never starves the live beams
+                    for (j in 0 until minOf(beamSize + 1, beam.nextTokens.size)) {
+                        candidates.add(BeamCandidate(beam, beam.nextTokens[j], beam.sumLogProb + beam.nextLogProbs[j]))
+                    }
+                }
+                candidates.sortByDescending { it.sumLogProb }
+
+                // Expand the best candidates; EOS (or a loop, or the token limit) finishes a hypothesis
+                val expanded = ArrayList<Beam>(beamSize)
+                try {
+                    for (candidate in candidates) {
+                        if (expanded.size >= beamSize || finished.size >= beamSize) break
+                        val parent = candidate.parent
+                        val generated = parent.generated + 1
+
+                        if (candidate.token == specialTokens.endOfText) {
+                            finished.add(DecodedSequence(parent.tokens, candidate.sumLogProb / generated, 0f))
+                            continue
+                        }
+
+                        val tokens = parent.tokens + candidate.token
+                        val loopEnd = RepetitionDetector.findLoop(tokens)
+                        if (loopEnd >= 0 || generated >= maxTokens) {
+                            val kept = if (loopEnd >= 0) tokens.copyOf(loopEnd) else tokens
+                            finished.add(DecodedSequence(kept, candidate.sumLogProb / generated, 0f, repetitive = loopEnd >= 0))
+                            continue
+                        }
+
+                        val result = runDecoderStep(candidate.token, parent.result)
+                        try {
+                            expanded.add(newBeam(tokens, candidate.sumLogProb, generated, result))
+                        } catch (e: Exception) {
+                            result.close()
+                            throw e
+                        }
+                    }
+                } catch (e: Exception) {
+                    expanded.forEach { it.result.close() }
+                    throw e
+                }
+
+                // Parents are no longer needed once all their children have run
+                beams.forEach { it.result.close() }
+                beams = expanded
+            }
+        } finally {
+            beams.forEach { it.result.close() }
+        }
 
-        return tokens.toIntArray()
+        // Best finished hypothesis; a looping one only wins if nothing else finished
+        return finished.maxByOrNull { if (it.repetitive) it.avgLogProb - REPETITION_PENALTY else it.avgLogProb }
+            ?: DecodedSequence(IntArray(0), Double.NEGATIVE_INFINITY, 0f)
     }
 
     /**
@@ -547,21 +1281,40 @@ class WhisperEngine(
         try {
             Log.i(TAG, "Releasing ONNX Whisper Engine...")
 
+            inputIdTensor?.close()
+            emptyDecoderCache?.close()
+            logitsTensor?.close()
+            cpuEncoderSession?.close()
+            closeBucketEncoders()
             initSession?.close()
+            spareMel.getAndSet(null)?.close()
             encoderSession?.close()
             cacheInitSession?.close()
             decoderSession?.close()
             detokenizerSession?.close()
             ortEnvironment?.close()
 
+            inputIdTensor = null
+            inputIdBuffer = null
+            emptyDecoderCache = null
+            logitsTensor = null
+            logitsBuffer = null
+            cpuEncoderSession = null
+            encoderDemoted = false
+            encoderFailures = 0
+            encoderBuckets = emptyList()
+            backendManager = null
+            pinnedLogits.clear()
             initSession = null
             encoderSession = null
             cacheInitSession = null
             decoderSession = null
             detokenizerSession = null
             ortEnvironment = null
+            modelCache = null
 
             initialized = false
+            if (residency != EngineResidency.UNLOADED) transition(EngineResidency.UNLOADED, "released")
 
             Log.i(TAG, "✅ ONNX Whisper Engine released")
         } catch (e: Exception) {
@@ -570,6 +1323,28 @@ class WhisperEngine(
     }
 }
 
+/**
+ * Output of [WhisperEngine.encode]: the cross-attention KV cache for one chunk
+ * plus the stage timings, handed to [WhisperEngine.decode].
+ */
+class EncodedAudio(
+    val cacheInitResult: OrtSession.Result,
+    val audioDurationSec: Float,
+    val encoderWindowSec: Int,
+    val startTimeMs: Long,
+    val preOpDurationMs: Long,
+    val encodeDurationMs: Long,
+    val cacheDurationMs: Long
+) : AutoCloseable {
+    override fun close() {
+        try {
+            cacheInitResult.close()
+        } catch (e: Exception) {
+            Log.e("WhisperEngine", "Error closing cacheInitResult", e)
+        }
+    }
+}
+
 /**
  * Result of transcription
  */
@@ -577,8 +1352,10 @@ data class TranscriptionResult(
     val text: String,
     val language: String,
     val segments: List<TranscriptionSegment> = emptyList(),
+    val tokens: List<Int> = emptyList(),  // Text tokens, for prompt carry-over into the next window
     val confidence: Float = 1.0f,
-    val processingTimeMs: Long = 0
+    val processingTimeMs: Long = 0,
+    val audioDurationSec: Float = 0f
 )
 
 /**
@@ -588,7 +1365,8 @@ data class TranscriptionSegment(
     val text: String,
     val startTime: Float,
     val endTime: Float,
-    val confidence: Float = 1.0f
+    val confidence: Float = 1.0f,
+    val tokens: List<Int> = emptyList()
 )
 
 /**
@@ -599,5 +1377,8 @@ data class ModelInfo(
     val path: String,
     val language: String,
     val isInitialized: Boolean,
-    val type: String = "ONNX Runtime"
+    val type: String = "ONNX Runtime",
+    val warmStart: Boolean = false,     // All sessions loaded from the optimized-graph cache
+    val loadTimeMs: Long = 0,           // Time to load all sessions
+    val cacheDir: String? = null
 )
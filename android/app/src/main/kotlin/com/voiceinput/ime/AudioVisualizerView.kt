@@ -8,6 +8,7 @@ import android.util.AttributeSet
 import android.view.View
 import kotlin.math.abs
 import kotlin.math.min
+import com.voiceinput.core.AudioUtils
 
 /**
  * Simple audio visualizer showing waveform bars
@@ -51,22 +52,20 @@ class AudioVisualizerView @JvmOverloads constructor(
      */
     fun updateAudioData(audioData: ByteArray) {
         if (audioData.isEmpty()) return
+        updateLevel(AudioUtils.calculateLevels(audioData).rms)
+    }
 
+    /**
+     * Add one bar from a chunk's RMS level (0.0-1.0), measured by the caller so it need not
+     * keep the audio until the UI thread runs
+     */
+    fun updateLevel(level: Float) {
         // Update every 2nd call for slower, lazier animation
         updateCounter++
         if (updateCounter % 2 != 0) return
 
-        // Calculate RMS (Root Mean Square) amplitude
-        var sum = 0.0
-        var i = 0
-        while (i < audioData.size - 1) {
-            // Convert bytes to 16-bit PCM sample
-            val sample = ((audioData[i + 1].toInt() shl 8) or (audioData[i].toInt() and 0xFF)).toShort()
-            sum += (sample * sample).toDouble()
-            i += 2
-        }
-
-        val rms = kotlin.math.sqrt(sum / (audioData.size / 2))
+        // RMS (Root Mean Square) amplitude in 16-bit sample units
+        val rms = level * 32768.0
 
         // Normalize to 0-1 range with adjustable sensitivity
         // Low sensitivity (0.0): divide by 32768 (only loud sounds show)
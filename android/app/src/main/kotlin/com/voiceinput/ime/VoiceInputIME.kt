@@ -12,12 +12,14 @@ import com.voiceinput.core.AudioRecorder
 import com.voiceinput.core.VoiceInputPipeline
 import com.voiceinput.core.WhisperEngine
 import com.voiceinput.core.TextProcessor
+import com.voiceinput.core.TraceStage
 import com.voiceinput.config.ConfigRepository
 import com.voiceinput.config.PreferencesManager
 import com.voiceinput.config.InputMode
 import com.voiceinput.data.Note
 import com.voiceinput.data.NotesRepository
 import com.voiceinput.SettingsActivity
+import com.voiceinput.service.EngineConnection
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.SupervisorJob
@@ -41,7 +43,7 @@ import android.util.Log
  * - VoiceInputIME (this) - IME service, lifecycle, & orchestration
  * - VoiceKeyboardView - UI & user interactions
  * - AudioRecorder - Microphone capture
- * - WhisperEngine - Speech-to-text transcription
+ * - WhisperEngine - Speech-to-text transcription, shared with the app through VoiceInputService
  */
 class VoiceInputIME : InputMethodService(), LifecycleOwner {
 
@@ -59,6 +61,7 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
     // Voice processing components (lazy init to save memory)
     private var audioRecorder: AudioRecorder? = null
     private var whisperEngine: WhisperEngine? = null
+    private val engineConnection = EngineConnection(this)
     private val textProcessor = TextProcessor()  // For filtering hallucinations + smart formatting
     private var voicePipeline: VoiceInputPipeline? = null
 
@@ -90,6 +93,9 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
         preferencesManager = PreferencesManager(this)
         notesRepository = NotesRepository(this)
 
+        // Bind the engine host now so the model is (usually) loaded before the keyboard opens
+        engineConnection.bind()
+
         // Load saved mode preference
         isTapMode = (preferencesManager.defaultMode == InputMode.TAP)
         Log.i(TAG, "Loaded saved mode: ${if (isTapMode) "TAP" else "HOLD"}")
@@ -138,11 +144,15 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
         
         // Update keyboard view based on text field type
         updateKeyboardForInputType(attribute)
+
+        // The mic is likely next: have the engine loaded and warm by then
+        engineConnection.onInputStarted()
     }
 
     override fun onFinishInput() {
         super.onFinishInput()
         Log.d(TAG, "Input finished")
+        engineConnection.onInputFinished()
         
         // ✅ FIX: Cancel recording instead of stopping (don't transcribe garbage)
         if (isRecording) {
@@ -198,13 +208,9 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
                     initialize()
                 }
 
-                // Initialize Whisper engine (heavy - do in background)
-                whisperEngine = WhisperEngine(
-                    context = this@VoiceInputIME,
-                    language = config.transcription.language
-                ).apply {
-                    initializeFromAssets("models/")
-                }
+                // Borrow the shared Whisper engine; only the first client in the process pays the load
+                whisperEngine = engineConnection.acquire()
+                    ?: throw IllegalStateException("Whisper engine failed to load")
 
                 // Initialize voice pipeline with VAD-based segmentation
                 voicePipeline = VoiceInputPipeline(
@@ -213,9 +219,17 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
                     whisperEngine = whisperEngine!!,
                     config = config,
                     onResult = null,
-                    onAudioChunk = { chunk -> keyboardView?.updateAudioLevel(chunk) }
+                    onAudioChunk = { chunk -> keyboardView?.updateAudioLevel(chunk.data, chunk.length) },
+                    ownsEngine = false
                 )
                 voicePipeline?.setSmartFormattingEnabled(preferencesManager.smartFormattingEnabled)
+                // Live preview: speculative partials, then each window's final text
+                voicePipeline?.setPartialTranscriptionCallback { committed, tentative ->
+                    keyboardView?.showPartialTranscription(committed, tentative)
+                }
+                voicePipeline?.setTranscriptionDeltaCallback { delta ->
+                    keyboardView?.applyTranscriptDelta(delta)
+                }
 
                 loadingJob.cancel()
 
@@ -239,10 +253,9 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
 
         val pipeline = voicePipeline
         try {
-            if (pipeline != null) {
-                runBlocking {
-                    pipeline.release()
-                }
+            runBlocking {
+                pipeline?.release()
+                engineConnection.close()
             }
         } catch (e: Exception) {
             Log.e(TAG, "Error during cleanup", e)
@@ -384,6 +397,7 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
         serviceScope.launch {
             try {
                 Log.i(TAG, "Stopping recording")
+                val stopNs = System.nanoTime()
                 isRecording = false
 
                 keyboardView?.showProcessingState()
@@ -407,6 +421,7 @@ class VoiceInputIME : InputMethodService(), LifecycleOwner {
                     Log.w(TAG, "Transcription returned empty after VAD chunking")
                 } else {
                     insertText(processedText)
+                    pipeline.trace.record(TraceStage.COMMIT, System.nanoTime() - stopNs)
 
                     // Save to history
                     val durationMs = System.currentTimeMillis() - recordingStartTime
@@ -3,6 +3,10 @@ package com.voiceinput.ime
 import android.content.Context
 import android.graphics.Color
 import android.graphics.drawable.GradientDrawable
+import android.text.SpannableStringBuilder
+import android.text.Spanned
+import android.text.TextUtils
+import android.text.style.ForegroundColorSpan
 import android.os.VibrationEffect
 import android.os.Vibrator
 import android.util.TypedValue
@@ -16,6 +20,8 @@ import android.widget.TextView
 import com.voiceinput.R
 import com.voiceinput.config.InputMode
 import com.voiceinput.config.PreferencesManager
+import com.voiceinput.core.AudioUtils
+import com.voiceinput.core.TextDelta
 import android.widget.FrameLayout
 
 /**
@@ -66,6 +72,10 @@ class VoiceKeyboardView(
     private val holdModeButton: Button
     private val settingsButton: Button
     private val previewText: TextView
+
+    // Transcript of the current recording, kept in sync by pipeline deltas (UI thread only)
+    private val liveTranscript = StringBuilder()
+    private val livePreviewChars = 320 // Well over the preview's two lines
     private val instructionText: TextView
 
     private val readyGradientColors = intArrayOf(Color.parseColor("#5B86E5"), Color.parseColor("#36D1DC"))
@@ -117,6 +127,8 @@ class VoiceKeyboardView(
             textSize = 14f
             setTextColor(Color.parseColor("#B0B0B0"))  // Lighter for dark background
             gravity = Gravity.CENTER
+            maxLines = 2
+            ellipsize = TextUtils.TruncateAt.START  // Live transcription: keep the newest words
             layoutParams = LayoutParams(
                 LayoutParams.MATCH_PARENT,
                 dpToPx(40)
@@ -501,6 +513,7 @@ class VoiceKeyboardView(
         isCurrentlyRecording = true
         post {
             clearPendingStatusReset()
+            liveTranscript.setLength(0)
             statusText.text = "Recording..."
             statusText.setTextColor(recordingAccentColor)
             applyMicrophoneVisualState(MicrophoneVisualState.RECORDING)
@@ -648,9 +661,14 @@ class VoiceKeyboardView(
         }
     }
 
-    fun updateAudioLevel(audioData: ByteArray) {
+    /**
+     * Show the level of a recorder chunk; only the first [length] bytes are read, before returning
+     */
+    fun updateAudioLevel(audioData: ByteArray, length: Int = audioData.size) {
+        if (length <= 0) return
+        val level = AudioUtils.calculateLevels(audioData, 0, length).rms
         post {
-            audioVisualizer.updateAudioData(audioData)
+            audioVisualizer.updateLevel(level)
         }
     }
 
@@ -663,11 +681,60 @@ class VoiceKeyboardView(
 
     fun showPreview(text: String) {
         post {
+            previewText.setTextColor(Color.parseColor("#B0B0B0"))
             previewText.text = text
             previewText.visibility = if (text.isNotEmpty()) View.VISIBLE else View.GONE
         }
     }
 
+    /**
+     * Apply the change a finished window made to the live transcript (see
+     * VoiceInputPipeline.setTranscriptionDeltaCallback) and show it
+     */
+    fun applyTranscriptDelta(delta: TextDelta) {
+        post {
+            delta.applyTo(liveTranscript)
+            if (isCurrentlyRecording) renderLiveTranscript(null, "")
+        }
+    }
+
+    /**
+     * Show live transcription while recording: committed text in full color,
+     * tentative text (may still change) dimmed
+     *
+     * @param committed Committed text as a change to the live transcript, shown but not applied
+     */
+    fun showPartialTranscription(committed: TextDelta, tentative: String) {
+        post {
+            if (isCurrentlyRecording) renderLiveTranscript(committed, tentative)
+        }
+    }
+
+    /**
+     * Preview of the live transcript's last [livePreviewChars], so a long session costs the
+     * UI thread no more than a short one
+     */
+    private fun renderLiveTranscript(committed: TextDelta?, tentative: String) {
+        val end = committed?.start?.coerceAtMost(liveTranscript.length) ?: liveTranscript.length
+        val from = maxOf(0, end - livePreviewChars)
+        val preview = SpannableStringBuilder()
+        if (from > 0) preview.append('…')
+        preview.append(liveTranscript, from, end)
+        committed?.let { preview.append(it.text) }
+        if (tentative.isNotEmpty()) {
+            if (preview.isNotEmpty()) preview.append(' ')
+            val start = preview.length
+            preview.append(tentative)
+            preview.setSpan(
+                ForegroundColorSpan(Color.parseColor("#707070")),
+                start, preview.length, Spanned.SPAN_EXCLUSIVE_EXCLUSIVE
+            )
+        }
+        previewText.setTextColor(Color.WHITE)
+        previewText.text = preview
+        previewText.visibility = if (preview.isNotEmpty()) View.VISIBLE else View.GONE
+    }
+
     // ============================================================================
     // Utilities
     // ============================================================================
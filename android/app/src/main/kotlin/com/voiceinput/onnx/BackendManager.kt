@@ -0,0 +1,318 @@
+package com.voiceinput.onnx
+
+import ai.onnxruntime.OnnxJavaType
+import ai.onnxruntime.OnnxTensor
+import ai.onnxruntime.OrtEnvironment
+import ai.onnxruntime.OrtException
+import ai.onnxruntime.OrtProvider
+import ai.onnxruntime.OrtSession
+import ai.onnxruntime.TensorInfo
+import android.util.Log
+import com.voiceinput.config.TranscriptionConfig
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.Properties
+
+/**
+ * Execution providers a pipeline stage can run on
+ */
+enum class Backend {
+    NNAPI,
+    QNN,
+    XNNPACK,
+    CPU;
+
+    /** Whether the EP compiles (part of) the graph, see [OrtModelCache.createSession] */
+    val compilesNodes: Boolean
+        get() = this != CPU
+
+    companion object {
+        /** Parse a config value; "auto" (or anything unknown) means benchmark */
+        fun parse(name: String): Backend? = values().firstOrNull { it.name.equals(name, ignoreCase = true) }
+    }
+}
+
+/**
+ * Pipeline stages with a choice of backend, most promising candidate first.
+ * The initializer and detokenizer use onnxruntime-extensions custom ops and always run on the CPU.
+ */
+enum class PipelineStage(val candidates: List<Backend>) {
+    ENCODER(listOf(Backend.NNAPI, Backend.QNN, Backend.XNNPACK, Backend.CPU)),
+    DECODER(listOf(Backend.XNNPACK, Backend.CPU))
+}
+
+/**
+ * A session and the backend it was placed on
+ */
+class PlacedSession(val session: OrtSession, val backend: Backend)
+
+/**
+ * Picks the execution provider for each pipeline stage.
+ *
+ * At the first launch on a device, every candidate backend that this ORT build provides is
+ * tried for a stage: a session is created and timed on a dummy input, and the fastest one
+ * is kept. The winner is remembered next to the optimized-graph cache (which is keyed by
+ * build fingerprint and ORT version), so later launches create only the winning session.
+ * A backend forced in the config skips the benchmark.
+ *
+ * CPU work is limited to the big cores: on big.LITTLE SoCs, threads landing on little cores
+ * hold back every parallel op, so intra-op threads default to the number of faster cores.
+ */
+class BackendManager(
+    private val env: OrtEnvironment,
+    private val modelCache: OrtModelCache,
+    private val preferences: Map<PipelineStage, Backend> = emptyMap()
+) {
+
+    companion object {
+        private const val TAG = "BackendManager"
+        private const val PLACEMENT_FILE = "backends.properties"
+        private const val BENCHMARK_RUNS = 2 // After one warm-up run
+        private const val MAX_THREADS = 4
+
+        /**
+         * Forced backends from the config; "auto" stages are benchmarked
+         */
+        fun preferencesFrom(config: TranscriptionConfig): Map<PipelineStage, Backend> {
+            val preferences = mutableMapOf<PipelineStage, Backend>()
+            Backend.parse(config.encoderBackend)?.let { preferences[PipelineStage.ENCODER] = it }
+            Backend.parse(config.decoderBackend)?.let { preferences[PipelineStage.DECODER] = it }
+            return preferences
+        }
+
+        /**
+         * Number of cores faster than the slowest cluster, from the cpufreq limits.
+         * Falls back to half the cores when the frequencies are unreadable or uniform.
+         */
+        fun detectBigCores(): Int {
+            val cores = Runtime.getRuntime().availableProcessors()
+            val maxFreqs = (0 until cores).mapNotNull { cpu ->
+                try {
+                    File("/sys/devices/system/cpu/cpu$cpu/cpufreq/cpuinfo_max_freq").readText().trim().toLong()
+                } catch (e: Exception) {
+                    null
+                }
+            }
+            val slowest = maxFreqs.minOrNull()
+            if (maxFreqs.size < 2 || slowest == maxFreqs.maxOrNull()) {
+                return (cores / 2).coerceIn(1, MAX_THREADS)
+            }
+            return maxFreqs.count { it > slowest!! }.coerceIn(1, MAX_THREADS)
+        }
+    }
+
+    /** Intra-op threads for CPU work */
+    val cpuThreads: Int = detectBigCores()
+
+    private val available: Set<Backend> = try {
+        val providers = OrtEnvironment.getAvailableProviders()
+        Backend.values().filter { backend ->
+            when (backend) {
+                Backend.NNAPI -> OrtProvider.NNAPI in providers
+                Backend.QNN -> OrtProvider.QNN in providers
+                Backend.XNNPACK -> OrtProvider.XNNPACK in providers
+                Backend.CPU -> true
+            }
+        }.toSet()
+    } catch (e: Exception) {
+        Log.w(TAG, "Could not query execution providers, using CPU only", e)
+        setOf(Backend.CPU)
+    }
+
+    private val placementFile = File(modelCache.cacheDir, PLACEMENT_FILE)
+    private val savedPlacements = Properties().apply {
+        if (placementFile.exists()) {
+            try {
+                placementFile.inputStream().use { load(it) }
+            } catch (e: Exception) {
+                Log.w(TAG, "Ignoring unreadable $PLACEMENT_FILE", e)
+            }
+        }
+    }
+
+    private val _placements = mutableMapOf<PipelineStage, Backend>()
+
+    /** Backend chosen for each stage created so far */
+    val placements: Map<PipelineStage, Backend>
+        get() = synchronized(_placements) { _placements.toMap() }
+
+    init {
+        Log.i(TAG, "Backends available: $available, CPU threads: $cpuThreads")
+    }
+
+    /**
+     * Apply the CPU thread count to options for a CPU-only session
+     */
+    fun tuneCpuThreads(options: OrtSession.SessionOptions) {
+        options.setIntraOpNumThreads(cpuThreads)
+    }
+
+    /**
+     * Create the session for [stage], on the configured, remembered or benchmarked backend.
+     *
+     * @param options Builds the stage's base options (no execution provider); called for
+     *                every session created
+     */
+    fun createSession(
+        stage: PipelineStage,
+        assetPath: String,
+        options: () -> OrtSession.SessionOptions
+    ): PlacedSession {
+        val forced = preferences[stage]
+        if (forced != null) {
+            if (forced in available) {
+                tryCreate(assetPath, options, forced)?.let { return place(stage, it) }
+            }
+            Log.w(TAG, "$forced requested for $stage but unavailable, choosing automatically")
+        }
+
+        val key = placementKey(stage, assetPath)
+        Backend.parse(savedPlacements.getProperty(key) ?: "")?.takeIf { it in available }?.let { saved ->
+            tryCreate(assetPath, options, saved)?.let { return place(stage, it) }
+            Log.w(TAG, "Remembered $saved for $stage failed, benchmarking again")
+        }
+
+        val placed = benchmark(stage, assetPath, options)
+        savePlacement(key, placed.backend)
+        return place(stage, placed)
+    }
+
+    /**
+     * CPU session for [assetPath], used when an accelerated stage fails at run time
+     */
+    fun createCpuSession(assetPath: String, options: () -> OrtSession.SessionOptions): OrtSession =
+        modelCache.createSession(assetPath, { options().withBackend(Backend.CPU) })
+
+    private fun benchmark(
+        stage: PipelineStage,
+        assetPath: String,
+        options: () -> OrtSession.SessionOptions
+    ): PlacedSession {
+        var best: PlacedSession? = null
+        var bestMs = Long.MAX_VALUE
+
+        for (backend in stage.candidates.filter { it in available }) {
+            val placed = tryCreate(assetPath, options, backend) ?: continue
+            val elapsed = timeDummyRun(placed.session)
+            if (elapsed == Long.MAX_VALUE) {
+                // A failed dummy run says nothing about speed; never keep (and persist) it
+                Log.i(TAG, "   $stage on $backend: failed")
+                placed.session.close()
+                continue
+            }
+            Log.i(TAG, "   $stage on $backend: ${elapsed}ms")
+
+            if (best == null || elapsed < bestMs) {
+                best?.session?.close()
+                best = placed
+                bestMs = elapsed
+            } else {
+                placed.session.close()
+            }
+        }
+
+        // Every dummy run failed: CPU always loads (real inputs differ)
+        return best ?: PlacedSession(createCpuSession(assetPath, options), Backend.CPU)
+    }
+
+    private fun tryCreate(
+        assetPath: String,
+        options: () -> OrtSession.SessionOptions,
+        backend: Backend
+    ): PlacedSession? {
+        return try {
+            val session = modelCache.createSession(
+                assetPath,
+                { options().withBackend(backend) },
+                compilesNodes = backend.compilesNodes
+            )
+            PlacedSession(session, backend)
+        } catch (e: Exception) {
+            Log.w(TAG, "Could not create $assetPath on $backend: ${e.message}")
+            null
+        }
+    }
+
+    private fun OrtSession.SessionOptions.withBackend(backend: Backend): OrtSession.SessionOptions {
+        when (backend) {
+            Backend.NNAPI -> {
+                addNnapi()
+                setIntraOpNumThreads(cpuThreads) // Nodes NNAPI cannot take stay on the CPU
+            }
+            Backend.QNN -> {
+                addQnn(mapOf("backend_path" to "libQnnHtp.so"))
+                setIntraOpNumThreads(cpuThreads)
+            }
+            Backend.XNNPACK -> {
+                // XNNPACK runs its own pool; ORT's pool would compete with it for the same cores
+                addXnnpack(mapOf("intra_op_num_threads" to cpuThreads.toString()))
+                setIntraOpNumThreads(1)
+            }
+            Backend.CPU -> setIntraOpNumThreads(cpuThreads)
+        }
+        return this
+    }
+
+    /**
+     * Best of [BENCHMARK_RUNS] timed runs on zero-filled inputs, or Long.MAX_VALUE if it fails
+     */
+    private fun timeDummyRun(session: OrtSession): Long {
+        val inputs = HashMap<String, OnnxTensor>()
+        try {
+            for ((name, node) in session.inputInfo) {
+                inputs[name] = dummyTensor(node.info as? TensorInfo ?: return Long.MAX_VALUE)
+                    ?: return Long.MAX_VALUE
+            }
+            session.run(inputs).close() // Warm-up: first run pays for allocation and compilation
+            var best = Long.MAX_VALUE
+            repeat(BENCHMARK_RUNS) {
+                val start = System.currentTimeMillis()
+                session.run(inputs).close()
+                best = minOf(best, System.currentTimeMillis() - start)
+            }
+            return best
+        } catch (e: OrtException) {
+            Log.w(TAG, "Benchmark run failed: ${e.message}")
+            return Long.MAX_VALUE
+        } finally {
+            inputs.values.forEach { it.close() }
+        }
+    }
+
+    /**
+     * Zero tensor matching an input, with dynamic dimensions set to 1
+     */
+    private fun dummyTensor(info: TensorInfo): OnnxTensor? {
+        val shape = info.shape.map { if (it < 0) 1L else it }.toLongArray()
+        val count = shape.fold(1L) { acc, dim -> acc * dim }.toInt()
+        return when (info.type) {
+            OnnxJavaType.FLOAT -> OnnxTensor.createTensor(env, directBuffer(count * 4).asFloatBuffer(), shape)
+            OnnxJavaType.INT64 -> OnnxTensor.createTensor(env, directBuffer(count * 8).asLongBuffer(), shape)
+            OnnxJavaType.INT32 -> OnnxTensor.createTensor(env, directBuffer(count * 4).asIntBuffer(), shape)
+            else -> null
+        }
+    }
+
+    private fun directBuffer(bytes: Int): ByteBuffer =
+        ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder())
+
+    private fun place(stage: PipelineStage, placed: PlacedSession): PlacedSession {
+        synchronized(_placements) { _placements[stage] = placed.backend }
+        Log.i(TAG, "⚡ $stage placed on ${placed.backend}")
+        return placed
+    }
+
+    // Keyed by asset path so every model tier is benchmarked on its own
+    private fun placementKey(stage: PipelineStage, assetPath: String) =
+        "${stage.name.lowercase()}.${assetPath.substringBeforeLast('.').replace('/', '_')}"
+
+    private fun savePlacement(key: String, backend: Backend) {
+        savedPlacements.setProperty(key, backend.name)
+        try {
+            placementFile.outputStream().use { savedPlacements.store(it, "Benchmarked backend per pipeline stage") }
+        } catch (e: Exception) {
+            Log.w(TAG, "Could not save backend placement", e)
+        }
+    }
+}
@@ -0,0 +1,89 @@
+package com.voiceinput.onnx
+
+import ai.onnxruntime.OrtEnvironment
+import ai.onnxruntime.OrtSession
+import android.content.Context
+import android.util.Log
+import com.voiceinput.config.ConfigRepository
+import java.io.File
+import java.io.FileInputStream
+import java.io.FileNotFoundException
+import java.nio.MappedByteBuffer
+import java.nio.channels.FileChannel
+
+/**
+ * Creates ORT sessions from bundled model assets without copying them into the Java heap.
+ *
+ * Models are packaged uncompressed (see `androidResources.noCompress` in build.gradle.kts),
+ * so each asset is memory-mapped straight out of the APK and handed to ORT as a direct
+ * buffer. If an asset is compressed anyway, it is streamed once to the models directory
+ * and ORT loads it by path on every later start.
+ */
+object ModelLoader {
+
+    private const val TAG = "ModelLoader"
+
+    /**
+     * Create a session for an asset model (e.g. "models/Whisper_encoder.onnx")
+     */
+    fun createSession(
+        env: OrtEnvironment,
+        context: Context,
+        assetPath: String,
+        options: OrtSession.SessionOptions
+    ): OrtSession {
+        val mapped = mapAsset(context, assetPath)
+        if (mapped != null) {
+            Log.d(TAG, "Memory-mapped $assetPath (${mapped.capacity() / (1024 * 1024)}MB)")
+            return env.createSession(mapped, options)
+        }
+
+        val file = extractAsset(context, assetPath)
+        Log.d(TAG, "Loading $assetPath from ${file.absolutePath}")
+        return env.createSession(file.absolutePath, options)
+    }
+
+    /**
+     * Map an uncompressed asset read-only, or return null if it is compressed in the APK
+     */
+    fun mapAsset(context: Context, assetPath: String): MappedByteBuffer? {
+        return try {
+            context.assets.openFd(assetPath).use { afd ->
+                FileInputStream(afd.fileDescriptor).use { stream ->
+                    stream.channel.map(FileChannel.MapMode.READ_ONLY, afd.startOffset, afd.declaredLength)
+                }
+            }
+        } catch (e: FileNotFoundException) {
+            // openFd() fails for compressed assets
+            Log.w(TAG, "$assetPath is compressed in the APK, falling back to extraction")
+            null
+        }
+    }
+
+    /**
+     * Stream an asset to the models directory once per app install/update and return the file
+     */
+    fun extractAsset(context: Context, assetPath: String): File {
+        @Suppress("DEPRECATION") // getPackageInfo(String, Int) is the only overload below API 33
+        val installStamp = context.packageManager.getPackageInfo(context.packageName, 0).lastUpdateTime
+        val dir = File(ConfigRepository(context).getModelsDir(), "extracted-$installStamp")
+        val target = File(dir, File(assetPath).name)
+        if (target.exists() && target.length() > 0) {
+            return target
+        }
+
+        dir.parentFile?.listFiles { f -> f.isDirectory && f.name.startsWith("extracted-") && f != dir }
+            ?.forEach { it.deleteRecursively() }
+        dir.mkdirs()
+
+        val partial = File(dir, "${target.name}.partial")
+        context.assets.open(assetPath).use { input ->
+            partial.outputStream().use { output -> input.copyTo(output) }
+        }
+        if (!partial.renameTo(target)) {
+            partial.delete()
+            throw IllegalStateException("Failed to extract $assetPath to ${target.absolutePath}")
+        }
+        return target
+    }
+}
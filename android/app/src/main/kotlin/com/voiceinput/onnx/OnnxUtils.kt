@@ -1,5 +1,6 @@
 package com.voiceinput.onnx
 
+import java.nio.FloatBuffer
 import kotlin.math.exp
 import kotlin.math.ln
 
@@ -93,4 +94,85 @@ object OnnxUtils {
 
         return max + ln(sum)
     }
+
+    /**
+     * Fused scoring of one decoder step, read straight from the logits tensor buffer.
+     *
+     * One pass finds the top-k tokens (index 0 is the argmax), a second computes the
+     * log-sum-exp for log-softmax, as in [logSumExpFast]. Tokens flagged in [suppressed]
+     * are skipped in both passes, so they can never be chosen and do not take
+     * probability mass from the rest.
+     *
+     * @param logits Logits for one position, read with absolute gets (position unchanged)
+     * @param suppressed Per-token mask, or null to score every token
+     * @param out Receives the top [TokenScores.capacity] tokens and their log-probabilities
+     */
+    fun scoreLogits(logits: FloatBuffer, suppressed: BooleanArray?, out: TokenScores) {
+        val size = logits.remaining()
+        val base = logits.position()
+        val k = out.capacity
+        val indices = out.indices
+        val values = out.logProbs
+        var count = 0
+
+        for (i in 0 until size) {
+            if (suppressed != null && i < suppressed.size && suppressed[i]) continue
+            val v = logits.get(base + i)
+            if (count == k && v <= values[k - 1]) continue
+
+            // Insert into the sorted top list
+            var pos = if (count < k) count++ else k - 1
+            while (pos > 0 && v > values[pos - 1]) {
+                values[pos] = values[pos - 1]
+                indices[pos] = indices[pos - 1]
+                pos--
+            }
+            values[pos] = v
+            indices[pos] = i
+        }
+        out.count = count
+        if (count == 0) {
+            out.logSumExp = Double.NEGATIVE_INFINITY
+            return
+        }
+
+        val max = values[0].toDouble()
+        val threshold = 20.0 // Skip correction if values are much lower
+        var sum = 0.0
+        for (i in 0 until size) {
+            if (suppressed != null && i < suppressed.size && suppressed[i]) continue
+            val diff = logits.get(base + i) - max
+            if (diff > -threshold) {
+                sum += exp(diff)
+            }
+        }
+        out.logSumExp = max + ln(sum)
+
+        for (j in 0 until count) {
+            values[j] = (values[j] - out.logSumExp).toFloat()
+        }
+    }
+}
+
+/**
+ * Reusable output of [OnnxUtils.scoreLogits]: the best tokens of one step, best first
+ *
+ * @param capacity Number of top tokens kept (k)
+ */
+class TokenScores(val capacity: Int) {
+    init {
+        require(capacity > 0) { "Capacity must be positive, got $capacity" }
+    }
+
+    val indices = IntArray(capacity)
+    val logProbs = FloatArray(capacity)
+
+    /** Valid entries (less than capacity only if most tokens are suppressed) */
+    var count = 0
+
+    /** Log-sum-exp of the unsuppressed logits; logit - logSumExp is the log-probability */
+    var logSumExp = 0.0
+
+    val best: Int
+        get() = indices[0]
 }
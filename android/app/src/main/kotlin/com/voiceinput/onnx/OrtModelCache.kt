@@ -0,0 +1,160 @@
+package com.voiceinput.onnx
+
+import ai.onnxruntime.OrtEnvironment
+import ai.onnxruntime.OrtException
+import ai.onnxruntime.OrtSession
+import ai.onnxruntime.extensions.OrtxPackage
+import android.content.Context
+import android.os.Build
+import android.util.Log
+import com.voiceinput.config.ConfigRepository
+import java.io.File
+import java.nio.ByteBuffer
+import java.security.MessageDigest
+
+/**
+ * On-device cache of optimized ORT-format models for fast warm start.
+ *
+ * The first launch runs graph optimization on each bundled .onnx model and saves the result
+ * as a .ort file under `getModelsDir()/ort-cache/<device>/`. Later launches load that file
+ * directly and skip parsing and optimization. The device directory is keyed by the build
+ * fingerprint and ORT version; each file name carries a hash of the source model, so an app
+ * update with new models or an OS/ORT upgrade never picks up a stale graph.
+ *
+ * Only BASIC optimizations are cached: they are hardware independent, so the same file is
+ * valid whether the session later runs on NNAPI or on the CPU.
+ */
+class OrtModelCache(
+    private val context: Context,
+    private val env: OrtEnvironment
+) {
+
+    companion object {
+        private const val TAG = "OrtModelCache"
+        private const val CACHE_DIR = "ort-cache"
+
+        // Bytes sampled from each end of a model for its content hash
+        private const val HASH_SAMPLE_BYTES = 64 * 1024
+    }
+
+    val cacheDir: File by lazy {
+        val root = File(ConfigRepository(context).getModelsDir(), CACHE_DIR)
+        val dir = File(root, shortHash("${Build.FINGERPRINT}|${env.version}".toByteArray()))
+        // Drop caches left behind by a previous OS build or ORT version
+        root.listFiles { f -> f.isDirectory && f != dir }?.forEach { it.deleteRecursively() }
+        dir.mkdirs()
+        dir
+    }
+
+    /** Number of sessions loaded from the cache / built from the original model */
+    var hits = 0
+        private set
+    var misses = 0
+        private set
+
+    /**
+     * Create a session for [assetPath], loading the cached optimized graph when available.
+     *
+     * @param options Builds the session options; called again for every attempt because
+     *                options used to write the cache must not be reused for loading it
+     * @param compilesNodes True if the options register an EP that compiles the graph (NNAPI);
+     *                      ORT cannot serialize such a session, so the cache is written by a
+     *                      separate CPU-only optimization pass instead
+     */
+    fun createSession(
+        assetPath: String,
+        options: () -> OrtSession.SessionOptions,
+        compilesNodes: Boolean = false
+    ): OrtSession {
+        val cached = cachedFile(assetPath)
+        if (cached != null && cached.exists()) {
+            try {
+                val session = env.createSession(cached.absolutePath, options())
+                hits++
+                Log.d(TAG, "Loaded ${cached.name} from cache")
+                return session
+            } catch (e: OrtException) {
+                Log.w(TAG, "Cached ${cached.name} is unusable, rebuilding", e)
+                cached.delete()
+            }
+        }
+
+        misses++
+        if (cached == null) {
+            return ModelLoader.createSession(env, context, assetPath, options())
+        }
+
+        val partial = File(cached.parentFile, "${cached.name}.partial")
+        try {
+            if (compilesNodes) {
+                ModelLoader.createSession(env, context, assetPath, optimizeOnlyOptions(partial)).close()
+            } else {
+                val session = ModelLoader.createSession(
+                    env, context, assetPath, options().apply { saveOptimizedModel(partial) }
+                )
+                commit(partial, cached)
+                return session
+            }
+            commit(partial, cached)
+            return env.createSession(cached.absolutePath, options())
+        } catch (e: OrtException) {
+            Log.w(TAG, "Could not cache optimized $assetPath, loading it directly", e)
+            partial.delete()
+            cached.delete()
+            return ModelLoader.createSession(env, context, assetPath, options())
+        }
+    }
+
+    /**
+     * Cache file for an asset, or null if the asset cannot be hashed cheaply (compressed)
+     */
+    private fun cachedFile(assetPath: String): File? {
+        val mapped = ModelLoader.mapAsset(context, assetPath) ?: return null
+        val name = File(assetPath).nameWithoutExtension
+        return File(cacheDir, "$name-${modelHash(mapped)}.ort")
+    }
+
+    private fun OrtSession.SessionOptions.saveOptimizedModel(target: File) {
+        setOptimizationLevel(OrtSession.SessionOptions.OptLevel.BASIC_OPT)
+        setOptimizedModelFilePath(target.absolutePath)
+        addConfigEntry("session.save_model_format", "ORT")
+    }
+
+    private fun optimizeOnlyOptions(target: File) = OrtSession.SessionOptions().apply {
+        registerCustomOpLibrary(OrtxPackage.getLibraryPath())
+        setCPUArenaAllocator(false)
+        setMemoryPatternOptimization(false)
+        saveOptimizedModel(target)
+    }
+
+    private fun commit(partial: File, target: File) {
+        if (!partial.exists() || !partial.renameTo(target)) {
+            partial.delete()
+            throw OrtException("Optimized model was not written to ${partial.absolutePath}")
+        }
+        Log.i(TAG, "💾 Cached optimized model ${target.name} (${target.length() / (1024 * 1024)}MB)")
+    }
+
+    /**
+     * Hash of size plus the head and tail of the model. Hashing every byte of the encoder on
+     * each launch would cost more than the cache saves; any re-exported model changes these.
+     */
+    private fun modelHash(model: ByteBuffer): String {
+        val digest = MessageDigest.getInstance("SHA-256")
+        val size = model.capacity()
+        digest.update(size.toString().toByteArray())
+        val sampleBytes = minOf(HASH_SAMPLE_BYTES, size)
+        val sample = ByteArray(sampleBytes)
+        model.duplicate().apply { position(0) }.get(sample)
+        digest.update(sample)
+        model.duplicate().apply { position(size - sampleBytes) }.get(sample)
+        digest.update(sample)
+        return digest.digest().toHex()
+    }
+
+    private fun shortHash(bytes: ByteArray): String =
+        MessageDigest.getInstance("SHA-256").digest(bytes).toHex()
+
+    private fun ByteArray.toHex(): String =
+        take(8).joinToString("") { "%02x".format(it) }
+}
@@ -3,6 +3,7 @@ package com.voiceinput.onnx
 import ai.onnxruntime.OnnxJavaType
 import ai.onnxruntime.OnnxTensor
 import ai.onnxruntime.OrtEnvironment
+import com.voiceinput.core.AudioUtils
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.nio.FloatBuffer
@@ -113,17 +114,5 @@ object TensorUtils {
      * Convert audio PCM bytes to Float array
      * Assumes 16-bit PCM (2 bytes per sample), little-endian
      */
-    fun convertPcmToFloatArray(audioData: ByteArray): FloatArray {
-        val audioSamples = audioData.size / 2
-        val floatArray = FloatArray(audioSamples)
-        val byteBuffer = ByteBuffer.wrap(audioData).order(ByteOrder.LITTLE_ENDIAN)
-
-        // Convert PCM samples to normalized floats [-1.0, 1.0]
-        for (i in 0 until audioSamples) {
-            val sample = byteBuffer.short.toFloat() / 32768.0f
-            floatArray[i] = sample
-        }
-
-        return floatArray
-    }
+    fun convertPcmToFloatArray(audioData: ByteArray): FloatArray = AudioUtils.bytesToFloat(audioData)
 }
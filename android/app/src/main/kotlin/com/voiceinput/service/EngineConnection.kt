@@ -0,0 +1,83 @@
+package com.voiceinput.service
+
+import android.content.ComponentName
+import android.content.Context
+import android.content.Intent
+import android.content.ServiceConnection
+import android.os.IBinder
+import android.util.Log
+import com.voiceinput.core.WhisperEngine
+import kotlinx.coroutines.CompletableDeferred
+
+/**
+ * A client's binding to [VoiceInputService] and its reference on the shared engine.
+ *
+ * Call [bind] early (onCreate), [acquire] when the engine is needed and [close] when the
+ * client goes away. The service, and with it the engine, stays alive while any client is
+ * bound.
+ */
+class EngineConnection(private val context: Context) : ServiceConnection {
+
+    companion object {
+        private const val TAG = "EngineConnection"
+    }
+
+    private val host = CompletableDeferred<VoiceInputService>()
+    @Volatile private var connected: VoiceInputService? = null
+    private var bound = false
+    private var engine: WhisperEngine? = null
+
+    fun bind() {
+        if (bound) return
+        bound = context.bindService(Intent(context, VoiceInputService::class.java), this, Context.BIND_AUTO_CREATE)
+        if (!bound) Log.e(TAG, "Could not bind VoiceInputService")
+    }
+
+    /**
+     * Wait for the service and take a reference on its engine, loading it if this is the
+     * first client
+     *
+     * @return The shared engine, or null if it failed to load
+     */
+    suspend fun acquire(): WhisperEngine? {
+        engine?.let { return it }
+        if (!bound) bind()
+        return host.await().sharedEngine.acquire().also { engine = it }
+    }
+
+    /**
+     * A text field gained focus: pre-warm the engine (loading it if needed)
+     */
+    fun onInputStarted() {
+        connected?.let { it.residencyPolicy.onInputStarted() }
+    }
+
+    /**
+     * Input ended: start the idle countdown to releasing the decoder
+     */
+    fun onInputFinished() {
+        connected?.let { it.residencyPolicy.onInputFinished() }
+    }
+
+    /**
+     * Drop the engine reference and unbind
+     */
+    suspend fun close() {
+        if (engine != null) host.await().sharedEngine.release()
+        engine = null
+        if (bound) context.unbindService(this)
+        bound = false
+    }
+
+    override fun onServiceConnected(name: ComponentName?, service: IBinder?) {
+        val binder = service as? VoiceInputService.VoiceInputBinder ?: return
+        connected = binder.getService()
+        host.complete(binder.getService())
+        Log.i(TAG, "Connected to shared engine host")
+    }
+
+    override fun onServiceDisconnected(name: ComponentName?) {
+        // Same process: only happens if the service crashed; the next bind recreates it
+        Log.w(TAG, "Shared engine host disconnected")
+    }
+}
@@ -11,7 +11,10 @@ import androidx.core.app.NotificationCompat
 import com.voiceinput.R
 import com.voiceinput.config.ConfigRepository
 import com.voiceinput.core.*
+import com.voiceinput.onnx.BackendManager
 import kotlinx.coroutines.*
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 
 /**
  * Background service for voice input transcription
@@ -23,6 +26,8 @@ import kotlinx.coroutines.*
  * - Memory-efficient operation
  * - Proper cleanup and error handling
  * - Integration with IME and app UI
+ * - Host of the one WhisperEngine shared by the IME, this service and the activities
+ *   ([sharedEngine], reached through [VoiceInputBinder]; see [EngineConnection])
  */
 class VoiceInputService : Service() {
 
@@ -46,14 +51,20 @@ class VoiceInputService : Service() {
     private val binder = VoiceInputBinder()
     private var serviceScope: CoroutineScope? = null
 
-    // Core components
+    /** The engine every bound client borrows; loaded on first use from the saved config */
+    val sharedEngine = SharedEngine(load = { loadEngine() }, unload = { it.release() })
+
+    /** Pre-warm on input start, decoder release when idle, full unload on critical memory */
+    lateinit var residencyPolicy: EngineResidencyPolicy<WhisperEngine>
+        private set
+
+    // Core components; the pipeline (and its engine reference) only exists while transcribing
     private var voicePipeline: VoiceInputPipeline? = null
-    private var audioRecorder: AudioRecorder? = null
-    private var whisperEngine: WhisperEngine? = null
     private var memoryManager: MemoryManager? = null
 
-    // State
-    private var isTranscribing = false
+    // State; start/stop are serialized so each session takes and drops exactly one reference
+    private val sessionLock = Mutex()
+    @Volatile private var isTranscribing = false
     private var isInitialized = false
 
     // Configuration
@@ -69,6 +80,7 @@ class VoiceInputService : Service() {
         Log.i(TAG, "VoiceInputService created")
 
         serviceScope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+        residencyPolicy = EngineResidencyPolicy(sharedEngine, serviceScope!!)
         configRepository = ConfigRepository(this)
         currentConfig = configRepository.load()
 
@@ -90,44 +102,33 @@ class VoiceInputService : Service() {
 
     /**
      * Initialize core components with memory management
+     *
+     * The engine is not touched here: binding clients (the IME on every onCreate) must not
+     * load the model, and a reference held for the service's lifetime would keep
+     * [SharedEngine.unloadIfIdle] and the critical-memory unload from ever running. The
+     * service's own pipeline borrows the engine in [startTranscription] instead.
      */
     private fun initializeComponents() {
-        serviceScope?.launch {
-            try {
-                Log.i(TAG, "Initializing service components...")
-
-                // Initialize audio recorder
-                audioRecorder = AudioRecorder()
-
-                // Initialize Whisper engine (ONNX Runtime)
-                whisperEngine = WhisperEngine(this@VoiceInputService)
-                val initSuccess = whisperEngine!!.initialize()
-
-                if (initSuccess) {
-                    // Initialize voice pipeline
-                    voicePipeline = VoiceInputPipeline(
-                        context = this@VoiceInputService,
-                        audioRecorder = audioRecorder!!,
-                        whisperEngine = whisperEngine!!,
-                        config = currentConfig!!,
-                        onResult = { result ->
-                            handleTranscriptionResult(result)
-                        }
-                    )
-
-                    isInitialized = true
-                    Log.i(TAG, "Service components initialized successfully")
-                    notifyStatusChange(ServiceStatus.READY)
-                } else {
-                    Log.e(TAG, "Failed to initialize Whisper engine")
-                    notifyStatusChange(ServiceStatus.ERROR)
-                }
+        isInitialized = true
+        Log.i(TAG, "Service components initialized successfully")
+        notifyStatusChange(ServiceStatus.READY)
+    }
 
-            } catch (e: Exception) {
-                Log.e(TAG, "Error initializing service components", e)
-                notifyStatusChange(ServiceStatus.ERROR)
-            }
-        }
+    /**
+     * Build and load the shared engine from the saved configuration
+     */
+    private suspend fun loadEngine(): WhisperEngine? {
+        val transcription = configRepository.load().transcription
+        val engine = WhisperEngine(
+            context = this,
+            language = transcription.language,
+            decodingOptions = DecodingOptions.from(transcription),
+            backendPreferences = BackendManager.preferencesFrom(transcription),
+            manifest = ModelManifest.resolve(this, transcription.modelName)
+        )
+        if (engine.initialize()) return engine
+        engine.release()
+        return null
     }
 
     /**
@@ -138,7 +139,8 @@ class VoiceInputService : Service() {
             setMemoryWarningCallback {
                 Log.w(TAG, "Service memory warning - optimizing")
                 if (!isTranscribing) {
-                    // Suggest cleanup when idle
+                    // Drop the decoder side while idle; it reloads on the next window
+                    residencyPolicy.onMemoryWarning()
                     requestGarbageCollection("Service memory warning")
                 }
             }
@@ -149,12 +151,15 @@ class VoiceInputService : Service() {
                     // Could implement emergency pause
                     Log.w(TAG, "Critical memory during transcription - monitoring")
                 }
+                // Refused while a window is being transcribed
+                residencyPolicy.onMemoryCritical()
                 requestGarbageCollection("Service critical memory")
             }
 
             setLowMemoryCallback {
                 Log.e(TAG, "Service low memory - emergency response")
                 // Emergency cleanup
+                residencyPolicy.onMemoryCritical()
                 requestGarbageCollection("Service low memory emergency")
             }
         }
@@ -175,22 +180,49 @@ class VoiceInputService : Service() {
         }
 
         serviceScope?.launch {
-            try {
-                // Start foreground service
-                startForeground(NOTIFICATION_ID, createNotification("Starting transcription..."))
-
-                // Start voice pipeline
-                voicePipeline?.startListening()
-                isTranscribing = true
-
-                Log.i(TAG, "Transcription started")
-                notifyStatusChange(ServiceStatus.TRANSCRIBING)
-                updateNotification("Listening for speech...")
-
-            } catch (e: Exception) {
-                Log.e(TAG, "Error starting transcription", e)
-                notifyStatusChange(ServiceStatus.ERROR)
-                stopForeground(STOP_FOREGROUND_REMOVE)
+            sessionLock.withLock {
+                if (isTranscribing) return@withLock
+                try {
+                    // Start foreground service
+                    startForeground(NOTIFICATION_ID, createNotification("Starting transcription..."))
+
+                    // Borrow the shared Whisper engine (ONNX Runtime) for this session, loading it if needed;
+                    // the reference is dropped again if the pipeline cannot be built
+                    val pipeline = sharedEngine.acquireFor { engine ->
+                        VoiceInputPipeline(
+                            context = this@VoiceInputService,
+                            audioRecorder = AudioRecorder(),
+                            whisperEngine = engine,
+                            config = currentConfig!!,
+                            onResult = { result ->
+                                handleTranscriptionResult(result)
+                            },
+                            ownsEngine = false
+                        )
+                    }
+                    if (pipeline == null) {
+                        Log.e(TAG, "Failed to initialize Whisper engine")
+                        notifyStatusChange(ServiceStatus.ERROR)
+                        stopForeground(STOP_FOREGROUND_REMOVE)
+                        return@withLock
+                    }
+                    voicePipeline = pipeline
+
+                    // Start voice pipeline (from here on endSession() releases the reference)
+                    pipeline.startListening()
+                    isTranscribing = true
+
+                    Log.i(TAG, "Transcription started")
+                    notifyStatusChange(ServiceStatus.TRANSCRIBING)
+                    updateNotification("Listening for speech...")
+
+                } catch (e: Exception) {
+                    Log.e(TAG, "Error starting transcription", e)
+                    // No pipeline means acquireFor() already dropped the reference; still let the idle timer unload
+                    if (voicePipeline == null) residencyPolicy.onInputFinished() else endSession()
+                    notifyStatusChange(ServiceStatus.ERROR)
+                    stopForeground(STOP_FOREGROUND_REMOVE)
+                }
             }
         }
     }
@@ -202,21 +234,40 @@ class VoiceInputService : Service() {
         if (!isTranscribing) return
 
         serviceScope?.launch {
-            try {
-                val finalText = voicePipeline?.stopListening() ?: ""
-                isTranscribing = false
+            sessionLock.withLock {
+                if (!isTranscribing) return@withLock
+                try {
+                    val finalText = voicePipeline?.stopListening() ?: ""
 
-                Log.i(TAG, "Transcription stopped. Final text length: ${finalText.length}")
-                notifyStatusChange(ServiceStatus.READY)
-
-                stopForeground(STOP_FOREGROUND_REMOVE)
+                    Log.i(TAG, "Transcription stopped. Final text length: ${finalText.length}")
+                    notifyStatusChange(ServiceStatus.READY)
 
-            } catch (e: Exception) {
-                Log.e(TAG, "Error stopping transcription", e)
+                } catch (e: Exception) {
+                    Log.e(TAG, "Error stopping transcription", e)
+                } finally {
+                    endSession()
+                    stopForeground(STOP_FOREGROUND_REMOVE)
+                }
             }
         }
     }
 
+    /**
+     * Release the session's pipeline and its engine reference; the engine stays warm until
+     * the residency policy's idle timeout
+     */
+    private suspend fun endSession() {
+        isTranscribing = false
+        val pipeline = voicePipeline ?: return
+        voicePipeline = null
+        try {
+            pipeline.release() // Does not release the shared engine (ownsEngine = false)
+        } finally {
+            sharedEngine.release()
+            residencyPolicy.onInputFinished()
+        }
+    }
+
     /**
      * Toggle transcription state
      */
@@ -351,12 +402,13 @@ class VoiceInputService : Service() {
         runBlocking {
             try {
                 // Stop transcription if running
-                if (isTranscribing) {
-                    voicePipeline?.stopListening()
+                sessionLock.withLock {
+                    if (isTranscribing) voicePipeline?.stopListening()
+                    endSession()
                 }
 
-                // Release all resources
-                voicePipeline?.release()
+                // Release all resources; clients are gone, so the shared engine goes too
+                sharedEngine.close()
                 memoryManager?.release()
 
             } catch (e: Exception) {
@@ -1,5 +1,8 @@
 package com.voiceinput.config
 
+import com.voiceinput.onnx.Backend
+import com.voiceinput.onnx.BackendManager
+import com.voiceinput.onnx.PipelineStage
 import org.junit.Assert.*
 import org.junit.Test
 
@@ -62,6 +65,18 @@ class AppConfigTest {
         }
     }
 
+    @Test
+    fun `AudioConfig should validate latency bounds`() {
+        AudioConfig(latencyBudgetMs = 500L, maxQueuedAudioSec = 5.0f)
+
+        assertThrows(IllegalArgumentException::class.java) {
+            AudioConfig(latencyBudgetMs = 0L)
+        }
+        assertThrows(IllegalArgumentException::class.java) {
+            AudioConfig(maxQueuedAudioSec = 0f)
+        }
+    }
+
     @Test
     fun `TranscriptionConfig should have valid defaults`() {
         val config = TranscriptionConfig()
@@ -143,4 +158,21 @@ class AppConfigTest {
         assertTrue(validModels.contains("medium"))
         assertTrue(validModels.contains("large"))
     }
-}
\ No newline at end of file
+
+    @Test
+    fun `TranscriptionConfig backends map to forced placements`() {
+        assertTrue(BackendManager.preferencesFrom(TranscriptionConfig()).isEmpty())
+
+        val forced = BackendManager.preferencesFrom(
+            TranscriptionConfig(encoderBackend = "QNN", decoderBackend = "cpu")
+        )
+        assertEquals(Backend.QNN, forced[PipelineStage.ENCODER])
+        assertEquals(Backend.CPU, forced[PipelineStage.DECODER])
+        assertNull(Backend.parse("auto"))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `TranscriptionConfig should reject unknown backend`() {
+        TranscriptionConfig(encoderBackend = "gpu")
+    }
+}
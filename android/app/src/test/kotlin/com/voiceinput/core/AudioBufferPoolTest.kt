@@ -0,0 +1,78 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+
+/**
+ * Unit tests for pooled recorder buffers and the on-disk session capture
+ */
+class AudioBufferPoolTest {
+
+    @get:Rule
+    val tempFolder = TemporaryFolder()
+
+    @Test
+    fun `recycled buffers are reused`() {
+        val pool = AudioBufferPool(bufferSize = 960)
+        repeat(100) {
+            val buffer = pool.acquire()
+            assertEquals(960, buffer.data.size)
+            buffer.length = 960
+            buffer.recycle()
+        }
+        assertEquals(1, pool.allocated)
+        assertEquals(0, pool.acquire().length)
+    }
+
+    @Test
+    fun `double recycle does not hand out a buffer twice`() {
+        val pool = AudioBufferPool(bufferSize = 16)
+        val buffer = pool.acquire()
+        buffer.recycle()
+        buffer.recycle()
+
+        val first = pool.acquire()
+        val second = pool.acquire()
+        assertNotSame(first, second)
+        assertEquals(2, pool.allocated)
+    }
+
+    @Test
+    fun `pool keeps at most maxPooled buffers`() {
+        val pool = AudioBufferPool(bufferSize = 16, maxPooled = 2)
+        val buffers = List(4) { pool.acquire() }
+        buffers.forEach { it.recycle() }
+        repeat(4) { pool.acquire() }
+        assertEquals(6, pool.allocated)
+    }
+
+    @Test
+    fun `copy holds only the valid bytes`() {
+        val buffer = AudioBufferPool(bufferSize = 8).acquire()
+        buffer.data.fill(7)
+        buffer.length = 3
+        assertArrayEquals(byteArrayOf(7, 7, 7), buffer.toByteArray())
+    }
+
+    @Test
+    fun `capture spills chunks to disk and maps them back`() {
+        val capture = SessionCapture(tempFolder.root.resolve("session.pcm"))
+        capture.reset()
+        capture.append(byteArrayOf(1, 2, 3, 4), 0, 4)
+        capture.append(byteArrayOf(5, 6, 9, 9), 0, 2)
+        capture.close()
+
+        assertEquals(6L, capture.size)
+        val mapped = capture.map()
+        assertEquals(6, mapped.remaining())
+        assertArrayEquals(byteArrayOf(1, 2, 3, 4, 5, 6), ByteArray(6).also { mapped.get(it) })
+
+        capture.reset()
+        assertEquals(0, capture.map().remaining())
+
+        capture.delete()
+        assertFalse(capture.file.exists())
+    }
+}
@@ -124,4 +124,55 @@ class AudioUtilsTest {
         val rms = AudioUtils.calculateRMS(ByteArray(0))
         assertEquals(0.0f, rms, 0.001f)
     }
-}
\ No newline at end of file
+
+    @Test
+    fun `pcmToFloat should convert at offsets and report levels in one pass`() {
+        val buffer = ByteBuffer.allocate(8).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.putShort(0)       // Skipped via srcOffset
+        buffer.putShort(16384)   // 0.5
+        buffer.putShort(-16384)  // -0.5
+        buffer.putShort(-32768)  // -1.0
+
+        val dest = FloatArray(4)
+        val levels = AudioUtils.pcmToFloat(buffer.array(), 2, 3, dest, destOffset = 1)
+
+        assertEquals(0.0f, dest[0], 0.0f) // Untouched
+        assertEquals(0.5f, dest[1], 0.001f)
+        assertEquals(-0.5f, dest[2], 0.001f)
+        assertEquals(-1.0f, dest[3], 0.001f)
+        assertEquals(1.0f, levels.peak, 0.001f)
+        assertEquals(Math.sqrt(1.5 / 3).toFloat(), levels.rms, 0.001f)
+    }
+
+    @Test
+    fun `calculateLevels should match pcmToFloat levels`() {
+        val buffer = ByteBuffer.allocate(200).order(ByteOrder.LITTLE_ENDIAN)
+        for (i in 0 until 100) {
+            buffer.putShort(((i * 331) % 20000 - 10000).toShort())
+        }
+        val audio = buffer.array()
+
+        val expected = AudioUtils.pcmToFloat(audio, 0, 100, FloatArray(100))
+        val levels = AudioUtils.calculateLevels(audio)
+        assertEquals(expected.rms, levels.rms, 0.0001f)
+        assertEquals(expected.peak, levels.peak, 0.0001f)
+        assertEquals(levels.rms, AudioUtils.calculateRMS(audio), 0.0001f)
+    }
+
+    @Test
+    fun `PcmFloatBuffer should expose exactly the loaded samples and grow when needed`() {
+        val pcm = ByteBuffer.allocate(6).order(ByteOrder.LITTLE_ENDIAN)
+            .putShort(16384).putShort(0).putShort(-16384).array()
+
+        val input = PcmFloatBuffer(initialSamples = 2)
+        val samples = input.load(pcm)
+
+        assertTrue(samples.isDirect)
+        assertEquals(3, samples.remaining())
+        assertEquals(0.5f, samples.get(0), 0.001f)
+        assertEquals(-0.5f, samples.get(2), 0.001f)
+        assertEquals(0.5f, input.levels.peak, 0.001f)
+
+        assertEquals(1, input.load(pcm.copyOf(2)).remaining())
+    }
+}
@@ -0,0 +1,64 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for benchmark statistics and the JSON report
+ */
+class BenchmarkReportTest {
+
+    @Test
+    fun `stats summarize samples`() {
+        val stat = BenchmarkStat.of("ms", (100 downTo 1).map { it.toDouble() })
+
+        assertEquals(100, stat.count)
+        assertEquals(1.0, stat.min, 0.0)
+        assertEquals(100.0, stat.max, 0.0)
+        assertEquals(50.5, stat.mean, 1e-9)
+        assertEquals(50.0, stat.p50, 0.0)
+        assertEquals(95.0, stat.p95, 0.0)
+        assertEquals(99.0, stat.p99, 0.0)
+    }
+
+    @Test
+    fun `samples are grouped per metric in insertion order`() {
+        val samples = BenchmarkSamples()
+        samples.add("encode.5s", "ms", 120.0)
+        samples.add("vad.per_frame", "us", 80.0)
+        samples.add("encode.5s", "ms", 100.0)
+
+        val stats = samples.stats()
+        assertEquals(listOf("encode.5s", "vad.per_frame"), stats.keys.toList())
+        assertEquals(2, stats.getValue("encode.5s").count)
+        assertEquals("us", stats.getValue("vad.per_frame").unit)
+    }
+
+    @Test
+    fun `report survives a JSON round trip`() {
+        val report = BenchmarkReport(
+            platform = "android",
+            build = "1.0",
+            device = "test",
+            model = "small",
+            startedAt = "2026-01-01T00:00:00Z",
+            warmup = 1,
+            repeats = 3,
+            corpusSec = listOf(5, 15),
+            thermalState = "none",
+            peakRssKb = 512_000L,
+            metrics = mapOf("encode.5s" to BenchmarkStat.of("ms", listOf(1.0, 2.0, 3.0)))
+        )
+
+        val json = report.toJson()
+        assertTrue(json.contains("\"corpusSec\""))
+        assertEquals(report, BenchmarkReport.fromJson(json))
+    }
+
+    @Test
+    fun `peak RSS is read from VmHWM`() {
+        val status = "Name:\tvoiceinput\nVmPeak:\t 8000000 kB\nVmHWM:\t  412345 kB\nVmRSS:\t  400000 kB\n"
+        assertEquals(412345L, BenchmarkReport.parsePeakRssKb(status))
+        assertNull(BenchmarkReport.parsePeakRssKb("Name:\tvoiceinput\n"))
+    }
+}
@@ -0,0 +1,119 @@
+package com.voiceinput.core
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import org.junit.After
+import org.junit.Assert.*
+import org.junit.Test
+
+class EngineResidencyPolicyTest {
+
+    private class FakeModel : ResidentModel {
+        override var residency = EngineResidency.RESIDENT
+        var busy = false
+        var warmUps = 0
+        val reasons = mutableListOf<String>()
+
+        override suspend fun warmUp(): Boolean {
+            warmUps++
+            residency = EngineResidency.RESIDENT
+            return true
+        }
+
+        override suspend fun releaseDecoder(reason: String): Boolean {
+            if (busy || residency != EngineResidency.RESIDENT) return false
+            residency = EngineResidency.ENCODER_ONLY
+            reasons.add(reason)
+            return true
+        }
+
+        override suspend fun unload(reason: String): Boolean {
+            if (busy || residency == EngineResidency.UNLOADED) return false
+            residency = EngineResidency.UNLOADED
+            reasons.add(reason)
+            return true
+        }
+    }
+
+    private val model = FakeModel()
+    private val host = SharedEngine(load = { model }, unload = {})
+    private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+    private val policy = EngineResidencyPolicy(host, scope, idleTimeoutMs = IDLE_MS)
+
+    @After
+    fun tearDown() {
+        scope.cancel()
+    }
+
+    @Test
+    fun `input start loads and pre-warms`() = runBlocking {
+        policy.onInputStarted()
+        delay(IDLE_MS / 2)
+
+        assertTrue(host.isLoaded)
+        assertEquals(1, model.warmUps)
+        assertEquals(EngineResidency.RESIDENT, model.residency)
+    }
+
+    @Test
+    fun `decoder is released after the idle timeout`() = runBlocking {
+        host.acquire()
+        policy.onInputFinished()
+        delay(IDLE_MS * 3)
+
+        assertEquals(EngineResidency.ENCODER_ONLY, model.residency)
+        assertTrue(host.isLoaded)
+    }
+
+    @Test
+    fun `new input cancels the idle release`() = runBlocking {
+        host.acquire()
+        policy.onInputFinished()
+        policy.onInputStarted()
+        delay(IDLE_MS / 2)
+
+        assertEquals(EngineResidency.RESIDENT, model.residency)
+    }
+
+    @Test
+    fun `busy engine is released on a later idle period`() = runBlocking {
+        host.acquire()
+        model.busy = true
+        policy.onInputFinished()
+        delay(IDLE_MS * 3 / 2)
+        assertEquals(EngineResidency.RESIDENT, model.residency)
+
+        model.busy = false
+        delay(IDLE_MS * 2)
+        assertEquals(EngineResidency.ENCODER_ONLY, model.residency)
+    }
+
+    @Test
+    fun `critical memory unloads and drops an unreferenced engine`() = runBlocking {
+        host.warmUp()
+        policy.onMemoryCritical()
+        delay(IDLE_MS / 2)
+
+        assertEquals(EngineResidency.UNLOADED, model.residency)
+        assertEquals(listOf("critical memory"), model.reasons)
+        assertFalse(host.isLoaded)
+    }
+
+    @Test
+    fun `residency log keeps the latest transitions`() {
+        val log = ResidencyLog(capacity = 2)
+        log.record(ResidencyTransition(EngineResidency.UNLOADED, EngineResidency.RESIDENT, "loaded"))
+        log.record(ResidencyTransition(EngineResidency.RESIDENT, EngineResidency.ENCODER_ONLY, "idle"))
+        log.record(ResidencyTransition(EngineResidency.ENCODER_ONLY, EngineResidency.UNLOADED, "critical memory"))
+
+        assertEquals(listOf("idle", "critical memory"), log.snapshot().map { it.reason })
+    }
+
+    companion object {
+        private const val IDLE_MS = 100L
+    }
+}
@@ -0,0 +1,80 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for offline segmentation of complete recordings
+ */
+class FileTranscriberTest {
+
+    private val frameBytes = 10
+
+    // 'S' = speech frame, '.' = silent frame
+    private fun frames(pattern: String) = BooleanArray(pattern.length) { pattern[it] == '.' }
+
+    private fun segment(pattern: String, minSilence: Int = 4, maxWindow: Int = 30) =
+        FileTranscriber.segment(
+            totalBytes = pattern.length * frameBytes,
+            silent = frames(pattern),
+            frameBytes = frameBytes,
+            minSilenceFrames = minSilence,
+            maxWindowFrames = maxWindow,
+            minWindowBytes = 1
+        ).map { it.first / frameBytes to (it.last + 1) / frameBytes }
+
+    @Test
+    fun `silence only yields no windows`() {
+        assertTrue(segment("....................").isEmpty())
+    }
+
+    @Test
+    fun `speech is padded and short pauses stay inside a region`() {
+        // Pause of 2 frames is shorter than minSilence; 2 frames of padding either side
+        assertEquals(listOf(3 to 15), segment(".....SSS..SSS........"))
+    }
+
+    @Test
+    fun `regions are packed up to the window limit`() {
+        val pattern = "SSSS......SSSS......SSSS......"
+        assertEquals(listOf(0 to 26), segment(pattern, maxWindow = 30))
+        assertEquals(listOf(0 to 16, 18 to 26), segment(pattern, maxWindow = 16))
+    }
+
+    @Test
+    fun `long regions split at a pause in the final third`() {
+        val pattern = "SSSSSSSSSSSSSSSSSSSS.SSSSSSSSS" // One short pause at frame 20
+        assertEquals(listOf(0 to 21, 21 to 30), segment(pattern, maxWindow = 24))
+    }
+
+    @Test
+    fun `long regions without pauses split hard at the limit`() {
+        assertEquals(listOf(0 to 10, 10 to 20, 20 to 25), segment("S".repeat(25), maxWindow = 10))
+    }
+
+    @Test
+    fun `windows are clipped to the recording and short ones dropped`() {
+        fun windows(minBytes: Int) = FileTranscriber.segment(
+            totalBytes = 95, // Last frame is only 5 bytes
+            silent = frames("SS.......S"),
+            frameBytes = frameBytes,
+            minSilenceFrames = 4,
+            maxWindowFrames = 5,
+            minWindowBytes = minBytes
+        )
+        assertEquals(listOf(0 until 40, 70 until 95), windows(minBytes = 20))
+        assertEquals(listOf(0 until 40), windows(minBytes = 30))
+    }
+
+    @Test
+    fun `energy gate flags quiet frames`() {
+        val pcm = ByteArray(40)
+        // Loud second frame: full-scale samples
+        for (i in 10 until 20 step 2) {
+            pcm[i] = 0xFF.toByte()
+            pcm[i + 1] = 0x7F
+        }
+        val silent = FileTranscriber.energySilence(pcm, frameBytes)
+        assertArrayEquals(booleanArrayOf(true, false, true, true), silent)
+    }
+}
@@ -0,0 +1,79 @@
+package com.voiceinput.core
+
+import com.voiceinput.core.LatencyScheduler.Level
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for the latency budget degradation ladder
+ */
+class LatencySchedulerTest {
+
+    private fun scheduler() = LatencyScheduler(budgetMs = 1000, stepIntervalMs = 100, tierRetryMs = 500)
+
+    @Test
+    fun `lag within budget keeps full quality`() {
+        val scheduler = scheduler()
+        for (now in 0L..2000L step 50) {
+            assertFalse(scheduler.update(lagMs = 900, nowMs = now))
+        }
+        assertEquals(Level.NORMAL, scheduler.level)
+    }
+
+    @Test
+    fun `sustained lag escalates one step per interval`() {
+        val scheduler = scheduler()
+        assertFalse(scheduler.update(1500, 1000))
+        assertEquals(Level.DROP_SILENCE, scheduler.level) // First step is immediate
+
+        assertFalse(scheduler.update(1500, 1050))
+        assertEquals(Level.DROP_SILENCE, scheduler.level) // Too soon for the next step
+
+        assertFalse(scheduler.update(1500, 1100))
+        assertEquals(Level.SHRINK_OVERLAP, scheduler.level)
+
+        assertTrue(scheduler.update(1500, 1200))
+        assertEquals(Level.SWITCH_TIER, scheduler.level)
+    }
+
+    @Test
+    fun `tier switch is re-requested only after the retry interval`() {
+        val scheduler = scheduler()
+        scheduler.update(1500, 1000)
+        scheduler.update(1500, 1100)
+        assertTrue(scheduler.update(1500, 1200))
+
+        assertFalse(scheduler.update(1500, 1300))
+        assertFalse(scheduler.update(1500, 1650))
+        assertTrue(scheduler.update(1500, 1700))
+    }
+
+    @Test
+    fun `recovers once lag falls under half the budget`() {
+        val scheduler = scheduler()
+        scheduler.update(1500, 1000)
+        scheduler.update(1500, 1100)
+        assertEquals(Level.SHRINK_OVERLAP, scheduler.level)
+
+        // Between half the budget and the budget: hold
+        scheduler.update(700, 1300)
+        assertEquals(Level.SHRINK_OVERLAP, scheduler.level)
+
+        scheduler.update(200, 1400)
+        assertEquals(Level.DROP_SILENCE, scheduler.level)
+        scheduler.update(200, 1450)
+        assertEquals(Level.DROP_SILENCE, scheduler.level)
+        scheduler.update(200, 1500)
+        assertEquals(Level.NORMAL, scheduler.level)
+    }
+
+    @Test
+    fun `reset returns to full quality`() {
+        val scheduler = scheduler()
+        scheduler.update(1500, 1000)
+        scheduler.reset()
+        assertEquals(Level.NORMAL, scheduler.level)
+        scheduler.update(1500, 1010)
+        assertEquals(Level.DROP_SILENCE, scheduler.level)
+    }
+}
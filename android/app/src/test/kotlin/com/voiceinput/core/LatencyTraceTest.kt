@@ -0,0 +1,72 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for stage latency percentiles
+ */
+class LatencyTraceTest {
+
+    private fun ms(value: Long) = value * 1_000_000L
+
+    @Test
+    fun `percentiles use nearest rank`() {
+        val trace = LatencyTrace()
+        for (i in 100L downTo 1L) trace.record(TraceStage.DECODE, ms(i))
+
+        val decode = trace.summary().getValue(TraceStage.DECODE)
+        assertEquals(100, decode.count)
+        assertEquals(50f, decode.p50Ms, 0.001f)
+        assertEquals(95f, decode.p95Ms, 0.001f)
+        assertEquals(99f, decode.p99Ms, 0.001f)
+    }
+
+    @Test
+    fun `only stages with spans are summarized`() {
+        val trace = LatencyTrace()
+        assertTrue(trace.summary().isEmpty())
+
+        trace.record(TraceStage.VAD, ms(2))
+        assertEquals(setOf(TraceStage.VAD), trace.summary().keys)
+
+        trace.reset()
+        assertTrue(trace.summary().isEmpty())
+    }
+
+    @Test
+    fun `old spans fall out of the window`() {
+        val trace = LatencyTrace(capacity = 4)
+        for (i in 1L..4L) trace.record(TraceStage.ENCODE, ms(1000))
+        for (i in 1L..4L) trace.record(TraceStage.ENCODE, ms(10))
+
+        val encode = trace.summary().getValue(TraceStage.ENCODE)
+        assertEquals(4, encode.count)
+        assertEquals(10f, encode.p99Ms, 0.001f)
+    }
+
+    @Test
+    fun `spans reach the sink and the summary`() {
+        val events = mutableListOf<String>()
+        val sink = object : TraceSink {
+            override fun begin(stage: TraceStage, cookie: Int) {
+                events.add("begin ${stage.label} $cookie")
+            }
+
+            override fun end(stage: TraceStage, cookie: Int) {
+                events.add("end ${stage.label} $cookie")
+            }
+        }
+        val trace = LatencyTrace(sink = sink)
+
+        assertEquals(42, trace.span(TraceStage.STITCH, cookie = 7) { 42 })
+        assertEquals(listOf("begin stitch 7", "end stitch 7"), events)
+        assertEquals(1, trace.summary().getValue(TraceStage.STITCH).count)
+    }
+
+    @Test
+    fun `percentile of no samples is zero`() {
+        assertEquals(0L, LatencyTrace.percentile(LongArray(0), 50.0))
+        assertEquals(5L, LatencyTrace.percentile(longArrayOf(5), 99.0))
+    }
+}
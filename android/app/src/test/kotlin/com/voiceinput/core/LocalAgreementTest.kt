@@ -0,0 +1,75 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Before
+import org.junit.Test
+
+/**
+ * Unit tests for LocalAgreement partial-result stabilization
+ */
+class LocalAgreementTest {
+
+    private lateinit var agreement: LocalAgreement
+
+    @Before
+    fun setUp() {
+        agreement = LocalAgreement()
+    }
+
+    @Test
+    fun `first hypothesis is entirely tentative`() {
+        val partial = agreement.update("hello world")
+        assertEquals("", partial.committed)
+        assertEquals("hello world", partial.tentative)
+    }
+
+    @Test
+    fun `words agreed by two hypotheses are committed`() {
+        agreement.update("hello world")
+        val partial = agreement.update("hello world how are")
+        assertEquals("hello world", partial.committed)
+        assertEquals("how are", partial.tentative)
+    }
+
+    @Test
+    fun `agreement ignores case and punctuation`() {
+        agreement.update("Hello, world")
+        val partial = agreement.update("hello world. How")
+        assertEquals("hello world.", partial.committed)
+        assertEquals("How", partial.tentative)
+    }
+
+    @Test
+    fun `committed text never shrinks when a hypothesis diverges`() {
+        agreement.update("the quick brown")
+        agreement.update("the quick brown fox")
+        val partial = agreement.update("a quick brown fox jumps")
+        assertEquals("the quick brown", partial.committed)
+        assertEquals("fox jumps", partial.tentative)
+    }
+
+    @Test
+    fun `only the common prefix is committed`() {
+        agreement.update("I scream")
+        val partial = agreement.update("ice cream")
+        assertEquals("", partial.committed)
+        assertEquals("ice cream", partial.tentative)
+    }
+
+    @Test
+    fun `reset starts a new window`() {
+        agreement.update("hello world")
+        agreement.update("hello world")
+        agreement.reset()
+        val partial = agreement.update("goodbye")
+        assertEquals("", partial.committed)
+        assertEquals("goodbye", partial.tentative)
+    }
+
+    @Test
+    fun `text joins committed and tentative`() {
+        assertEquals("a b", PartialTranscription("a", "b").text)
+        assertEquals("b", PartialTranscription("", "b").text)
+        assertEquals("a", PartialTranscription("a", "").text)
+    }
+}
@@ -0,0 +1,74 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for model tier manifests and the step-down policy
+ */
+class ModelTierPolicyTest {
+
+    @Test
+    fun `config model names map to tiers`() {
+        assertEquals(ModelManifest.BASE, ModelManifest.forName("base.en-q5_1"))
+        assertEquals(ModelManifest.SMALL, ModelManifest.forName("small"))
+        assertEquals(ModelManifest.TINY, ModelManifest.forName("tiny-q8_0"))
+        assertNull(ModelManifest.forName("large"))
+    }
+
+    @Test
+    fun `smaller tiers are nearest first`() {
+        assertEquals(listOf(ModelManifest.BASE, ModelManifest.TINY), ModelManifest.SMALL.smaller())
+        assertTrue(ModelManifest.TINY.smaller().isEmpty())
+        assertEquals("models/Whisper_encoder.onnx", ModelManifest.SMALL.encoderPath)
+        assertEquals("models/tiny/Whisper_decoder.onnx", ModelManifest.TINY.decoderPath)
+    }
+
+    @Test
+    fun `policy trips once the rolling RTF exceeds the threshold`() {
+        val policy = ModelTierPolicy(rtfThreshold = 1.0f, window = 3)
+        assertFalse(policy.record(1500, 1.0f))
+        assertFalse(policy.record(1500, 1.0f)) // Window not full yet
+        assertTrue(policy.record(1500, 1.0f))
+        assertEquals(1.5f, policy.rollingRtf, 0.001f)
+
+        // Trips only once until reset
+        assertFalse(policy.record(2000, 1.0f))
+        policy.reset()
+        assertEquals(0f, policy.rollingRtf, 0f)
+    }
+
+    @Test
+    fun `fast transcription never trips`() {
+        val policy = ModelTierPolicy(rtfThreshold = 1.0f, window = 3)
+        repeat(10) { assertFalse(policy.record(400, 1.0f)) }
+        assertFalse(policy.record(400, 0f)) // No audio duration: ignored
+        assertEquals(0.4f, policy.rollingRtf, 0.001f)
+    }
+
+    @Test
+    fun `memory pressure trips until reset`() {
+        val policy = ModelTierPolicy()
+        assertTrue(policy.onMemoryPressure())
+        assertFalse(policy.onMemoryPressure())
+        policy.reset()
+        assertTrue(policy.onMemoryPressure())
+    }
+
+    @Test
+    fun `encoder bucket is the smallest that covers the chunk`() {
+        val available = listOf(5, 10, 20)
+        assertEquals(5, EncoderBuckets.select(2.0f, available))
+        assertEquals(10, EncoderBuckets.select(4.9f, available)) // Inside the margin
+        assertEquals(20, EncoderBuckets.select(12.0f, available))
+        assertNull(EncoderBuckets.select(25.0f, available))
+        assertEquals(10, EncoderBuckets.select(2.0f, listOf(10)))
+        assertNull(EncoderBuckets.select(2.0f, emptyList()))
+    }
+
+    @Test
+    fun `bucket encoders live next to the full one`() {
+        assertEquals("models/tiny/Whisper_encoder_5s.onnx", ModelManifest.TINY.bucketEncoderPath(5))
+        assertEquals(1000, EncoderBuckets.frames(10))
+    }
+}
@@ -0,0 +1,68 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for PcmRingBuffer
+ */
+class PcmRingBufferTest {
+
+    private fun bytes(range: IntRange) = ByteArray(range.count()) { (range.first + it).toByte() }
+
+    @Test
+    fun `append and copy out preserves order`() {
+        val ring = PcmRingBuffer(8)
+        ring.append(bytes(0..2))
+        ring.append(bytes(3..5))
+        assertEquals(6, ring.size)
+        assertArrayEquals(bytes(0..5), ring.toByteArray())
+        assertArrayEquals(bytes(2..4), ring.toByteArray(2, 3))
+    }
+
+    @Test
+    fun `discard moves head without reallocating and wraps on append`() {
+        val ring = PcmRingBuffer(8)
+        ring.append(bytes(0..5))
+        ring.discard(4)
+        ring.append(bytes(6..11)) // wraps past the end of storage
+        assertEquals(8, ring.capacity)
+        assertArrayEquals(bytes(4..11), ring.toByteArray())
+    }
+
+    @Test
+    fun `retainLast keeps the overlap tail`() {
+        val ring = PcmRingBuffer(16)
+        ring.append(bytes(0..9))
+        ring.retainLast(3)
+        assertArrayEquals(bytes(7..9), ring.toByteArray())
+        ring.retainLast(10) // more than buffered keeps everything
+        assertEquals(3, ring.size)
+    }
+
+    @Test
+    fun `grows when the window outgrows capacity`() {
+        val ring = PcmRingBuffer(4)
+        ring.append(bytes(0..2))
+        ring.discard(2)
+        ring.append(bytes(3..9))
+        assertTrue(ring.capacity >= 8)
+        assertArrayEquals(bytes(2..9), ring.toByteArray())
+    }
+
+    @Test
+    fun `clear empties the buffer`() {
+        val ring = PcmRingBuffer(4)
+        ring.append(bytes(0..3))
+        ring.clear()
+        assertTrue(ring.isEmpty())
+        assertEquals(0, ring.toByteArray().size)
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `discarding more than buffered is rejected`() {
+        val ring = PcmRingBuffer(4)
+        ring.append(bytes(0..1))
+        ring.discard(3)
+    }
+}
@@ -0,0 +1,104 @@
+package com.voiceinput.core
+
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.*
+import org.junit.Test
+
+class SharedEngineTest {
+
+    private class FakeEngine {
+        var released = false
+    }
+
+    private var loads = 0
+
+    private fun host(fail: Boolean = false) = SharedEngine(
+        load = {
+            loads++
+            delay(10)
+            if (fail) null else FakeEngine()
+        },
+        unload = { it.released = true }
+    )
+
+    @Test
+    fun `clients share one load`() = runBlocking {
+        val shared = host()
+        val engines = List(4) { async { shared.acquire() } }.awaitAll()
+
+        assertEquals(1, loads)
+        assertTrue(engines.all { it === engines[0] })
+        assertEquals(4, shared.clients)
+    }
+
+    @Test
+    fun `release keeps the engine warm`() = runBlocking {
+        val shared = host()
+        val engine = shared.acquire()!!
+        shared.release()
+
+        assertEquals(0, shared.clients)
+        assertTrue(shared.isLoaded)
+        assertSame(engine, shared.acquire())
+        assertEquals(1, loads)
+    }
+
+    @Test
+    fun `unloadIfIdle waits for the last client`() = runBlocking {
+        val shared = host()
+        val engine = shared.acquire()!!
+
+        assertFalse(shared.unloadIfIdle())
+        shared.release()
+        assertTrue(shared.unloadIfIdle())
+        assertTrue(engine.released)
+        assertFalse(shared.isLoaded)
+    }
+
+    @Test
+    fun `failed load takes no reference and retries`() = runBlocking {
+        val shared = host(fail = true)
+
+        assertNull(shared.acquire())
+        assertNull(shared.acquire())
+        assertEquals(0, shared.clients)
+        assertEquals(2, loads)
+    }
+
+    @Test
+    fun `failed client setup drops its reference`() = runBlocking {
+        val shared = host()
+
+        val thrown = runCatching {
+            shared.acquireFor<Unit> { throw IllegalStateException("pipeline") }
+        }.exceptionOrNull()
+
+        assertTrue(thrown is IllegalStateException)
+        assertEquals(0, shared.clients)
+        assertTrue(shared.unloadIfIdle())
+    }
+
+    @Test
+    fun `acquireFor keeps the reference for a built client`() = runBlocking {
+        val shared = host()
+
+        val built = shared.acquireFor { engine -> engine }
+
+        assertSame(shared.current, built)
+        assertEquals(1, shared.clients)
+        assertFalse(shared.unloadIfIdle())
+    }
+
+    @Test
+    fun `warmUp loads without a reference`() = runBlocking {
+        val shared = host()
+
+        assertTrue(shared.warmUp())
+        assertTrue(shared.isLoaded)
+        assertEquals(0, shared.clients)
+        assertTrue(shared.unloadIfIdle())
+    }
+}
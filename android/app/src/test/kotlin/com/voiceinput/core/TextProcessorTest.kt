@@ -200,4 +200,34 @@ class TextProcessorTest {
         val result = textProcessor.appendText(accumulated, newText)
         assertEquals("Hello world.", result)
     }
-}
\ No newline at end of file
+
+    // --- Test formatStructuredData ---
+    // Same cases as test_format_structured_data in desktop/tests/test_text_processor.py
+
+    @Test
+    fun `formatStructuredData should join spoken emails and URLs`() {
+        val testCases = mapOf(
+            "contact me at john dot smith at gmail dot com." to "contact me at john.smith@gmail.com.",
+            "mail jane underscore doe at example dot io, thanks" to "mail jane_doe@example.io, thanks",
+            "visit docs dot google dot com today" to "visit docs.google.com today",
+            "w w w dot example dot org" to "www.example.org",
+            "https colon slash slash example dot org slash docs" to "https://example.org/docs"
+        )
+
+        testCases.forEach { (input, expected) ->
+            assertEquals("Failed for input: $input", expected, textProcessor.formatStructuredData(input))
+        }
+    }
+
+    @Test
+    fun `formatStructuredData should leave separators outside addresses alone`() {
+        assertEquals("look at this", textProcessor.formatStructuredData("look at this"))
+        assertEquals("it is 5 dot 3 percent", textProcessor.formatStructuredData("it is 5 dot 3 percent"))
+    }
+
+    @Test
+    fun `formatStructuredData should do nothing when disabled`() {
+        val processor = TextProcessor(enableSmartFormatting = false)
+        assertEquals("google dot com", processor.formatStructuredData("google dot com"))
+    }
+}
@@ -0,0 +1,107 @@
+package com.voiceinput.core
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for the incremental transcript
+ */
+class TranscriptTest {
+
+    private val textProcessor = TextProcessor()
+
+    // Windows with overlapping words at the boundaries, as the streaming path produces them
+    private val windows = List(60) { i ->
+        "we talked about item $i and then we moved on to number ${i + 1}. Then we"
+    }
+
+    @Test
+    fun `appending the tail matches appending the whole text`() {
+        val transcript = Transcript(textProcessor)
+        var whole = ""
+        for (window in windows) {
+            whole = textProcessor.appendText(whole, window)
+            transcript.append(window)
+            assertEquals(whole, transcript.toString())
+        }
+        assertTrue(transcript.length > 2000)
+    }
+
+    @Test
+    fun `deltas rebuild the transcript`() {
+        val transcript = Transcript(textProcessor)
+        val listenerCopy = StringBuilder()
+        for (window in windows) {
+            val delta = transcript.append(window) ?: continue
+            assertTrue("Delta should stay near the end", transcript.length - delta.start < 400)
+            delta.applyTo(listenerCopy)
+        }
+        assertEquals(transcript.toString(), listenerCopy.toString())
+    }
+
+    @Test
+    fun `overlap only window changes nothing`() {
+        val transcript = Transcript(textProcessor)
+        transcript.append("the quick brown fox jumps")
+        assertNull(transcript.append("brown fox jumps"))
+    }
+
+    @Test
+    fun `preview does not change the transcript`() {
+        val transcript = Transcript(textProcessor)
+        transcript.append("hello there my friend")
+        val before = transcript.toString()
+
+        val delta = transcript.preview("how are you")
+        assertNotNull(delta)
+        assertEquals(before, transcript.toString())
+
+        val applied = StringBuilder(before)
+        delta!!.applyTo(applied)
+        transcript.append("how are you")
+        assertEquals(transcript.toString(), applied.toString())
+    }
+
+    @Test
+    fun `previews read a consistent tail while appending`() {
+        val transcript = Transcript(textProcessor)
+        val reference = Transcript(textProcessor)
+        val failure = java.util.concurrent.atomic.AtomicReference<Throwable>()
+        val done = java.util.concurrent.atomic.AtomicBoolean(false)
+        val previewer = Thread {
+            try {
+                while (!done.get()) transcript.previewTail("moved on to the next")
+            } catch (t: Throwable) {
+                failure.set(t)
+            }
+        }
+        previewer.start()
+        windows.forEach { transcript.append(it); reference.append(it) }
+        done.set(true)
+        previewer.join()
+
+        assertNull(failure.get())
+        assertEquals(reference.toString(), transcript.toString())
+        assertEquals(reference.previewTail("next"), transcript.previewTail("next"))
+    }
+
+    @Test
+    fun `final text is processed and reset on clear`() {
+        val transcript = Transcript(textProcessor)
+        transcript.append("write to john at gmail dot com please")
+        assertEquals(textProcessor.processFinal(transcript.toString()), transcript.finalText())
+
+        transcript.clear()
+        assertTrue(transcript.isEmpty())
+        assertEquals("", transcript.finalText())
+    }
+
+    @Test
+    fun `tail starts after a space`() {
+        val text = (1..100).joinToString(" ") { "word$it" }
+        val start = textProcessor.boundaryTailStart(text)
+        assertTrue(start > 0)
+        assertEquals(' ', text[start - 1])
+        assertEquals(0, textProcessor.boundaryTailStart("short text"))
+    }
+}
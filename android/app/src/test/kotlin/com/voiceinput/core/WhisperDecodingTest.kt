@@ -0,0 +1,94 @@
+package com.voiceinput.core
+
+import com.voiceinput.onnx.OnnxUtils
+import com.voiceinput.onnx.TokenScores
+import org.junit.Assert.*
+import org.junit.Test
+import java.nio.FloatBuffer
+import kotlin.math.exp
+
+/**
+ * Unit tests for decoding options, fallback checks and repetition detection
+ */
+class WhisperDecodingTest {
+
+    @Test
+    fun `temperature ladder runs from zero to one`() {
+        val temperatures = DecodingOptions().temperatures
+        assertEquals(6, temperatures.size)
+        assertEquals(0f, temperatures.first(), 0.0001f)
+        assertEquals(1f, temperatures.last(), 0.0001f)
+        assertEquals(listOf(0f), DecodingOptions(temperatureFallback = false).temperatures)
+    }
+
+    @Test
+    fun `looping text compresses far better than speech`() {
+        val speech = "The quick brown fox jumps over the lazy dog near the river bank."
+        val loop = "thank you ".repeat(20)
+        assertTrue(DecodingOptions.compressionRatio(speech) < 2.4f)
+        assertTrue(DecodingOptions.compressionRatio(loop) > 2.4f)
+        assertEquals(0f, DecodingOptions.compressionRatio(""), 0f)
+    }
+
+    @Test
+    fun `fallback triggers on low log probability or repetition`() {
+        val options = DecodingOptions()
+        val text = "hello world"
+        assertFalse(options.needsFallback(DecodedSequence(intArrayOf(1, 2), -0.3, 0f), text))
+        assertTrue(options.needsFallback(DecodedSequence(intArrayOf(1, 2), -1.5, 0f), text))
+        assertTrue(options.needsFallback(DecodedSequence(intArrayOf(1, 2), -0.3, 0f, repetitive = true), text))
+    }
+
+    @Test
+    fun `repeated token is cut to one copy`() {
+        val tokens = intArrayOf(5, 6) + IntArray(16) { 7 }
+        assertEquals(3, RepetitionDetector.findLoop(tokens))
+    }
+
+    @Test
+    fun `repeated phrase is cut to one copy`() {
+        val phrase = intArrayOf(10, 11, 12, 13)
+        val tokens = intArrayOf(1, 2) + phrase + phrase + phrase + phrase
+        assertEquals(6, RepetitionDetector.findLoop(tokens))
+    }
+
+    @Test
+    fun `normal sequence is not a loop`() {
+        val tokens = IntArray(40) { it }
+        assertEquals(-1, RepetitionDetector.findLoop(tokens))
+        // Only the first length tokens are considered
+        assertEquals(-1, RepetitionDetector.findLoop(IntArray(16) { 7 }, 10))
+    }
+
+    @Test
+    fun `scoreLogits ranks tokens and normalizes log probabilities`() {
+        val logits = FloatBuffer.wrap(floatArrayOf(1f, 4f, 2f, 3f))
+        val scores = TokenScores(2)
+        OnnxUtils.scoreLogits(logits, null, scores)
+
+        assertEquals(2, scores.count)
+        assertEquals(1, scores.best)
+        assertEquals(3, scores.indices[1])
+        assertEquals(OnnxUtils.logSumExpFast(floatArrayOf(1f, 4f, 2f, 3f)), scores.logSumExp, 1e-6)
+        val total = (0 until 4).sumOf { exp(logits.get(it) - scores.logSumExp) }
+        assertEquals(1.0, total, 1e-6)
+        assertEquals(4f - scores.logSumExp.toFloat(), scores.logProbs[0], 1e-6f)
+    }
+
+    @Test
+    fun `scoreLogits never returns suppressed tokens`() {
+        val logits = FloatBuffer.wrap(floatArrayOf(1f, 9f, 2f, 8f))
+        val scores = TokenScores(3)
+        OnnxUtils.scoreLogits(logits, booleanArrayOf(false, true, false, true), scores)
+
+        assertEquals(2, scores.count)
+        assertEquals(2, scores.best)
+        assertEquals(0, scores.indices[1])
+        assertEquals(OnnxUtils.logSumExpFast(floatArrayOf(1f, 2f)), scores.logSumExp, 1e-6)
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `beam size is bounded`() {
+        DecodingOptions(beamSize = DecodingOptions.MAX_BEAM_SIZE + 1)
+    }
+}
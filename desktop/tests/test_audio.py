@@ -3,7 +3,7 @@ import pytest
 from unittest.mock import Mock, patch
 import pyaudio
 import numpy as np
-from voice_input_service.core.audio import AudioRecorder
+from voice_input_service.core.audio import AudioRecorder, AudioRingBuffer
 from voice_input_service.config import AudioConfig
 import wave
 import os
@@ -69,13 +69,18 @@ def test_audio_callback(audio_recorder):
     callback_mock = Mock()
     audio_recorder.on_data_callback = callback_mock
     
-    # Call the callback method
+    # Call the callback method: it only fills the ring
     audio_recorder._audio_callback(
         in_data=test_data,
         frame_count=1024,
         time_info={},
         status=0
     )
+    callback_mock.assert_not_called()
+    
+    # The drain (normally its own thread) delivers it
+    assert audio_recorder._drain() is True
+    assert audio_recorder._drain() is False
     
     # Verify callback was called with data
     callback_mock.assert_called_once_with(test_data)
@@ -83,6 +88,37 @@ def test_audio_callback(audio_recorder):
     # Verify data was added to buffer
     assert test_data in audio_recorder.get_audio_data()
 
+def test_ring_buffer_wraps_and_drops_whole_writes():
+    """Writes wrap around the end; one that does not fit is dropped and counted."""
+    ring = AudioRingBuffer(10)
+    assert ring.write(b"abcdef")
+    assert ring.read() == b"abcdef"
+    assert ring.write(b"1234567") # Wraps past the end
+    assert ring.read() == b"1234567"
+    
+    assert ring.write(b"xyz")
+    assert not ring.write(b"12345678")
+    assert ring.read() == b"xyz"
+    assert ring.read() == b""
+    assert (ring.overflows, ring.dropped_bytes, ring.max_fill) == (1, 8, 7)
+
+def test_capture_stats_count_overflows(audio_recorder):
+    """Ring and PortAudio overflows show up in capture_stats()."""
+    chunk = b"\x00\x01" * 1024
+    frames = audio_recorder.ring.capacity // len(chunk)
+    for _ in range(frames + 1):
+        audio_recorder._audio_callback(chunk, 1024, {}, 0)
+    audio_recorder._audio_callback(b"", 0, {}, pyaudio.paInputOverflow)
+    
+    stats = audio_recorder.capture_stats()
+    assert stats["ring_overflows"] == 1
+    assert stats["ring_dropped_bytes"] == len(chunk)
+    assert stats["input_overflows"] == 1
+    assert stats["max_fill_bytes"] == frames * len(chunk)
+    
+    audio_recorder._drain()
+    assert len(audio_recorder.get_audio_data()) == frames * len(chunk)
+
 def test_silence_detection(audio_recorder):
     """Test silence detection functionality."""
     # Create silent audio (zeros)
@@ -0,0 +1,117 @@
+from __future__ import annotations
+import wave
+import numpy as np
+import pytest
+from unittest.mock import Mock
+from voice_input_service.config import Config, AudioConfig, TranscriptionConfig
+from voice_input_service.core.batch import (
+    BatchTranscriber, MappedWav, WavFormatError, energy_silence, segment_frames, FRAME_MS
+)
+from voice_input_service.core.transcription import TranscriptionEngine, TranscriptionResult
+
+SAMPLE_RATE = 16000
+FRAME = SAMPLE_RATE * FRAME_MS // 1000
+
+def frames(pattern: str) -> np.ndarray:
+    """'S' = speech frame, '.' = silent frame."""
+    return np.array([c == "." for c in pattern], dtype=bool)
+
+def write_wav(path, samples: np.ndarray, channels: int = 1, rate: int = SAMPLE_RATE) -> None:
+    with wave.open(str(path), "wb") as wav:
+        wav.setnchannels(channels)
+        wav.setsampwidth(2)
+        wav.setframerate(rate)
+        wav.writeframes(samples.astype("<i2").tobytes())
+
+def speech_pattern(pattern: str) -> np.ndarray:
+    """Samples with a loud tone for 'S' frames and zeros for '.' frames."""
+    tone = (np.sin(np.arange(FRAME) * 0.1) * 8000).astype(np.int16)
+    return np.concatenate([tone if c == "S" else np.zeros(FRAME, dtype=np.int16) for c in pattern])
+
+@pytest.fixture
+def mock_config():
+    config = Mock(spec=Config)
+    config.audio = Mock(spec=AudioConfig)
+    config.transcription = Mock(spec=TranscriptionConfig)
+    config.audio.silence_duration_sec = 0.5
+    config.transcription.min_chunk_size_bytes = 2 * FRAME * 2  # Two frames
+    config.transcription.prompt_carryover = True
+    config.transcription.prompt_max_tokens = 64
+    return config
+
+@pytest.fixture
+def mock_transcriber():
+    transcriber = Mock(spec=TranscriptionEngine)
+    texts = iter(["hello there", "general kenobi"])
+    transcriber.transcribe.side_effect = lambda audio, **kwargs: TranscriptionResult(
+        {"text": next(texts), "language": "en", "segments": []}
+    )
+    return transcriber
+
+def test_segment_frames_pads_and_packs():
+    """Regions are padded and packed into windows up to the limit."""
+    pattern = "SSSS......SSSS......SSSS......"
+    assert segment_frames(frames(pattern), 4, 30) == [(0, 26)]
+    assert segment_frames(frames(pattern), 4, 16) == [(0, 16), (18, 26)]
+    assert segment_frames(frames("." * 20), 4, 30) == []
+
+def test_segment_frames_splits_long_regions():
+    """Long regions split at a late pause, or hard at the limit without one."""
+    assert segment_frames(frames("S" * 20 + "." + "S" * 9), 4, 24) == [(0, 21), (21, 30)]
+    assert segment_frames(frames("S" * 25), 4, 10) == [(0, 10), (10, 20), (20, 25)]
+
+def test_energy_silence_flags_quiet_frames():
+    """Frames below the RMS threshold are silent, including a short last frame."""
+    samples = np.concatenate([speech_pattern(".S."), np.zeros(10, dtype=np.int16)])
+    assert energy_silence(samples, FRAME).tolist() == [True, False, True, True]
+
+def test_mapped_wav_reads_mono_without_copy(temp_dir):
+    """Mono PCM is a view of the mapped file."""
+    path = temp_dir / "mono.wav"
+    samples = np.arange(-100, 100, dtype=np.int16)
+    write_wav(path, samples)
+    with MappedWav(str(path)) as wav:
+        assert wav.sample_rate == SAMPLE_RATE
+        assert wav.channels == 1
+        assert not wav.samples.flags.owndata
+        np.testing.assert_array_equal(wav.samples, samples)
+
+def test_mapped_wav_downmixes_stereo(temp_dir):
+    """Stereo frames are averaged to mono."""
+    path = temp_dir / "stereo.wav"
+    write_wav(path, np.array([100, 300, -50, -150], dtype=np.int16), channels=2)
+    with MappedWav(str(path)) as wav:
+        assert wav.samples.tolist() == [200, -100]
+
+def test_mapped_wav_rejects_non_wav(temp_dir):
+    """Files that are not RIFF/WAVE raise WavFormatError."""
+    path = temp_dir / "not.wav"
+    path.write_bytes(b"definitely not a wav file")
+    with pytest.raises(WavFormatError):
+        MappedWav(str(path))
+
+def test_transcribe_samples_carries_prompt(mock_config, mock_transcriber):
+    """Windows are transcribed in order, each prompted with the text so far."""
+    batch = BatchTranscriber(mock_config, mock_transcriber)
+    samples = speech_pattern("SSSS" + "." * 30 + "SSSS")
+
+    assert len(batch.segment(samples, SAMPLE_RATE)) == 1  # Packed into one 30 s window
+    progress = Mock()
+    batch.segment = Mock(return_value=[(0, 4 * FRAME), (34 * FRAME, 38 * FRAME)])
+    text = batch.transcribe_samples(samples, SAMPLE_RATE, on_progress=progress)
+
+    assert text.lower() == "hello there general kenobi"
+    calls = mock_transcriber.transcribe.call_args_list
+    assert len(calls) == 2
+    assert "prompt" not in calls[0].kwargs
+    assert calls[1].kwargs["prompt"] == "hello there"
+    assert len(calls[1].kwargs["audio"]) == 4 * FRAME * 2
+    progress.assert_called_with(2, 2, text)
+
+def test_transcribe_file_rejects_other_sample_rates(temp_dir, mock_config, mock_transcriber):
+    """Files must already be 16kHz."""
+    path = temp_dir / "fast.wav"
+    write_wav(path, np.zeros(100, dtype=np.int16), rate=44100)
+    with pytest.raises(WavFormatError):
+        BatchTranscriber(mock_config, mock_transcriber).transcribe_file(str(path))
+    mock_transcriber.transcribe.assert_not_called()
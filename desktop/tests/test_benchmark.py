@@ -0,0 +1,52 @@
+from __future__ import annotations
+import numpy as np
+import pytest
+from voice_input_service.core.benchmark import (
+    BenchmarkReport, BenchmarkSamples, parse_peak_rss_kb, stat_summary, tile_clip
+)
+
+def test_stat_summary():
+    """Summaries hold min/mean/max and nearest-rank percentiles."""
+    stat = stat_summary("ms", [float(v) for v in range(100, 0, -1)])
+    assert stat["count"] == 100
+    assert stat["min"] == 1.0
+    assert stat["max"] == 100.0
+    assert stat["mean"] == pytest.approx(50.5)
+    assert (stat["p50"], stat["p95"], stat["p99"]) == (50.0, 95.0, 99.0)
+
+    with pytest.raises(ValueError):
+        stat_summary("ms", [])
+
+def test_samples_grouped_per_metric():
+    """Samples are grouped per metric in insertion order with their unit."""
+    samples = BenchmarkSamples()
+    samples.add("transcribe.5s", "ms", 120.0)
+    samples.add("vad.per_frame", "us", 80.0)
+    samples.add("transcribe.5s", "ms", 100.0)
+
+    stats = samples.stats()
+    assert list(stats) == ["transcribe.5s", "vad.per_frame"]
+    assert stats["transcribe.5s"]["count"] == 2
+    assert stats["vad.per_frame"]["unit"] == "us"
+
+def test_report_json_round_trip():
+    """Reports use the Android field names and load back unchanged."""
+    report = BenchmarkReport(
+        platform="desktop", build="0.1.0", device="test", model="base.en", started_at="2026-01-01T00:00:00Z",
+        warmup=1, repeats=3, corpus_sec=[5, 15], thermal_state="unknown", peak_rss_kb=None,
+        metrics={"transcribe.5s": stat_summary("ms", [1.0, 2.0, 3.0])}
+    )
+    text = report.to_json()
+    assert '"corpusSec"' in text and '"peakRssKb"' in text
+    assert BenchmarkReport.from_json(text) == report
+
+def test_parse_peak_rss():
+    """Peak RSS comes from the VmHWM line."""
+    status = "Name:\tpython\nVmPeak:\t 900000 kB\nVmHWM:\t  412345 kB\n"
+    assert parse_peak_rss_kb(status) == 412345
+    assert parse_peak_rss_kb("Name:\tpython\n") is None
+
+def test_tile_clip():
+    """Clips are the source repeated to the exact length."""
+    clip = tile_clip(np.arange(4, dtype=np.int16), 1, sample_rate=10)
+    assert clip.tolist() == [0, 1, 2, 3, 0, 1, 2, 3, 0, 1]
@@ -0,0 +1,22 @@
+"""Checks for the scheduler binding (or its pure-Python fallback); the rules are tested in native/tests/chunk_scheduler_test.cpp."""
+from voice_input_service.core.chunk_scheduler import Action, ChunkLimits, ChunkScheduler
+
+LIMITS = ChunkLimits(min_audio_length_bytes=1000, max_chunk_bytes=4000, silence_duration_ms=500)
+
+def test_actions_map_to_python_actions():
+    scheduler = ChunkScheduler(LIMITS)
+    scheduler.reset(0)
+    assert scheduler.on_chunk(True, 0, 1000, 100) == Action.IGNORE
+    assert scheduler.on_chunk(False, 0, 1000, 1000) == Action.APPEND
+    assert scheduler.on_chunk(False, 3000, 1000, 1100) == Action.APPEND_AND_FLUSH
+    assert scheduler.on_chunk(True, 2000, 500, 1200, keep_silence=False) == Action.IGNORE
+    assert scheduler.on_chunk(True, 2000, 500, 1600) == Action.FLUSH
+    assert scheduler.last_speech_ms == 1100
+    assert scheduler.flush_on_idle(1000, recent_audio=False)
+    assert not scheduler.flush_on_idle(1000, recent_audio=True)
+
+def test_new_limits_reach_the_scheduler():
+    scheduler = ChunkScheduler(LIMITS)
+    scheduler.limits = ChunkLimits(min_audio_length_bytes=1000, max_chunk_bytes=1000, silence_duration_ms=500)
+    assert scheduler.on_chunk(False, 0, 1000, 100) == Action.APPEND_AND_FLUSH
+    assert scheduler.limits.max_chunk_bytes == 1000
@@ -69,7 +69,7 @@ def test_main_microphone_check_failed(capsys):
     """Test main function when microphone check fails."""
     with patch('voice_input_service.__main__.check_microphone', return_value=False):
         with pytest.raises(SystemExit) as exc_info:
-            main()
+            main([])
         
         assert exc_info.value.code == 1
         captured = capsys.readouterr()
@@ -95,12 +95,12 @@ def test_main_success():
         mock_voice_service.return_value = mock_service_instance
 
         # Call main
-        main()
+        main([])
 
         # Assertions
         mock_init_app.assert_called_once()
         mock_model_manager.initialize_transcription_engine.assert_called_once()
-        mock_voice_service.assert_called_once_with(mock_config, mock_ui, mock_transcriber)
+        mock_voice_service.assert_called_once_with(mock_config, mock_ui, mock_transcriber, model_manager=mock_model_manager)
         mock_service_instance.run.assert_called_once()
 
 def test_main_keyboard_interrupt(capsys):
@@ -123,14 +123,14 @@ def test_main_keyboard_interrupt(capsys):
         mock_voice_service.return_value = mock_service_instance
 
         # Call main
-        main()
+        main([])
 
         # Assertions
         captured = capsys.readouterr()
         assert "Service stopped by user" in captured.out
         mock_init_app.assert_called_once()
         mock_model_manager.initialize_transcription_engine.assert_called_once()
-        mock_voice_service.assert_called_once_with(mock_config, mock_ui, mock_transcriber)
+        mock_voice_service.assert_called_once_with(mock_config, mock_ui, mock_transcriber, model_manager=mock_model_manager)
         mock_service_instance.run.assert_called_once()
 
 def test_main_error(capsys):
@@ -154,7 +154,7 @@ def test_main_error(capsys):
 
         # Expect SystemExit when main encounters an error
         with pytest.raises(SystemExit) as exc_info:
-            main()
+            main([])
 
         # Assertions
         assert exc_info.value.code == 1
@@ -162,7 +162,7 @@ def test_main_error(capsys):
         assert "Error: Test error" in captured.out
         mock_init_app.assert_called_once()
         mock_model_manager.initialize_transcription_engine.assert_called_once()
-        mock_voice_service.assert_called_once_with(mock_config, mock_ui, mock_transcriber)
+        mock_voice_service.assert_called_once_with(mock_config, mock_ui, mock_transcriber, model_manager=mock_model_manager)
         mock_service_instance.run.assert_called_once()
 
 def test_main_engine_init_fails(capsys):
@@ -181,7 +181,7 @@ def test_main_engine_init_fails(capsys):
 
         # Expect SystemExit
         with pytest.raises(SystemExit) as exc_info:
-            main()
+            main([])
             
         # Assertions
         assert exc_info.value.code == 1
@@ -189,4 +189,26 @@ def test_main_engine_init_fails(capsys):
         assert "No transcription model was selected" in captured.out
         mock_init_app.assert_called_once()
         mock_model_manager.initialize_transcription_engine.assert_called_once()
-        mock_voice_service.assert_not_called() # Service should not be created 
\ No newline at end of file
+        mock_voice_service.assert_not_called() # Service should not be created 
+
+def test_main_batch_mode_skips_microphone():
+    """--transcribe runs the batch path and exits with its code."""
+    with patch('voice_input_service.__main__.check_microphone') as mock_check,\
+         patch('voice_input_service.__main__.run_batch', return_value=0) as mock_batch:
+        with pytest.raises(SystemExit) as exc_info:
+            main(["--transcribe", "talk.wav", "--output", "talk.txt"])
+
+        assert exc_info.value.code == 0
+        mock_batch.assert_called_once_with("talk.wav", "talk.txt")
+        mock_check.assert_not_called()
+
+def test_main_benchmark_mode_skips_microphone():
+    """--benchmark runs the benchmark (synthetic corpus without a WAV) and exits with its code."""
+    with patch('voice_input_service.__main__.check_microphone') as mock_check,\
+         patch('voice_input_service.__main__.run_benchmark', return_value=0) as mock_bench:
+        with pytest.raises(SystemExit) as exc_info:
+            main(["--benchmark", "--repeats", "3", "--output", "report.json"])
+
+        assert exc_info.value.code == 0
+        mock_bench.assert_called_once_with("", "report.json", 1, 3)
+        mock_check.assert_not_called()
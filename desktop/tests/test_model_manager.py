@@ -1,7 +1,9 @@
 import pytest
+import threading
 from unittest.mock import Mock, patch, create_autospec, ANY
 import tkinter as tk
 from voice_input_service.core.model_manager import ModelManager
+from voice_input_service.core.model_tiers import smaller_models
 from voice_input_service.config import Config
 from voice_input_service.core.transcription import TranscriptionEngine
 
@@ -135,4 +137,48 @@ def test_initialize_transcription_engine_download_model(model_manager, monkeypat
                 mock_download_method.assert_called_once_with("tiny") 
                 
                 # Result should be the mocked engine instance returned by _download_model
-                assert result is mock_engine_instance 
\ No newline at end of file
+                assert result is mock_engine_instance 
+def test_smaller_models_keep_variant_suffix():
+    """Fallback tiers step down one size at a time and keep the .en/quantization suffix."""
+    assert smaller_models("small.en") == ["base.en", "tiny.en"]
+    assert smaller_models("base.en-q5_1") == ["tiny.en-q5_1"]
+    assert smaller_models("tiny") == []
+    assert smaller_models("custom") == []
+
+def test_select_fallback_model_skips_missing_tiers(model_manager, monkeypatch):
+    """The nearest smaller model that exists locally is chosen."""
+    monkeypatch.setattr("os.path.exists", lambda path: path.endswith("tiny.pt"))
+    assert model_manager.select_fallback_model("small") == "tiny"
+    assert model_manager.select_fallback_model("tiny") is None
+
+def test_select_fallback_model_uses_ggml_files(model_manager, tmp_path):
+    """With whisper.cpp, tiers are found as GGML files in the models directory."""
+    (tmp_path / "ggml-base.en.bin").touch()
+    (tmp_path / "ggml-small.en.bin").touch()
+    model_manager.models_dir = str(tmp_path)
+    model_manager.config.transcription.use_cpp = True
+
+    assert model_manager.select_fallback_model("small.en") == "base.en"
+    assert model_manager._find_ggml_model("base.en") == str(tmp_path / "ggml-base.en.bin")
+
+    engine = Mock(model_name="base", model_file_path=str(tmp_path / "ggml-small.en.bin"))
+    assert model_manager.engine_model_name(engine) == "small.en"
+
+def test_preload_fallback_hands_over_loaded_engine(model_manager, monkeypatch):
+    """The fallback engine is built without touching the saved config."""
+    monkeypatch.setattr("os.path.exists", lambda path: path.endswith("base.pt"))
+    loaded = Mock(loaded=True)
+    ready = threading.Event()
+    received = []
+
+    def on_ready(engine):
+        received.append(engine)
+        ready.set()
+
+    with patch.object(model_manager, "_select_model", return_value=loaded) as mock_select:
+        assert model_manager.preload_fallback("small", on_ready) == "base"
+        assert ready.wait(timeout=2.0)
+
+    mock_select.assert_called_once_with("base", persist=False)
+    assert received == [loaded]
+    model_manager.config.save.assert_not_called()
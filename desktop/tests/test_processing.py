@@ -7,6 +7,7 @@ from unittest.mock import Mock, patch, MagicMock
 from voice_input_service.core.processing import TranscriptionWorker, STOP_SIGNAL
 from voice_input_service.config import Config, AudioConfig, TranscriptionConfig
 from voice_input_service.core.processing import SilenceDetector
+from voice_input_service.core.model_tiers import RtfMonitor
 from voice_input_service.core.transcription import TranscriptionEngine, TranscriptionResult
 # Constants for testing
 TEST_TEXT = "Test transcription result"
@@ -23,6 +24,12 @@ def mock_config():
     # Use the actual names from Config
     config.audio.min_audio_length_sec = 0.5 
     config.transcription.min_chunk_size_bytes = MIN_CHUNK_SIZE_BYTES
+    config.transcription.prompt_carryover = True
+    config.transcription.prompt_max_tokens = 64
+    config.transcription.adaptive_model = True
+    config.transcription.adaptive_rtf_threshold = 1.0
+    config.transcription.pool_workers = 1 # Tests drive the primary engine only
+    config.transcription.pool_threads_per_worker = 0
     config.audio.sample_rate = 16000
     config.audio.silence_duration_sec = 1.5 # Match test expectations below
     config.audio.max_chunk_duration_sec = 10.0 
@@ -84,6 +91,7 @@ def worker(mock_config, mock_transcriber, mock_result_callback, mock_silence_det
         worker_instance.stop()
         if worker_instance.thread and worker_instance.thread.is_alive():
             worker_instance.thread.join(timeout=1.0)
+    worker_instance.close()
 
 def test_worker_initialization(worker, mock_config, mock_transcriber, mock_result_callback):
     """Test TranscriptionWorker initialization."""
@@ -150,12 +158,29 @@ def test_process_audio_buffer(worker, mock_transcriber, mock_result_callback):
     test_audio = b'test_audio_data' * MIN_CHUNK_SIZE_BYTES # Ensure it meets min size
 
     worker._process_audio_buffer(test_audio)
+    worker.wait_idle()
 
     # Verify transcriber was called correctly
     mock_transcriber.transcribe.assert_called_once_with(audio=test_audio, target_wav_path=None)
     # Verify on_result was called with only the text
     mock_result_callback.assert_called_once_with(TEST_TEXT)
 
+def test_process_audio_buffer_carries_prompt(worker, mock_transcriber):
+    """The previous chunk's text is passed as the next chunk's prompt."""
+    test_audio = b'test_audio_data' * MIN_CHUNK_SIZE_BYTES
+
+    worker._process_audio_buffer(test_audio)
+    worker.wait_idle()
+    worker._process_audio_buffer(test_audio)
+    worker.wait_idle()
+
+    assert mock_transcriber.transcribe.call_args_list[1].kwargs["prompt"] == TEST_TEXT
+
+    worker.prompt_carryover = False
+    worker._process_audio_buffer(test_audio)
+    worker.wait_idle()
+    assert "prompt" not in mock_transcriber.transcribe.call_args_list[2].kwargs
+
 def test_process_audio_buffer_small_audio(worker, mock_transcriber):
     """Test processing a small audio buffer (should be skipped)."""
     # Setup small test data (smaller than min_chunk_size_bytes)
@@ -175,6 +200,7 @@ def test_process_audio_buffer_with_empty_result(worker, mock_transcriber, mock_r
     test_audio = b'test_audio_data' * MIN_CHUNK_SIZE_BYTES
 
     worker._process_audio_buffer(test_audio)
+    worker.wait_idle()
 
     mock_transcriber.transcribe.assert_called_once_with(audio=test_audio, target_wav_path=None)
     # Result callback should NOT be called for empty text
@@ -190,6 +216,7 @@ def test_process_audio_buffer_with_exception(worker, mock_transcriber, mock_resu
     
     # Process the buffer - should not raise the exception out
     worker._process_audio_buffer(test_audio) 
+    worker.wait_idle()
 
     # Verify transcriber was called
     mock_transcriber.transcribe.assert_called_once_with(audio=test_audio, target_wav_path=None)
@@ -206,6 +233,7 @@ def test_on_result_callback_exception(worker, mock_transcriber):
 
     # Process the buffer - should not raise the exception out
     worker._process_audio_buffer(test_audio) 
+    worker.wait_idle()
 
     # Verify transcriber was called
     mock_transcriber.transcribe.assert_called_once()
@@ -313,4 +341,38 @@ def test_worker_continuous_mode_processing(mock_time, worker, mock_config, mock_
 # It might be less relevant with the new queue-based stop mechanism.
 
 # Remove old test_worker_start_stop if redundant
-# Keep other tests like test_add_audio, small audio, exceptions etc. 
\ No newline at end of file
+# Keep other tests like test_add_audio, small audio, exceptions etc. 
+def test_rtf_monitor_trips_once_when_behind_real_time():
+    """The monitor trips after a full window above the threshold, then waits for reset()."""
+    monitor = RtfMonitor(threshold=1.0, window=3)
+    assert not monitor.record(1.5, 1.0)
+    assert not monitor.record(1.5, 1.0) # Window not full yet
+    assert monitor.record(1.5, 1.0)
+    assert monitor.rolling_rtf == pytest.approx(1.5)
+    assert not monitor.record(2.0, 1.0)
+
+    monitor.reset()
+    assert monitor.rolling_rtf == 0.0
+    for _ in range(5):
+        assert not monitor.record(0.4, 1.0)
+
+def test_worker_reports_overload_and_swaps_transcriber(worker, mock_transcriber):
+    """A slow transcriber triggers on_overload; swap_transcriber routes later chunks to the new engine."""
+    overloads = []
+    worker.on_overload = overloads.append
+    worker.rtf_monitor = RtfMonitor(threshold=1.0, window=1)
+    test_audio = b'test_audio_data' * MIN_CHUNK_SIZE_BYTES
+
+    with patch('voice_input_service.core.processing.time.perf_counter', side_effect=[0.0, 10.0]):
+        worker._process_audio_buffer(test_audio)
+        worker.wait_idle()
+    assert len(overloads) == 1 and overloads[0] > 1.0
+
+    new_transcriber = Mock(spec=TranscriptionEngine)
+    new_transcriber.transcribe.return_value = TranscriptionResult({"text": TEST_TEXT, "language": "en", "segments": []})
+    assert worker.swap_transcriber(new_transcriber) is mock_transcriber
+
+    worker._process_audio_buffer(test_audio)
+    worker.wait_idle()
+    new_transcriber.transcribe.assert_called_once()
+    assert mock_transcriber.transcribe.call_count == 1
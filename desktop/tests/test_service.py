@@ -139,6 +139,8 @@ def mock_config():
     config.data_dir = Path("/fake/data/dir") # Use Path object
     config.debug = False
     config.log_level = "INFO"
+    config.trace_file = None
+    config.trace_format = "jsonl"
     
     # Mock save method to prevent file operations
     config.save = Mock()
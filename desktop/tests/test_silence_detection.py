@@ -0,0 +1,88 @@
+from __future__ import annotations
+import numpy as np
+import pytest
+from types import SimpleNamespace
+from unittest.mock import Mock, patch
+
+from voice_input_service.config import Config, AudioConfig
+from voice_input_service.utils import silence_detection
+from voice_input_service.utils.silence_detection import SilenceDetector
+
+WINDOW = 512
+
+class FakeSession:
+    """Silero stand-in: speech probability is the window's peak level; the state counts windows."""
+
+    def __init__(self):
+        self.windows = []
+
+    def get_inputs(self):
+        return [SimpleNamespace(name=name) for name in ("input", "state", "sr")]
+
+    def run(self, outputs, feeds):
+        window = feeds["input"].copy()
+        self.windows.append(window)
+        return np.array([[np.abs(window[0, 64:]).max()]], dtype=np.float32), feeds["state"] + 1
+
+@pytest.fixture
+def session():
+    return FakeSession()
+
+@pytest.fixture
+def detector(session):
+    config = Mock(spec=Config)
+    config.audio = Mock(spec=AudioConfig)
+    config.audio.sample_rate = 16000
+    config.audio.vad_threshold = 0.5
+    config.audio.vad_model_path = None
+    with patch.object(silence_detection, "ORT_AVAILABLE", True), \
+         patch.object(silence_detection, "_load_session", return_value=session):
+        return SilenceDetector(config)
+
+def pcm(level: float, samples: int) -> np.ndarray:
+    return np.full(samples, int(level * 32767), dtype=np.int16)
+
+def test_windows_are_512_samples(detector):
+    assert detector._initialized
+    assert detector.frame_size_bytes == 2 * WINDOW
+    assert detector.frame_duration_ms == 32
+
+def test_partial_windows_carry_over(detector, session):
+    audio = np.concatenate((pcm(0.9, 700), pcm(0.0, 324))).tobytes()
+    assert detector.process_frames(audio[:300]).size == 0
+    assert detector.process_frames(audio[300:]).size == 2
+    assert len(session.windows) == 2
+    # The second window starts with the last 64 samples of the first as context
+    np.testing.assert_array_equal(session.windows[1][0, :64], session.windows[0][0, WINDOW:])
+    assert detector._state.max() == 2
+
+def test_is_silent_thresholds_the_loudest_window(detector):
+    assert detector.is_silent(pcm(0.1, 2 * WINDOW).tobytes())
+    assert not detector.is_silent(np.concatenate((pcm(0.1, WINDOW), pcm(0.9, WINDOW))).tobytes())
+    assert not detector.is_silent(pcm(0.1, 100).tobytes()) # No full window yet: assume speech
+    assert detector.is_silent(b"")
+
+def test_reset_stream_drops_state(detector):
+    detector.process_frames(pcm(0.9, WINDOW + 10).tobytes())
+    detector.reset_stream()
+    assert detector._state.max() == 0
+    assert detector._pending.size == 0
+    assert not detector._window.any()
+
+def test_silent_frames_maps_windows_to_frames(detector):
+    # Speech only in the third window (samples 1024-1535), inside the first 1600-sample frame
+    samples = np.concatenate((pcm(0.0, 2 * WINDOW), pcm(0.9, WINDOW), pcm(0.0, WINDOW), pcm(0.0, 1600)))
+    silent = detector.silent_frames(samples, 1600)
+    assert silent.tolist() == [False, True, True]
+    assert detector._state.max() == 0 # Live stream untouched
+
+def test_uninitialized_detector_assumes_speech():
+    config = Mock(spec=Config)
+    config.audio = Mock(spec=AudioConfig)
+    config.audio.sample_rate = 16000
+    config.audio.vad_threshold = 0.5
+    with patch.object(silence_detection, "ORT_AVAILABLE", False):
+        detector = SilenceDetector(config)
+    assert not detector._initialized
+    assert not detector.is_silent(pcm(0.0, WINDOW).tobytes())
+    assert detector.silent_frames(pcm(0.0, 3200), 1600).tolist() == [False, False]
@@ -1,6 +1,6 @@
 from __future__ import annotations
 import pytest
-from voice_input_service.utils.text_processor import TextProcessor
+from voice_input_service.utils.text_processor import BOUNDARY_TAIL_CHARS, TextProcessor, Transcript
 
 @pytest.fixture
 def text_processor() -> TextProcessor:
@@ -189,4 +189,68 @@ def test_integration_append_format_filter(text_processor: TextProcessor) -> None
     # assert accumulated_text == "This is the first part. The second part. And the conclusion." # Original
     assert accumulated_text == "This is the first part. The second part. and the conclusion" # Updated
 
-    assert accumulated_text == "This is the first part. The second part. and the conclusion" 
\ No newline at end of file
+    assert accumulated_text == "This is the first part. The second part. and the conclusion" 
+
+# --- Test Transcript ---
+
+def _chunks(count: int) -> list:
+    return [f"we moved on to item {i}. then we" if i % 3 else f"then we talked about number {i}" for i in range(count)]
+
+def test_transcript_matches_whole_text_append(text_processor: TextProcessor) -> None:
+    transcript = Transcript(text_processor)
+    expected = ""
+    for chunk in _chunks(80):
+        transcript.append(chunk)
+        expected = text_processor.append_text(expected, chunk)
+    assert len(expected) > 4 * BOUNDARY_TAIL_CHARS # Long enough for the head to be frozen
+    assert transcript.text() == expected
+    assert len(transcript) == len(expected)
+    assert transcript.word_count == len(expected.split())
+
+def test_transcript_deltas_rebuild_text(text_processor: TextProcessor) -> None:
+    transcript = Transcript(text_processor)
+    shown = ""
+    for chunk in _chunks(80):
+        delta = transcript.append(chunk)
+        if delta:
+            assert len(transcript) - delta.start <= BOUNDARY_TAIL_CHARS * 2 + len(chunk) + 1
+            shown = delta.apply(shown)
+    assert shown == transcript.text()
+
+def test_transcript_overlap_only_chunk_is_no_change(text_processor: TextProcessor) -> None:
+    transcript = Transcript(text_processor)
+    transcript.append("the quick brown fox jumps")
+    assert transcript.append("brown fox jumps") is None
+    assert transcript.text() == "The quick brown fox jumps"
+
+def test_transcript_reset(text_processor: TextProcessor) -> None:
+    transcript = Transcript(text_processor)
+    transcript.append("some words here")
+    transcript.reset("Final text.")
+    assert transcript.text() == "Final text."
+    assert transcript.word_count == 2
+    transcript.reset()
+    assert transcript.text() == "" and len(transcript) == 0
+
+
+# --- Test format_structured_data ---
+# Same cases as formatStructuredData in the Android TextProcessorTest
+
+@pytest.mark.parametrize(
+    "input_text, expected_output",
+    [
+        ("contact me at john dot smith at gmail dot com.", "contact me at john.smith@gmail.com."),
+        ("mail jane underscore doe at example dot io, thanks", "mail jane_doe@example.io, thanks"),
+        ("visit docs dot google dot com today", "visit docs.google.com today"),
+        ("w w w dot example dot org", "www.example.org"),
+        ("https colon slash slash example dot org slash docs", "https://example.org/docs"),
+        ("look at this", "look at this"), # No address, separators stay words
+        ("it is 5 dot 3 percent", "it is 5 dot 3 percent"), # Not a known TLD
+    ]
+)
+def test_format_structured_data(text_processor: TextProcessor, input_text: str, expected_output: str) -> None:
+    assert text_processor.format_structured_data(input_text) == expected_output
+
+def test_format_structured_data_disabled() -> None:
+    processor = TextProcessor(enable_smart_formatting=False)
+    assert processor.format_structured_data("google dot com") == "google dot com"
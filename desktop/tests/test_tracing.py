@@ -0,0 +1,70 @@
+from __future__ import annotations
+import json
+import pytest
+from voice_input_service.utils import tracing
+from voice_input_service.utils.tracing import LatencyTracer, percentile
+
+MS = 1_000_000
+
+def test_percentile_nearest_rank():
+    """Percentiles pick the nearest rank; an empty list gives 0."""
+    values = [float(v) for v in range(1, 101)]
+    assert percentile(values, 50) == 50.0
+    assert percentile(values, 95) == 95.0
+    assert percentile(values, 99) == 99.0
+    assert percentile([7.0], 99) == 7.0
+    assert percentile([], 50) == 0.0
+
+def test_summary_per_stage():
+    """Recorded spans are summarized per stage in milliseconds."""
+    tracer = LatencyTracer()
+    for ms in range(100, 0, -1):
+        tracer.record(tracing.TRANSCRIBE, 0, ms * MS)
+    tracer.record(tracing.VAD, 0, 2 * MS)
+
+    summary = tracer.summary()
+    assert set(summary) == {tracing.TRANSCRIBE, tracing.VAD}
+    assert summary[tracing.TRANSCRIBE]["count"] == 100
+    assert summary[tracing.TRANSCRIBE]["p95_ms"] == pytest.approx(95.0)
+    assert summary[tracing.VAD]["p50_ms"] == pytest.approx(2.0)
+    assert "transcribe p50/p95/p99" in tracer.format_summary()
+
+def test_summary_keeps_recent_spans():
+    """Only the newest capacity spans count towards the percentiles."""
+    tracer = LatencyTracer(capacity=3)
+    for ms in (500, 500, 500, 10, 10, 10):
+        tracer.record(tracing.QUEUE, 0, ms * MS)
+    assert tracer.summary()[tracing.QUEUE]["p99_ms"] == pytest.approx(10.0)
+
+def test_jsonl_trace_file(temp_dir):
+    """JSONL traces hold one span per line with its extra fields."""
+    path = temp_dir / "trace.jsonl"
+    tracer = LatencyTracer(path=path)
+    with tracer.span(tracing.TRANSCRIBE, bytes=320):
+        pass
+    tracer.record(tracing.END_TO_END, tracer.now())
+    tracer.close()
+
+    events = [json.loads(line) for line in path.read_text().splitlines()]
+    assert [e["stage"] for e in events] == [tracing.TRANSCRIBE, tracing.END_TO_END]
+    assert events[0]["bytes"] == 320
+    assert events[0]["dur_us"] >= 0
+
+def test_chrome_trace_file(temp_dir):
+    """Chrome traces are complete events in an (unterminated) JSON array."""
+    path = temp_dir / "trace.json"
+    tracer = LatencyTracer(path=path, trace_format="chrome")
+    with tracer.span(tracing.VAD):
+        pass
+    tracer.close()
+
+    text = path.read_text()
+    assert text.startswith("[")
+    events = json.loads(text.rstrip().rstrip(",") + "]")
+    assert events[0]["name"] == tracing.VAD
+    assert events[0]["ph"] == "X"
+
+def test_rejects_unknown_format():
+    """Only jsonl and chrome traces are supported."""
+    with pytest.raises(ValueError):
+        LatencyTracer(trace_format="csv")
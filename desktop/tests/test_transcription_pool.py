@@ -0,0 +1,84 @@
+from __future__ import annotations
+import threading
+from unittest.mock import Mock
+from voice_input_service.core.transcription import TranscriptionEngine
+from voice_input_service.core.transcription_pool import TranscriptionPool, autotune_pool
+
+def test_autotune_pool_scales_with_cores():
+    """Auto sizing keeps at least four threads per worker and caps the worker count."""
+    assert autotune_pool(2) == (1, 2)
+    assert autotune_pool(8) == (2, 4)
+    assert autotune_pool(32) == (4, 8)
+    assert autotune_pool(8, workers=3) == (3, 2)
+    assert autotune_pool(8, workers=2, threads=6) == (2, 6)
+    assert autotune_pool(0) == (1, 1)
+
+def test_pool_delivers_in_submission_order():
+    """A job that finishes early waits for the slower job submitted before it."""
+    slow, fast = Mock(spec=TranscriptionEngine), Mock(spec=TranscriptionEngine)
+    slow_started, release_slow = threading.Event(), threading.Event()
+    fast_done = threading.Event()
+
+    def run(engine, audio):
+        if audio == b"first":
+            slow_started.set()
+            release_slow.wait(timeout=2.0)
+        else:
+            fast_done.set()
+        return None if audio == b"empty" else audio.decode()
+
+    delivered = []
+    pool = TranscriptionPool(slow, run, delivered.append)
+    try:
+        pool.submit(b"first")
+        assert slow_started.wait(timeout=2.0) # Held by the primary engine
+        pool.add_engine(fast)
+        pool.submit(b"second")
+        pool.submit(b"empty")
+        assert fast_done.wait(timeout=2.0)
+        assert delivered == []
+
+        release_slow.set()
+        assert pool.wait_idle(timeout=2.0)
+        assert delivered == ["first", "second"]
+    finally:
+        pool.close()
+
+def test_pool_replace_engines_retires_extras():
+    """Replacing engines returns the old primary and closes owned extra engines."""
+    primary, extra, replacement = (Mock(spec=TranscriptionEngine) for _ in range(3))
+    pool = TranscriptionPool(primary, lambda engine, audio: None, Mock())
+    pool.add_engine(extra)
+    extra_thread = pool._slots[1].thread
+    assert pool.size == 2
+
+    assert pool.replace_engines(replacement) is primary
+    assert pool.size == 1
+    extra_thread.join(timeout=1.0) # Retired slots close their engine on the way out
+    pool.close()
+    extra.close.assert_called_once()
+    primary.close.assert_not_called()
+    assert pool.submit(b"late") == -1
+
+def test_pool_close_drops_queued_jobs():
+    """Jobs still queued at close are discarded; the one in progress finishes."""
+    started, release = threading.Event(), threading.Event()
+    ran = []
+
+    def run(engine, audio):
+        ran.append(audio)
+        started.set()
+        release.wait(timeout=2.0)
+        return None
+
+    pool = TranscriptionPool(Mock(spec=TranscriptionEngine), run, Mock())
+    pool.submit(b"first")
+    assert started.wait(timeout=2.0)
+    pool.submit(b"second")
+    pool.submit(b"third")
+
+    pool.close()
+    assert pool._jobs.empty()
+    release.set()
+    pool._slots[0].thread.join(timeout=1.0)
+    assert ran == [b"first"]
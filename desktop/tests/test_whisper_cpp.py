@@ -0,0 +1,206 @@
+from __future__ import annotations
+import io
+import json
+import wave
+import pytest
+from unittest.mock import Mock, MagicMock, patch
+
+from voice_input_service.core import whisper_cpp
+from voice_input_service.core.whisper_cpp import (
+    WhisperCppServer,
+    wav_bytes,
+    resolve_server_path,
+    _encode_multipart,
+)
+
+AUDIO = b"\x00\x01" * 16000  # 1 second of 16-bit mono PCM
+
+@pytest.fixture
+def server_files(temp_dir):
+    """Create dummy server executable and model files."""
+    server_path = temp_dir / "whisper-server"
+    model_path = temp_dir / "ggml-base.en.bin"
+    server_path.write_bytes(b"")
+    model_path.write_bytes(b"")
+    return str(server_path), str(model_path)
+
+@pytest.fixture
+def running_server(server_files):
+    """Create a WhisperCppServer whose child process is mocked as alive."""
+    server_path, model_path = server_files
+    server = WhisperCppServer(server_path, model_path, port=8123)
+    server.process = Mock()
+    server.process.poll.return_value = None
+    return server
+
+def _http_response(payload: dict) -> MagicMock:
+    response = MagicMock()
+    response.read.return_value = json.dumps(payload).encode("utf-8")
+    response.__enter__.return_value = response
+    return response
+
+def test_wav_bytes_wraps_pcm_in_memory():
+    """wav_bytes produces a valid 16kHz mono WAV without touching disk."""
+    data = wav_bytes(AUDIO)
+    with wave.open(io.BytesIO(data), "rb") as wav_file:
+        assert wav_file.getnchannels() == 1
+        assert wav_file.getsampwidth() == 2
+        assert wav_file.getframerate() == 16000
+        assert wav_file.readframes(wav_file.getnframes()) == AUDIO
+
+def test_encode_multipart_contains_fields_and_file():
+    body, content_type = _encode_multipart({"language": "en"}, "file", "audio.wav", b"RIFFDATA")
+    boundary = content_type.split("boundary=")[1]
+    assert content_type.startswith("multipart/form-data")
+    assert f"--{boundary}--".encode() in body
+    assert b'name="language"\r\n\r\nen' in body
+    assert b'filename="audio.wav"' in body
+    assert b"RIFFDATA" in body
+
+def test_resolve_server_path(temp_dir):
+    cli_path = temp_dir / "whisper-cli"
+    cli_path.write_bytes(b"")
+    with patch("platform.system", return_value="Linux"):
+        assert resolve_server_path(str(cli_path)) is None
+        (temp_dir / "whisper-server").write_bytes(b"")
+        assert resolve_server_path(str(cli_path)) == str(temp_dir / "whisper-server")
+    assert resolve_server_path(None) is None
+
+def test_server_start_waits_for_port(server_files):
+    server_path, model_path = server_files
+    process = Mock()
+    process.poll.return_value = None
+    process.stderr = []
+    with patch("subprocess.Popen", return_value=process) as mock_popen, \
+         patch("socket.create_connection", side_effect=[OSError(), MagicMock()]):
+        server = WhisperCppServer(server_path, model_path, port=8123)
+        server.start()
+
+    cmd = mock_popen.call_args[0][0]
+    assert cmd[0] == server_path
+    assert cmd[cmd.index("-m") + 1] == model_path
+    assert cmd[cmd.index("--port") + 1] == "8123"
+    assert server.is_running()
+
+def test_server_start_fails_when_process_exits(server_files):
+    server_path, model_path = server_files
+    process = Mock()
+    process.poll.return_value = 1
+    process.returncode = 1
+    process.stderr = []
+    with patch("subprocess.Popen", return_value=process):
+        server = WhisperCppServer(server_path, model_path, port=8123)
+        with pytest.raises(RuntimeError):
+            server.start()
+
+def test_server_transcribe_posts_pcm(running_server):
+    payload = {"text": " hello", "segments": [{"start": 0.0, "end": 1.0, "text": " hello"}]}
+    with patch("urllib.request.urlopen", return_value=_http_response(payload)) as mock_urlopen:
+        result = running_server.transcribe(AUDIO, language="de")
+
+    assert result == payload
+    request = mock_urlopen.call_args[0][0]
+    assert request.full_url == "http://127.0.0.1:8123/inference"
+    assert b'name="language"\r\n\r\nde' in request.data
+    assert wav_bytes(AUDIO) in request.data
+
+def test_server_transcribe_sends_prompt(running_server):
+    with patch("urllib.request.urlopen", return_value=_http_response({"segments": []})) as mock_urlopen:
+        running_server.transcribe(AUDIO, prompt="previous words")
+
+    assert b'name="prompt"\r\n\r\nprevious words' in mock_urlopen.call_args[0][0].data
+
+def test_server_transcribe_reports_unreachable(running_server):
+    with patch("urllib.request.urlopen", side_effect=whisper_cpp.urllib.error.URLError("refused")):
+        result = running_server.transcribe(AUDIO)
+    assert "error" in result
+
+def test_server_transcribe_when_not_running(server_files):
+    server_path, model_path = server_files
+    server = WhisperCppServer(server_path, model_path)
+    assert "error" in server.transcribe(AUDIO)
+
+def test_engine_uses_resident_server():
+    """TranscriptionEngine routes chunks to the server and standardizes segments."""
+    from voice_input_service.core.transcription import TranscriptionEngine
+
+    engine = TranscriptionEngine.__new__(TranscriptionEngine)
+    engine.logger = Mock()
+    engine.loaded = True
+    engine.use_cpp = True
+    engine.language = "en"
+    engine.whisper_cpp_path = "whisper-cli"
+    engine.model_file_path = "ggml-base.en.bin"
+    engine.server = Mock()
+    engine.server.is_running.return_value = True
+    engine.server.transcribe.return_value = {
+        "language": "en",
+        "segments": [
+            {"start": 0.0, "end": 1.2, "text": " Hello"},
+            {"start": 1.2, "end": 2.0, "text": " world"},
+        ],
+    }
+
+    with patch("voice_input_service.core.transcription.whisper_cpp_transcribe") as mock_cli:
+        result = engine.transcribe(AUDIO)
+
+    mock_cli.assert_not_called()
+    assert result["text"] == "Hello world"
+    assert [s["start"] for s in result["segments"]] == [0.0, 1.2]
+    assert result["segments"][1]["end"] == 2.0
+
+def test_parse_segments_from_cli_stdout():
+    output = (
+        "[00:00:00.000 --> 00:00:01.500]   Hello there.\n"
+        "some unrelated line\n"
+        "[00:01:02.250 --> 00:01:04.000]   General Kenobi.\n"
+    )
+    segments = whisper_cpp.parse_segments(output)
+    assert segments == [
+        {"start": 0.0, "end": 1.5, "text": "Hello there."},
+        {"start": 62.25, "end": 64.0, "text": "General Kenobi."},
+    ]
+
+def test_cli_transcribe_pipes_pcm_without_temp_files(server_files):
+    """The CLI path sends WAV over stdin and never creates files."""
+    cli_path, model_path = server_files
+    completed = Mock()
+    completed.stdout = b"[00:00:00.000 --> 00:00:01.000]   Hi\n"
+    with patch("subprocess.run", return_value=completed) as mock_run, \
+         patch("platform.system", return_value="Linux"), \
+         patch("builtins.open") as mock_open:
+        result = whisper_cpp.transcribe(AUDIO, model_path, cli_path, language="en")
+
+    mock_open.assert_not_called()
+    cmd = mock_run.call_args[0][0]
+    assert cmd[cmd.index("-f") + 1] == "-"
+    assert mock_run.call_args[1]["input"] == wav_bytes(AUDIO)
+    assert result["segments"] == [{"start": 0.0, "end": 1.0, "text": "Hi"}]
+
+def test_cli_transcribe_passes_prompt(server_files):
+    cli_path, model_path = server_files
+    completed = Mock()
+    completed.stdout = b""
+    with patch("subprocess.run", return_value=completed) as mock_run, \
+         patch("platform.system", return_value="Linux"):
+        whisper_cpp.transcribe(AUDIO, model_path, cli_path, prompt="previous words")
+
+    cmd = mock_run.call_args[0][0]
+    assert cmd[cmd.index("--prompt") + 1] == "previous words"
+
+def test_prompt_tail_keeps_last_words_within_budget():
+    from voice_input_service.core.transcription import prompt_tail
+
+    text = "one two three four five"
+    assert prompt_tail(text, 0) == ""
+    assert prompt_tail(text, 4) == "four five"
+    assert prompt_tail(text, 100) == text
+
+def test_async_wav_writer_writes_off_thread(temp_dir):
+    writer = whisper_cpp.AsyncWavWriter()
+    target = temp_dir / "session.wav"
+    writer.submit(str(target), AUDIO)
+    writer.flush()
+    with wave.open(str(target), "rb") as wav_file:
+        assert wav_file.readframes(wav_file.getnframes()) == AUDIO
+    writer.close()
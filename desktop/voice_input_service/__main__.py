@@ -1,10 +1,16 @@
+import argparse
 import pyaudio
 import sys
 import logging
+import tkinter as tk
+from typing import List, Optional
 from .service import VoiceInputService
 from .config import Config
+from .core.batch import BatchTranscriber, WavFormatError
+from .core.benchmark import PipelineBenchmark
 from .core.model_manager import ModelManager
 from .ui.window import TranscriptionUI
+from .utils.silence_detection import SilenceDetector
 from .utils.logging import setup_logging
 
 def check_microphone() -> bool:
@@ -75,8 +81,109 @@ def initialize_app() -> tuple[Config, TranscriptionUI, ModelManager]:
     
     return config, ui, model_manager
 
-def main() -> None:
+def parse_args(argv: List[str]) -> argparse.Namespace:
+    """Parse command line options; unknown arguments are ignored."""
+    parser = argparse.ArgumentParser(prog="voice_input_service", description="Voice input service")
+    parser.add_argument("--transcribe", metavar="WAV", help="Transcribe a 16kHz 16-bit WAV file and exit")
+    parser.add_argument("--benchmark", metavar="WAV", nargs="?", const="",
+                        help="Benchmark every pipeline stage on a corpus tiled from WAV (synthetic audio if omitted) and exit")
+    parser.add_argument("--warmup", type=int, default=1, help="Untimed --benchmark runs per metric")
+    parser.add_argument("--repeats", type=int, default=5, help="Timed --benchmark runs per metric")
+    parser.add_argument("--output", metavar="PATH", help="Write the --transcribe transcript or --benchmark report here instead of stdout")
+    args, _ = parser.parse_known_args(argv)
+    return args
+
+def run_batch(wav_path: str, output_path: Optional[str] = None) -> int:
+    """Transcribe one file without the UI or microphone.
+    
+    Args:
+        wav_path: 16kHz 16-bit PCM WAV file.
+        output_path: Transcript file; printed to stdout if None.
+    
+    Returns:
+        Process exit code.
+    """
+    logger = setup_logging()
+    config = Config.load()
+    
+    # Hidden root for the model selection dialogs, shown only if no model is available
+    root = tk.Tk()
+    root.withdraw()
+    transcriber = None
+    detector = None
+    try:
+        transcriber = ModelManager(root, config).initialize_transcription_engine()
+        if not transcriber:
+            print("\nNo transcription model was selected or model initialization failed.")
+            return 1
+        
+        # Segment with Silero VAD like the live path (energy gate if it fails to load)
+        detector = SilenceDetector(config)
+        text = BatchTranscriber(config, transcriber, silence_detector=detector).transcribe_file(wav_path)
+        if output_path:
+            with open(output_path, "w", encoding="utf-8") as f:
+                f.write(text)
+            print(f"Transcript written to {output_path}")
+        else:
+            print(text)
+        return 0
+    except (OSError, WavFormatError) as e:
+        logger.error(f"Batch transcription failed: {e}")
+        print(f"\nError: {e}")
+        return 1
+    finally:
+        if detector:
+            detector.close()
+        if transcriber:
+            transcriber.close()
+        root.destroy()
+
+def run_benchmark(wav_path: Optional[str], output_path: Optional[str] = None, warmup: int = 1, repeats: int = 5) -> int:
+    """Run the pipeline benchmark and write its JSON report.
+    
+    Args:
+        wav_path: 16kHz 16-bit PCM WAV tiled into the corpus; synthetic audio if None.
+        output_path: Report file; printed to stdout if None.
+        warmup: Untimed runs per metric.
+        repeats: Timed runs per metric.
+    
+    Returns:
+        Process exit code.
+    """
+    logger = setup_logging()
+    config = Config.load()
+    
+    # Hidden root for the model selection dialogs, shown only if no model is available
+    root = tk.Tk()
+    root.withdraw()
+    try:
+        model_manager = ModelManager(root, config)
+        benchmark = PipelineBenchmark(
+            config, model_manager.initialize_transcription_engine, wav_path or None, warmup=warmup, repeats=repeats
+        )
+        report = benchmark.run().to_json()
+        if output_path:
+            with open(output_path, "w", encoding="utf-8") as f:
+                f.write(report)
+            print(f"Benchmark report written to {output_path}")
+        else:
+            print(report)
+        return 0
+    except (OSError, ValueError, RuntimeError) as e:
+        logger.error(f"Benchmark failed: {e}")
+        print(f"\nError: {e}")
+        return 1
+    finally:
+        root.destroy()
+
+def main(argv: Optional[List[str]] = None) -> None:
     """Main entry point for the voice input service."""
+    args = parse_args(sys.argv[1:] if argv is None else argv)
+    if args.transcribe:
+        sys.exit(run_batch(args.transcribe, args.output))
+    if args.benchmark is not None:
+        sys.exit(run_benchmark(args.benchmark, args.output, args.warmup, args.repeats))
+    
     if not check_microphone():
         print("\nMicrophone check failed. Please fix the issues and try again.")
         sys.exit(1)
@@ -97,7 +204,7 @@ def main() -> None:
             
         # Step 3: Create and run service
         logger.info("Creating voice input service")
-        service = VoiceInputService(config, ui, transcriber)
+        service = VoiceInputService(config, ui, transcriber, model_manager=model_manager)
         service.run()
         
     except KeyboardInterrupt:
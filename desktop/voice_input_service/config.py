@@ -22,6 +22,7 @@ class AudioConfig(BaseModel):
     # Voice Activity Detection settings (used by worker in continuous mode)
     vad_mode: Literal["silero"] = Field("silero", description="Voice activity detection mode (only silero supported currently)")
     vad_threshold: float = Field(0.5, description="Silero VAD threshold (0.0-1.0, higher = less sensitive)")
+    vad_model_path: Optional[str] = Field(None, description="Silero VAD ONNX model (None: models/silero_vad.onnx, downloaded on first use)")
     silence_duration_sec: float = Field(2.0, description="Duration of silence (seconds) after speech to trigger processing in continuous mode")
     max_chunk_duration_sec: float = Field(15.0, description="Maximum duration (seconds) of a single audio chunk before forcing processing in continuous mode")
     
@@ -61,6 +62,21 @@ class TranscriptionConfig(BaseModel):
     use_cpp: bool = Field(True, description="Whether to use whisper.cpp instead of Python Whisper")
     whisper_cpp_path: str = Field("C:\\Users\\Cicada38\\Projects\\whisper.cpp\\build\\bin\\Release\\whisper-cli.exe", description="Path to the whisper.cpp executable")
     ggml_model_path: Optional[str] = Field(None, description="Path to specific GGML model file (if not specified, attempts auto-find)")
+    use_server: bool = Field(True, description="Keep the GGML model resident in a whisper.cpp server process instead of one subprocess per chunk")
+    whisper_server_path: Optional[str] = Field(None, description="Path to the whisper.cpp server executable (if not specified, looks next to whisper_cpp_path)")
+    server_port: int = Field(0, description="Local port for the whisper.cpp server (0 = pick a free port)")
+    server_threads: Optional[int] = Field(None, description="Decoder threads for the whisper.cpp server (None = whisper.cpp default)")
+    server_startup_timeout_sec: float = Field(30.0, description="Maximum time (seconds) to wait for the whisper.cpp server to load the model")
+    pool_workers: int = Field(0, ge=0, description="Resident whisper.cpp servers transcribing speech segments in parallel (0 = auto from CPU cores)")
+    pool_threads_per_worker: int = Field(0, ge=0, description="Decoder threads for each additional pool server (0 = CPU cores / workers)")
+    
+    # Prompt carry-over between chunks
+    prompt_carryover: bool = Field(True, description="Pass the tail of the transcript so far as the prompt for the next chunk")
+    prompt_max_tokens: int = Field(64, ge=0, le=224, description="Approximate token budget for the carried-over prompt (whisper allows up to 224)")
+    
+    # Adaptive model tier
+    adaptive_model: bool = Field(True, description="Switch to the next smaller available model when transcription falls behind real time")
+    adaptive_rtf_threshold: float = Field(1.0, gt=0, description="Rolling real-time factor (processing time / audio duration) that triggers the switch")
     
     @field_validator('model_name')
     @classmethod
@@ -114,6 +130,8 @@ class Config(BaseModel):
     debug: bool = Field(False, description="Enable debug mode")
     log_level: str = Field("INFO", description="Logging level")
     data_dir: Path = Field(default_factory=lambda: Path.home() / ".voice_input_service")
+    trace_file: Optional[Path] = Field(None, description="File to write latency trace spans to (None = percentiles only)")
+    trace_format: str = Field("jsonl", description="Trace file format: jsonl (one span per line) or chrome (chrome://tracing, Perfetto)")
     
     @field_validator('log_level')
     @classmethod
@@ -123,6 +141,14 @@ class Config(BaseModel):
             raise ValueError(f"Log level must be one of {valid_levels}, got {v}")
         return v.upper()
     
+    @field_validator('trace_format')
+    @classmethod
+    def validate_trace_format(cls, v: str) -> str:
+        valid_formats = ["jsonl", "chrome"]
+        if v not in valid_formats:
+            raise ValueError(f"Trace format must be one of {valid_formats}, got {v}")
+        return v
+    
     @field_validator('data_dir')
     @classmethod
     def validate_data_dir(cls, v: Path) -> Path:
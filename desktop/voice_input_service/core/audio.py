@@ -10,6 +10,80 @@ import threading
 import time
 from typing import Any, Optional, Callable, Dict, Tuple
 
+# Lock-free SPSC byte ring from the native core (native/src/spsc_ring.cpp); its write()
+# copies without holding the GIL, so the PortAudio callback stays short
+try:
+    from voice_input_service._voiceinput_core import AudioRingBuffer
+except ImportError:
+    class AudioRingBuffer:
+        """Single-producer, single-consumer byte ring between the PortAudio callback and one reader.
+
+        The buffer is allocated once. The writer only advances the write position and the
+        reader only the read position, so neither side takes a lock; each copies into or out
+        of the preallocated buffer. A write that does not fit is dropped whole and counted,
+        never blocking the callback or overwriting unread audio. Pure-Python copy of
+        native/src/spsc_ring.cpp for source checkouts without the built extension.
+        """
+
+        def __init__(self, capacity: int) -> None:
+            """Initialize the ring.
+
+            Args:
+                capacity: Size in bytes.
+            """
+            self.capacity = capacity
+            self._buffer = bytearray(capacity)
+            self._view = memoryview(self._buffer)
+            self._write = 0 # Total bytes written; only the producer assigns it
+            self._read = 0  # Total bytes read; only the consumer assigns it
+            self.overflows = 0      # Writes dropped because the ring was full
+            self.dropped_bytes = 0
+            self.max_fill = 0       # High-water mark in bytes
+
+        def __len__(self) -> int:
+            return self._write - self._read
+
+        def write(self, data: bytes) -> bool:
+            """Copy data in (producer side).
+
+            Returns:
+                False if it did not fit and was dropped.
+            """
+            size = len(data)
+            write = self._write
+            fill = write - self._read
+            if fill + size > self.capacity:
+                self.overflows += 1
+                self.dropped_bytes += size
+                return False
+            start = write % self.capacity
+            first = min(size, self.capacity - start)
+            source = memoryview(data)
+            self._view[start:start + first] = source[:first]
+            if first < size:
+                self._view[:size - first] = source[first:]
+            self._write = write + size # Publish only after the bytes are in place
+            if fill + size > self.max_fill:
+                self.max_fill = fill + size
+            return True
+
+        def read(self) -> bytes:
+            """Copy out everything written so far (consumer side); empty if nothing is pending."""
+            read = self._read
+            size = self._write - read
+            if size == 0:
+                return b""
+            start = read % self.capacity
+            first = min(size, self.capacity - start)
+            data = bytes(self._view[start:start + first])
+            if first < size:
+                data += bytes(self._view[:size - first])
+            self._read = read + size # Frees the space for the producer
+            return data
+
+# Capture the ring can hold before the drain thread must have caught up
+RING_SECONDS = 5.0
+
 class AudioRecorder:
     """Handles audio recording and processing."""
     
@@ -50,6 +124,9 @@ class AudioRecorder:
         self.stream: Optional[pyaudio.Stream] = None
         self.audio_data = bytearray()
         self.lock = threading.Lock()
+        self.input_overflows = 0 # Overflows reported by PortAudio
+        self._drain_thread: Optional[threading.Thread] = None
+        self._drain_stop = threading.Event()
         
         # Get actual device capabilities
         if device_index is not None:
@@ -62,6 +139,10 @@ class AudioRecorder:
         else:
             self.device_sample_rate = sample_rate
         
+        # Callback -> drain thread handoff, sized for RING_SECONDS of device-rate audio
+        frame_bytes = channels * pyaudio.get_sample_size(format_type)
+        self.ring = AudioRingBuffer(max(int(self.device_sample_rate * RING_SECONDS), 2 * chunk_size) * frame_bytes)
+        
     def __del__(self) -> None:
         """Clean up resources when the object is destroyed."""
         self.stop()
@@ -92,6 +173,11 @@ class AudioRecorder:
             
         try:
             self.audio_data = bytearray()
+            self.ring = AudioRingBuffer(self.ring.capacity) # No producer yet: safe to replace
+            self.input_overflows = 0
+            self._drain_stop.clear()
+            self._drain_thread = threading.Thread(target=self._drain_loop, daemon=True)
+            self._drain_thread.start()
             
             # Start the audio stream
             self.stream = self.py_audio.open(
@@ -111,6 +197,7 @@ class AudioRecorder:
         except Exception as e:
             self.logger.error(f"Failed to start recording: {e}")
             self.is_recording = False
+            self._stop_drain()
             return False
             
     def stop(self) -> bytes:
@@ -128,7 +215,12 @@ class AudioRecorder:
             self.stream = None
             
         self.is_recording = False
-        self.logger.info("Recording stopped")
+        self._stop_drain() # Delivers whatever the callback wrote last
+        stats = self.capture_stats()
+        if stats["ring_overflows"] or stats["input_overflows"]:
+            self.logger.warning(f"Recording stopped with capture overflows: {stats}")
+        else:
+            self.logger.info(f"Recording stopped (peak ring fill {stats['max_fill_bytes']}/{stats['capacity_bytes']} bytes)")
         
         with self.lock:
             # Resample if needed
@@ -160,7 +252,10 @@ class AudioRecorder:
         time_info: Dict[str, float], 
         status: int
     ) -> tuple[bytes, int]:
-        """Process audio data from the stream.
+        """Hand audio from the stream to the drain thread (PortAudio thread).
+        
+        Only copies into the preallocated ring: no locks, logging, resampling or callbacks,
+        so a busy interpreter cannot stall capture into an input overflow.
         
         Args:
             in_data: Audio data from PyAudio
@@ -169,10 +264,37 @@ class AudioRecorder:
             status: Status flag
             
         Returns:
-            Tuple of (in_data, flag) where flag indicates if more data is expected
+            Tuple of (None, flag) where flag indicates if more data is expected
+        """
+        if status & pyaudio.paInputOverflow:
+            self.input_overflows += 1
+        self.ring.write(in_data)
+        return None, pyaudio.paContinue
+    
+    def _drain_loop(self) -> None:
+        """Move captured audio to the buffer and the data callback until stopped."""
+        interval = self.chunk_size / self.device_sample_rate / 4
+        while not self._drain_stop.is_set():
+            if not self._drain():
+                self._drain_stop.wait(interval)
+        self._drain()
+    
+    def _stop_drain(self) -> None:
+        """Stop the drain thread after it has delivered everything pending."""
+        self._drain_stop.set()
+        thread, self._drain_thread = self._drain_thread, None
+        if thread and thread is not threading.current_thread():
+            thread.join()
+    
+    def _drain(self) -> bool:
+        """Deliver pending ring audio once (ring consumer side).
+        
+        Returns:
+            True if there was audio.
         """
-        if status:
-            self.logger.warning(f"Audio callback status: {status}")
+        in_data = self.ring.read()
+        if not in_data:
+            return False
             
         # Append data to our buffer
         with self.lock:
@@ -189,8 +311,24 @@ class AudioRecorder:
                 self.on_data_callback(in_data)
             except Exception as e:
                 self.logger.error(f"Error in audio data callback: {e}")
+        return True
+    
+    def capture_stats(self) -> Dict[str, int]:
+        """Overflow counters of the current (or last) recording.
         
-        return in_data, pyaudio.paContinue
+        Returns:
+            ring_overflows / ring_dropped_bytes: callback writes dropped because the drain
+            thread fell RING_SECONDS behind; input_overflows: overflows reported by PortAudio;
+            max_fill_bytes / capacity_bytes: ring high-water mark and size.
+        """
+        ring = self.ring
+        return {
+            "ring_overflows": ring.overflows,
+            "ring_dropped_bytes": ring.dropped_bytes,
+            "input_overflows": self.input_overflows,
+            "max_fill_bytes": ring.max_fill,
+            "capacity_bytes": ring.capacity,
+        }
         
     def get_audio_data(self) -> bytes:
         """Get a copy of the current audio data.
@@ -0,0 +1,296 @@
+"""Offline transcription of complete audio files."""
+from __future__ import annotations
+import logging
+import mmap
+import struct
+import time
+from typing import Callable, List, Optional, Tuple
+import numpy as np
+
+from voice_input_service.config import Config
+from voice_input_service.core.transcription import TranscriptionEngine, prompt_tail
+from voice_input_service.utils.silence_detection import SilenceDetector
+from voice_input_service.utils.text_processor import TextProcessor, Transcript
+
+FRAME_MS = 100
+SILENCE_RMS = 0.01
+# Whisper's input length; offline windows are packed up to it rather than the live chunk limit
+MAX_WINDOW_SEC = 30.0
+# Frames kept around each speech region so word edges are not clipped
+PAD_FRAMES = 2
+
+class WavFormatError(ValueError):
+    """Raised for WAV files the batch transcriber cannot read without conversion."""
+    pass
+
+class MappedWav:
+    """16-bit PCM samples of a WAV file, memory-mapped instead of read into memory.
+
+    Mono files are exposed as a zero-copy int16 view of the mapping; stereo files are
+    downmixed, which allocates one mono copy.
+    """
+
+    def __init__(self, path: str) -> None:
+        """Map a WAV file.
+
+        Args:
+            path: Path to a 16-bit PCM WAV file.
+
+        Raises:
+            WavFormatError: If the file is not 16-bit PCM WAV.
+            OSError: If the file cannot be opened.
+        """
+        self.path = path
+        self.samples = np.zeros(0, dtype=np.int16)
+        self._map: Optional[mmap.mmap] = None
+        self._file = open(path, "rb")
+        try:
+            self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        except ValueError as e:  # Empty file
+            self._file.close()
+            raise WavFormatError(f"Not a WAV file: {path}") from e
+        try:
+            self.sample_rate, self.channels, offset, length = self._parse_header()
+            frames = np.frombuffer(self._map, dtype="<i2", count=length // 2, offset=offset)
+            if self.channels == 1:
+                self.samples = frames
+            else:
+                usable = len(frames) - len(frames) % self.channels
+                self.samples = frames[:usable].reshape(-1, self.channels).mean(axis=1).astype(np.int16)
+        except Exception:
+            self.close()
+            raise
+
+    def _parse_header(self) -> Tuple[int, int, int, int]:
+        """Walk the RIFF chunks; returns (sample_rate, channels, data_offset, data_length)."""
+        data = self._map
+        if len(data) < 12 or data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+            raise WavFormatError(f"Not a WAV file: {self.path}")
+
+        fmt: Optional[Tuple[int, int, int, int]] = None
+        pos = 12
+        while pos + 8 <= len(data):
+            chunk_id = data[pos:pos + 4]
+            size = struct.unpack_from("<I", data, pos + 4)[0]
+            body = pos + 8
+            if chunk_id == b"fmt " and size >= 16:
+                audio_format, channels, rate, _, _, bits = struct.unpack_from("<HHIIHH", data, body)
+                fmt = (audio_format, channels, rate, bits)
+            elif chunk_id == b"data":
+                if fmt is None:
+                    raise WavFormatError(f"WAV data before format chunk: {self.path}")
+                audio_format, channels, rate, bits = fmt
+                # 0xFFFE = WAVE_FORMAT_EXTENSIBLE, used by some recorders for plain PCM
+                if audio_format not in (1, 0xFFFE) or bits != 16 or channels < 1:
+                    raise WavFormatError(f"Only 16-bit PCM WAV is supported, got format {audio_format} with {bits} bits")
+                return rate, channels, body, min(size, len(data) - body)
+            pos = body + size + (size & 1)  # Chunks are word aligned
+        raise WavFormatError(f"WAV file has no data chunk: {self.path}")
+
+    @property
+    def duration_sec(self) -> float:
+        """Duration of the audio in seconds."""
+        return len(self.samples) / self.sample_rate
+
+    def close(self) -> None:
+        """Release the mapping."""
+        self.samples = np.zeros(0, dtype=np.int16)  # Drop the view before closing the map
+        if self._map is not None:
+            try:
+                self._map.close()
+            except BufferError:
+                pass  # A caller still holds a view of the samples; the map is freed with it
+            self._map = None
+        self._file.close()
+
+    def __enter__(self) -> MappedWav:
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+def energy_silence(samples: np.ndarray, frame_samples: int, threshold: float = SILENCE_RMS) -> np.ndarray:
+    """Silence flag per frame from its RMS level, in one vectorized pass.
+
+    Args:
+        samples: int16 mono samples.
+        frame_samples: Samples per frame (the last frame may be short).
+        threshold: RMS (0.0-1.0 of full scale) below which a frame is silent.
+
+    Returns:
+        Boolean array, True for silent frames.
+    """
+    frames = -(-len(samples) // frame_samples)
+    padded = np.zeros(frames * frame_samples, dtype=np.float32)
+    padded[:len(samples)] = samples
+    power = np.square(padded.reshape(frames, frame_samples) / 32768.0).sum(axis=1)
+    counts = np.full(frames, frame_samples, dtype=np.float32)
+    if frames and len(samples) % frame_samples:
+        counts[-1] = len(samples) % frame_samples
+    return np.sqrt(power / counts) < threshold
+
+def segment_frames(silent: np.ndarray, min_silence_frames: int, max_window_frames: int) -> List[Tuple[int, int]]:
+    """Cut a recording into transcription windows, in frames.
+
+    Speech regions end at a run of at least min_silence_frames silent frames and are padded
+    by PAD_FRAMES. Consecutive regions are packed into one window while it stays within
+    max_window_frames; a single longer region is split at its last silent frame in the final
+    third, or hard at the limit if it has none.
+
+    Args:
+        silent: Silence flag per frame.
+        min_silence_frames: Pause length that ends a speech region.
+        max_window_frames: Longest window.
+
+    Returns:
+        (start, end) frame ranges, end exclusive.
+    """
+    if max_window_frames < 3:
+        raise ValueError(f"Windows must span at least 3 frames, got {max_window_frames}")
+    frames = len(silent)
+
+    regions: List[List[int]] = []
+    region_start = -1
+    last_speech = -1
+    for i in range(frames):
+        if not silent[i]:
+            if region_start < 0:
+                region_start = i
+            last_speech = i
+        elif region_start >= 0 and i - last_speech >= min_silence_frames:
+            regions.append([region_start, last_speech + 1])
+            region_start = -1
+    if region_start >= 0:
+        regions.append([region_start, last_speech + 1])
+    for region in regions:
+        region[0] = max(0, region[0] - PAD_FRAMES)
+        region[1] = min(frames, region[1] + PAD_FRAMES)
+
+    windows: List[Tuple[int, int]] = []
+    window_start = window_end = -1
+    for region_start, end in regions:
+        start = max(region_start, window_end)  # Padding may overlap the previous window
+        if window_start >= 0 and end - window_start <= max_window_frames:
+            window_end = end
+            continue
+        if window_start >= 0:
+            windows.append((window_start, window_end))
+
+        while end - start > max_window_frames:
+            limit = start + max_window_frames
+            cut = limit
+            for i in range(limit - 1, start + max_window_frames * 2 // 3 - 1, -1):
+                if silent[i]:
+                    cut = i + 1
+                    break
+            windows.append((start, cut))
+            start = cut
+        window_start, window_end = start, end
+    if window_start >= 0:
+        windows.append((window_start, window_end))
+    return windows
+
+class BatchTranscriber:
+    """Transcribes whole files as fast as the engine allows.
+
+    The live worker replays audio chunk by chunk; here the file is segmented in one pass
+    (Silero VAD when available, an energy gate otherwise) into windows of up to 30 s cut in
+    pauses, which are sent to the engine back to back with the usual prompt carry-over.
+    """
+
+    def __init__(
+        self,
+        config: Config,
+        transcriber: TranscriptionEngine,
+        silence_detector: Optional[SilenceDetector] = None,
+        text_processor: Optional[TextProcessor] = None
+    ) -> None:
+        """Initialize the batch transcriber.
+
+        Args:
+            config: Application configuration (silence duration, prompt settings).
+            transcriber: Loaded transcription engine.
+            silence_detector: VAD used for segmentation; energy gate if None or not initialized.
+            text_processor: Text cleanup and joining; a default one if None.
+        """
+        self.logger = logging.getLogger("VoiceService.Batch")
+        self.config = config
+        self.transcriber = transcriber
+        self.silence_detector = silence_detector
+        self.text_processor = text_processor or TextProcessor()
+
+    def segment(self, samples: np.ndarray, sample_rate: int) -> List[Tuple[int, int]]:
+        """Transcription windows of a recording as (start, end) sample ranges."""
+        frame_samples = sample_rate * FRAME_MS // 1000
+        detector = self.silence_detector
+        if detector is not None and detector._initialized:
+            silent = detector.silent_frames(samples, frame_samples)
+        else:
+            silent = energy_silence(samples, frame_samples)
+
+        min_silence = max(1, int(self.config.audio.silence_duration_sec * 1000 / FRAME_MS))
+        max_window = int(MAX_WINDOW_SEC * 1000 / FRAME_MS)
+        min_samples = self.config.transcription.min_chunk_size_bytes // 2
+        windows = []
+        for start, end in segment_frames(silent, min_silence, max_window):
+            start, end = start * frame_samples, min(len(samples), end * frame_samples)
+            if end - start >= min_samples:
+                windows.append((start, end))
+        return windows
+
+    def transcribe_samples(
+        self,
+        samples: np.ndarray,
+        sample_rate: int = 16000,
+        on_progress: Optional[Callable[[int, int, str], None]] = None
+    ) -> str:
+        """Transcribe int16 mono samples.
+
+        Args:
+            samples: Audio samples (16kHz for whisper).
+            sample_rate: Sample rate of samples.
+            on_progress: Called with (window index, window count, text so far) after each window.
+
+        Returns:
+            The joined transcript.
+        """
+        windows = self.segment(samples, sample_rate)
+        self.logger.info(f"Transcribing {len(samples) / sample_rate:.1f}s of audio in {len(windows)} windows")
+
+        transcript = Transcript(self.text_processor)
+        prompt_context = ""
+        carryover = self.config.transcription.prompt_carryover
+        max_tokens = self.config.transcription.prompt_max_tokens
+        for index, (start, end) in enumerate(windows):
+            prompt_args = {"prompt": prompt_context} if carryover and prompt_context else {}
+            try:
+                result = self.transcriber.transcribe(audio=samples[start:end].tobytes(), **prompt_args)
+            except Exception as e:
+                self.logger.error(f"Window {index + 1}/{len(windows)} failed: {e}")
+                continue
+
+            text = self.text_processor.remove_timestamps(result.get("text", "").strip())
+            text = self.text_processor.filter_hallucinations(text) if text else ""
+            if text:
+                prompt_context = prompt_tail(f"{prompt_context} {text}", max_tokens)
+                transcript.append(text)
+            if on_progress:
+                on_progress(index + 1, len(windows), transcript.text())
+        return transcript.text()
+
+    def transcribe_file(self, path: str, on_progress: Optional[Callable[[int, int, str], None]] = None) -> str:
+        """Transcribe a 16kHz 16-bit PCM WAV file.
+
+        Raises:
+            WavFormatError: If the file is not 16-bit PCM WAV at the engine's 16kHz.
+        """
+        start_time = time.perf_counter()
+        with MappedWav(path) as wav:
+            if wav.sample_rate != 16000:
+                raise WavFormatError(f"Expected 16000 Hz audio, got {wav.sample_rate} Hz; convert the file first")
+            transcript = self.transcribe_samples(wav.samples, wav.sample_rate, on_progress)
+            duration = wav.duration_sec
+        elapsed = time.perf_counter() - start_time
+        rtf = elapsed / duration if duration > 0 else 0.0
+        self.logger.info(f"Transcribed {duration:.1f}s in {elapsed:.1f}s (RTF {rtf:.2f})")
+        return transcript
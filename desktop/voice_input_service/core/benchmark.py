@@ -0,0 +1,356 @@
+"""Reproducible benchmark of every pipeline stage, reported as JSON.
+
+The report layout matches the Android benchmark (PipelineBenchmark / BenchmarkReport), so
+reports from two builds, or from the two platforms, can be diffed metric by metric.
+"""
+from __future__ import annotations
+import glob
+import json
+import logging
+import math
+import os
+import platform
+import sys
+import time
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from typing import Callable, Dict, List, Optional
+
+import numpy as np
+
+from voice_input_service.config import Config
+from voice_input_service.core.batch import BatchTranscriber, MappedWav, MAX_WINDOW_SEC
+from voice_input_service.core.processing import TranscriptionWorker
+from voice_input_service.core.transcription import TranscriptionEngine
+from voice_input_service.utils import tracing
+from voice_input_service.utils.silence_detection import SilenceDetector
+from voice_input_service.utils.text_processor import TextProcessor, Transcript
+from voice_input_service.utils.tracing import LatencyTracer, percentile
+
+try:
+    import resource
+except ImportError: # Windows
+    resource = None
+
+SCHEMA_VERSION = 1
+CORPUS_SEC = (5, 15, 30, 120)
+STREAMING_CLIP_SEC = 15
+STREAMING_CHUNK_SEC = 0.1
+SAMPLE_RATE = 16000
+
+def stat_summary(unit: str, samples: List[float]) -> Dict[str, float]:
+    """Count, min, mean, p50/p95/p99 and max of samples (same fields as Android's BenchmarkStat)."""
+    if not samples:
+        raise ValueError(f"No samples for a {unit} metric")
+    values = sorted(samples)
+    return {
+        "unit": unit,
+        "count": len(values),
+        "min": values[0],
+        "mean": sum(values) / len(values),
+        "p50": percentile(values, 50),
+        "p95": percentile(values, 95),
+        "p99": percentile(values, 99),
+        "max": values[-1],
+    }
+
+class BenchmarkSamples:
+    """Collects samples per metric while a benchmark runs."""
+
+    def __init__(self) -> None:
+        self._samples: Dict[str, tuple[str, List[float]]] = {}
+
+    def add(self, metric: str, unit: str, value: float) -> None:
+        self._samples.setdefault(metric, (unit, []))[1].append(value)
+
+    def stats(self) -> Dict[str, Dict[str, float]]:
+        return {metric: stat_summary(unit, values) for metric, (unit, values) in self._samples.items()}
+
+@dataclass
+class BenchmarkReport:
+    """Benchmark results; to_json() uses the Android report's field names."""
+    platform: str
+    build: str
+    device: str
+    model: str
+    started_at: str
+    warmup: int
+    repeats: int
+    corpus_sec: List[int]
+    thermal_state: str
+    peak_rss_kb: Optional[int]
+    metrics: Dict[str, Dict[str, float]]
+    notes: Dict[str, str] = field(default_factory=dict)
+    schema: int = SCHEMA_VERSION
+
+    _JSON_KEYS = {"started_at": "startedAt", "corpus_sec": "corpusSec", "thermal_state": "thermalState", "peak_rss_kb": "peakRssKb"}
+
+    def to_json(self) -> str:
+        data = {self._JSON_KEYS.get(key, key): value for key, value in self.__dict__.items()}
+        return json.dumps(data, indent=2)
+
+    @classmethod
+    def from_json(cls, text: str) -> BenchmarkReport:
+        keys = {json_key: key for key, json_key in cls._JSON_KEYS.items()}
+        return cls(**{keys.get(key, key): value for key, value in json.loads(text).items()})
+
+def parse_peak_rss_kb(proc_status: str) -> Optional[int]:
+    """Peak resident set size (VmHWM) from the contents of /proc/<pid>/status, or None."""
+    for line in proc_status.splitlines():
+        if line.startswith("VmHWM:"):
+            try:
+                return int(line.split()[1])
+            except (IndexError, ValueError):
+                return None
+    return None
+
+def tile_clip(source: np.ndarray, seconds: int, sample_rate: int = SAMPLE_RATE) -> np.ndarray:
+    """source repeated (or cut) to exactly seconds of audio."""
+    return np.resize(source, seconds * sample_rate).astype(np.int16)
+
+def synthetic_audio(seconds: int, sample_rate: int = SAMPLE_RATE) -> np.ndarray:
+    """Speech-band tones, for benchmarking without a recording."""
+    t = np.arange(seconds * sample_rate) / sample_rate
+    wave = 0.3 * np.sin(2 * np.pi * 200 * t) + 0.2 * np.sin(2 * np.pi * 800 * t)
+    return (wave * 10000).astype(np.int16)
+
+class PipelineBenchmark:
+    """Runs a fixed corpus through each stage with warm-up and repeated timed runs.
+
+    Metrics (see the Android PipelineBenchmark for the shared names):
+    - init.cold / init.warm: first engine start in the process, then restarts
+    - transcribe.<n>s: one engine call per clip up to 30 s; whisper.cpp encodes and decodes
+      in one request, so there are no separate encode or per-token decode metrics here
+    - vad.per_frame: Silero VAD per frame
+    - stitch.per_append: Transcript.append per segment
+    - streaming.lag_p50 / streaming.lag_p95: end-to-end trace stage with the 15 s clip fed
+      to the live worker at real-time pace
+    - file.<n>s_rtf: BatchTranscriber over every clip
+    """
+
+    def __init__(
+        self,
+        config: Config,
+        engine_factory: Callable[[], Optional[TranscriptionEngine]],
+        wav_path: Optional[str] = None,
+        warmup: int = 1,
+        repeats: int = 5,
+        corpus_sec: tuple[int, ...] = CORPUS_SEC
+    ) -> None:
+        """Initialize the benchmark.
+
+        Args:
+            config: Application configuration.
+            engine_factory: Starts a loaded engine (None on failure); called for every init run.
+            wav_path: 16kHz 16-bit WAV tiled into the corpus clips; synthetic audio if None.
+            warmup: Untimed runs before the timed ones.
+            repeats: Timed runs per metric.
+            corpus_sec: Clip lengths in seconds.
+        """
+        if warmup < 0 or repeats <= 0:
+            raise ValueError(f"Need warmup >= 0 and repeats > 0, got {warmup} and {repeats}")
+        if not corpus_sec or any(sec <= 0 for sec in corpus_sec):
+            raise ValueError(f"Corpus clip lengths must be positive: {corpus_sec}")
+        self.logger = logging.getLogger("VoiceService.Benchmark")
+        self.config = config
+        self.engine_factory = engine_factory
+        self.wav_path = wav_path
+        self.warmup = warmup
+        self.repeats = repeats
+        self.corpus_sec = tuple(corpus_sec)
+        self.samples = BenchmarkSamples()
+        self.notes: Dict[str, str] = {}
+
+    def run(self) -> BenchmarkReport:
+        """Run the whole suite; takes several minutes."""
+        self.logger.info(f"Pipeline benchmark: corpus {list(self.corpus_sec)}s, warmup {self.warmup}, repeats {self.repeats}")
+        started_at = datetime.now(timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ")
+        thermal_before = thermal_state()
+        corpus = self._build_corpus()
+
+        engine = self._benchmark_init()
+        try:
+            self._benchmark_transcribe(engine, corpus)
+            self._benchmark_vad(corpus)
+            self._benchmark_stitch()
+            self._benchmark_streaming(engine, corpus)
+            self._benchmark_file(engine, corpus)
+            peak_rss = peak_rss_kb()
+            server_rss = self._server_peak_rss_kb(engine)
+            if server_rss is not None:
+                self.notes["peak_rss_kb.server"] = str(server_rss)
+            model = engine.model_name
+        finally:
+            engine.close()
+
+        thermal_after = thermal_state()
+        report = BenchmarkReport(
+            platform="desktop",
+            build=_package_version(),
+            device=f"{platform.system()} {platform.machine()} ({os.cpu_count()} cores)",
+            model=model,
+            started_at=started_at,
+            warmup=self.warmup,
+            repeats=self.repeats,
+            corpus_sec=list(self.corpus_sec),
+            thermal_state=thermal_after if thermal_before == thermal_after else f"{thermal_before}->{thermal_after}",
+            peak_rss_kb=peak_rss,
+            metrics=self.samples.stats(),
+            notes=self.notes
+        )
+        self.logger.info(f"Benchmark complete: {len(report.metrics)} metrics, thermal {report.thermal_state}, peak RSS {peak_rss} kB")
+        return report
+
+    def _measure(self, metric: str, unit: str, run: Callable[[], float]) -> None:
+        """Call run warmup times untimed, then repeats times, recording what it returns."""
+        for _ in range(self.warmup):
+            run()
+        for _ in range(self.repeats):
+            self.samples.add(metric, unit, run())
+
+    @staticmethod
+    def _elapsed_ms(run: Callable[[], object]) -> float:
+        start = time.perf_counter_ns()
+        run()
+        return (time.perf_counter_ns() - start) / 1e6
+
+    def _start_engine(self) -> TranscriptionEngine:
+        engine = self.engine_factory()
+        if engine is None:
+            raise RuntimeError("Transcription engine failed to start")
+        return engine
+
+    def _benchmark_init(self) -> TranscriptionEngine:
+        self.logger.info("Engine initialization")
+        start = time.perf_counter_ns()
+        engine = self._start_engine()
+        self.samples.add("init.cold", "ms", (time.perf_counter_ns() - start) / 1e6)
+        for _ in range(self.repeats):
+            engine.close()
+            start = time.perf_counter_ns()
+            engine = self._start_engine()
+            self.samples.add("init.warm", "ms", (time.perf_counter_ns() - start) / 1e6)
+        return engine
+
+    def _benchmark_transcribe(self, engine: TranscriptionEngine, corpus: Dict[int, np.ndarray]) -> None:
+        for sec, clip in corpus.items():
+            if sec > MAX_WINDOW_SEC:
+                continue
+            self.logger.info(f"Transcribe {sec}s clip")
+            audio = clip.tobytes()
+            self._measure(f"transcribe.{sec}s", "ms", lambda: self._elapsed_ms(lambda: engine.transcribe(audio=audio)))
+
+    def _benchmark_vad(self, corpus: Dict[int, np.ndarray]) -> None:
+        detector = SilenceDetector(self.config)
+        try:
+            if not detector._initialized:
+                self.notes["vad.per_frame"] = "skipped: Silero VAD not available"
+                return
+            self.logger.info("Silero VAD")
+            clip = corpus[max((sec for sec in corpus if sec <= MAX_WINDOW_SEC), default=min(corpus))].tobytes()
+            size = detector.frame_size_bytes
+            frames = [clip[i:i + size] for i in range(0, len(clip) - size + 1, size)]
+
+            def run() -> float:
+                start = time.perf_counter_ns()
+                for frame in frames:
+                    detector.is_silent(frame)
+                return (time.perf_counter_ns() - start) / 1e3 / len(frames)
+            self._measure("vad.per_frame", "us", run)
+        finally:
+            detector.close()
+
+    def _benchmark_stitch(self) -> None:
+        self.logger.info("Text stitching")
+        processor = TextProcessor()
+        segments = [f"and so my fellow americans ask not what your country can do for you segment {i}" for i in range(40)]
+
+        def run() -> float:
+            transcript = Transcript(processor)
+            start = time.perf_counter_ns()
+            for segment in segments:
+                transcript.append(segment)
+            return (time.perf_counter_ns() - start) / 1e3 / len(segments)
+        self._measure("stitch.per_append", "us", run)
+
+    def _benchmark_streaming(self, engine: TranscriptionEngine, corpus: Dict[int, np.ndarray]) -> None:
+        clip = corpus.get(STREAMING_CLIP_SEC, next(iter(corpus.values()))).tobytes()
+        chunk_bytes = int(SAMPLE_RATE * STREAMING_CHUNK_SEC) * 2
+        self.logger.info(f"Streaming lag ({len(clip) // (SAMPLE_RATE * 2)}s at real-time pace)")
+        for run in range(self.warmup + self.repeats):
+            tracer = LatencyTracer()
+            worker = TranscriptionWorker(engine, lambda result: None, self.config, tracer=tracer)
+            try:
+                worker.start()
+                for start in range(0, len(clip), chunk_bytes):
+                    worker.add_audio(clip[start:start + chunk_bytes])
+                    time.sleep(STREAMING_CHUNK_SEC)
+                worker.stop()
+                if worker.thread:
+                    worker.thread.join() # The worker drains its pool before exiting
+            finally:
+                worker.close()
+            lag = tracer.summary().get(tracing.END_TO_END)
+            if lag and run >= self.warmup:
+                self.samples.add("streaming.lag_p50", "ms", lag["p50_ms"])
+                self.samples.add("streaming.lag_p95", "ms", lag["p95_ms"])
+
+    def _benchmark_file(self, engine: TranscriptionEngine, corpus: Dict[int, np.ndarray]) -> None:
+        detector = SilenceDetector(self.config)
+        try:
+            batch = BatchTranscriber(self.config, engine, silence_detector=detector)
+            for sec, clip in corpus.items():
+                self.logger.info(f"File transcription {sec}s clip")
+                self._measure(f"file.{sec}s_rtf", "x", lambda: self._elapsed_ms(lambda: batch.transcribe_samples(clip)) / (sec * 1000.0))
+        finally:
+            detector.close()
+
+    def _build_corpus(self) -> Dict[int, np.ndarray]:
+        """The WAV tiled to every corpus length, or synthetic audio without one."""
+        if self.wav_path:
+            with MappedWav(self.wav_path) as wav:
+                if wav.sample_rate != SAMPLE_RATE:
+                    raise ValueError(f"Benchmark audio must be {SAMPLE_RATE} Hz, got {wav.sample_rate} Hz")
+                source = np.array(wav.samples, dtype=np.int16)
+            self.notes["corpus.source"] = os.path.basename(self.wav_path)
+            return {sec: tile_clip(source, sec) for sec in self.corpus_sec}
+        self.notes["corpus.source"] = "synthetic"
+        return {sec: synthetic_audio(sec) for sec in self.corpus_sec}
+
+    @staticmethod
+    def _server_peak_rss_kb(engine: TranscriptionEngine) -> Optional[int]:
+        """Peak RSS of the whisper.cpp server process, where the model lives (Linux only)."""
+        server = getattr(engine, "server", None)
+        process = getattr(server, "process", None) if server else None
+        if process is None:
+            return None
+        try:
+            with open(f"/proc/{process.pid}/status", encoding="utf-8") as f:
+                return parse_peak_rss_kb(f.read())
+        except OSError:
+            return None
+
+def peak_rss_kb() -> Optional[int]:
+    """Peak resident set size of this process in kB, or None where unsupported."""
+    if resource is None:
+        return None
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return peak // 1024 if sys.platform == "darwin" else peak # Bytes on macOS, kB on Linux
+
+def thermal_state() -> str:
+    """Hottest thermal zone (e.g. "52C"), or "unknown" where the kernel does not expose one."""
+    temps = []
+    for path in glob.glob("/sys/class/thermal/thermal_zone*/temp"):
+        try:
+            with open(path, encoding="utf-8") as f:
+                temps.append(int(f.read().strip()) / 1000.0)
+        except (OSError, ValueError):
+            continue
+    return f"{math.floor(max(temps))}C" if temps else "unknown"
+
+def _package_version() -> str:
+    try:
+        from importlib.metadata import version
+        return version("voice-input-service")
+    except Exception:
+        return "unknown"
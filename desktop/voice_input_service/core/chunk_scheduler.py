@@ -0,0 +1,88 @@
+"""Chunk scheduling, implemented once in the native core (native/src/chunk_scheduler.cpp).
+
+ChunkScheduler decides, chunk by chunk, when the buffered speech becomes a transcription
+window:
+
+- Speech is appended; reaching max_chunk_bytes flushes the window.
+- Silence after at least min_audio_length_bytes of buffer, once silence_duration_ms
+  have passed since the last speech, flushes what is buffered (without the silent chunk).
+- Shorter silences after speech are appended for context (unless keep_silence is off),
+  and may also reach the max size.
+- Silence with nothing buffered is ignored.
+
+The Android app binds the same library through JNI, so both apps cut windows identically.
+A source checkout without the built extension falls back to the pure-Python copy below.
+Compare actions with ==, not `is`, so callers work with either.
+"""
+from __future__ import annotations
+
+try:
+    from voice_input_service._voiceinput_core import Action, ChunkLimits, ChunkScheduler
+    NATIVE_CORE = True
+except ImportError:
+    NATIVE_CORE = False
+    from dataclasses import dataclass
+    from enum import Enum
+
+    @dataclass(frozen=True)
+    class ChunkLimits:
+        """Byte thresholds for cutting buffered audio into windows (16-bit mono PCM)."""
+        min_audio_length_bytes: int
+        max_chunk_bytes: int
+        silence_duration_ms: int
+
+    class Action(Enum):
+        IGNORE = "ignore"                        # Drop the chunk
+        APPEND = "append"                        # Append the chunk
+        APPEND_AND_FLUSH = "append_and_flush"    # Append the chunk, then flush (max size reached)
+        FLUSH = "flush"                          # Flush the buffer without the chunk (silence after speech)
+
+    class ChunkScheduler:
+        """Pure-Python copy of native/src/chunk_scheduler.cpp (rules above); keep the two in step."""
+
+        def __init__(self, limits: ChunkLimits) -> None:
+            """Initialize the scheduler.
+
+            Args:
+                limits: Thresholds; may be replaced between chunks when the config changes.
+            """
+            self.limits = limits
+            self.last_speech_ms = 0
+
+        def reset(self, now_ms: int) -> None:
+            """Start a session: silence is measured from now_ms until the first speech."""
+            self.last_speech_ms = now_ms
+
+        def on_chunk(self, silent: bool, buffered_bytes: int, chunk_bytes: int, now_ms: int, keep_silence: bool = True) -> Action:
+            """Decide what to do with one chunk.
+
+            Args:
+                silent: VAD verdict for the chunk.
+                buffered_bytes: Bytes buffered before this chunk.
+                chunk_bytes: Size of the chunk.
+                now_ms: Current time in milliseconds.
+                keep_silence: Whether short silences after speech are buffered.
+
+            Returns:
+                The action for the caller to apply.
+            """
+            limits = self.limits
+            if not silent:
+                self.last_speech_ms = now_ms
+                return self._append_action(buffered_bytes + chunk_bytes, limits)
+            if (buffered_bytes > 0 and buffered_bytes >= limits.min_audio_length_bytes
+                    and now_ms - self.last_speech_ms >= limits.silence_duration_ms):
+                return Action.FLUSH
+            if buffered_bytes > 0 and keep_silence:
+                return self._append_action(buffered_bytes + chunk_bytes, limits)
+            return Action.IGNORE
+
+        def flush_on_idle(self, buffered_bytes: int, recent_audio: bool) -> bool:
+            """Whether a quiet queue (no audio for a while) should flush what is buffered."""
+            return not recent_audio and buffered_bytes > 0 and buffered_bytes >= self.limits.min_audio_length_bytes
+
+        @staticmethod
+        def _append_action(total_bytes: int, limits: ChunkLimits) -> Action:
+            return Action.APPEND_AND_FLUSH if total_bytes >= limits.max_chunk_bytes else Action.APPEND
+
+__all__ = ["Action", "ChunkLimits", "ChunkScheduler", "NATIVE_CORE"]
@@ -10,6 +10,7 @@ from typing import Optional, List, Dict, Any, Callable
 
 from voice_input_service.ui.dialogs import ModelSelectionDialog, DownloadProgressDialog
 from voice_input_service.core.transcription import TranscriptionEngine
+from voice_input_service.core.model_tiers import MODEL_TIERS, smaller_models
 from voice_input_service.config import Config
 
 class ModelManager:
@@ -26,6 +27,7 @@ class ModelManager:
         self.ui_root = ui_root
         self.config = config
         self.cache_dir = os.path.join(os.path.expanduser("~"), ".cache", "whisper")
+        self.models_dir = os.path.join(os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))), "models")
     
     def initialize_transcription_engine(self) -> Optional[TranscriptionEngine]:
         """Initialize transcription engine with proper model handling.
@@ -61,7 +63,7 @@ class ModelManager:
                 return engine
             
             # Check for model file in models directory
-            models_dir = os.path.join(os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))), "models")
+            models_dir = self.models_dir
             ggml_models = []
             
             self.logger.info(f"Scanning for GGML models in {models_dir}")
@@ -190,7 +192,7 @@ class ModelManager:
             List of available model names
         """
         available_models = []
-        for model in ["tiny", "base", "small", "medium", "large"]:
+        for model in MODEL_TIERS:
             if os.path.exists(os.path.join(self.cache_dir, f"{model}.pt")):
                 available_models.append(model)
         return available_models
@@ -292,20 +294,34 @@ class ModelManager:
             )
             return None
     
-    def _select_model(self, model_name: str) -> TranscriptionEngine:
+    def _select_model(self, model_name: str, persist: bool = True) -> TranscriptionEngine:
         """Select an existing model.
         
+        With whisper.cpp, the GGML file for the model's tier is looked up in the
+        models directory, so this also switches between tiers.
+        
         Args:
             model_name: Name of the model to select
+            persist: Save the selection to the config; an adaptive fallback
+                builds its engine on a copy of the config instead
             
         Returns:
             TranscriptionEngine: Initialized transcription engine
         """
         self.logger.info(f"Selecting model: {model_name}")
         
-        # Update config
-        self.config.transcription.model_name = model_name
-        self.config.save()
+        engine_config = self.config
+        ggml_path = self._find_ggml_model(model_name) if self.config.transcription.use_cpp else None
+        if persist:
+            # Update config
+            self.config.transcription.model_name = model_name
+            if ggml_path:
+                self.config.transcription.ggml_model_path = ggml_path
+            self.config.save()
+        elif ggml_path:
+            engine_config = self.config.model_copy(deep=True)
+            engine_config.transcription.model_name = model_name
+            engine_config.transcription.ggml_model_path = ggml_path
         
         # Create the transcriber
         engine = TranscriptionEngine(
@@ -313,12 +329,93 @@ class ModelManager:
             device=self.config.transcription.device,
             language=self.config.transcription.language,
             use_cpp=self.config.transcription.use_cpp,
-            config=self.config
+            config=engine_config
         )
         
         self.logger.info(f"Transcription engine initialized with model: {model_name}")
         return engine
 
+    def _find_ggml_model(self, model_name: str) -> Optional[str]:
+        """Find the GGML file for a model name in the models directory.
+        
+        Args:
+            model_name: Model name such as "base.en"
+            
+        Returns:
+            Path of ggml-<model_name>.bin, else of the best ggml-<model_name>* variant, or None
+        """
+        if not os.path.isdir(self.models_dir):
+            return None
+        candidates = sorted(
+            f for f in os.listdir(self.models_dir)
+            if f.startswith(f"ggml-{model_name}") and f.endswith(".bin")
+        )
+        if not candidates:
+            return None
+        exact = f"ggml-{model_name}.bin"
+        return os.path.join(self.models_dir, exact if exact in candidates else candidates[-1])
+    
+    def engine_model_name(self, engine: TranscriptionEngine) -> str:
+        """Model name an engine runs, e.g. "small.en" for ggml-small.en.bin."""
+        model_file = getattr(engine, "model_file_path", None)
+        if model_file:
+            filename = os.path.basename(model_file)
+            if filename.startswith("ggml-") and filename.endswith(".bin"):
+                return filename[len("ggml-"):-len(".bin")]
+        return engine.model_name
+    
+    def select_fallback_model(self, model_name: str) -> Optional[str]:
+        """Next smaller model tier that is available locally.
+        
+        Args:
+            model_name: Current model name
+            
+        Returns:
+            The nearest smaller available model name, or None
+        """
+        for candidate in smaller_models(model_name):
+            if self.config.transcription.use_cpp:
+                if self._find_ggml_model(candidate):
+                    return candidate
+            elif os.path.exists(os.path.join(self.cache_dir, f"{candidate}.pt")):
+                return candidate
+        return None
+    
+    def preload_fallback(self, model_name: str, on_ready: Callable[[TranscriptionEngine], None]) -> Optional[str]:
+        """Load the next smaller tier in the background for a hot swap.
+        
+        The current engine keeps transcribing while the fallback loads; on_ready is
+        called from the loader thread once the new engine is usable. The config is
+        not changed, so the next start uses the configured model again.
+        
+        Args:
+            model_name: Current model name
+            on_ready: Receives the loaded fallback engine
+            
+        Returns:
+            Name of the fallback being loaded, or None if there is no smaller model
+        """
+        fallback = self.select_fallback_model(model_name)
+        if fallback is None:
+            self.logger.info(f"No smaller model than '{model_name}' available locally")
+            return None
+        
+        def load() -> None:
+            try:
+                engine = self._select_model(fallback, persist=False)
+            except Exception as e:
+                self.logger.error(f"Error loading fallback model '{fallback}': {e}", exc_info=True)
+                return
+            if not engine.loaded:
+                self.logger.error(f"Fallback model '{fallback}' failed to load: {engine.initialization_error}")
+                engine.close()
+                return
+            on_ready(engine)
+        
+        self.logger.info(f"Preloading fallback model '{fallback}' (current: '{model_name}')")
+        threading.Thread(target=load, daemon=True, name="ModelPreload").start()
+        return fallback
+
     def check_available_models(self) -> Dict[str, Dict[str, Any]]:
         """Check which Whisper models are available in the cache.
         
@@ -328,7 +425,7 @@ class ModelManager:
         self.logger.info(f"Checking for models in {self.cache_dir}")
         
         results = {}
-        for model_name in ["tiny", "base", "small", "medium", "large"]:
+        for model_name in MODEL_TIERS:
             model_path = os.path.join(self.cache_dir, f"{model_name}.pt")
             if os.path.exists(model_path):
                 size_bytes = os.path.getsize(model_path)
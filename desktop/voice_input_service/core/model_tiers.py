@@ -0,0 +1,95 @@
+from __future__ import annotations
+import re
+import threading
+from collections import deque
+from typing import Deque, List, Optional, Tuple
+
+# Whisper model tiers, smallest first
+MODEL_TIERS = ["tiny", "base", "small", "medium", "large"]
+
+_TIER_PATTERN = re.compile(r"^(tiny|base|small|medium|large)(.*)$")
+
+def split_model_name(model_name: str) -> Tuple[Optional[str], str]:
+    """Split a model name into its tier and variant suffix.
+
+    Args:
+        model_name: Model name such as "small.en" or "base.en-q5_1".
+
+    Returns:
+        (tier, suffix), e.g. ("small", ".en"); tier is None for unknown names.
+    """
+    match = _TIER_PATTERN.match(model_name)
+    if not match:
+        return None, model_name
+    return match.group(1), match.group(2)
+
+def smaller_models(model_name: str) -> List[str]:
+    """Model names of the tiers below model_name, nearest first, keeping its variant suffix.
+
+    Args:
+        model_name: Current model name.
+
+    Returns:
+        e.g. ["base.en", "tiny.en"] for "small.en"; empty for tiny or unknown names.
+    """
+    tier, suffix = split_model_name(model_name)
+    if tier is None:
+        return []
+    index = MODEL_TIERS.index(tier)
+    return [f"{smaller}{suffix}" for smaller in reversed(MODEL_TIERS[:index])]
+
+class RtfMonitor:
+    """Rolling real-time factor (processing time / audio duration) over recent chunks.
+
+    Trips once when the RTF over a full window exceeds the threshold, i.e. chunks are
+    arriving faster than they are transcribed; reset() re-arms it after a model swap
+    so the new tier is measured from scratch.
+    """
+
+    def __init__(self, threshold: float = 1.0, window: int = 5) -> None:
+        """Initialize the monitor.
+
+        Args:
+            threshold: RTF above which the monitor trips.
+            window: Number of chunks averaged.
+        """
+        self.threshold = threshold
+        self._samples: Deque[Tuple[float, float]] = deque(maxlen=window)
+        self._tripped = False
+        self._lock = threading.Lock()
+
+    @property
+    def rolling_rtf(self) -> float:
+        """Total processing time over total audio duration in the window (0.0 if empty)."""
+        with self._lock:
+            audio = sum(sample[1] for sample in self._samples)
+            return sum(sample[0] for sample in self._samples) / audio if audio > 0 else 0.0
+
+    def record(self, processing_sec: float, audio_sec: float) -> bool:
+        """Record one transcribed chunk.
+
+        Args:
+            processing_sec: Wall time spent transcribing the chunk.
+            audio_sec: Duration of the chunk's audio.
+
+        Returns:
+            True if the model should step down now.
+        """
+        if audio_sec <= 0:
+            return False
+        with self._lock:
+            self._samples.append((processing_sec, audio_sec))
+            if self._tripped or len(self._samples) < self._samples.maxlen:
+                return False
+            audio = sum(sample[1] for sample in self._samples)
+            rtf = sum(sample[0] for sample in self._samples) / audio
+            if rtf <= self.threshold:
+                return False
+            self._tripped = True
+            return True
+
+    def reset(self) -> None:
+        """Forget the measurements and re-arm."""
+        with self._lock:
+            self._samples.clear()
+            self._tripped = False
@@ -1,15 +1,22 @@
 from __future__ import annotations
+import os
 import threading
 import queue
 import logging
+from dataclasses import dataclass
 from typing import Callable, Optional, Literal, Dict, Any, Union, Tuple
 import time
 import numpy as np
 
+from voice_input_service.utils import tracing
 from voice_input_service.utils.lifecycle import Component
 from voice_input_service.utils.silence_detection import SilenceDetector
+from voice_input_service.utils.tracing import LatencyTracer
 from voice_input_service.config import Config
-from voice_input_service.core.transcription import TranscriptionEngine, TranscriptionResult
+from voice_input_service.core.transcription import TranscriptionEngine, TranscriptionResult, prompt_tail
+from voice_input_service.core.model_tiers import RtfMonitor
+from voice_input_service.core.chunk_scheduler import Action, ChunkLimits, ChunkScheduler
+from voice_input_service.core.transcription_pool import TranscriptionPool, autotune_pool
 
 # Try to import VAD-related modules
 try:
@@ -18,27 +25,24 @@ try:
 except ImportError:
     WEBRTC_AVAILABLE = False
 
-try:
-    import torch
-    TORCH_AVAILABLE = True
-except ImportError:
-    TORCH_AVAILABLE = False
-
-# Global variable to hold the Silero VAD model
-SILERO_MODEL = None
-SILERO_AVAILABLE = False
-
 # Define a sentinel object for the stop signal
 STOP_SIGNAL = object()
 
+@dataclass
+class _Segment:
+    """A speech segment on its way to a pool engine; times are on the tracer's clock (ns)."""
+    audio: bytes
+    captured_ns: int # When its newest audio was received
+    queued_ns: int
+
 class TranscriptionWorker(Component):
     """Manages threaded audio processing, VAD (Voice Activity Detection), and transcription.
     
     This is the primary component responsible for:
     1. Voice activity detection using one of several backends (basic, webrtc, silero)
     2. Audio buffering based on speech detection
-    3. Asynchronous processing of detected speech segments
-    4. Delivery of transcription results via callbacks
+    3. Asynchronous processing of detected speech segments on a pool of resident engines
+    4. Delivery of transcription results via callbacks, in speech order
     """
     
     def __init__(
@@ -46,6 +50,8 @@ class TranscriptionWorker(Component):
         transcriber: TranscriptionEngine,
         on_result: Callable[[TranscriptionResult], None],
         config: Config,
+        on_overload: Optional[Callable[[float], None]] = None,
+        tracer: Optional[LatencyTracer] = None,
     ) -> None:
         """Initialize the worker.
         
@@ -53,6 +59,9 @@ class TranscriptionWorker(Component):
             transcriber: The TranscriptionEngine instance.
             on_result: Callback for when an intermediate text chunk is transcribed.
             config: Application configuration.
+            on_overload: Called with the rolling real-time factor when transcription falls
+                behind real time (adaptive_model), e.g. to switch to a smaller model.
+            tracer: Records VAD, queue, transcription and end-to-end spans (statistics only if None).
         """
         self.logger = logging.getLogger("VoiceService.Worker")
         self.transcriber = transcriber
@@ -66,12 +75,22 @@ class TranscriptionWorker(Component):
         self.max_chunk_duration_sec = config.audio.max_chunk_duration_sec
         self.max_chunk_bytes = int(self.max_chunk_duration_sec * self.sample_rate * 2)
         self.min_chunk_size_bytes = config.transcription.min_chunk_size_bytes # Min bytes for transcription call
+        self.chunk_scheduler = ChunkScheduler(self._chunk_limits())
+        self.prompt_carryover = config.transcription.prompt_carryover
+        self.prompt_max_tokens = config.transcription.prompt_max_tokens
+        self.on_overload = on_overload
+        self.tracer = tracer or LatencyTracer()
+        self.rtf_monitor: Optional[RtfMonitor] = (
+            RtfMonitor(threshold=config.transcription.adaptive_rtf_threshold)
+            if config.transcription.adaptive_model else None
+        )
         
         # State initialization
         self.running = False
         self.thread: Optional[threading.Thread] = None
-        self.audio_queue: queue.Queue[bytes | object] = queue.Queue()
+        self.audio_queue: queue.Queue[Tuple[bytes, int] | object] = queue.Queue() # (chunk, receive time) or STOP_SIGNAL
         self.last_audio_time = time.time()
+        self.prompt_context = "" # Tail of the transcript, passed as the next chunk's prompt
         
         # VAD setup
         self.silence_detector = SilenceDetector(config=self.config)
@@ -81,6 +100,13 @@ class TranscriptionWorker(Component):
         
         # Thread synchronization
         self.buffer_lock = threading.RLock() # Lock for buffer access
+        
+        # Segments are transcribed off the VAD thread; extra engines are started on first start()
+        self.pool: TranscriptionPool[Tuple[TranscriptionResult, _Segment]] = TranscriptionPool(
+            transcriber, self._transcribe_segment, self._deliver_result
+        )
+        self.pool_lock = threading.Lock() # Orders pool growth against engine swaps
+        self.pool_generation = 0 # Bumped by each swap so stale spawns are discarded
     
     def has_recent_audio(self) -> bool:
         """Check if we've received audio data recently."""
@@ -96,7 +122,10 @@ class TranscriptionWorker(Component):
                 return False
             self.running = True
             self.last_audio_time = time.time() # Reset timer
+            self.prompt_context = "" # New session, no previous text
             
+        self.silence_detector.reset_stream() # VAD state must not carry over from the last session
+        
         # Clear any old data in the queue
         while not self.audio_queue.empty():
             try:
@@ -108,9 +137,43 @@ class TranscriptionWorker(Component):
         self.thread = threading.Thread(target=self._worker_loop)
         self.thread.daemon = True
         self.thread.start()
+        self._grow_pool_async()
         self.logger.info(f"Transcription worker started (Continuous Mode)")
         return True
     
+    def _grow_pool_async(self) -> None:
+        """Start additional engines up to the configured pool size in the background."""
+        workers, threads = autotune_pool(
+            os.cpu_count() or 1,
+            self.config.transcription.pool_workers,
+            self.config.transcription.pool_threads_per_worker
+        )
+        if self.pool.size >= workers:
+            return
+        with self.pool_lock:
+            generation = self.pool_generation
+            source = self.transcriber
+        threading.Thread(
+            target=self._grow_pool, args=(source, generation, workers, threads), daemon=True
+        ).start()
+    
+    def _grow_pool(self, source: TranscriptionEngine, generation: int, workers: int, threads: int) -> None:
+        """Spawn copies of source until the pool has workers engines."""
+        while self.pool.size < workers and not self.pool.closed:
+            try:
+                engine = source.spawn(threads)
+            except Exception as e:
+                self.logger.error(f"Failed to start additional transcription engine: {e}")
+                return
+            if engine is None:
+                return # Engine type cannot be replicated (e.g. Python Whisper)
+            with self.pool_lock:
+                if generation != self.pool_generation:
+                    engine.close() # Swapped to another model while this one was loading
+                    return
+                self.pool.add_engine(engine)
+            self.logger.info(f"Transcription pool has {self.pool.size} workers ({threads} threads each)")
+    
     def stop(self) -> None:
         """Stop the worker thread asynchronously by putting STOP_SIGNAL in the queue."""
         if not self.running:
@@ -123,7 +186,7 @@ class TranscriptionWorker(Component):
     def add_audio(self, data: bytes) -> None:
         """Add audio data to the processing queue."""
         if self.running:
-            self.audio_queue.put(data)
+            self.audio_queue.put((data, self.tracer.now()))
             with self.buffer_lock: # Update last audio time safely
                 self.last_audio_time = time.time()
     
@@ -139,8 +202,10 @@ class TranscriptionWorker(Component):
         self.logger.info("Worker thread entering loop.")
         
         active_speech_buffer = bytearray()
-        last_speech_time = time.time()
+        scheduler = self.chunk_scheduler
+        scheduler.reset(int(time.time() * 1000))
         total_processed_bytes = 0 # Track bytes processed within the current potential chunk
+        captured_ns = self.tracer.now() # Receive time of the newest buffered chunk
 
         while True: # Loop until STOP_SIGNAL is received
             try:
@@ -152,55 +217,41 @@ class TranscriptionWorker(Component):
                     # Process any remaining data in the buffer before exiting
                     if len(active_speech_buffer) >= self.min_chunk_size_bytes:
                         self.logger.info(f"Processing final remaining buffer chunk ({len(active_speech_buffer)} bytes) before stopping worker.")
-                        self._process_audio_buffer(bytes(active_speech_buffer))
+                        self._process_audio_buffer(bytes(active_speech_buffer), captured_ns)
+                    self.pool.wait_idle() # Deliver every segment before the session ends
                     break # Exit the while loop
                 
                 # --- Regular Audio Chunk Handling --- 
-                audio_chunk: bytes = item
+                audio_chunk, chunk_captured_ns = item
                 chunk_len = len(audio_chunk)
                 if chunk_len == 0: continue
+                captured_ns = chunk_captured_ns
                 
                 # Check VAD on the incoming chunk
-                is_chunk_silent = self._is_silent(audio_chunk)
+                with self.tracer.span(tracing.VAD):
+                    is_chunk_silent = self._is_silent(audio_chunk)
                 
                 with self.buffer_lock: # Protect buffer and related state
-                    time_since_last_speech = time.time() - last_speech_time
-                    buffer_len = len(active_speech_buffer)
-                    
-                    # --- Logic for Buffering and Processing --- 
-                    if not is_chunk_silent:
-                        # Speech detected
+                    # --- Logic for Buffering and Processing (see ChunkScheduler) --- 
+                    action = scheduler.on_chunk(is_chunk_silent, len(active_speech_buffer), chunk_len, int(time.time() * 1000))
+                    if action in (Action.APPEND, Action.APPEND_AND_FLUSH):
+                        # Speech, or some silence after it (helps context)
                         active_speech_buffer.extend(audio_chunk)
-                        last_speech_time = time.time() # Update last speech time
                         total_processed_bytes += chunk_len
-                        self.logger.debug(f"VAD=Speech. Added {chunk_len} bytes. Buffer: {len(active_speech_buffer)} bytes.")
+                        self.logger.debug(f"VAD={'Silence' if is_chunk_silent else 'Speech'}. Added {chunk_len} bytes. Buffer: {len(active_speech_buffer)} bytes.")
                         
                         # Process if buffer exceeds max duration/size
-                        if len(active_speech_buffer) >= self.max_chunk_bytes:
+                        if action == Action.APPEND_AND_FLUSH:
                             self.logger.info(f"Processing chunk due to max size reached ({len(active_speech_buffer)} bytes).")
-                            self._process_audio_buffer(bytes(active_speech_buffer))
-                            active_speech_buffer.clear()
-                            total_processed_bytes = 0
-                    else:
-                        # Silence detected
-                        self.logger.debug(f"VAD=Silence. Time since speech: {time_since_last_speech:.2f}s. Buffer: {buffer_len} bytes.")
-                        # If we have a buffer with speech and enough silence has passed, process it
-                        if buffer_len >= self.min_audio_length_bytes and time_since_last_speech >= self.silence_duration_sec:
-                            self.logger.info(f"Processing chunk due to silence detected after speech ({buffer_len} bytes).")
-                            self._process_audio_buffer(bytes(active_speech_buffer))
+                            self._process_audio_buffer(bytes(active_speech_buffer), captured_ns)
                             active_speech_buffer.clear()
                             total_processed_bytes = 0
-                        elif buffer_len > 0:
-                            # Still buffer some silence if speech just ended, helps context
-                            # Limit how much silence we buffer? Maybe add a config for this.
-                            active_speech_buffer.extend(audio_chunk)
-                            total_processed_bytes += chunk_len
-                            # Process if silence makes buffer exceed max size
-                            if len(active_speech_buffer) >= self.max_chunk_bytes:
-                                self.logger.info(f"Processing chunk due to max size reached during silence ({len(active_speech_buffer)} bytes).")
-                                self._process_audio_buffer(bytes(active_speech_buffer))
-                                active_speech_buffer.clear()
-                                total_processed_bytes = 0
+                    elif action == Action.FLUSH:
+                        # Enough silence has passed after speech
+                        self.logger.info(f"Processing chunk due to silence detected after speech ({len(active_speech_buffer)} bytes).")
+                        self._process_audio_buffer(bytes(active_speech_buffer), captured_ns)
+                        active_speech_buffer.clear()
+                        total_processed_bytes = 0
                     # --- End Buffering Logic --- 
 
                 self.audio_queue.task_done()
@@ -208,9 +259,9 @@ class TranscriptionWorker(Component):
             except queue.Empty:
                 # Timeout occurred, check if we should process buffer due to inactivity
                 with self.buffer_lock:
-                    if self.running and len(active_speech_buffer) >= self.min_audio_length_bytes and not self.has_recent_audio():
+                    if self.running and scheduler.flush_on_idle(len(active_speech_buffer), self.has_recent_audio()):
                         self.logger.info(f"Processing chunk due to inactivity timeout ({len(active_speech_buffer)} bytes).")
-                        self._process_audio_buffer(bytes(active_speech_buffer))
+                        self._process_audio_buffer(bytes(active_speech_buffer), captured_ns)
                         active_speech_buffer.clear()
                         total_processed_bytes = 0
                 continue # Continue loop after timeout check
@@ -228,39 +279,119 @@ class TranscriptionWorker(Component):
         self.running = False
         self.thread = None
     
-    def _process_audio_buffer(self, audio_data: bytes) -> None:
-        """Process a complete buffer of audio data (likely containing speech)."""
+    def _process_audio_buffer(self, audio_data: bytes, captured_ns: Optional[int] = None) -> None:
+        """Queue a complete buffer of audio data (likely containing speech) for transcription.
+        
+        Args:
+            audio_data: PCM audio of the segment.
+            captured_ns: Receive time of its newest audio on the tracer's clock (default: now).
+        """
         buffer_len = len(audio_data)
         if buffer_len < self.min_chunk_size_bytes:
             self.logger.debug(f"Skipping transcription for small buffer chunk ({buffer_len} bytes < {self.min_chunk_size_bytes} min bytes)")
             return
         
         self.logger.info(f"Sending buffer chunk ({buffer_len / 1024:.1f} KB) to transcription engine.")
-        
+        now = self.tracer.now()
+        self.pool.submit(_Segment(audio_data, captured_ns if captured_ns is not None else now, now))
+    
+    def _transcribe_segment(self, engine: TranscriptionEngine, segment: _Segment) -> Optional[Tuple[TranscriptionResult, _Segment]]:
+        """Transcribe one segment on a pool engine; None if it produced no text."""
+        self.tracer.record(tracing.QUEUE, segment.queued_ns)
+        audio_data = segment.audio
         try:
-            # Transcribe the audio - DO NOT provide a save path for intermediate chunks
-            result: TranscriptionResult = self.transcriber.transcribe(
-                audio=audio_data, 
-                target_wav_path=None # Explicitly None
-            )
-            
-            # Check if the result actually contains meaningful text
-            text = result.get("text", "").strip()
+            # Condition on the text delivered so far so shorter windows keep context.
+            # With several workers this may not yet include the segment just before.
+            prompt = self.prompt_context if self.prompt_carryover else ""
+            prompt_args = {"prompt": prompt} if prompt else {}
             
-            if text:
-                self.logger.debug(f"Worker received transcription result: '{text[:50]}...'')")
-                # Send the transcribed text back via the callback
-                try:
-                    self.on_result(result)
-                except Exception as cb_err:
-                    self.logger.error(f"Error in worker on_result callback: {cb_err}")
-            else:
-                self.logger.debug("Worker received empty transcription result.")
-                
+            # Transcribe the audio - DO NOT provide a save path for intermediate chunks
+            start_time = time.perf_counter()
+            with self.tracer.span(tracing.TRANSCRIBE, bytes=len(audio_data)):
+                result: TranscriptionResult = engine.transcribe(
+                    audio=audio_data, 
+                    target_wav_path=None, # Explicitly None
+                    **prompt_args
+                )
+            # Engines run in parallel, so throughput is what has to keep up with real time
+            processing_sec = (time.perf_counter() - start_time) / max(1, self.pool.size)
+            self._record_rtf(processing_sec, len(audio_data) / (self.sample_rate * 2))
         except Exception as e:
             # Log errors from transcription engine
             self.logger.error(f"Error during transcription call in worker: {e}", exc_info=True)
-            # Optionally, notify main thread of error?
+            return None
+        
+        # Check if the result actually contains meaningful text
+        if not result.get("text", "").strip():
+            self.logger.debug("Worker received empty transcription result.")
+            return None
+        return result, segment
+    
+    def _deliver_result(self, item: Tuple[TranscriptionResult, _Segment]) -> None:
+        """Pass a result on in speech order and extend the prompt context with it."""
+        result, segment = item
+        text = result.get("text", "").strip()
+        self.prompt_context = prompt_tail(f"{self.prompt_context} {text}", self.prompt_max_tokens)
+        self.logger.debug(f"Worker received transcription result: '{text[:50]}...'')")
+        # Send the transcribed text back via the callback
+        try:
+            self.on_result(result)
+        except Exception as cb_err:
+            self.logger.error(f"Error in worker on_result callback: {cb_err}")
+        # on_result appends and shows the text, so this spans capture to commit
+        self.tracer.record(tracing.END_TO_END, segment.captured_ns)
+    
+    def wait_idle(self, timeout: Optional[float] = None) -> bool:
+        """Block until every queued segment has been transcribed and delivered.
+        
+        Returns:
+            False if the timeout expired first.
+        """
+        return self.pool.wait_idle(timeout)
+    
+    def _record_rtf(self, processing_sec: float, audio_sec: float) -> None:
+        """Feed the RTF monitor and report an overload once it trips."""
+        if self.rtf_monitor is None or not self.rtf_monitor.record(processing_sec, audio_sec):
+            return
+        rtf = self.rtf_monitor.rolling_rtf
+        self.logger.warning(f"Transcription is falling behind real time (RTF {rtf:.2f})")
+        if self.on_overload:
+            try:
+                self.on_overload(rtf)
+            except Exception as cb_err:
+                self.logger.error(f"Error in worker on_overload callback: {cb_err}")
+    
+    def swap_transcriber(self, transcriber: TranscriptionEngine) -> TranscriptionEngine:
+        """Switch to another engine between chunks.
+        
+        Waits for a transcription in progress on the primary engine to finish, so the
+        returned engine is idle. Additional pool engines of the old model are closed and
+        replaced by copies of the new one.
+        
+        Args:
+            transcriber: The new TranscriptionEngine instance.
+            
+        Returns:
+            The previous engine.
+        """
+        with self.pool_lock:
+            self.pool_generation += 1
+            previous = self.pool.replace_engines(transcriber)
+            self.transcriber = transcriber
+        if self.rtf_monitor is not None:
+            self.rtf_monitor.reset()
+        self.logger.info("Transcription engine swapped")
+        if self.running:
+            self._grow_pool_async()
+        return previous
+    
+    def _chunk_limits(self) -> ChunkLimits:
+        """Window thresholds from the current settings."""
+        return ChunkLimits(
+            min_audio_length_bytes=self.min_audio_length_bytes,
+            max_chunk_bytes=self.max_chunk_bytes,
+            silence_duration_ms=int(self.silence_duration_sec * 1000)
+        )
     
     def update_settings(self) -> None:
         """Update worker settings from config (e.g., VAD threshold)."""
@@ -275,11 +406,15 @@ class TranscriptionWorker(Component):
             self.max_chunk_duration_sec = self.config.audio.max_chunk_duration_sec 
             self.max_chunk_bytes = int(self.max_chunk_duration_sec * self.sample_rate * 2)
             self.min_chunk_size_bytes = self.config.transcription.min_chunk_size_bytes
+            self.chunk_scheduler.limits = self._chunk_limits()
+            self.prompt_carryover = self.config.transcription.prompt_carryover
+            self.prompt_max_tokens = self.config.transcription.prompt_max_tokens
             self.logger.info(f"Worker settings updated: SilenceDur={self.silence_duration_sec}s, MaxChunk={self.max_chunk_duration_sec}s")
     
     def close(self) -> None:
         """Clean up resources."""
         self.stop() # Signal the worker to stop
+        self.pool.close()
         # Wait for thread to finish? Optional, depends on desired shutdown behavior.
         # if self.thread and self.thread.is_alive():
         #    self.logger.debug("Waiting for worker thread to join...")
@@ -28,20 +28,52 @@ except ImportError:
                 return False
 
 # Import our whisper.cpp implementation
-from voice_input_service.core.whisper_cpp import transcribe as whisper_cpp_transcribe, save_wav_file
+from voice_input_service.core.whisper_cpp import (
+    transcribe as whisper_cpp_transcribe,
+    resolve_server_path,
+    AsyncWavWriter,
+    WhisperCppServer,
+)
+from voice_input_service.utils.lifecycle import Closeable
 # Removed direct import of TranscriptManager
 
 class ModelError(Exception):
     """Exception raised for model loading or initialization errors."""
     pass
 
+def prompt_tail(text: str, max_tokens: int) -> str:
+    """Keep the end of a transcript that fits a whisper prompt token budget.
+    
+    Tokens are estimated at about four characters each (English BPE), so the
+    budget is approximate; whisper truncates anything over its own limit.
+    
+    Args:
+        text: Transcript so far.
+        max_tokens: Token budget (0 disables the prompt).
+    
+    Returns:
+        The last whole words of text within the budget.
+    """
+    if max_tokens <= 0:
+        return ""
+    words = text.split()
+    kept: List[str] = []
+    used = 0
+    for word in reversed(words):
+        cost = max(1, (len(word) + 4) // 4)
+        if used + cost > max_tokens:
+            break
+        kept.append(word)
+        used += cost
+    return " ".join(reversed(kept))
+
 class TranscriptionResult(Dict):
     """Standardized transcription result structure."""
     text: str
     language: str
     segments: List[Dict[str, Any]]
 
-class TranscriptionEngine:
+class TranscriptionEngine(Closeable):
     """Engine responsible for speech-to-text transcription."""
 
     def __init__(
@@ -51,7 +83,8 @@ class TranscriptionEngine:
         language: str = "en",
         use_cpp: bool = False,
         cache_dir: Optional[str] = None,
-        config: Optional[Dict[str, Any]] = None # Pass config for cpp paths
+        config: Optional[Dict[str, Any]] = None, # Pass config for cpp paths
+        server_threads: Optional[int] = None # Overrides transcription.server_threads
     ):
         """Initialize Whisper model for transcription."""
         self.logger = logging.getLogger(__name__)
@@ -66,6 +99,9 @@ class TranscriptionEngine:
         self.config = config
         self.whisper_cpp_path = None # Store paths after verification
         self.model_file_path = None
+        self.server: Optional[WhisperCppServer] = None # Resident whisper.cpp backend
+        self.server_threads = server_threads
+        self.wav_writer = AsyncWavWriter() # Session audio archiving, off the transcription path
         
         # --- Resolve Device --- 
         if self.device == "auto":
@@ -110,6 +146,9 @@ class TranscriptionEngine:
                 
                 self.logger.info(f"whisper.cpp setup verified. Executable: {self.whisper_cpp_path}, Initial Model: {self.model_file_path}")
                 self.loaded = True # Mark as loaded if paths are valid (even if model is None initially)
+                
+                # Load the model once into a resident server; subprocess-per-chunk stays as fallback
+                self._start_server()
             else:
                 # Check if we're using CPU and warn about large model
                 if self.device == "cpu" and self.model_name == "large":
@@ -171,12 +210,87 @@ class TranscriptionEngine:
             self.loaded = False 
             raise ModelError(error_msg) from e
 
+    def _start_server(self) -> None:
+        """Start the resident whisper.cpp server if configured and available."""
+        cpp_config = self.config.transcription
+        if not cpp_config.use_server:
+            return
+        if not self.model_file_path or not os.path.exists(self.model_file_path):
+            self.logger.debug("No GGML model selected yet, whisper.cpp server not started.")
+            return
+        
+        server_path = cpp_config.whisper_server_path or resolve_server_path(self.whisper_cpp_path)
+        if not server_path or not os.path.exists(server_path):
+            self.logger.warning("whisper.cpp server executable not found. Falling back to one subprocess per chunk.")
+            return
+        
+        server = WhisperCppServer(
+            server_path=server_path,
+            model_path=self.model_file_path,
+            language=self.language,
+            port=cpp_config.server_port,
+            threads=self.server_threads or cpp_config.server_threads,
+            startup_timeout_sec=cpp_config.server_startup_timeout_sec
+        )
+        try:
+            server.start()
+            self.server = server
+        except (FileNotFoundError, RuntimeError, OSError) as e:
+            self.logger.warning(f"Failed to start whisper.cpp server: {e}. Falling back to one subprocess per chunk.")
+            server.stop()
+            self.server = None
+    
+    def spawn(self, server_threads: Optional[int] = None) -> Optional[TranscriptionEngine]:
+        """Start another resident engine for the same model, e.g. for a transcription pool.
+        
+        Only whisper.cpp engines with a running server are replicated; each copy is a
+        separate server process holding its own copy of the model.
+        
+        Args:
+            server_threads: Decoder threads for the new server (None = config value).
+        
+        Returns:
+            The new engine, or None if this engine cannot be replicated.
+        """
+        if not self.use_cpp or self.server is None:
+            return None
+        config = self.config
+        if config.transcription.ggml_model_path != self.model_file_path:
+            # The shared config has moved on to another model (e.g. after a tier change)
+            config = config.model_copy(deep=True)
+            config.transcription.ggml_model_path = self.model_file_path
+        engine = TranscriptionEngine(
+            model_name=self.model_name,
+            device=self.device,
+            language=self.language,
+            use_cpp=True,
+            cache_dir=self.cache_dir,
+            config=config,
+            server_threads=server_threads
+        )
+        if engine.server is None:
+            engine.close()
+            return None
+        return engine
+    
+    def flush_audio_archive(self) -> None:
+        """Block until every queued session WAV has been written."""
+        self.wav_writer.flush()
+    
+    def close(self) -> None:
+        """Stop the resident whisper.cpp server and finish pending WAV writes."""
+        if self.server:
+            self.server.stop()
+            self.server = None
+        self.wav_writer.close()
+    
     def transcribe(self, audio: bytes, target_wav_path: Optional[str] = None, prompt: str = "") -> TranscriptionResult:
-        """Transcribe audio to text. Optionally saves the WAV file if target_wav_path is provided.
+        """Transcribe audio to text. Optionally archives the WAV file if target_wav_path is provided.
 
         Args:
             audio: Raw audio bytes to transcribe (16kHz, 16-bit mono).
-            target_wav_path: Optional full path where the WAV file should be saved.
+            target_wav_path: Optional full path where the WAV file should be saved
+                (written asynchronously, see flush_audio_archive()).
             prompt: Prompt to guide transcription.
 
         Returns:
@@ -184,7 +298,6 @@ class TranscriptionEngine:
             
         Raises:
             ModelError: If transcription prerequisites fail or transcription itself fails.
-            IOError: If saving the WAV file fails (when path is provided).
         """
         # --- Pre-transcription Checks --- 
         if not self.loaded:
@@ -208,70 +321,39 @@ class TranscriptionEngine:
             audio_duration = len(audio_data_np) / 16000  # Whisper uses 16kHz
             self.logger.info(f"Processing {audio_duration:.1f}s of audio")
             
+            # Archive the session audio off the transcription path
+            if target_wav_path:
+                self.wav_writer.submit(target_wav_path, audio)
+            
             if self.use_cpp:
                 # --- whisper.cpp Path --- 
                 self.logger.info(f"Using whisper.cpp for transcription. Model: {self.model_file_path}")
                 
-                # Call whisper.cpp wrapper - it handles WAV saving internally if path is given
-                raw_result = whisper_cpp_transcribe(
-                    audio_data=audio,
-                    model_path=self.model_file_path,
-                    main_path=self.whisper_cpp_path,
-                    target_wav_path=target_wav_path, # Pass the optional path
-                    language=self.language
-                )
+                if self.server and not self.server.is_running():
+                    self.logger.warning("whisper.cpp server died, restarting it.")
+                    self.server = None
+                    self._start_server()
                 
-                # Check for errors returned by the wrapper
+                if self.server:
+                    # Resident model: only the decode runs per chunk
+                    raw_result = self.server.transcribe(audio, language=self.language, prompt=prompt)
+                else:
+                    # PCM is piped to the CLI, segments come back on stdout
+                    raw_result = whisper_cpp_transcribe(
+                        audio_data=audio,
+                        model_path=self.model_file_path,
+                        main_path=self.whisper_cpp_path,
+                        language=self.language,
+                        prompt=prompt
+                    )
+                
+                # Check for errors returned by the backend
                 if "error" in raw_result:
                     error_msg = f"Whisper.cpp transcription failed: {raw_result['error']}"
                     self.logger.error(error_msg)
                     raise ModelError(error_msg)
-                    
-                # --- Standardize whisper.cpp JSON output --- 
-                # Adapted based on testing whisper.cpp -oj output structure
-                segments = []
-                full_text = ""
-                
-                cpp_segments = raw_result.get('transcription', []) 
-                if isinstance(cpp_segments, list):
-                    for i, seg_data in enumerate(cpp_segments):
-                        # Extract text and timestamps (stored as lists within 'timestamps')
-                        text = seg_data.get('text', '').strip()
-                        timestamps = seg_data.get('timestamps', {})
-                        start_ms = timestamps.get('from')
-                        end_ms = timestamps.get('to')
-                        
-                        if start_ms is not None and end_ms is not None:
-                            segments.append({
-                                "id": i,
-                                "seek": 0,
-                                "start": start_ms / 1000.0,
-                                "end": end_ms / 1000.0,
-                                "text": text,
-                                "tokens": [], 
-                                "temperature": 0.0,
-                                "avg_logprob": 0.0,
-                                "compression_ratio": 0.0,
-                                "no_speech_prob": 0.0
-                            })
-                        else:
-                            self.logger.warning(f"Skipping segment due to missing timestamp data: {seg_data}")
-                else:
-                    self.logger.warning(f"Unexpected whisper.cpp transcription segment format: {cpp_segments}")
-                
-                # Reconstruct full text
-                if segments:
-                    full_text = " ".join([s['text'] for s in segments])
                 
-                # Get language (whisper.cpp JSON might not include it, fall back)
-                detected_language = raw_result.get("params", {}).get("language", self.language)
-                
-                return TranscriptionResult({
-                    "text": full_text,
-                    "language": detected_language,
-                    "segments": segments
-                })
-                # --- End Standardization --- 
+                return self._standardize_cpp_result(raw_result)
             else:
                 # --- Python Whisper Path --- 
                 if self.model is None:
@@ -293,18 +375,6 @@ class TranscriptionEngine:
                 # Perform transcription
                 result: Dict[str, Any] = self.model.transcribe(audio_float32, **options)
                 
-                # --- Save WAV file (Only if path provided) --- 
-                if target_wav_path:
-                    try:
-                        save_wav_file(target_wav_path, audio) # Save the original bytes
-                        self.logger.info(f"Session audio saved to: {target_wav_path}")
-                    except Exception as e:
-                        # Log error but don't necessarily fail transcription if WAV save fails
-                        self.logger.error(f"Failed to save WAV file after Python Whisper transcription: {e}")
-                        # Raise specific error? Or just log?
-                        # raise IOError(f"Failed to save WAV file: {e}") from e
-                # --- End Save WAV --- 
-                
                 # Return standardized result
                 if "text" not in result: result["text"] = ""
                 if "language" not in result: result["language"] = self.language
@@ -314,15 +384,40 @@ class TranscriptionEngine:
         except ModelError as e:
              self.logger.error(f"ModelError during transcription: {e}")
              raise
-        except IOError as e:
-             self.logger.error(f"IOError during transcription (likely WAV save): {e}")
-             raise
         except Exception as e:
             exc_type, exc_value, exc_traceback = sys.exc_info()
             tb_detail = "".join(traceback.format_exception(exc_type, exc_value, exc_traceback))
             self.logger.error(f"Unexpected transcription error: {e}\n{tb_detail}")
             raise ModelError(f"Unexpected transcription failed: {e}") from e
 
+    def _standardize_cpp_result(self, raw_result: Dict[str, Any]) -> TranscriptionResult:
+        """Convert whisper.cpp segments (server verbose_json or parsed CLI output) to a TranscriptionResult."""
+        segments = []
+        for i, seg_data in enumerate(raw_result.get("segments", []) or []):
+            segments.append({
+                "id": i,
+                "seek": 0,
+                "start": float(seg_data.get("start", 0.0)),
+                "end": float(seg_data.get("end", 0.0)),
+                "text": seg_data.get("text", "").strip(),
+                "tokens": seg_data.get("tokens", []),
+                "temperature": seg_data.get("temperature", 0.0),
+                "avg_logprob": seg_data.get("avg_logprob", 0.0),
+                "compression_ratio": seg_data.get("compression_ratio", 0.0),
+                "no_speech_prob": seg_data.get("no_speech_prob", 0.0)
+            })
+        
+        if segments:
+            full_text = " ".join([s['text'] for s in segments])
+        else:
+            full_text = raw_result.get("text", "").strip()
+        
+        return TranscriptionResult({
+            "text": full_text,
+            "language": raw_result.get("language", self.language),
+            "segments": segments
+        })
+    
     def get_available_languages(self) -> Dict[str, str]:
         """Get available languages for transcription."""
         if WHISPER_AVAILABLE:
@@ -344,6 +439,7 @@ class TranscriptionEngine:
         if self.use_cpp:
             info["type"] = "whisper.cpp"
             info["path"] = self.model_file_path
+            info["resident"] = self.server is not None and self.server.is_running()
         elif WHISPER_AVAILABLE and self.model:
             info["type"] = "whisper-python"
             if hasattr(self.model, "dims"):
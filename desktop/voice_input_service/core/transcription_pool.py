@@ -0,0 +1,211 @@
+"""Parallel transcription of speech segments with in-order delivery."""
+from __future__ import annotations
+import logging
+import queue
+import threading
+from typing import Any, Callable, Dict, Generic, List, Optional, Tuple, TypeVar
+
+from voice_input_service.core.transcription import TranscriptionEngine
+
+R = TypeVar("R")
+
+# Cap on automatically chosen workers; each one holds its own copy of the model in memory
+MAX_AUTO_WORKERS = 4
+# Decoder threads below which an additional worker is not worth its memory
+MIN_THREADS_PER_WORKER = 4
+
+def autotune_pool(cores: int, workers: int = 0, threads: int = 0) -> Tuple[int, int]:
+    """Choose the worker count and decoder threads per worker.
+
+    Args:
+        cores: Available CPU cores.
+        workers: Configured worker count (0 = auto).
+        threads: Configured threads per worker (0 = auto).
+
+    Returns:
+        (workers, threads_per_worker), both at least 1.
+    """
+    cores = max(1, cores)
+    if workers <= 0:
+        workers = max(1, min(MAX_AUTO_WORKERS, cores // MIN_THREADS_PER_WORKER))
+    if threads <= 0:
+        threads = max(1, cores // workers)
+    return workers, threads
+
+class _Slot:
+    """One pool worker: an engine and the thread that feeds it."""
+
+    def __init__(self, engine: TranscriptionEngine, owned: bool) -> None:
+        self.engine = engine
+        self.owned = owned # Closed by the pool when the slot retires
+        self.lock = threading.Lock() # Held while the engine transcribes
+        self.retired = False
+        self.thread: Optional[threading.Thread] = None
+
+class TranscriptionPool(Generic[R]):
+    """Runs transcription jobs on several engines and delivers results in submission order.
+
+    Jobs go to a shared queue that every engine's thread pulls from, so a long segment on
+    one engine does not hold up the next segment. Finished jobs wait in a reorder buffer
+    until every earlier job is done; failed or empty jobs still release their place in line.
+    """
+
+    def __init__(
+        self,
+        engine: TranscriptionEngine,
+        run: Callable[[TranscriptionEngine, Any], Optional[R]],
+        deliver: Callable[[R], None]
+    ) -> None:
+        """Initialize the pool with its primary engine.
+
+        Args:
+            engine: Primary engine; owned by the caller and never closed by the pool.
+            run: Transcribes one job (as passed to submit) on the given engine; None for
+                nothing to deliver.
+            deliver: Called with each non-None result, in submission order.
+        """
+        self.logger = logging.getLogger("VoiceService.Pool")
+        self.run = run
+        self.deliver = deliver
+        self.closed = False
+
+        self._jobs: queue.Queue[Tuple[int, Any]] = queue.Queue()
+        self._slots: List[_Slot] = []
+        self._slots_lock = threading.Lock()
+        self._results: Dict[int, Optional[R]] = {} # Reorder buffer: sequence number -> result
+        self._delivery_lock = threading.Lock() # Serializes delivery
+        self._idle = threading.Condition()
+        self._next_seq = 0
+        self._next_delivery = 0
+        self.add_engine(engine, owned=False)
+
+    @property
+    def size(self) -> int:
+        """Number of active engines."""
+        with self._slots_lock:
+            return sum(1 for slot in self._slots if not slot.retired)
+
+    def add_engine(self, engine: TranscriptionEngine, owned: bool = True) -> None:
+        """Start a worker thread for another engine.
+
+        Args:
+            engine: Engine to add.
+            owned: Close the engine when its slot is retired.
+        """
+        slot = _Slot(engine, owned)
+        with self._slots_lock:
+            if self.closed:
+                if owned:
+                    engine.close()
+                return
+            self._slots.append(slot)
+            index = len(self._slots) - 1
+        slot.thread = threading.Thread(target=self._slot_loop, args=(slot,), name=f"TranscriptionPool-{index}")
+        slot.thread.daemon = True
+        slot.thread.start()
+        self.logger.debug(f"Pool worker {index} started")
+
+    def submit(self, job: Any) -> int:
+        """Queue a job (e.g. audio bytes) for transcription.
+
+        Returns:
+            The job's sequence number, or -1 if the pool is closed.
+        """
+        with self._idle:
+            if self.closed:
+                return -1
+            seq = self._next_seq
+            self._next_seq += 1
+            self._jobs.put((seq, job)) # Under the lock so close() cannot miss it
+        return seq
+
+    def wait_idle(self, timeout: Optional[float] = None) -> bool:
+        """Block until every submitted job has been delivered.
+
+        Returns:
+            False if the timeout expired first.
+        """
+        with self._idle:
+            return self._idle.wait_for(lambda: self.closed or self._next_delivery == self._next_seq, timeout)
+
+    def replace_engines(self, engine: TranscriptionEngine) -> TranscriptionEngine:
+        """Make engine the only active engine.
+
+        Waits for a job in progress on the primary engine to finish, so the returned
+        engine is idle. Additional engines retire after their current job.
+
+        Returns:
+            The previous primary engine.
+        """
+        with self._slots_lock:
+            primary = self._slots[0]
+            extras = [slot for slot in self._slots[1:] if not slot.retired]
+            for slot in extras:
+                slot.retired = True
+            self._slots = [primary]
+        with primary.lock:
+            previous = primary.engine
+            primary.engine = engine
+        if extras:
+            self.logger.info(f"Retired {len(extras)} additional pool workers")
+        return previous
+
+    def close(self) -> None:
+        """Stop all worker threads; queued jobs are dropped and additional engines closed.
+
+        A job already being transcribed finishes; the rest of the queue (and its audio) is
+        discarded without being run or delivered.
+        """
+        with self._slots_lock:
+            if self.closed:
+                return
+            self.closed = True
+            for slot in self._slots:
+                slot.retired = True
+        dropped = 0
+        with self._idle:
+            while True:
+                try:
+                    self._jobs.get_nowait()
+                except queue.Empty:
+                    break
+                dropped += 1
+            self._idle.notify_all()
+        if dropped:
+            self.logger.info(f"Dropped {dropped} queued transcription jobs")
+
+    def _slot_loop(self, slot: _Slot) -> None:
+        """Pull jobs from the shared queue until the slot retires."""
+        while not slot.retired:
+            try:
+                seq, job = self._jobs.get(timeout=0.1)
+            except queue.Empty:
+                continue
+            result: Optional[R] = None
+            with slot.lock:
+                try:
+                    result = self.run(slot.engine, job)
+                except Exception as e:
+                    self.logger.error(f"Error in pool job {seq}: {e}", exc_info=True)
+            self._complete(seq, result)
+        if slot.owned:
+            try:
+                slot.engine.close()
+            except Exception as e:
+                self.logger.error(f"Error closing pool engine: {e}")
+
+    def _complete(self, seq: int, result: Optional[R]) -> None:
+        """Store a result and deliver every result that is next in line."""
+        with self._delivery_lock:
+            self._results[seq] = result
+            while self._next_delivery in self._results:
+                ready = self._results.pop(self._next_delivery)
+                if ready is not None:
+                    try:
+                        self.deliver(ready)
+                    except Exception as cb_err:
+                        self.logger.error(f"Error in pool deliver callback: {cb_err}")
+                with self._idle:
+                    self._next_delivery += 1
+                    if self._next_delivery == self._next_seq:
+                        self._idle.notify_all()
@@ -1,20 +1,28 @@
 from __future__ import annotations
 import os
 import subprocess
-import tempfile
 import logging
+import queue
+import re
 from typing import Optional, Dict, List, Any
 import numpy as np
 import time
 import platform
-from pathlib import Path
-import json # Added for parsing JSON output
+import json # Added for parsing server JSON output
 import wave # Added for saving WAV
+import io
+import socket
+import threading
+import uuid
+import urllib.request
+import urllib.error
 
 logger = logging.getLogger("VoiceService.Transcription.WhisperCPP")
 
 # Removed TempWavFile context manager as we save permanently now
 
+SAMPLE_RATE = 16000
+
 def save_wav_file(file_path: str, audio_data: bytes) -> None:
     """
     Write audio data to a WAV file.
@@ -39,55 +47,258 @@ def save_wav_file(file_path: str, audio_data: bytes) -> None:
         logger.error(f"Failed to write WAV file {file_path}: {e}")
         raise # Re-raise the exception
 
+def wav_bytes(audio_data: bytes) -> bytes:
+    """
+    Wrap raw PCM in an in-memory WAV container.
+    
+    Args:
+        audio_data: Raw audio bytes (16-bit PCM, 16kHz mono assumed).
+    
+    Returns:
+        Complete WAV file contents as bytes.
+    """
+    buffer = io.BytesIO()
+    with wave.open(buffer, 'wb') as wav_file:
+        wav_file.setnchannels(1)
+        wav_file.setsampwidth(2)
+        wav_file.setframerate(SAMPLE_RATE)
+        wav_file.writeframes(audio_data)
+    return buffer.getvalue()
+
+def resolve_server_path(main_path: Optional[str]) -> Optional[str]:
+    """
+    Locate the whisper.cpp server binary next to the CLI executable.
+    
+    Args:
+        main_path: Path to the whisper.cpp CLI executable (whisper-cli / main).
+    
+    Returns:
+        Path to whisper-server if it exists alongside the CLI, else None.
+    """
+    if not main_path:
+        return None
+    suffix = ".exe" if platform.system() == "Windows" else ""
+    candidate = os.path.join(os.path.dirname(os.path.abspath(main_path)), f"whisper-server{suffix}")
+    return candidate if os.path.exists(candidate) else None
+
+class WhisperCppServer:
+    """
+    Long-lived whisper.cpp server child process.
+    
+    The GGML model is loaded once when the process starts; each call to
+    transcribe() only posts PCM to the /inference endpoint, so per-chunk
+    latency is the decode time alone.
+    """
+    
+    def __init__(
+        self,
+        server_path: str,
+        model_path: str,
+        language: str = "en",
+        host: str = "127.0.0.1",
+        port: int = 0,
+        threads: Optional[int] = None,
+        startup_timeout_sec: float = 30.0
+    ) -> None:
+        """
+        Args:
+            server_path: Path to the whisper-server executable.
+            model_path: Path to the whisper.cpp model file (.bin).
+            language: Default language code for transcription.
+            host: Interface the server binds to (loopback by default).
+            port: TCP port, 0 picks a free one.
+            threads: Decoder thread count, None for whisper.cpp default.
+            startup_timeout_sec: How long to wait for the model to load.
+        """
+        self.server_path = os.path.abspath(server_path)
+        self.model_path = os.path.abspath(model_path)
+        self.language = language
+        self.host = host
+        self.port = port
+        self.threads = threads
+        self.startup_timeout_sec = startup_timeout_sec
+        self.process: Optional[subprocess.Popen] = None
+        self._request_lock = threading.Lock()
+    
+    @property
+    def url(self) -> str:
+        return f"http://{self.host}:{self.port}"
+    
+    def is_running(self) -> bool:
+        """Check whether the server process is alive."""
+        return self.process is not None and self.process.poll() is None
+    
+    def start(self) -> None:
+        """
+        Launch the server and block until the model is loaded.
+        
+        Raises:
+            FileNotFoundError: If the executable or the model does not exist.
+            RuntimeError: If the server exits or does not come up in time.
+        """
+        if self.is_running():
+            return
+        if not os.path.exists(self.server_path):
+            raise FileNotFoundError(f"whisper.cpp server executable not found: {self.server_path}")
+        if not os.path.exists(self.model_path):
+            raise FileNotFoundError(f"Model file not found: {self.model_path}")
+        
+        if self.port == 0:
+            self.port = _find_free_port(self.host)
+        
+        cmd = [
+            self.server_path,
+            "-m", self.model_path,
+            "-l", self.language,
+            "--host", self.host,
+            "--port", str(self.port),
+        ]
+        if self.threads:
+            cmd += ["-t", str(self.threads)]
+        
+        logger.info(f"Starting whisper.cpp server with model: {os.path.basename(self.model_path)} on {self.url}")
+        logger.debug(f"Running command: {' '.join(cmd)}")
+        start_time = time.time()
+        self.process = subprocess.Popen(
+            cmd,
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.PIPE,
+            text=True,
+            cwd=os.path.dirname(self.model_path)
+        )
+        # Drain stderr so a chatty server can never block on a full pipe
+        threading.Thread(target=self._drain_stderr, args=(self.process,), daemon=True).start()
+        
+        # The server only starts listening after the model is loaded
+        deadline = start_time + self.startup_timeout_sec
+        while time.time() < deadline:
+            if self.process.poll() is not None:
+                raise RuntimeError(f"whisper.cpp server exited during startup (code {self.process.returncode})")
+            try:
+                with socket.create_connection((self.host, self.port), timeout=0.5):
+                    logger.info(f"whisper.cpp server ready in {time.time() - start_time:.2f} seconds")
+                    return
+            except OSError:
+                time.sleep(0.1)
+        
+        self.stop()
+        raise RuntimeError(f"whisper.cpp server did not become ready within {self.startup_timeout_sec}s")
+    
+    def transcribe(self, audio_data: bytes, language: Optional[str] = None, prompt: str = "") -> Dict[str, Any]:
+        """
+        Transcribe PCM with the resident model.
+        
+        Args:
+            audio_data: Raw audio bytes (16-bit PCM, 16kHz mono).
+            language: Language code, defaults to the server language.
+            prompt: Previous-text context for the decoder (whisper initial prompt).
+        
+        Returns:
+            whisper.cpp verbose JSON response or {"error": "..."}.
+        """
+        if not self.is_running():
+            return {"error": "whisper.cpp server is not running"}
+        
+        fields = {
+            "language": language or self.language,
+            "response_format": "verbose_json",
+            "temperature": "0.0",
+        }
+        if prompt:
+            fields["prompt"] = prompt
+        body, content_type = _encode_multipart(fields, "file", "audio.wav", wav_bytes(audio_data))
+        request = urllib.request.Request(
+            f"{self.url}/inference",
+            data=body,
+            headers={"Content-Type": content_type},
+            method="POST"
+        )
+        
+        start_time = time.time()
+        try:
+            # whisper-server serves one inference at a time
+            with self._request_lock:
+                with urllib.request.urlopen(request) as response:
+                    result_data = json.loads(response.read().decode("utf-8"))
+            logger.info(f"whisper.cpp server transcription completed in {time.time() - start_time:.2f} seconds")
+        except urllib.error.HTTPError as e:
+            logger.error(f"whisper.cpp server returned HTTP {e.code}")
+            return {"error": f"Server error: HTTP {e.code}"}
+        except (urllib.error.URLError, OSError) as e:
+            logger.error(f"Error contacting whisper.cpp server: {e}")
+            return {"error": f"Server unreachable: {e}"}
+        except json.JSONDecodeError as e:
+            logger.error(f"Failed to parse whisper.cpp server response: {e}")
+            return {"error": f"Failed to parse server response: {e}"}
+        
+        if isinstance(result_data, dict) and "error" in result_data:
+            logger.error(f"whisper.cpp server reported error: {result_data['error']}")
+        return result_data
+    
+    def stop(self) -> None:
+        """Terminate the server process."""
+        process, self.process = self.process, None
+        if process is None or process.poll() is not None:
+            return
+        logger.info("Stopping whisper.cpp server")
+        process.terminate()
+        try:
+            process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            logger.warning("whisper.cpp server did not terminate, killing it")
+            process.kill()
+            process.wait()
+    
+    @staticmethod
+    def _drain_stderr(process: subprocess.Popen) -> None:
+        for line in process.stderr:
+            logger.debug(f"whisper-server: {line.rstrip()}")
+
+def _find_free_port(host: str) -> int:
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+        sock.bind((host, 0))
+        return sock.getsockname()[1]
+
+def _encode_multipart(fields: Dict[str, str], file_field: str, file_name: str, file_data: bytes) -> tuple[bytes, str]:
+    boundary = uuid.uuid4().hex
+    parts: List[bytes] = []
+    for name, value in fields.items():
+        parts.append(
+            f"--{boundary}\r\nContent-Disposition: form-data; name=\"{name}\"\r\n\r\n{value}\r\n".encode("utf-8")
+        )
+    parts.append(
+        f"--{boundary}\r\nContent-Disposition: form-data; name=\"{file_field}\"; filename=\"{file_name}\"\r\n"
+        f"Content-Type: audio/wav\r\n\r\n".encode("utf-8")
+    )
+    parts.append(file_data)
+    parts.append(f"\r\n--{boundary}--\r\n".encode("utf-8"))
+    return b"".join(parts), f"multipart/form-data; boundary={boundary}"
+
 def transcribe(
     audio_data: bytes, 
     model_path: str, 
     main_path: str, 
-    target_wav_path: Optional[str] = None, # Made optional
-    language: str = "en"
+    language: str = "en",
+    prompt: str = ""
 ) -> Dict[str, Any]:
     """
-    Transcribes using whisper.cpp (JSON output). Optionally saves audio first if target_wav_path is provided.
+    Transcribes using the whisper.cpp CLI without touching the filesystem.
+    
+    The WAV is streamed to the executable over stdin and segments are parsed
+    from its timestamped stdout, so no temp WAV or JSON file is created.
     
     Args:
         audio_data: Raw audio bytes (16-bit PCM, 16kHz mono).
         model_path: Path to the whisper.cpp model file (.bin).
         main_path: Path to the whisper.cpp executable.
-        target_wav_path: Optional full path to save the session audio WAV file.
         language: Language code for transcription.
+        prompt: Previous-text context for the decoder (whisper initial prompt).
     
     Returns:
-        Dictionary containing transcription results or {"error": "..."}.
-        
-    Raises:
-        IOError: If saving the WAV file fails (when path is provided).
+        Dictionary with "segments" (start/end seconds, text) and "language",
+        or {"error": "..."}.
     """
     start_time = time.time()
-    input_file_path = None # Path to the audio file whisper.cpp will read
-    temp_file_created = False
-
-    # --- Handle Audio Input: Save Permanently or Use Temp File --- 
-    if target_wav_path:
-        # Save permanently if path is provided
-        try:
-            save_wav_file(target_wav_path, audio_data)
-            logger.info(f"Session audio saved to: {target_wav_path}")
-            input_file_path = target_wav_path
-        except Exception as e:
-            raise IOError(f"Failed to save WAV file before transcription: {e}") from e
-    else:
-        # Transcribing intermediate chunk, use a temporary WAV file
-        try:
-            fd, temp_path = tempfile.mkstemp(suffix='.wav')
-            os.close(fd)
-            save_wav_file(temp_path, audio_data)
-            input_file_path = temp_path
-            temp_file_created = True
-            logger.debug(f"Using temporary WAV file for transcription: {input_file_path}")
-        except Exception as e:
-            logger.error(f"Failed to create/write temporary WAV file: {e}")
-            return {"error": "Failed to create temporary audio file"}
-    # --- End Audio Input Handling --- 
 
     # Resolve executable and model paths
     model_path = os.path.abspath(model_path)
@@ -98,7 +309,6 @@ def transcribe(
         main_path += '.exe'
     
     # Log paths for debugging
-    logger.debug(f"Current directory: {os.getcwd()}")
     logger.debug(f"Model path: {model_path}")
     logger.debug(f"Whisper.cpp path: {main_path}")
     
@@ -106,92 +316,127 @@ def transcribe(
     if not os.path.exists(model_path):
         error_msg = f"Model file not found: {model_path}"
         logger.error(error_msg)
-        # Clean up temp file if created
-        if temp_file_created and input_file_path and os.path.exists(input_file_path):
-             try: os.remove(input_file_path) 
-             except OSError: pass
         return {"error": error_msg}
         
     if not os.path.exists(main_path):
         error_msg = f"Whisper.cpp executable not found: {main_path}"
         logger.error(error_msg)
-        # Clean up temp file if created
-        if temp_file_created and input_file_path and os.path.exists(input_file_path):
-             try: os.remove(input_file_path) 
-             except OSError: pass
         return {"error": error_msg}
 
     # --- Run Transcription --- 
     cmd = [
         main_path,
         "-m", model_path,
-        "-f", input_file_path, # Use the saved permanent or temporary WAV
+        "-f", "-", # Read the WAV from stdin
         "-l", language,
-        "-oj" # Output JSON format (to file)
+        "-np" # Only print results (timestamped segments) to stdout
     ]
+    if prompt:
+        cmd += ["--prompt", prompt]
     
     logger.debug(f"Running command: {' '.join(cmd)}")
-    result_data: Dict[str, Any] = {}
-    output_json_path = input_file_path + ".json" # Expected output path
 
     try:
         logger.info(f"Starting whisper.cpp with model: {os.path.basename(model_path)}")
         
         process = subprocess.run(
             cmd,
+            input=wav_bytes(audio_data),
             check=True,
-            capture_output=True, 
-            text=True,
-            cwd=os.path.dirname(input_file_path) # Run in the output directory
+            capture_output=True
         )
         
         elapsed_time = time.time() - start_time
         logger.info(f"whisper.cpp transcription completed in {elapsed_time:.2f} seconds")
 
-        # --- Parse JSON Output --- 
-        if os.path.exists(output_json_path):
-            try:
-                with open(output_json_path, "r", encoding="utf-8") as f:
-                    result_data = json.load(f)
-                logger.debug(f"Successfully loaded transcription JSON from: {output_json_path}")
-            except json.JSONDecodeError as e_json:
-                logger.error(f"Failed to parse whisper.cpp JSON output from {output_json_path}: {e_json}")
-                result_data = {"error": f"Failed to parse JSON output: {e_json}"}
-            except OSError as e_os:
-                 logger.error(f"Error reading whisper.cpp JSON output file {output_json_path}: {e_os}")
-                 result_data = {"error": f"Error accessing JSON output file: {e_os}"}
-        else:
-            logger.error(f"whisper.cpp did not produce expected JSON output file: {output_json_path}")
-            stderr_output = process.stderr.strip()
-            if stderr_output:
-                 logger.error(f"whisper.cpp stderr: {stderr_output}")
-                 result_data = {"error": f"No JSON output. Stderr: {stderr_output}"}
-            else:
-                 result_data = {"error": "No JSON output and no stderr from whisper.cpp."}
+        stdout = process.stdout.decode("utf-8", errors="replace")
+        segments = parse_segments(stdout)
+        if not segments and stdout.strip():
+            logger.warning(f"Could not parse whisper.cpp output: {stdout.strip()[:200]}")
+        return {"segments": segments, "language": language}
 
     except subprocess.CalledProcessError as e:
+        stderr = (e.stderr or b"").decode("utf-8", errors="replace")
+        stdout = (e.stdout or b"").decode("utf-8", errors="replace")
         logger.error(f"whisper.cpp command failed with exit code {e.returncode}")
-        logger.error(f"Command stdout: {e.stdout}")
-        logger.error(f"Command stderr: {e.stderr}")
-        result_data = {"error": f"Command failed: {e.stderr or e.stdout}"}
+        logger.error(f"Command stdout: {stdout}")
+        logger.error(f"Command stderr: {stderr}")
+        return {"error": f"Command failed: {stderr or stdout}"}
     except Exception as e:
         logger.error(f"Error running whisper.cpp: {e}", exc_info=True) # Added exc_info
-        result_data = {"error": f"Unexpected error: {str(e)}"}
-    finally:
-        # Clean up whisper.cpp output JSON if it exists
-        if os.path.exists(output_json_path):
-           try: 
-               os.remove(output_json_path)
-               logger.debug(f"Cleaned up whisper.cpp output JSON: {output_json_path}")
-           except OSError: pass
-           
-        # Clean up temp input WAV file if we created one
-        if temp_file_created and input_file_path and os.path.exists(input_file_path):
-            try: 
-                os.remove(input_file_path)
-                logger.debug(f"Cleaned up temporary input WAV: {input_file_path}")
-            except OSError: pass
-           
-    return result_data
-
-# Removed _write_wav_file as it's replaced by save_wav_file
\ No newline at end of file
+        return {"error": f"Unexpected error: {str(e)}"}
+
+_SEGMENT_LINE = re.compile(
+    r"^\[(\d+):(\d{2}):(\d{2})[.,](\d{3})\s*-->\s*(\d+):(\d{2}):(\d{2})[.,](\d{3})\]\s*(.*)$"
+)
+
+def parse_segments(output: str) -> List[Dict[str, Any]]:
+    """
+    Parse whisper.cpp timestamped stdout lines into segments.
+    
+    Args:
+        output: stdout of whisper.cpp, one "[hh:mm:ss.mmm --> hh:mm:ss.mmm]  text" line per segment.
+    
+    Returns:
+        List of {"start", "end", "text"} dicts with times in seconds.
+    """
+    segments: List[Dict[str, Any]] = []
+    for line in output.splitlines():
+        match = _SEGMENT_LINE.match(line.strip())
+        if not match:
+            continue
+        g = match.groups()
+        start = int(g[0]) * 3600 + int(g[1]) * 60 + int(g[2]) + int(g[3]) / 1000.0
+        end = int(g[4]) * 3600 + int(g[5]) * 60 + int(g[6]) + int(g[7]) / 1000.0
+        segments.append({"start": start, "end": end, "text": g[8].strip()})
+    return segments
+
+class AsyncWavWriter:
+    """
+    Archives session audio on a background thread.
+    
+    Keeps WAV writes (and any antivirus / network-drive stalls they trigger)
+    off the transcription path.
+    """
+    
+    _STOP = object()
+    
+    def __init__(self) -> None:
+        self._queue: queue.Queue = queue.Queue()
+        self._thread: Optional[threading.Thread] = None
+        self._lock = threading.Lock()
+    
+    def submit(self, file_path: str, audio_data: bytes) -> None:
+        """Queue audio to be written to file_path."""
+        with self._lock:
+            if self._thread is None or not self._thread.is_alive():
+                self._thread = threading.Thread(target=self._run, name="WavWriter", daemon=True)
+                self._thread.start()
+        self._queue.put((file_path, audio_data))
+    
+    def flush(self) -> None:
+        """Block until all queued writes have completed."""
+        self._queue.join()
+    
+    def close(self) -> None:
+        """Finish pending writes and stop the writer thread."""
+        with self._lock:
+            thread, self._thread = self._thread, None
+        if thread is not None and thread.is_alive():
+            self._queue.put(self._STOP)
+            thread.join()
+    
+    def _run(self) -> None:
+        while True:
+            item = self._queue.get()
+            try:
+                if item is self._STOP:
+                    return
+                file_path, audio_data = item
+                try:
+                    save_wav_file(file_path, audio_data)
+                    logger.info(f"Session audio saved to: {file_path}")
+                except Exception:
+                    pass # save_wav_file already logged the failure
+            finally:
+                self._queue.task_done()
@@ -1,7 +1,7 @@
 from __future__ import annotations
 import threading
 import time
-from typing import Optional, Dict, Any, List, Literal, Tuple
+from typing import Optional, Dict, Any, List, Literal, Tuple, TYPE_CHECKING
 import logging
 import tkinter as tk
 from tkinter import messagebox
@@ -18,7 +18,12 @@ from voice_input_service.ui.events import KeyboardEventManager, EventHandler
 from voice_input_service.config import Config
 from voice_input_service.utils.clipboard import copy_to_clipboard
 from voice_input_service.utils.lifecycle import Component, Closeable
-from voice_input_service.utils.text_processor import TextProcessor
+from voice_input_service.utils.text_processor import TextProcessor, Transcript
+from voice_input_service.utils import tracing
+from voice_input_service.utils.tracing import LatencyTracer
+
+if TYPE_CHECKING:
+    from voice_input_service.core.model_manager import ModelManager
 
 # Type alias for mode
 OperatingMode = Literal["session", "continuous"]
@@ -30,7 +35,8 @@ class VoiceInputService(EventHandler, Closeable):
         self, 
         config: Config, 
         ui, 
-        transcriber: TranscriptionEngine
+        transcriber: TranscriptionEngine,
+        model_manager: Optional[ModelManager] = None
     ) -> None:
         """Initialize the voice input service.
         
@@ -38,6 +44,7 @@ class VoiceInputService(EventHandler, Closeable):
             config: Application configuration
             ui: User interface component
             transcriber: Transcription engine
+            model_manager: Loads a smaller model when transcription falls behind (optional)
         """
         # Get logger (should be already set up)
         self.logger = logging.getLogger("VoiceService")
@@ -47,6 +54,8 @@ class VoiceInputService(EventHandler, Closeable):
         self.config = config
         self.ui = ui
         self.transcriber = transcriber
+        self.model_manager = model_manager
+        self.tier_swap_pending = False # A fallback model is loading
         
         # Initialize additional components
         self.recorder = AudioRecorder(
@@ -60,6 +69,7 @@ class VoiceInputService(EventHandler, Closeable):
         # Initialize utility classes - each with a clear responsibility
         self.transcript_manager = TranscriptManager(base_dir=self.config.data_dir / "data")
         self.text_processor = TextProcessor(min_words=2)
+        self.tracer = LatencyTracer.from_config(self.config) # Stage latencies, optionally to a trace file
         
         # State variables
         self.current_mode: OperatingMode = "session" # Default mode
@@ -69,7 +79,7 @@ class VoiceInputService(EventHandler, Closeable):
         self.accumulated_audio_data = bytearray() # For session mode
         # Store for intermediate results in continuous mode (replace ChunkMetadataManager)
         self.continuous_segments: List[Dict[str, Any]] = [] 
-        self.last_continuous_text = "" # Track last successful continuous text for UI
+        self.continuous_transcript = Transcript(self.text_processor) # Text shown in the UI while recording continuously
         
         # Thread synchronization
         self.state_lock = threading.RLock()
@@ -85,7 +95,9 @@ class VoiceInputService(EventHandler, Closeable):
              self.worker = TranscriptionWorker(
                  transcriber=self.transcriber,
                  on_result=self._on_continuous_result,
-                 config=self.config
+                 config=self.config,
+                 on_overload=self._on_worker_overload,
+                 tracer=self.tracer
              )
              self.logger.info("TranscriptionWorker initialized.")
         except Exception as e:
@@ -232,6 +244,34 @@ class VoiceInputService(EventHandler, Closeable):
             # Notify UI of error
             self.ui.show_language_error(str(e))
     
+    def _on_worker_overload(self, rtf: float) -> None:
+        """Step down to a smaller model when continuous transcription falls behind."""
+        if self.model_manager is None:
+            return
+        with self.state_lock:
+            if self.tier_swap_pending:
+                return
+            self.tier_swap_pending = True
+        current = self.model_manager.engine_model_name(self.transcriber)
+        self.logger.warning(f"RTF {rtf:.2f} with model '{current}', looking for a smaller model")
+        if self.model_manager.preload_fallback(current, self._swap_transcriber) is None:
+            # Nothing smaller to load; leave the flag set so we do not retry every window
+            self.logger.info("Already on the smallest available model")
+    
+    def _swap_transcriber(self, engine: TranscriptionEngine) -> None:
+        """Switch the service and worker to a preloaded engine and close the old one."""
+        with self.state_lock:
+            previous = self.transcriber
+            self.transcriber = engine
+            worker = self.worker
+            self.tier_swap_pending = False
+        # Outside the lock: the worker waits for a transcription in progress to finish
+        if worker:
+            worker.swap_transcriber(engine)
+        self.logger.info(f"Switched transcription model to '{self.model_manager.engine_model_name(engine)}'")
+        if previous is not engine and isinstance(previous, Closeable):
+            previous.close()
+    
     def _on_audio_data(self, data: bytes) -> None:
         """Handle incoming audio data by passing it to the worker."""
         if self.recording and self.worker:
@@ -362,6 +402,8 @@ class VoiceInputService(EventHandler, Closeable):
             # Signal worker to stop processing its queue and finish
             if self.worker:
                 self.worker.stop() 
+            self.logger.info(f"Latency {self.tracer.format_summary()}")
+            self.tracer.flush()
                  
             # --- UI Update: Processing --- Immediately update UI
             self.ui.update_status(False) 
@@ -426,7 +468,7 @@ class VoiceInputService(EventHandler, Closeable):
                     audio=full_audio_data, 
                     target_wav_path=target_wav_path 
                 )
-                final_text = transcription_result.get("text", "")
+                final_text = self.text_processor.format_structured_data(transcription_result.get("text", ""))
                 session_data["full_text"] = final_text
                 session_data["segments"] = transcription_result.get("segments", [])
                 session_data["language"] = transcription_result.get("language", session_data["language"])
@@ -439,17 +481,14 @@ class VoiceInputService(EventHandler, Closeable):
                      session_data["segments"] = list(self.continuous_segments) # Take a copy
                 # Reconstruct full text from segments
                 final_text = " ".join([seg.get('text', '') for seg in session_data["segments"]]).strip()
+                final_text = self.text_processor.format_structured_data(final_text)
                 session_data["full_text"] = final_text
                 # Language was determined by chunks, might be less accurate than full pass
                 # Keep language from config or maybe last chunk? For now, use config.
                 
-                # Save the WAV file separately since transcribe wasn't called with path
-                try:
-                     self.transcript_manager.save_wav(target_wav_path, full_audio_data)
-                     self.logger.info(f"Background thread: Continuous mode WAV saved to {target_wav_path}")
-                except Exception as wav_e:
-                     self.logger.error(f"Background thread: Failed to save continuous mode WAV file: {wav_e}", exc_info=True)
-                     # Proceed to save JSON anyway?
+                # Archive the WAV separately since transcribe wasn't called with path
+                self.transcriber.wav_writer.submit(target_wav_path, full_audio_data)
+                self.logger.info(f"Background thread: Continuous mode WAV queued for {target_wav_path}")
 
             # --- Save Session JSON --- 
             saved_paths = self.transcript_manager.save_session(session_data)
@@ -548,12 +587,14 @@ class VoiceInputService(EventHandler, Closeable):
         # --- Update UI Incrementally --- 
         with self.state_lock: 
             # Use text processor to handle appending and capitalization
-            new_full_text = self.text_processor.append_text(self.last_continuous_text, new_text_chunk)
-            self.last_continuous_text = new_full_text
+            with self.tracer.span(tracing.TEXT):
+                delta = self.continuous_transcript.append(new_text_chunk)
             
-            # Update UI
-            self.ui.update_text(self.last_continuous_text) 
-            self.ui.update_word_count(len(self.last_continuous_text.split()))
+            # Update UI with only the changed tail
+            if delta:
+                with self.tracer.span(tracing.COMMIT):
+                    self.ui.apply_text_delta(delta)
+                    self.ui.update_word_count(self.continuous_transcript.word_count)
             
         # --- VAD/Silence checks are handled by the Worker --- 
 
@@ -600,13 +641,13 @@ class VoiceInputService(EventHandler, Closeable):
         with self.state_lock: 
             # Append new chunk to the last known text for UI update
             # Use text processor to handle potential overlaps or spacing
-            new_full_text = self.text_processor.append_text(self.last_continuous_text, text)
-            self.last_continuous_text = new_full_text
+            delta = self.continuous_transcript.append(text)
             
             # Update UI via queue or direct call if safe
             # For simplicity, assuming direct UI update might be okay for text
-            self.ui.update_text(self.last_continuous_text) 
-            self.ui.update_word_count(len(self.last_continuous_text.split()))
+            if delta:
+                self.ui.apply_text_delta(delta)
+                self.ui.update_word_count(self.continuous_transcript.word_count)
             
         # --- Check for auto-stop (natural pause) ---
         # Use worker's check for recent audio
@@ -618,6 +659,26 @@ class VoiceInputService(EventHandler, Closeable):
              self.stop_recording() 
              # TODO: Ensure thread safety if calling stop_recording from here
         
+    @property
+    def last_continuous_text(self) -> str:
+        """Last successful continuous text shown in the UI."""
+        return self.continuous_transcript.text()
+
+    @last_continuous_text.setter
+    def last_continuous_text(self, text: str) -> None:
+        self.continuous_transcript.reset(text)
+
+    def get_status(self) -> Dict[str, Any]:
+        """Current state and p50/p95/p99 latency per pipeline stage."""
+        with self.state_lock:
+            status: Dict[str, Any] = {
+                "recording": self.recording,
+                "mode": self.current_mode,
+                "model": getattr(self.transcriber, "model_name", None),
+            }
+        status["latency"] = self.tracer.summary()
+        return status
+    
     def _handle_clipboard_copy(self) -> None:
         """Handle copying text to clipboard and updating UI."""
         text_to_copy = self.last_continuous_text # Use the final displayed text
@@ -669,6 +730,7 @@ class VoiceInputService(EventHandler, Closeable):
  
                 if self.worker:
                      self.worker.close()
+                self.tracer.close()
                      
                 # --- Recorder cleanup handled by stop_recording / __del__ --- 
                 # if hasattr(self, 'recorder') and self.recorder:
@@ -7,6 +7,7 @@ from typing import Callable, Dict, Any, Optional
 import queue # Import queue
 
 from voice_input_service.ui.dialogs import SettingsDialog
+from voice_input_service.utils.text_processor import TextDelta
 
 class TranscriptionUI:
     """Handles the user interface for transcription."""
@@ -316,6 +317,19 @@ class TranscriptionUI:
             # Widget might have been destroyed while we were processing
             pass
     
+    def apply_text_delta(self, delta: TextDelta) -> None:
+        """Replace the text display from delta.start on, leaving the text before it untouched."""
+        if not hasattr(self, 'text_display') or not self.text_display.winfo_exists():
+            return  # UI already destroyed or not fully initialized
+            
+        try:
+            self.text_display.delete(f"1.0 + {delta.start} chars", tk.END)
+            self.text_display.insert(tk.END, delta.text)
+            self.text_display.see(tk.END)
+        except tk.TclError:
+            # Widget might have been destroyed while we were processing
+            pass
+    
     def update_status_text(self, text: str) -> None:
         """Update the status text."""
         if not hasattr(self, 'status_label') or not self.status_label.winfo_exists():
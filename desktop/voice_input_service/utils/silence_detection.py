@@ -1,154 +1,244 @@
-"""Silence detection utility using Silero VAD."""
+"""Silence detection utility using Silero VAD (ONNX)."""
 from __future__ import annotations
+import os
+import threading
+import urllib.request
 import numpy as np
-from typing import Optional
+from typing import Optional, Tuple
 import logging
-import platform # Added platform import
 
 # Import the Config class (adjust path if necessary)
-from voice_input_service.config import Config 
+from voice_input_service.config import Config
 
-# Conditional imports for Silero VAD
+# Conditional import: onnxruntime is the only runtime needed for VAD
 try:
-    import torch
-    # Check for MPS availability on Mac
-    _IS_MAC = platform.system() == 'Darwin'
-    _IS_ARM = platform.machine() == 'arm64' or platform.machine() == 'aarch64'
-    # Check device based on availability
-    if _IS_MAC and _IS_ARM and hasattr(torch.backends, 'mps') and torch.backends.mps.is_available():
-         _DEVICE = "mps"
-    elif torch.cuda.is_available():
-         _DEVICE = "cuda"
-    else:
-         _DEVICE = "cpu"
-    TORCH_AVAILABLE = True
+    import onnxruntime as ort
+    ORT_AVAILABLE = True
 except ImportError:
-    TORCH_AVAILABLE = False
-    _DEVICE = "cpu" # Default to CPU if torch isn't installed
+    ORT_AVAILABLE = False
 
-# Global variable for Silero model and utils to load only once
-SILERO_MODEL = None
-SILERO_UTILS = None
+# Same model as the Android app ships (models/silero_vad.onnx, Silero v5)
+SILERO_VAD_URL = "https://github.com/snakers4/silero-vad/raw/master/src/silero_vad/data/silero_vad.onnx"
+DEFAULT_MODEL_PATH = os.path.join(
+    os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))), "models", "silero_vad.onnx"
+)
+
+# Silero v5 window: 512 samples at 16kHz (256 at 8kHz), each preceded by the last
+# 64 (32) samples of the previous window as context; recurrent state [2, batch, 128]
+WINDOW_SAMPLES = {16000: 512, 8000: 256}
+CONTEXT_SAMPLES = {16000: 64, 8000: 32}
+STATE_SHAPE = (2, 1, 128)
+REQUIRED_INPUTS = {"input", "state", "sr"}
+
+# Sessions are shared by every detector using the same model file; streams keep their own state
+_SESSIONS = {}
+_SESSIONS_LOCK = threading.Lock()
 
 logger = logging.getLogger("VoiceService.SilenceDetection")
 
+def _load_session(model_path: str) -> "ort.InferenceSession":
+    """Load (once) the Silero ONNX model, downloading it to the default path if missing."""
+    with _SESSIONS_LOCK:
+        session = _SESSIONS.get(model_path)
+        if session is not None:
+            return session
+        if not os.path.exists(model_path):
+            if model_path != DEFAULT_MODEL_PATH:
+                raise FileNotFoundError(f"Silero VAD model not found: {model_path}")
+            logger.info(f"Downloading Silero VAD model to {model_path}...")
+            os.makedirs(os.path.dirname(model_path), exist_ok=True)
+            partial = model_path + ".part"
+            urllib.request.urlretrieve(SILERO_VAD_URL, partial)
+            os.replace(partial, model_path)
+
+        options = ort.SessionOptions()
+        # One small window at a time: threading only adds overhead
+        options.intra_op_num_threads = 1
+        options.inter_op_num_threads = 1
+        session = ort.InferenceSession(model_path, sess_options=options, providers=["CPUExecutionProvider"])
+        missing = REQUIRED_INPUTS - {i.name for i in session.get_inputs()}
+        if missing:
+            raise ValueError(f"{model_path} is not a Silero v5 model (missing inputs {sorted(missing)})")
+        _SESSIONS[model_path] = session
+        return session
+
 class SilenceDetector:
-    """Handles silence detection using the Silero VAD model."""
-    
+    """Handles silence detection using the Silero VAD model through onnxruntime.
+
+    Consecutive is_silent()/process_frames() calls form one audio stream: an incomplete
+    trailing window is kept for the next call and the recurrent state carries over, so
+    chunks of any length give the same result as one long recording. Call reset_stream()
+    when a new recording starts. silent_frames() runs a whole recording on its own state.
+    """
+
     def __init__(self, config: Config):
         """Initialize the Silero VAD detector using settings from Config.
-        
+
         Args:
             config (Config): The application configuration object.
         """
         self.logger = logger
         self.config = config # Store config
-        self.sample_rate = config.audio.sample_rate 
+        self.sample_rate = config.audio.sample_rate
         self.vad_threshold = config.audio.vad_threshold
-        
-        self.silero_model = None
-        self.silero_utils = None
+
+        self.session = None
         self._initialized = False
+        self._lock = threading.Lock() # One stream per detector; calls may come from several threads
+
+        # Model window (assuming 16-bit PCM)
+        self.frame_size_samples = WINDOW_SAMPLES.get(self.sample_rate, WINDOW_SAMPLES[16000])
+        self.context_samples = CONTEXT_SAMPLES.get(self.sample_rate, CONTEXT_SAMPLES[16000])
+        self.frame_duration_ms = self.frame_size_samples * 1000 // self.sample_rate
+        self.bytes_per_sample = 2
+        self.frame_size_bytes = self.frame_size_samples * self.bytes_per_sample
 
-        if not TORCH_AVAILABLE:
-            self.logger.critical("PyTorch is not available. Silero VAD cannot be initialized.")
+        if not ORT_AVAILABLE:
+            self.logger.critical("onnxruntime is not available. Silero VAD cannot be initialized.")
             return
-            
-        # Ensure sample rate is supported by default Silero model (8k or 16k)
-        if self.sample_rate not in [8000, 16000]:
-             self.logger.warning(f"Silero VAD model used typically supports 8kHz or 16kHz. Current config rate is {self.sample_rate}Hz. VAD might not work as expected.")
-             # Optionally, could force a supported rate or load a different model variant
 
-        self._init_detector()
+        # The Silero model only supports 8kHz and 16kHz
+        if self.sample_rate not in WINDOW_SAMPLES:
+            self.logger.critical(f"Silero VAD supports 8kHz or 16kHz only, config rate is {self.sample_rate}Hz. VAD disabled.")
+            return
 
-        # Calculate frame size (assuming 16-bit PCM) - common frame sizes for VAD
-        self.frame_duration_ms = 30 # Silero examples often use 30ms
-        self.frame_size_samples = int(self.sample_rate * (self.frame_duration_ms / 1000.0))
-        # Bytes per sample (16-bit = 2 bytes)
-        self.bytes_per_sample = 2
-        self.frame_size_bytes = self.frame_size_samples * self.bytes_per_sample
+        self._sr = np.array(self.sample_rate, dtype=np.int64)
+        self._state, self._window = self._new_stream()
+        self._pending = np.empty(0, dtype=np.int16)
+        self._init_detector()
         self.logger.debug(f"VAD Frame size: {self.frame_size_bytes} bytes ({self.frame_duration_ms}ms) at {self.sample_rate}Hz")
-            
+
     def _init_detector(self) -> None:
         """Initialize the Silero VAD detector."""
-        global SILERO_MODEL, SILERO_UTILS
-        if self.silero_model:
+        if self.session:
              return # Already initialized
 
+        model_path = self.config.audio.vad_model_path or DEFAULT_MODEL_PATH
         try:
-            if SILERO_MODEL is None:
-                self.logger.info(f"Loading Silero VAD model (device: {_DEVICE})...")
-                # torch.set_num_threads(1) # Recommended for Silero VAD
-                torch.set_grad_enabled(False)
-                
-                # Choose model based on sample rate if needed (e.g., silero_vad_micro_8k)
-                # Using default 'silero_vad' which supports 16k and possibly 8k
-                model_name = 'silero_vad'
-                # Add logic here if specific 8k model needed based on self.sample_rate
-
-                model, utils = torch.hub.load(
-                    repo_or_dir='snakers4/silero-vad',
-                    model=model_name, 
-                    force_reload=False, # Use cached model if available
-                    onnx=False # Set to True if using ONNX runtime
-                )
-                # Move model to the determined device
-                model.to(_DEVICE)
-                
-                SILERO_MODEL = model
-                SILERO_UTILS = utils
-                self.logger.info("Silero VAD model loaded successfully")
-            
-            self.silero_model = SILERO_MODEL
-            self.silero_utils = SILERO_UTILS
+            self.session = _load_session(model_path)
             self._initialized = True
+            self.logger.info(f"Silero VAD model loaded ({model_path})")
         except Exception as e:
             self.logger.critical(f"CRITICAL Error initializing Silero VAD: {e}", exc_info=True)
-            self.silero_model = None
-            self.silero_utils = None
+            self.session = None
             self._initialized = False
-            # Optionally raise the exception to halt startup if VAD is critical
-            # raise RuntimeError(f"Failed to initialize Silero VAD: {e}") from e
-        
+
+    def _new_stream(self) -> Tuple[np.ndarray, np.ndarray]:
+        """Zeroed recurrent state and input window (context + samples)."""
+        state = np.zeros(STATE_SHAPE, dtype=np.float32)
+        window = np.zeros((1, self.context_samples + self.frame_size_samples), dtype=np.float32)
+        return state, window
+
+    def _run_windows(self, samples: np.ndarray, state: np.ndarray, window: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        """Speech probability of each full window in samples (int16), continuing state/window.
+
+        Returns:
+            (probabilities, new state); window is updated in place with the last context.
+        """
+        size, context = self.frame_size_samples, self.context_samples
+        count = len(samples) // size
+        probabilities = np.empty(count, dtype=np.float32)
+        if count == 0:
+            return probabilities, state
+        # Matches the Android conversion: int16 / 32768.0, done once for the whole chunk
+        audio = samples[:count * size].astype(np.float32) / 32768.0
+        feeds = {"input": window, "state": state, "sr": self._sr}
+        for i in range(count):
+            window[0, context:] = audio[i * size:(i + 1) * size]
+            output, feeds["state"] = self.session.run(None, feeds)
+            probabilities[i] = output.item()
+            # Last samples of this window are the context for the next one
+            window[0, :context] = window[0, size:]
+        return probabilities, feeds["state"]
+
+    def process_frames(self, audio_chunk: bytes) -> np.ndarray:
+        """Run VAD over the next part of the stream, one probability per model window.
+
+        Args:
+            audio_chunk: Raw audio bytes (16-bit PCM, matching sample_rate), any length.
+
+        Returns:
+            Probabilities for every window completed by this chunk (empty if VAD failed).
+        """
+        if not self._initialized or not self.session:
+            return np.empty(0, dtype=np.float32)
+        with self._lock:
+            samples = np.frombuffer(audio_chunk, dtype=np.int16)
+            if self._pending.size:
+                samples = np.concatenate((self._pending, samples))
+            try:
+                probabilities, self._state = self._run_windows(samples, self._state, self._window)
+            except Exception as e:
+                self.logger.error(f"Error during Silero VAD processing: {e}", exc_info=True)
+                # Corrupted recurrent state would skew every following window
+                self._state, self._window = self._new_stream()
+                self._pending = np.empty(0, dtype=np.int16)
+                return np.empty(0, dtype=np.float32)
+            self._pending = samples[len(probabilities) * self.frame_size_samples:].copy()
+            return probabilities
+
+    def reset_stream(self) -> None:
+        """Start a new stream: drop any partial window and zero the recurrent state."""
+        if not self._initialized:
+            return
+        with self._lock:
+            self._state, self._window = self._new_stream()
+            self._pending = np.empty(0, dtype=np.int16)
+
     def is_silent(self, audio_chunk: bytes) -> bool:
         """Determine if audio chunk is silent using Silero VAD.
-        
+
         Args:
             audio_chunk: Raw audio bytes (16-bit PCM, matching sample_rate) to analyze.
-                         Should ideally be a multiple of frame_size_bytes, but the underlying
-                         model can handle variable lengths.
-            
+                         Streamed through process_frames(); any length is accepted.
+
         Returns:
             True if audio is determined to be silent, False if speech is detected (or if VAD failed).
         """
-        if not self._initialized or not self.silero_model or not self.silero_utils:
+        if not self._initialized or not self.session:
             self.logger.warning("Silero VAD not initialized, cannot perform silence detection. Assuming NOT silent.")
             return False # Fail safe: assume not silent if VAD isn't working
-            
+
         if not audio_chunk:
             self.logger.debug("Received empty audio chunk, assuming silent.")
             return True
 
-        # Silero expects Float32 Tensor
-        try:
-            audio_int16 = np.frombuffer(audio_chunk, dtype=np.int16)
-            audio_float32 = audio_int16.astype(np.float32) / 32768.0
-            audio_tensor = torch.from_numpy(audio_float32).to(_DEVICE)
-            
-            # Use the VAD model directly - it returns speech probability for the chunk
-            speech_prob = self.silero_model(audio_tensor, self.sample_rate).item()
-            
-            # Use the threshold from the config
-            is_speech = speech_prob >= self.vad_threshold 
-            
-            # Log sparingly, maybe only on transition or high probability?
-            # self.logger.debug(f"VAD Result: Speech Prob={speech_prob:.3f}, Threshold={self.vad_threshold}, IsSpeech={is_speech}")
-            
-            return not is_speech # Return True if silent (i.e., not speech)
-            
-        except Exception as e:
-            self.logger.error(f"Error during Silero VAD processing: {e}", exc_info=True)
-            return False # Fail safe: assume not silent on error
+        probabilities = self.process_frames(audio_chunk)
+        if probabilities.size == 0:
+            # Not a full window yet (or VAD failed) - assume speech so the first word isn't lost
+            return False
+
+        # Use the threshold from the config
+        return bool(probabilities.max() < self.vad_threshold) # True if silent (i.e., not speech)
+
+    def silent_frames(self, samples: np.ndarray, frame_samples: int) -> np.ndarray:
+        """Silence verdict for each frame_samples frame of a whole recording.
+
+        Runs every window of the recording in one pass on a fresh state (the live stream
+        is not touched). A frame is speech if any window overlapping it is; a trailing
+        part shorter than a window counts as silence.
+
+        Args:
+            samples: 16-bit PCM samples at sample_rate.
+            frame_samples: Frame length of the returned verdicts.
+
+        Returns:
+            Boolean array, True where silent; all False if VAD is not initialized.
+        """
+        count = -(-len(samples) // frame_samples)
+        if not self._initialized or not self.session:
+            return np.zeros(count, dtype=bool)
+        state, window = self._new_stream()
+        probabilities, _ = self._run_windows(np.asarray(samples, dtype=np.int16), state, window)
+
+        size = self.frame_size_samples
+        starts = np.flatnonzero(probabilities >= self.vad_threshold) * size
+        first, last = starts // frame_samples, (starts + size - 1) // frame_samples
+        speech = np.zeros(count, dtype=bool)
+        for offset in range(-(-size // frame_samples) + 1):
+            frames = first + offset
+            speech[frames[frames <= last]] = True
+        return ~speech
 
     def update_settings(self) -> None:
         """Update VAD settings from the stored config object."""
@@ -159,17 +249,12 @@ class SilenceDetector:
                 self.logger.info(f"Updated Silero VAD threshold from config to: {self.vad_threshold}")
             else:
                  self.logger.warning(f"Invalid VAD threshold in config ignored: {new_threshold}. Must be between 0.0 and 1.0.")
-        
+
         new_sample_rate = self.config.audio.sample_rate
         if new_sample_rate != self.sample_rate:
             self.logger.warning(f"Sample rate changed in config to {new_sample_rate}Hz. SilenceDetector requires re-initialization for this change to take effect.")
-            # For simplicity, we don't re-initialize here, but ideally the app should handle this.
-            # self.sample_rate = new_sample_rate 
-            # # Re-calculate frame sizes etc. if needed
-            # # Potentially re-load model if rate change requires it
 
     def close(self) -> None:
-        """Clean up resources (optional, model is global)."""
-        # Global model is kept, but could unload here if needed
-        self.logger.debug("SilenceDetector closed (no explicit cleanup needed for global model).")
-        pass 
\ No newline at end of file
+        """Clean up resources (the session is shared and kept)."""
+        self.reset_stream()
+        self.logger.debug("SilenceDetector closed (session kept for other detectors).")
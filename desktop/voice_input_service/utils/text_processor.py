@@ -1,22 +1,33 @@
 from __future__ import annotations
 import logging
+import os
 import re
+from dataclasses import dataclass
 from typing import List, Optional
 
 # Define a maximum overlap length to prevent excessive searching
 MAX_OVERLAP = 30
 
+# Characters of accumulated text append_text needs: the overlap window plus the
+# punctuation and capitalization checks just before it, with room to spare
+BOUNDARY_TAIL_CHARS = 4 * MAX_OVERLAP
+
+WHITESPACE = re.compile(r'\s+')
+TIMESTAMP_PATTERN = re.compile(r'\[\d{2}:\d{2}:\d{2}\.\d{3}\s+-->\s+\d{2}:\d{2}:\d{2}\.\d{3}\]\s*')
+
 class TextProcessor:
     """Handles text processing operations such as filtering and formatting."""
     
-    def __init__(self, min_words: int = 2) -> None:
+    def __init__(self, min_words: int = 2, enable_smart_formatting: bool = True) -> None:
         """Initialize the text processor.
         
         Args:
             min_words: Minimum number of words to consider a valid utterance
+            enable_smart_formatting: Turn spoken emails and URLs into symbols
         """
         self.logger = logging.getLogger("voice_input_service.utils.text_processor")
         self.min_words = min_words
+        self.enable_smart_formatting = enable_smart_formatting
         self.hallucination_patterns = [
             "thanks for watching",
             "thank you for watching",
@@ -42,7 +53,7 @@ class TextProcessor:
         ]
         
         # Regular expression for matching timestamp patterns from whisper.cpp
-        self.timestamp_pattern = re.compile(r'\[\d{2}:\d{2}:\d{2}\.\d{3}\s+-->\s+\d{2}:\d{2}:\d{2}\.\d{3}\]\s*')
+        self.timestamp_pattern = TIMESTAMP_PATTERN
     
     def remove_timestamps(self, text: str) -> str:
         """Remove whisper.cpp timestamp markers from text.
@@ -61,7 +72,7 @@ class TextProcessor:
         
         # Remove any leading/trailing whitespace AFTER removing timestamps
         # And replace multiple spaces that might result from substitution with a single space
-        clean_text = re.sub(r'\s+', ' ', clean_text).strip() # Replace multiple spaces and strip
+        clean_text = WHITESPACE.sub(' ', clean_text).strip() # Replace multiple spaces and strip
         
         if text != clean_text:
             self.logger.debug(f"Removed timestamps from text")
@@ -235,6 +246,22 @@ class TextProcessor:
                 
         return " ".join(sentences).strip()
     
+    def format_structured_data(self, text: str) -> str:
+        """Convert spoken emails and URLs to their symbolic form.
+
+        "john at gmail dot com" -> "john@gmail.com", "google dot com" -> "google.com".
+        See SpokenFormatter for the rules.
+
+        Args:
+            text: Text to format
+
+        Returns:
+            Text with structured data formatted
+        """
+        if not self.enable_smart_formatting or not text:
+            return text
+        return SpokenFormatter.format(text)
+
     def append_text(self, accumulated: str, new_text: str) -> str:
         """Append new text to accumulated text intelligently.
 
@@ -349,4 +376,235 @@ class TextProcessor:
                 append_part = formatted_new_text
 
             self.logger.debug(f"Appending with formatting: '{append_part}'")
-            return f"{accumulated}{separator}{append_part}"
\ No newline at end of file
+            return f"{accumulated}{separator}{append_part}"
+
+
+# Spoken separator words and the symbol each one stands for
+SEPARATORS = {
+    "at": "@",
+    "dot": ".",
+    "colon": ":",
+    "slash": "/",
+    "underscore": "_",
+    "dash": "-",
+}
+
+# Endings that make "word dot word" a domain (and an email host valid)
+TLDS = frozenset({
+    "com", "org", "net", "edu", "gov", "io", "co", "uk", "de", "fr", "jp", "cn",
+    "dev", "app", "ai", "me", "us", "ca", "au", "in", "info", "biz",
+})
+
+PROTOCOLS = frozenset({"http", "https", "ftp"})
+
+# Punctuation that may trail the last word of an address ("... gmail dot com.")
+TRAILING_PUNCTUATION = ".,!?;:"
+
+
+class _Token:
+    __slots__ = ("text", "core", "lower", "trailing", "is_label", "separator")
+
+    def __init__(self, text: str) -> None:
+        self.text = text
+        self.core = text.rstrip(TRAILING_PUNCTUATION)
+        self.lower = self.core.lower()
+        self.trailing = text[len(self.core):]
+        self.is_label = self.core.isalnum() and self.lower not in SEPARATORS
+        self.separator = SEPARATORS.get(self.lower) if not self.trailing else None
+
+
+class SpokenFormatter:
+    """Turns spoken structured data into symbols in a single pass over the words.
+
+    "john dot smith at gmail dot com" -> "john.smith@gmail.com",
+    "w w w dot example dot org" -> "www.example.org",
+    "https colon slash slash example dot org slash docs" -> "https://example.org/docs".
+
+    Separators come from one table (SEPARATORS). A run of words joined by separators is only
+    rewritten when it reads as an email, a www or protocol URL, or a domain ending in a known
+    TLD, so "look at this" is left alone. Every rule is a dict lookup per word, so the cost
+    stays linear in the text however many separators or TLDs are added.
+
+    Mirrors SpokenFormatter.kt on Android; keep the tables in sync.
+    """
+
+    @staticmethod
+    def format(text: str) -> str:
+        tokens = [_Token(word) for word in text.split()]
+        if not any(token.separator for token in tokens):
+            return " ".join(token.text for token in tokens)
+
+        out: List[str] = []
+        i = 0
+        while i < len(tokens):
+            end = SpokenFormatter._match_address(tokens, i)
+            if end < 0:
+                out.append(tokens[i].text)
+                i += 1
+            else:
+                out.append(SpokenFormatter._join_address(tokens, i, end))
+                i = end + 1
+        return " ".join(out)
+
+    @staticmethod
+    def _spoken_www_length(tokens: List[_Token], start: int) -> int:
+        # "w w w" spoken letter by letter counts as one label
+        if start + 2 >= len(tokens):
+            return 0
+        for k in range(start, start + 3):
+            if tokens[k].lower != "w" or (k < start + 2 and tokens[k].trailing):
+                return 0
+        return 3
+
+    @staticmethod
+    def _match_address(tokens: List[_Token], start: int) -> int:
+        """Index of the last token of the longest address starting at `start`, or -1."""
+        index = start
+        protocol = False
+        first = tokens[index]
+        if (first.lower in PROTOCOLS and not first.trailing and index + 4 < len(tokens)
+                and tokens[index + 1].separator == ":" and tokens[index + 2].separator == "/"
+                and tokens[index + 3].separator == "/"):
+            protocol = True
+            index += 4
+
+        www_length = SpokenFormatter._spoken_www_length(tokens, index)
+        if www_length:
+            www = True
+            label_end = index + www_length - 1
+        elif tokens[index].is_label:
+            www = tokens[index].lower == "www"
+            label_end = index
+        else:
+            return -1
+
+        ats = dots = dots_after_at = 0
+        in_path = False
+        host_label = tokens[label_end].lower
+        best = -1
+        last = label_end
+        while not tokens[last].trailing and last + 2 < len(tokens):
+            separator = tokens[last + 1].separator
+            label = tokens[last + 2]
+            if not separator or not label.is_label:
+                break
+            if separator == "@":
+                if ats or protocol or www or in_path:
+                    break
+                ats += 1
+            elif separator == ".":
+                dots += 1
+                if ats:
+                    dots_after_at += 1
+            elif separator == "/":
+                if not dots or ats:
+                    break
+                in_path = True
+            elif separator == ":":
+                break
+            last += 2
+            if not in_path:
+                host_label = label.lower
+
+            if protocol:
+                valid = dots > 0
+            elif www:
+                valid = dots >= 2
+            elif ats:
+                valid = dots_after_at > 0 and host_label in TLDS
+            else:
+                valid = dots > 0 and host_label in TLDS
+            if valid:
+                best = last
+        return best
+
+    @staticmethod
+    def _join_address(tokens: List[_Token], start: int, end: int) -> str:
+        parts: List[str] = []
+        index = start
+        while index <= end:
+            token = tokens[index]
+            letters = SpokenFormatter._spoken_www_length(tokens, index) if token.lower == "w" else 0
+            if letters:
+                parts.append("www")
+                index += letters
+                continue
+            parts.append(token.separator or token.core)
+            index += 1
+        parts.append(tokens[end].trailing)
+        return "".join(parts)
+
+
+@dataclass(frozen=True)
+class TextDelta:
+    """A change to a transcript: everything from `start` on is replaced by `text`."""
+    start: int
+    text: str
+
+    def apply(self, text: str) -> str:
+        return text[:self.start] + self.text
+
+
+class Transcript:
+    """Transcript of a session, appended chunk by chunk.
+
+    append_text only ever looks at the end of the accumulated text, so it is run over the
+    last BOUNDARY_TAIL_CHARS or so instead of the whole transcript; older text is kept as
+    frozen pieces and only joined when text() is asked for. Each append returns a TextDelta
+    so the UI can patch its copy instead of redrawing everything. Not thread-safe.
+    """
+
+    def __init__(self, processor: TextProcessor) -> None:
+        self.processor = processor
+        self.reset()
+
+    def reset(self, text: str = "") -> None:
+        """Replace the transcript with `text` (empty by default)."""
+        self._head: List[str] = []
+        self._head_len = 0
+        self._head_words = 0
+        self._tail = text
+        self._text: Optional[str] = text
+        self._freeze_head()
+
+    def __len__(self) -> int:
+        return self._head_len + len(self._tail)
+
+    @property
+    def word_count(self) -> int:
+        return self._head_words + len(self._tail.split())
+
+    def append(self, new_text: str) -> Optional[TextDelta]:
+        """Append a chunk of text.
+
+        Returns:
+            The change, or None if the chunk added nothing (e.g. it was all overlap)
+        """
+        updated = self.processor.append_text(self._tail, new_text)
+        if updated == self._tail:
+            return None
+        common = len(os.path.commonprefix([self._tail, updated]))
+        delta = TextDelta(self._head_len + common, updated[common:])
+        self._tail = updated
+        self._text = None
+        self._freeze_head()
+        return delta
+
+    def text(self) -> str:
+        """The whole transcript, joined once per change."""
+        if self._text is None:
+            self._text = "".join(self._head) + self._tail
+        return self._text
+
+    def _freeze_head(self) -> None:
+        # Cut at a space so word counts of the frozen pieces add up exactly
+        if len(self._tail) <= 2 * BOUNDARY_TAIL_CHARS:
+            return
+        cut = self._tail.rfind(" ", 0, len(self._tail) - BOUNDARY_TAIL_CHARS)
+        if cut <= 0:
+            return
+        piece = self._tail[:cut + 1]
+        self._head.append(piece)
+        self._head_len += len(piece)
+        self._head_words += len(piece.split())
+        self._tail = self._tail[cut + 1:]
@@ -0,0 +1,161 @@
+"""Latency tracing across the transcription pipeline."""
+from __future__ import annotations
+import json
+import logging
+import math
+import os
+import threading
+import time
+from collections import deque
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Any, Deque, Dict, Iterator, List, Optional, TextIO, Union
+
+from voice_input_service.utils.lifecycle import Closeable
+
+# Stage names shared with the Android trace (TraceStage)
+VAD = "vad"                # Silence decision for one recorder chunk
+QUEUE = "queue"            # Speech segment waiting for a transcription engine
+TRANSCRIBE = "transcribe"  # Engine call (whisper.cpp does encode and decode in one request)
+TEXT = "text"              # Appending the segment's text to the transcript
+COMMIT = "commit"          # Showing the updated transcript in the UI
+END_TO_END = "end_to_end"  # Newest captured audio of a segment -> its text committed
+
+TRACE_FORMATS = ("jsonl", "chrome")
+DEFAULT_CAPACITY = 256
+
+def percentile(sorted_values: List[float], p: float) -> float:
+    """Nearest-rank percentile of an ascending list (0.0 if empty)."""
+    if not sorted_values:
+        return 0.0
+    rank = min(len(sorted_values), max(1, math.ceil(p / 100.0 * len(sorted_values))))
+    return sorted_values[rank - 1]
+
+class LatencyTracer(Closeable):
+    """Records stage spans, keeps p50/p95/p99 per stage and optionally writes a trace file.
+
+    Each stage keeps its most recent `capacity` durations. With a trace file every span is
+    also written as it ends, either one JSON object per line ("jsonl") or as Chrome trace
+    events ("chrome", loadable in chrome://tracing and Perfetto). Times come from
+    perf_counter_ns, relative to when the tracer was created. Thread-safe.
+    """
+
+    def __init__(
+        self,
+        path: Optional[Union[str, Path]] = None,
+        trace_format: str = "jsonl",
+        capacity: int = DEFAULT_CAPACITY
+    ) -> None:
+        """Initialize the tracer.
+
+        Args:
+            path: Trace file to write spans to (None = keep statistics only).
+            trace_format: "jsonl" or "chrome".
+            capacity: Recent spans kept per stage for the percentiles.
+        """
+        if trace_format not in TRACE_FORMATS:
+            raise ValueError(f"Trace format must be one of {TRACE_FORMATS}, got {trace_format}")
+        self.logger = logging.getLogger("VoiceService.Trace")
+        self.trace_format = trace_format
+        self.capacity = capacity
+        self._durations: Dict[str, Deque[float]] = {}
+        self._lock = threading.Lock()
+        self._origin_ns = time.perf_counter_ns()
+        self._file: Optional[TextIO] = None
+        if path is not None:
+            path = Path(path)
+            path.parent.mkdir(parents=True, exist_ok=True)
+            self._file = open(path, "w", encoding="utf-8")
+            if trace_format == "chrome":
+                self._file.write("[\n") # The closing bracket is optional in the Chrome trace format
+            self.logger.info(f"Writing latency trace to {path}")
+
+    @classmethod
+    def from_config(cls, config: Any) -> LatencyTracer:
+        """Tracer writing to config.trace_file, if set."""
+        return cls(path=config.trace_file, trace_format=config.trace_format)
+
+    @staticmethod
+    def now() -> int:
+        """Current time on the tracer's clock (ns), for spans measured across threads."""
+        return time.perf_counter_ns()
+
+    @contextmanager
+    def span(self, stage: str, **args: Any) -> Iterator[None]:
+        """Time the enclosed block as one span of stage."""
+        start = time.perf_counter_ns()
+        try:
+            yield
+        finally:
+            self.record(stage, start, time.perf_counter_ns(), **args)
+
+    def record(self, stage: str, start_ns: int, end_ns: Optional[int] = None, **args: Any) -> None:
+        """Record a span from start_ns (see now()) to end_ns (default: now).
+
+        Args:
+            stage: Stage name.
+            start_ns: Span start on the tracer's clock.
+            end_ns: Span end on the tracer's clock.
+            **args: Extra fields written to the trace file.
+        """
+        if end_ns is None:
+            end_ns = time.perf_counter_ns()
+        duration_ns = max(0, end_ns - start_ns)
+        with self._lock:
+            durations = self._durations.get(stage)
+            if durations is None:
+                durations = self._durations[stage] = deque(maxlen=self.capacity)
+            durations.append(duration_ns / 1e6)
+            if self._file is not None:
+                self._write(stage, start_ns, duration_ns, args)
+
+    def _write(self, stage: str, start_ns: int, duration_ns: int, args: Dict[str, Any]) -> None:
+        """Append one span to the trace file; called with the lock held."""
+        ts_us = (start_ns - self._origin_ns) / 1000.0
+        dur_us = duration_ns / 1000.0
+        if self.trace_format == "chrome":
+            event = {
+                "name": stage, "cat": "voice_input", "ph": "X", "ts": ts_us, "dur": dur_us,
+                "pid": os.getpid(), "tid": threading.get_ident(), "args": args
+            }
+            self._file.write(json.dumps(event) + ",\n")
+        else:
+            event = {"stage": stage, "ts_us": ts_us, "dur_us": dur_us, "thread": threading.current_thread().name, **args}
+            self._file.write(json.dumps(event) + "\n")
+
+    def summary(self) -> Dict[str, Dict[str, float]]:
+        """Percentiles per stage, e.g. {"transcribe": {"count": 12, "p50_ms": ..., "p95_ms": ..., "p99_ms": ...}}."""
+        with self._lock:
+            snapshot = {stage: sorted(values) for stage, values in self._durations.items() if values}
+        return {
+            stage: {
+                "count": len(values),
+                "p50_ms": percentile(values, 50),
+                "p95_ms": percentile(values, 95),
+                "p99_ms": percentile(values, 99),
+            }
+            for stage, values in snapshot.items()
+        }
+
+    def format_summary(self) -> str:
+        """One-line form of summary() for logs."""
+        summary = self.summary()
+        if not summary:
+            return "no spans"
+        return ", ".join(
+            f"{stage} p50/p95/p99 {s['p50_ms']:.1f}/{s['p95_ms']:.1f}/{s['p99_ms']:.1f}ms (n={s['count']})"
+            for stage, s in summary.items()
+        )
+
+    def flush(self) -> None:
+        """Flush the trace file."""
+        with self._lock:
+            if self._file is not None:
+                self._file.flush()
+
+    def close(self) -> None:
+        """Close the trace file; statistics stay available."""
+        with self._lock:
+            if self._file is not None:
+                self._file.close()
+                self._file = None
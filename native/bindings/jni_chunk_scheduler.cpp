@@ -0,0 +1,57 @@
+// JNI side of com.voiceinput.core.ChunkScheduler: the Kotlin object holds the native
+// scheduler's address and forwards each call here.
+#include <jni.h>
+
+#include <new>
+
+#include "voiceinput/chunk_scheduler.h"
+
+using voiceinput::ChunkLimits;
+using voiceinput::ChunkScheduler;
+
+namespace {
+
+ChunkScheduler* scheduler(jlong handle) {
+    return reinterpret_cast<ChunkScheduler*>(handle);
+}
+
+}  // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeCreate(
+    JNIEnv*, jobject, jlong min_audio_length_bytes, jlong max_chunk_bytes, jlong silence_duration_ms) {
+    return reinterpret_cast<jlong>(
+        new (std::nothrow) ChunkScheduler(ChunkLimits{min_audio_length_bytes, max_chunk_bytes, silence_duration_ms}));
+}
+
+JNIEXPORT void JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeDestroy(JNIEnv*, jobject, jlong handle) {
+    delete scheduler(handle);
+}
+
+JNIEXPORT void JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeSetLimits(
+    JNIEnv*, jobject, jlong handle, jlong min_audio_length_bytes, jlong max_chunk_bytes, jlong silence_duration_ms) {
+    scheduler(handle)->set_limits(ChunkLimits{min_audio_length_bytes, max_chunk_bytes, silence_duration_ms});
+}
+
+JNIEXPORT void JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeReset(JNIEnv*, jobject, jlong handle, jlong now_ms) {
+    scheduler(handle)->reset(now_ms);
+}
+
+JNIEXPORT jlong JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeLastSpeechMs(JNIEnv*, jobject, jlong handle) {
+    return scheduler(handle)->last_speech_ms();
+}
+
+JNIEXPORT jint JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeOnChunk(
+    JNIEnv*, jobject, jlong handle, jboolean silent, jint buffered_bytes, jint chunk_bytes, jlong now_ms,
+    jboolean keep_silence) {
+    return static_cast<jint>(
+        scheduler(handle)->on_chunk(silent == JNI_TRUE, buffered_bytes, chunk_bytes, now_ms, keep_silence == JNI_TRUE));
+}
+
+JNIEXPORT jboolean JNICALL Java_com_voiceinput_core_ChunkScheduler_nativeFlushOnIdle(
+    JNIEnv*, jobject, jlong handle, jint buffered_bytes, jboolean recent_audio) {
+    return scheduler(handle)->flush_on_idle(buffered_bytes, recent_audio == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
+}  // extern "C"
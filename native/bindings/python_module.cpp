@@ -0,0 +1,77 @@
+// voice_input_service._voiceinput_core: the desktop service's binding of the native core
+#include <pybind11/pybind11.h>
+
+#include <string>
+
+#include "voiceinput/chunk_scheduler.h"
+#include "voiceinput/spsc_ring.h"
+
+namespace py = pybind11;
+using namespace voiceinput;
+
+PYBIND11_MODULE(_voiceinput_core, m) {
+    m.doc() = "Native chunk scheduling and audio ring buffer shared with the Android app";
+
+    py::class_<ChunkLimits>(m, "ChunkLimits", "Byte thresholds for cutting buffered audio into windows (16-bit mono PCM).")
+        .def(py::init([](int64_t min_audio_length_bytes, int64_t max_chunk_bytes, int64_t silence_duration_ms) {
+                 return ChunkLimits{min_audio_length_bytes, max_chunk_bytes, silence_duration_ms};
+             }),
+             py::arg("min_audio_length_bytes"), py::arg("max_chunk_bytes"), py::arg("silence_duration_ms"))
+        .def_readonly("min_audio_length_bytes", &ChunkLimits::min_audio_length_bytes)
+        .def_readonly("max_chunk_bytes", &ChunkLimits::max_chunk_bytes)
+        .def_readonly("silence_duration_ms", &ChunkLimits::silence_duration_ms)
+        .def("__eq__", [](const ChunkLimits& a, const ChunkLimits& b) {
+            return a.min_audio_length_bytes == b.min_audio_length_bytes && a.max_chunk_bytes == b.max_chunk_bytes &&
+                   a.silence_duration_ms == b.silence_duration_ms;
+        })
+        .def("__repr__", [](const ChunkLimits& l) {
+            return "ChunkLimits(min_audio_length_bytes=" + std::to_string(l.min_audio_length_bytes) +
+                   ", max_chunk_bytes=" + std::to_string(l.max_chunk_bytes) +
+                   ", silence_duration_ms=" + std::to_string(l.silence_duration_ms) + ")";
+        });
+
+    py::enum_<ChunkAction>(m, "Action")
+        .value("IGNORE", ChunkAction::kIgnore)
+        .value("APPEND", ChunkAction::kAppend)
+        .value("APPEND_AND_FLUSH", ChunkAction::kAppendAndFlush)
+        .value("FLUSH", ChunkAction::kFlush);
+
+    py::class_<ChunkScheduler>(m, "ChunkScheduler", "Decides, chunk by chunk, when the buffered speech becomes a transcription window.")
+        .def(py::init<ChunkLimits>(), py::arg("limits"))
+        .def_property("limits", &ChunkScheduler::limits, &ChunkScheduler::set_limits)
+        .def_property_readonly("last_speech_ms", &ChunkScheduler::last_speech_ms)
+        .def("reset", &ChunkScheduler::reset, py::arg("now_ms"))
+        .def("on_chunk", &ChunkScheduler::on_chunk, py::arg("silent"), py::arg("buffered_bytes"),
+             py::arg("chunk_bytes"), py::arg("now_ms"), py::arg("keep_silence") = true)
+        .def("flush_on_idle", &ChunkScheduler::flush_on_idle, py::arg("buffered_bytes"), py::arg("recent_audio"));
+
+    py::class_<SpscRing>(m, "AudioRingBuffer",
+                         "Single-producer, single-consumer byte ring between the PortAudio callback and one reader.")
+        .def(py::init<size_t>(), py::arg("capacity"))
+        .def_property_readonly("capacity", &SpscRing::capacity)
+        .def_property_readonly("overflows", &SpscRing::overflows)
+        .def_property_readonly("dropped_bytes", &SpscRing::dropped_bytes)
+        .def_property_readonly("max_fill", &SpscRing::max_fill)
+        .def("__len__", &SpscRing::size)
+        .def(
+            "write",
+            [](SpscRing& ring, const py::buffer& data) {
+                const py::buffer_info info = data.request();
+                const auto* bytes = static_cast<const uint8_t*>(info.ptr);
+                const size_t size = static_cast<size_t>(info.size * info.itemsize);
+                // The copy runs without the GIL; `data` keeps the buffer alive meanwhile
+                py::gil_scoped_release release;
+                return ring.write(bytes, size);
+            },
+            py::arg("data"), "Copy data in (producer side); False if it did not fit and was dropped.")
+        .def(
+            "read",
+            [](SpscRing& ring) {
+                const size_t pending = ring.size();
+                if (pending == 0) return py::bytes();
+                std::string out(pending, '\0');
+                out.resize(ring.read(reinterpret_cast<uint8_t*>(&out[0]), pending));
+                return py::bytes(out);
+            },
+            "Copy out everything written so far (consumer side); empty if nothing is pending.");
+}
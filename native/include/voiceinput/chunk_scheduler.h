@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+namespace voiceinput {
+
+// Byte thresholds for cutting buffered audio into windows (16-bit mono PCM)
+struct ChunkLimits {
+    int64_t min_audio_length_bytes = 0;
+    int64_t max_chunk_bytes = 1;
+    int64_t silence_duration_ms = 0;
+};
+
+// Values are shared with the bindings (Kotlin ordinals); append only
+enum class ChunkAction : int32_t {
+    kIgnore = 0,          // Drop the chunk
+    kAppend = 1,          // Append the chunk
+    kAppendAndFlush = 2,  // Append the chunk, then flush (max size reached)
+    kFlush = 3,           // Flush the buffer without the chunk (silence after speech)
+};
+
+// Decides, chunk by chunk, when the buffered speech becomes a transcription window.
+//
+// - Speech is appended; reaching max_chunk_bytes flushes the window.
+// - Silence after at least min_audio_length_bytes of buffer, once silence_duration_ms
+//   have passed since the last speech, flushes what is buffered (without the silent chunk).
+// - Shorter silences after speech are appended for context (unless keep_silence is off),
+//   and may also reach the max size.
+// - Silence with nothing buffered is ignored.
+//
+// Only the decision lives here; how a window is flushed (overlap, partials) is up to the
+// caller. Both apps use this class through their bindings, so they cut windows identically.
+// on_chunk/reset are called from one worker thread; limits may be replaced from any thread.
+class ChunkScheduler {
+public:
+    explicit ChunkScheduler(ChunkLimits limits);
+
+    ChunkLimits limits() const;
+    void set_limits(ChunkLimits limits);
+
+    // Time of the last speech chunk
+    int64_t last_speech_ms() const { return last_speech_ms_; }
+
+    // Start a session: silence is measured from now_ms until the first speech
+    void reset(int64_t now_ms) { last_speech_ms_ = now_ms; }
+
+    // buffered_bytes: bytes buffered before this chunk
+    ChunkAction on_chunk(bool silent, int64_t buffered_bytes, int64_t chunk_bytes, int64_t now_ms,
+                         bool keep_silence = true);
+
+    // Whether a quiet queue (no audio for a while) should flush what is buffered
+    bool flush_on_idle(int64_t buffered_bytes, bool recent_audio) const;
+
+private:
+    mutable std::mutex limits_mutex_;
+    ChunkLimits limits_;
+    int64_t last_speech_ms_ = 0;
+};
+
+}  // namespace voiceinput
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace voiceinput {
+
+// Single-producer, single-consumer byte ring between an audio callback and one reader.
+//
+// The buffer is allocated once. The writer only advances the write position and the
+// reader only the read position, so neither side takes a lock; each copies into or out
+// of the preallocated buffer. A write that does not fit is dropped whole and counted,
+// never blocking the callback or overwriting unread audio.
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity);
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return buffer_.size(); }
+
+    // Bytes written and not read yet
+    size_t size() const;
+
+    // Copy size bytes in (producer side); false if they did not fit and were dropped
+    bool write(const uint8_t* data, size_t size);
+
+    // Copy out up to max_size pending bytes (consumer side); returns the count
+    size_t read(uint8_t* out, size_t max_size);
+
+    // Producer-side statistics, readable from any thread
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+    uint64_t dropped_bytes() const { return dropped_bytes_.load(std::memory_order_relaxed); }
+    size_t max_fill() const { return max_fill_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<uint8_t> buffer_;
+    std::atomic<uint64_t> write_{0};  // Total bytes written; only the producer stores it
+    std::atomic<uint64_t> read_{0};   // Total bytes read; only the consumer stores it
+    std::atomic<uint64_t> overflows_{0};
+    std::atomic<uint64_t> dropped_bytes_{0};
+    std::atomic<size_t> max_fill_{0};
+};
+
+}  // namespace voiceinput
@@ -0,0 +1,46 @@
+#include "voiceinput/chunk_scheduler.h"
+
+namespace voiceinput {
+
+namespace {
+
+ChunkAction append_action(int64_t total_bytes, const ChunkLimits& limits) {
+    return total_bytes >= limits.max_chunk_bytes ? ChunkAction::kAppendAndFlush : ChunkAction::kAppend;
+}
+
+}  // namespace
+
+ChunkScheduler::ChunkScheduler(ChunkLimits limits) : limits_(limits) {}
+
+ChunkLimits ChunkScheduler::limits() const {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    return limits_;
+}
+
+void ChunkScheduler::set_limits(ChunkLimits limits) {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    limits_ = limits;
+}
+
+ChunkAction ChunkScheduler::on_chunk(bool silent, int64_t buffered_bytes, int64_t chunk_bytes, int64_t now_ms,
+                                     bool keep_silence) {
+    const ChunkLimits limits = this->limits();
+    if (!silent) {
+        last_speech_ms_ = now_ms;
+        return append_action(buffered_bytes + chunk_bytes, limits);
+    }
+    if (buffered_bytes > 0 && buffered_bytes >= limits.min_audio_length_bytes &&
+        now_ms - last_speech_ms_ >= limits.silence_duration_ms) {
+        return ChunkAction::kFlush;
+    }
+    if (buffered_bytes > 0 && keep_silence) {
+        return append_action(buffered_bytes + chunk_bytes, limits);
+    }
+    return ChunkAction::kIgnore;
+}
+
+bool ChunkScheduler::flush_on_idle(int64_t buffered_bytes, bool recent_audio) const {
+    return !recent_audio && buffered_bytes > 0 && buffered_bytes >= limits().min_audio_length_bytes;
+}
+
+}  // namespace voiceinput
@@ -0,0 +1,50 @@
+#include "voiceinput/spsc_ring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace voiceinput {
+
+SpscRing::SpscRing(size_t capacity) : buffer_(capacity) {
+    if (capacity == 0) throw std::invalid_argument("SpscRing capacity must be positive");
+}
+
+size_t SpscRing::size() const {
+    return static_cast<size_t>(write_.load(std::memory_order_acquire) - read_.load(std::memory_order_acquire));
+}
+
+bool SpscRing::write(const uint8_t* data, size_t size) {
+    const uint64_t write = write_.load(std::memory_order_relaxed);
+    const size_t fill = static_cast<size_t>(write - read_.load(std::memory_order_acquire));
+    if (size > buffer_.size() - fill) {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+    const size_t start = static_cast<size_t>(write % buffer_.size());
+    const size_t first = std::min(size, buffer_.size() - start);
+    std::memcpy(buffer_.data() + start, data, first);
+    if (first < size) std::memcpy(buffer_.data(), data + first, size - first);
+    // Publish only after the bytes are in place
+    write_.store(write + size, std::memory_order_release);
+    if (fill + size > max_fill_.load(std::memory_order_relaxed)) {
+        max_fill_.store(fill + size, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+size_t SpscRing::read(uint8_t* out, size_t max_size) {
+    const uint64_t read = read_.load(std::memory_order_relaxed);
+    const size_t size = std::min(max_size, static_cast<size_t>(write_.load(std::memory_order_acquire) - read));
+    if (size == 0) return 0;
+    const size_t start = static_cast<size_t>(read % buffer_.size());
+    const size_t first = std::min(size, buffer_.size() - start);
+    std::memcpy(out, buffer_.data() + start, first);
+    if (first < size) std::memcpy(out + first, buffer_.data(), size - first);
+    // Frees the space for the producer
+    read_.store(read + size, std::memory_order_release);
+    return size;
+}
+
+}  // namespace voiceinput
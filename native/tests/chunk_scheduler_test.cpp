@@ -0,0 +1,66 @@
+#include "voiceinput/chunk_scheduler.h"
+
+#include <gtest/gtest.h>
+
+namespace voiceinput {
+namespace {
+
+constexpr ChunkLimits kLimits{1000, 4000, 500};
+
+TEST(ChunkSchedulerTest, SpeechIsAppendedUntilTheMaxSizeFlushesIt) {
+    ChunkScheduler s(kLimits);
+    s.reset(0);
+    EXPECT_EQ(ChunkAction::kAppend, s.on_chunk(false, 0, 1000, 100));
+    EXPECT_EQ(ChunkAction::kAppend, s.on_chunk(false, 2000, 1000, 200));
+    EXPECT_EQ(ChunkAction::kAppendAndFlush, s.on_chunk(false, 3000, 1000, 300));
+    EXPECT_EQ(300, s.last_speech_ms());
+}
+
+TEST(ChunkSchedulerTest, SilenceWithNothingBufferedIsIgnored) {
+    ChunkScheduler s(kLimits);
+    EXPECT_EQ(ChunkAction::kIgnore, s.on_chunk(true, 0, 1000, 10000));
+}
+
+TEST(ChunkSchedulerTest, ShortSilenceAfterSpeechIsKeptForContext) {
+    ChunkScheduler s(kLimits);
+    s.on_chunk(false, 0, 2000, 1000);
+    EXPECT_EQ(ChunkAction::kAppend, s.on_chunk(true, 2000, 500, 1200));
+    EXPECT_EQ(ChunkAction::kAppendAndFlush, s.on_chunk(true, 3600, 500, 1300));
+}
+
+TEST(ChunkSchedulerTest, LongSilenceAfterEnoughSpeechFlushesWithoutTheChunk) {
+    ChunkScheduler s(kLimits);
+    s.on_chunk(false, 0, 2000, 1000);
+    EXPECT_EQ(ChunkAction::kFlush, s.on_chunk(true, 2000, 500, 1500));
+}
+
+TEST(ChunkSchedulerTest, LongSilenceAfterTooLittleSpeechKeepsBuffering) {
+    ChunkScheduler s(kLimits);
+    s.on_chunk(false, 0, 500, 1000);
+    EXPECT_EQ(ChunkAction::kAppend, s.on_chunk(true, 500, 500, 2000));
+}
+
+TEST(ChunkSchedulerTest, SilenceIsDroppedWhenNotKept) {
+    ChunkScheduler s(kLimits);
+    s.on_chunk(false, 0, 2000, 1000);
+    EXPECT_EQ(ChunkAction::kIgnore, s.on_chunk(true, 2000, 500, 1200, false));
+    EXPECT_EQ(ChunkAction::kFlush, s.on_chunk(true, 2000, 500, 1600, false));
+}
+
+TEST(ChunkSchedulerTest, IdleQueueFlushesEnoughBufferedAudio) {
+    ChunkScheduler s(kLimits);
+    EXPECT_TRUE(s.flush_on_idle(1000, false));
+    EXPECT_FALSE(s.flush_on_idle(1000, true));
+    EXPECT_FALSE(s.flush_on_idle(999, false));
+    EXPECT_FALSE(ChunkScheduler(ChunkLimits{0, 4000, 500}).flush_on_idle(0, false));
+}
+
+TEST(ChunkSchedulerTest, NewLimitsApplyToTheNextChunk) {
+    ChunkScheduler s(kLimits);
+    s.set_limits(ChunkLimits{1000, 1000, 500});
+    EXPECT_EQ(ChunkAction::kAppendAndFlush, s.on_chunk(false, 0, 1000, 100));
+    EXPECT_EQ(1000, s.limits().max_chunk_bytes);
+}
+
+}  // namespace
+}  // namespace voiceinput
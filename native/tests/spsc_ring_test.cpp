@@ -0,0 +1,74 @@
+#include "voiceinput/spsc_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace voiceinput {
+namespace {
+
+bool write(SpscRing& ring, const std::string& data) {
+    return ring.write(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+std::string read(SpscRing& ring, size_t max_size = 64) {
+    std::string out(max_size, '\0');
+    out.resize(ring.read(reinterpret_cast<uint8_t*>(&out[0]), max_size));
+    return out;
+}
+
+TEST(SpscRingTest, WrapsAndDropsWholeWrites) {
+    SpscRing ring(10);
+    EXPECT_TRUE(write(ring, "abcdef"));
+    EXPECT_EQ("abcdef", read(ring));
+    EXPECT_TRUE(write(ring, "1234567"));  // Wraps past the end
+    EXPECT_EQ("1234567", read(ring));
+
+    EXPECT_TRUE(write(ring, "xyz"));
+    EXPECT_FALSE(write(ring, "12345678"));
+    EXPECT_EQ(3u, ring.size());
+    EXPECT_EQ("xyz", read(ring));
+    EXPECT_EQ("", read(ring));
+    EXPECT_EQ(1u, ring.overflows());
+    EXPECT_EQ(8u, ring.dropped_bytes());
+    EXPECT_EQ(7u, ring.max_fill());
+}
+
+TEST(SpscRingTest, ReadStopsAtMaxSize) {
+    SpscRing ring(8);
+    EXPECT_TRUE(write(ring, "abcdefgh"));
+    EXPECT_FALSE(write(ring, "i"));
+    EXPECT_EQ("abc", read(ring, 3));
+    EXPECT_EQ("defgh", read(ring));
+}
+
+TEST(SpscRingTest, ProducerAndConsumerThreadsKeepOrder) {
+    SpscRing ring(64);
+    constexpr int kValues = 20000;
+    std::thread producer([&ring] {
+        for (int i = 0; i < kValues;) {
+            const uint8_t value = static_cast<uint8_t>(i);
+            if (ring.write(&value, 1)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::vector<uint8_t> received;
+    uint8_t chunk[16];
+    while (received.size() < kValues) {
+        const size_t count = ring.read(chunk, sizeof(chunk));
+        received.insert(received.end(), chunk, chunk + count);
+        if (count == 0) std::this_thread::yield();
+    }
+    producer.join();
+
+    for (int i = 0; i < kValues; i++) ASSERT_EQ(static_cast<uint8_t>(i), received[i]);
+}
+
+}  // namespace
+}  // namespace voiceinput